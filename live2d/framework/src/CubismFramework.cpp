@@ -218,6 +218,16 @@ CubismIdManager* CubismFramework::GetIdManager()
     return s_cubismIdManager;
 }
 
+void CubismFramework::BeginSharedAllocation()
+{
+    GetAllocator()->BeginSharedAllocation();
+}
+
+void CubismFramework::EndSharedAllocation()
+{
+    GetAllocator()->EndSharedAllocation();
+}
+
 #ifdef CSM_DEBUG_MEMORY_LEAKING
 
 void* CubismFramework::Allocate(csmSizeType size, const csmChar* fileName, csmInt32 lineNumber)
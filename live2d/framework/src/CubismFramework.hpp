@@ -280,6 +280,17 @@ public:
      */
     static CubismIdManager* GetIdManager();
 
+    /**
+     * @brief   モデルをまたいで共有されるオブジェクトの確保を開始する。<br>
+     *           EndSharedAllocationと対で呼ぶ。CubismSharedAllocationScopeを使うとよい。
+     */
+    static void BeginSharedAllocation();
+
+    /**
+     * @brief   BeginSharedAllocationで開始した共有の確保を終了する。
+     */
+    static void EndSharedAllocation();
+
 #ifdef CSM_DEBUG_MEMORY_LEAKING
 
     static void* Allocate(csmSizeType size, const csmChar* fileName, csmInt32 lineNumber);
@@ -306,5 +317,20 @@ private:
 
 };
 
+/**
+ * @brief   スコープの間、モデルをまたいで共有されるオブジェクトを共有の領域から確保させる<br>
+ *           シングルトンやIDのように、確保したモデルより長く生存するものを作るときに使う。
+ */
+class CubismSharedAllocationScope
+{
+public:
+    CubismSharedAllocationScope() { CubismFramework::BeginSharedAllocation(); }
+    ~CubismSharedAllocationScope() { CubismFramework::EndSharedAllocation(); }
+
+private:
+    CubismSharedAllocationScope(const CubismSharedAllocationScope&);
+    CubismSharedAllocationScope& operator=(const CubismSharedAllocationScope&);
+};
+
 }}}
 //--------- LIVE2D NAMESPACE ------------
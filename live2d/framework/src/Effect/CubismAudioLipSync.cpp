@@ -0,0 +1,188 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+#include "CubismAudioLipSync.hpp"
+#include <math.h>
+
+namespace Live2D { namespace Cubism { namespace Framework {
+
+namespace {
+const csmFloat32 DefaultWindowSeconds = 0.05f;      ///< RMSを求める区間の既定の長さ[秒]
+const csmFloat32 DefaultAttackSeconds = 0.02f;      ///< 値が上がるときの既定の時定数[秒]
+const csmFloat32 DefaultReleaseSeconds = 0.12f;     ///< 値が下がるときの既定の時定数[秒]
+const csmFloat32 UnderrunHoldSeconds = 0.1f;        ///< サンプルが途切れても直前の音量を保つ時間[秒]。これを過ぎたら無音として扱う
+const csmFloat32 MaxLatencySeconds = 0.1f;          ///< 取り出していないサンプルがこれより長くなったら古いものを読み飛ばす[秒]
+
+// 時定数timeConstantで、経過時間deltaTimeSeconds分だけ目標に近づける割合
+csmFloat32 SmoothingRate(csmFloat32 deltaTimeSeconds, csmFloat32 timeConstant)
+{
+    if (timeConstant <= 0.0f)
+    {
+        return 1.0f;
+    }
+    return 1.0f - expf(-deltaTimeSeconds / timeConstant);
+}
+}
+
+CubismAudioLipSync* CubismAudioLipSync::Create(csmUint32 capacity)
+{
+    return CSM_NEW CubismAudioLipSync(capacity);
+}
+
+void CubismAudioLipSync::Delete(CubismAudioLipSync* instance)
+{
+    CSM_DELETE_SELF(CubismAudioLipSync, instance);
+}
+
+CubismAudioLipSync::CubismAudioLipSync(csmUint32 capacity)
+    : _writeIndex(0)
+    , _sampleRate(0)
+    , _pushedSamples(0)
+    , _droppedSamples(0)
+    , _readIndex(0)
+    , _windowSeconds(DefaultWindowSeconds)
+    , _attackSeconds(DefaultAttackSeconds)
+    , _releaseSeconds(DefaultReleaseSeconds)
+    , _pendingSamples(0.0f)
+    , _meanSquare(0.0f)
+    , _underrunSeconds(0.0f)
+    , _value(0.0f)
+    , _skippedSamples(0)
+    , _underruns(0)
+{
+    // 添字をマスクで折り返せるよう2のべき乗に切り上げる
+    csmUint32 size = 1;
+    while (size < capacity && size < 0x40000000)
+    {
+        size <<= 1;
+    }
+    _samples.Resize(size, 0.0f);
+    _mask = size - 1;
+}
+
+CubismAudioLipSync::~CubismAudioLipSync()
+{ }
+
+csmUint32 CubismAudioLipSync::Push(const csmFloat32* samples, csmUint32 count, csmUint32 sampleRate)
+{
+    const csmUint32 writeIndex = _writeIndex.load(std::memory_order_relaxed);
+    const csmUint32 readIndex = _readIndex.load(std::memory_order_acquire);
+    const csmUint32 space = _samples.GetSize() - (writeIndex - readIndex);
+    const csmUint32 written = (count < space) ? count : space;
+
+    // 折り返しをまたぐ場合は2回に分けて書き込む
+    const csmUint32 first = writeIndex & _mask;
+    const csmUint32 head = (written < _samples.GetSize() - first) ? written : _samples.GetSize() - first;
+    for (csmUint32 i = 0; i < head; ++i)
+    {
+        _samples[first + i] = samples[i];
+    }
+    for (csmUint32 i = head; i < written; ++i)
+    {
+        _samples[i - head] = samples[i];
+    }
+
+    _sampleRate.store(sampleRate, std::memory_order_relaxed);
+    _pushedSamples.fetch_add(count, std::memory_order_relaxed);
+    _droppedSamples.fetch_add(count - written, std::memory_order_relaxed);
+    _writeIndex.store(writeIndex + written, std::memory_order_release);
+    return written;
+}
+
+void CubismAudioLipSync::SetEnvelope(csmFloat32 windowSeconds, csmFloat32 attackSeconds, csmFloat32 releaseSeconds)
+{
+    _windowSeconds = (windowSeconds > 0.0f) ? windowSeconds : DefaultWindowSeconds;
+    _attackSeconds = (attackSeconds > 0.0f) ? attackSeconds : 0.0f;
+    _releaseSeconds = (releaseSeconds > 0.0f) ? releaseSeconds : 0.0f;
+}
+
+csmFloat32 CubismAudioLipSync::Update(csmFloat32 deltaTimeSeconds)
+{
+    const csmUint32 sampleRate = _sampleRate.load(std::memory_order_relaxed);
+    if (deltaTimeSeconds <= 0.0f || sampleRate == 0)
+    {
+        return _value;
+    }
+
+    const csmUint32 writeIndex = _writeIndex.load(std::memory_order_acquire);
+    csmUint32 readIndex = _readIndex.load(std::memory_order_relaxed);
+    csmUint32 available = writeIndex - readIndex;
+
+    // 音声スレッドが先行しすぎている場合は、古いサンプルを捨てて口の動きが遅れないようにする
+    const csmUint32 maxLatency = static_cast<csmUint32>(MaxLatencySeconds * sampleRate);
+    if (available > maxLatency)
+    {
+        _skippedSamples += available - maxLatency;
+        readIndex += available - maxLatency;
+        available = maxLatency;
+    }
+
+    // 経過時間分のサンプルを取り出す
+    _pendingSamples += deltaTimeSeconds * sampleRate;
+    csmUint32 count = static_cast<csmUint32>(_pendingSamples);
+    if (count > available)
+    {
+        count = available;
+        _pendingSamples = 0.0f;
+        _underruns++;
+    }
+    else
+    {
+        _pendingSamples -= count;
+    }
+
+    // 区間より多く取り出した場合は末尾の区間だけを使う
+    const csmUint32 windowSamples = static_cast<csmUint32>(_windowSeconds * sampleRate) + 1;
+    const csmUint32 skip = (count > windowSamples) ? count - windowSamples : 0;
+    csmFloat32 sum = 0.0f;
+    for (csmUint32 i = readIndex + skip; i != readIndex + count; ++i)
+    {
+        const csmFloat32 sample = _samples[i & _mask];
+        sum += sample * sample;
+    }
+    _readIndex.store(readIndex + count, std::memory_order_release);
+
+    if (count > 0)
+    {
+        // 区間に足りない分は前回の2乗平均で補う
+        const csmUint32 used = count - skip;
+        _meanSquare = (sum + _meanSquare * (windowSamples - used)) / windowSamples;
+        _underrunSeconds = 0.0f;
+    }
+    else
+    {
+        // 途切れてもしばらくは直前の音量を保ち、それを過ぎたら無音に向けてリリースさせる
+        _underrunSeconds += deltaTimeSeconds;
+        if (_underrunSeconds > UnderrunHoldSeconds)
+        {
+            _meanSquare = 0.0f;
+        }
+    }
+
+    const csmFloat32 target = sqrtf(_meanSquare);
+    const csmFloat32 rate = SmoothingRate(deltaTimeSeconds, (target > _value) ? _attackSeconds : _releaseSeconds);
+    _value += (target - _value) * rate;
+
+    return _value;
+}
+
+csmFloat32 CubismAudioLipSync::GetValue() const
+{
+    return _value;
+}
+
+CubismAudioLipSync::Statistics CubismAudioLipSync::GetStatistics() const
+{
+    Statistics statistics;
+    statistics.PushedSamples = _pushedSamples.load(std::memory_order_relaxed);
+    statistics.DroppedSamples = _droppedSamples.load(std::memory_order_relaxed);
+    statistics.SkippedSamples = _skippedSamples;
+    statistics.Underruns = _underruns;
+    return statistics;
+}
+
+}}}
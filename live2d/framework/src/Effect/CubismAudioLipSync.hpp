@@ -0,0 +1,136 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+#pragma once
+
+#include "CubismFramework.hpp"
+#include "Type/csmVector.hpp"
+#include <atomic>
+
+namespace Live2D { namespace Cubism { namespace Framework {
+
+/**
+ * @brief 外部から与えられる音声によるリップシンク
+ *
+ * 音声スレッドが書き込むサンプルをリングバッファで受け取り、
+ * モデルの更新時に直近の区間のRMSを求めて、アタック・リリースで平滑化した値を返す。<br>
+ * Pushを呼ぶスレッドとUpdateを呼ぶスレッドがそれぞれ1つであれば、ロックなしで同時に呼び出せる。
+ */
+class CubismAudioLipSync
+{
+public:
+    /**
+     * @brief 受け取ったサンプルの状態
+     */
+    struct Statistics
+    {
+        csmUint64 PushedSamples;        ///< Pushで受け取ったサンプル数
+        csmUint64 DroppedSamples;       ///< バッファが一杯で捨てたサンプル数
+        csmUint64 SkippedSamples;       ///< 遅延が大きくなりすぎたため読み飛ばしたサンプル数
+        csmUint32 Underruns;            ///< 経過時間分のサンプルが届いていなかったフレーム数
+    };
+
+    /**
+     * @brief インスタンスの作成
+     *
+     * インスタンスを作成する。
+     *
+     * @param[in]   capacity    バッファに保持できるサンプル数。2のべき乗に切り上げる
+     */
+    static CubismAudioLipSync* Create(csmUint32 capacity = DefaultCapacity);
+
+    /**
+     * @brief インスタンスの破棄
+     *
+     * インスタンスを破棄する。
+     *
+     * @param[in]   instance    対象のCubismAudioLipSync
+     */
+    static void Delete(CubismAudioLipSync* instance);
+
+    /**
+     * @brief サンプルの追加
+     *
+     * モノラルのサンプルをバッファに追加する。音声スレッドから呼び出してよく、ブロックしない。<br>
+     * 入りきらなかったサンプルは捨てる。
+     *
+     * @param[in]   samples     -1～1の範囲のサンプル
+     * @param[in]   count       サンプル数
+     * @param[in]   sampleRate  サンプリングレート[Hz]
+     * @return  バッファに追加したサンプル数
+     */
+    csmUint32 Push(const csmFloat32* samples, csmUint32 count, csmUint32 sampleRate);
+
+    /**
+     * @brief 平滑化の設定
+     *
+     * @param[in]   windowSeconds   RMSを求める区間の長さ[秒]
+     * @param[in]   attackSeconds   値が上がるときの時定数[秒]
+     * @param[in]   releaseSeconds  値が下がるときの時定数[秒]
+     */
+    void SetEnvelope(csmFloat32 windowSeconds, csmFloat32 attackSeconds, csmFloat32 releaseSeconds);
+
+    /**
+     * @brief 値の更新
+     *
+     * 経過時間分のサンプルをバッファから取り出し、値を更新する。モデルの更新と同じスレッドから呼び出す。
+     *
+     * @param[in]   deltaTimeSeconds    デルタ時間[秒]
+     * @return  更新後の値
+     */
+    csmFloat32 Update(csmFloat32 deltaTimeSeconds);
+
+    /**
+     * @brief 現在の値を取得する。
+     */
+    csmFloat32 GetValue() const;
+
+    /**
+     * @brief 受け取ったサンプルの状態を取得する。Updateと同じスレッドから呼び出す。
+     */
+    Statistics GetStatistics() const;
+
+    static const csmUint32 DefaultCapacity = 16384;     ///< バッファの既定のサンプル数。48kHzで約0.34秒
+
+private:
+    /**
+     * @brief コンストラクタ
+     *
+     * コンストラクタ。
+     */
+    CubismAudioLipSync(csmUint32 capacity);
+
+    /**
+     * @brief デストラクタ
+     *
+     * デストラクタ。
+     */
+    virtual ~CubismAudioLipSync();
+
+    csmVector<csmFloat32> _samples;                 ///< リングバッファ。要素数は2のべき乗
+    csmUint32 _mask;                                ///< リングバッファの添字のマスク
+
+    // Pushを呼ぶスレッドだけが書き込む
+    std::atomic<csmUint32> _writeIndex;             ///< 書き込んだサンプルの総数
+    std::atomic<csmUint32> _sampleRate;             ///< 直近のPushのサンプリングレート[Hz]
+    std::atomic<csmUint64> _pushedSamples;          ///< Pushで受け取ったサンプル数
+    std::atomic<csmUint64> _droppedSamples;         ///< バッファが一杯で捨てたサンプル数
+
+    // Updateを呼ぶスレッドだけが書き込む
+    std::atomic<csmUint32> _readIndex;              ///< 読み出したサンプルの総数
+    csmFloat32 _windowSeconds;                      ///< RMSを求める区間の長さ[秒]
+    csmFloat32 _attackSeconds;                      ///< 値が上がるときの時定数[秒]
+    csmFloat32 _releaseSeconds;                     ///< 値が下がるときの時定数[秒]
+    csmFloat32 _pendingSamples;                     ///< 経過時間のうち、まだサンプルを取り出していない端数
+    csmFloat32 _meanSquare;                         ///< 直近の区間の2乗平均
+    csmFloat32 _underrunSeconds;                    ///< サンプルが届かなくなってからの時間[秒]
+    csmFloat32 _value;                              ///< 平滑化した値
+    csmUint64 _skippedSamples;                      ///< 読み飛ばしたサンプル数
+    csmUint32 _underruns;                           ///< サンプルが足りなかったフレーム数
+};
+
+}}}
@@ -39,9 +39,7 @@ const csmVector<CubismBreath::BreathParameterData>& CubismBreath::GetParameters(
 
 void CubismBreath::UpdateParameters(CubismModel* model, csmFloat32 deltaTimeSeconds)
 {
-    _currentTime += deltaTimeSeconds;
-
-    const csmFloat32 t = _currentTime * 2.0f * 3.14159f;
+    const csmFloat32 t = UpdatePhase(deltaTimeSeconds);
 
     for (csmUint32 i = 0; i < _breathParameters.GetSize(); ++i)
     {
@@ -51,4 +49,11 @@ void CubismBreath::UpdateParameters(CubismModel* model, csmFloat32 deltaTimeSeco
     }
 }
 
+csmFloat32 CubismBreath::UpdatePhase(csmFloat32 deltaTimeSeconds)
+{
+    _currentTime += deltaTimeSeconds;
+
+    return _currentTime * 2.0f * 3.14159f;
+}
+
 }}}
@@ -114,6 +114,16 @@ public:
      */
     void UpdateParameters(CubismModel* model, csmFloat32 deltaTimeSeconds);
 
+    /**
+     * @brief 呼吸の位相の更新
+     *
+     * 積算時間を進め、パラメータの正弦波に渡す位相を返す。
+     *
+     * @param[in]   deltaTimeSeconds   デルタ時間[秒]
+     * @return   位相[ラジアン]
+     */
+    csmFloat32 UpdatePhase(csmFloat32 deltaTimeSeconds);
+
 private:
     /**
      * @brief コンストラクタ
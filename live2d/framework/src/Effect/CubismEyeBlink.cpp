@@ -80,6 +80,16 @@ const csmVector<CubismIdHandle>& CubismEyeBlink::GetParameterIds() const
 }
 
 void CubismEyeBlink::UpdateParameters(CubismModel* model, csmFloat32 deltaTimeSeconds)
+{
+    const csmFloat32 parameterValue = UpdateValue(deltaTimeSeconds);
+
+    for (csmUint32 i = 0; i < _parameterIds.GetSize(); ++i)
+    {
+        model->SetParameterValue(_parameterIds[i], parameterValue);
+    }
+}
+
+csmFloat32 CubismEyeBlink::UpdateValue(csmFloat32 deltaTimeSeconds)
 {
     _userTimeSeconds += deltaTimeSeconds;
     csmFloat32 parameterValue;
@@ -150,10 +160,7 @@ void CubismEyeBlink::UpdateParameters(CubismModel* model, csmFloat32 deltaTimeSe
         parameterValue = -parameterValue;
     }
 
-    for (csmUint32 i = 0; i < _parameterIds.GetSize(); ++i)
-    {
-        model->SetParameterValue(_parameterIds[i], parameterValue);
-    }
+    return parameterValue;
 }
 
 }}}
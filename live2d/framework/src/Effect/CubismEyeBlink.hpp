@@ -106,6 +106,16 @@ public:
      */
     void            UpdateParameters(CubismModel* model, csmFloat32 deltaTimeSeconds);
 
+    /**
+     * @brief まばたきの値の更新
+     *
+     * まばたきの状態を進め、パラメータに設定する値を返す。
+     *
+     * @param[in]   deltaTimeSeconds   デルタ時間[秒]
+     * @return   パラメータに設定する値
+     */
+    csmFloat32      UpdateValue(csmFloat32 deltaTimeSeconds);
+
 private:
 
     /**
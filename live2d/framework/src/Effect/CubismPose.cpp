@@ -172,33 +172,52 @@ void CubismPose::Reset(CubismModel* model)
 
     }
 
-}
+    // 毎フレームのフェード処理で使うインデックスを詰めて保持する
+    _partIndices.Clear();
+    _parameterIndices.Clear();
+    _linkSourcePartIndices.Clear();
+    _linkPartIndices.Clear();
 
-void CubismPose::CopyPartOpacities(CubismModel* model)
-{
-    for (csmUint32 groupIndex = 0; groupIndex < _partGroups.GetSize(); ++groupIndex)
+    for (csmUint32 i = 0; i < _partGroups.GetSize(); ++i)
     {
-        PartData& partData = _partGroups[groupIndex];
+        const PartData& partData = _partGroups[i];
 
-        if (partData.Link.GetSize() == 0)
-        {
-            continue; // 連動するパラメータはない
-        }
-
-        const csmInt32    partIndex = _partGroups[groupIndex].PartIndex;
-        const csmFloat32  opacity = model->GetPartOpacity(partIndex);
+        _partIndices.PushBack(partData.PartIndex);
+        _parameterIndices.PushBack(partData.ParameterIndex);
 
         for (csmUint32 linkIndex = 0; linkIndex < partData.Link.GetSize(); ++linkIndex)
         {
-            PartData&   linkPart = partData.Link[linkIndex];
-            const csmInt32    linkPartIndex = linkPart.PartIndex;
-
-            if (linkPartIndex < 0)
+            if (partData.Link[linkIndex].PartIndex < 0)
             {
                 continue;
             }
 
-            model->SetPartOpacity(linkPartIndex, opacity);
+            _linkSourcePartIndices.PushBack(partData.PartIndex);
+            _linkPartIndices.PushBack(partData.Link[linkIndex].PartIndex);
+        }
+    }
+
+    _partOpacities.UpdateSize(_partGroups.GetSize(), 0.0f, false);
+}
+
+void CubismPose::CopyPartOpacities(CubismModel* model)
+{
+    csmFloat32* partOpacities = Core::csmGetPartOpacities(model->GetModel());
+    const csmInt32 partCount = model->GetPartCount();
+
+    for (csmUint32 i = 0; i < _linkPartIndices.GetSize(); ++i)
+    {
+        const csmInt32 sourceIndex = _linkSourcePartIndices[i];
+        const csmInt32 linkIndex = _linkPartIndices[i];
+
+        // モデルに存在しないパーツはモデル側の管理領域を経由する
+        if (sourceIndex < partCount && linkIndex < partCount)
+        {
+            partOpacities[linkIndex] = partOpacities[sourceIndex];
+        }
+        else
+        {
+            model->SetPartOpacity(linkIndex, model->GetPartOpacity(sourceIndex));
         }
     }
 }
@@ -211,13 +230,33 @@ void CubismPose::DoFade(CubismModel* model, csmFloat32 deltaTimeSeconds, csmInt3
     const csmFloat32 Phi = 0.5f;
     const csmFloat32 BackOpacityThreshold = 0.15f;
 
+    if (partGroupCount <= 0)
+    {
+        return;
+    }
+
+    csmFloat32* partOpacities = Core::csmGetPartOpacities(model->GetModel());
+    const csmFloat32* parameterValues = Core::csmGetParameterValues(model->GetModel());
+    const csmInt32 partCount = model->GetPartCount();
+    const csmInt32 parameterCount = model->GetParameterCount();
+
+    const csmInt32* partIndices = &_partIndices[beginIndex];
+    const csmInt32* parameterIndices = &_parameterIndices[beginIndex];
+    csmFloat32* opacities = &_partOpacities[beginIndex];
+
+    // グループの不透明度を作業領域に集める
+    for (csmInt32 i = 0; i < partGroupCount; ++i)
+    {
+        opacities[i] = (partIndices[i] < partCount) ? partOpacities[partIndices[i]] : model->GetPartOpacity(partIndices[i]);
+    }
+
     // 現在、表示状態になっているパーツを取得
-    for (csmInt32 i = beginIndex; i < beginIndex + partGroupCount; ++i)
+    for (csmInt32 i = 0; i < partGroupCount; ++i)
     {
-        const csmInt32 partIndex = _partGroups[i].PartIndex;
-        const csmInt32 paramIndex = _partGroups[i].ParameterIndex;
+        const csmInt32 paramIndex = parameterIndices[i];
+        const csmFloat32 value = (paramIndex < parameterCount) ? parameterValues[paramIndex] : model->GetParameterValue(paramIndex);
 
-        if (model->GetParameterValue(paramIndex) > Epsilon)
+        if (value > Epsilon)
         {
             if (visiblePartIndex >= 0)
             {
@@ -225,7 +264,7 @@ void CubismPose::DoFade(CubismModel* model, csmFloat32 deltaTimeSeconds, csmInt3
             }
 
             visiblePartIndex = i;
-            newOpacity = model->GetPartOpacity(partIndex);
+            newOpacity = opacities[i];
 
             // 新しい不透明度を計算
             newOpacity += (deltaTimeSeconds / _fadeTimeSeconds);
@@ -243,45 +282,44 @@ void CubismPose::DoFade(CubismModel* model, csmFloat32 deltaTimeSeconds, csmInt3
         newOpacity = 1.0f;
     }
 
+    // 非表示パーツの不透明度の上限はグループ内で共通
+    csmFloat32 a1;          // 計算によって求められる不透明度
+
+    if (newOpacity < Phi)
+    {
+        a1 = newOpacity * (Phi - 1) / Phi + 1.0f; // (0,1),(phi,phi)を通る直線式
+    }
+    else
+    {
+        a1 = (1 - newOpacity) * Phi / (1.0f - Phi); // (1,0),(phi,phi)を通る直線式
+    }
+
+    // 背景の見える割合を制限する場合
+    const csmFloat32 backOpacity = (1.0f - a1) * (1.0f - newOpacity);
+
+    if (backOpacity > BackOpacityThreshold)
+    {
+        a1 = 1.0f - BackOpacityThreshold / (1.0f - newOpacity);
+    }
+
     //  表示パーツ、非表示パーツの不透明度を設定する
-    for (csmInt32 i = beginIndex; i < beginIndex + partGroupCount; ++i)
+    for (csmInt32 i = 0; i < partGroupCount; ++i)
     {
-        const csmInt32 partsIndex = _partGroups[i].PartIndex;
+        // 計算の不透明度よりも大きければ（濃ければ）不透明度を上げる
+        opacities[i] = (opacities[i] > a1) ? a1 : opacities[i];
+    }
+    opacities[visiblePartIndex] = newOpacity;
 
-        //  表示パーツの設定
-        if (visiblePartIndex == i)
+    // 作業領域からモデルへ書き戻す
+    for (csmInt32 i = 0; i < partGroupCount; ++i)
+    {
+        if (partIndices[i] < partCount)
         {
-            model->SetPartOpacity(partsIndex, newOpacity); // 先に設定
+            partOpacities[partIndices[i]] = opacities[i];
         }
-        // 非表示パーツの設定
         else
         {
-            csmFloat32 opacity = model->GetPartOpacity(partsIndex);
-            csmFloat32 a1;          // 計算によって求められる不透明度
-
-            if (newOpacity < Phi)
-            {
-                a1 = newOpacity * (Phi - 1) / Phi + 1.0f; // (0,1),(phi,phi)を通る直線式
-            }
-            else
-            {
-                a1 = (1 - newOpacity) * Phi / (1.0f - Phi); // (1,0),(phi,phi)を通る直線式
-            }
-
-            // 背景の見える割合を制限する場合
-            const csmFloat32 backOpacity = (1.0f - a1) * (1.0f - newOpacity);
-
-            if (backOpacity > BackOpacityThreshold)
-            {
-                a1 = 1.0f - BackOpacityThreshold / (1.0f - newOpacity);
-            }
-
-            if (opacity > a1)
-            {
-                opacity = a1; // 計算の不透明度よりも大きければ（濃ければ）不透明度を上げる
-            }
-
-            model->SetPartOpacity(partsIndex, opacity);
+            model->SetPartOpacity(partIndices[i], opacities[i]);
         }
     }
 }
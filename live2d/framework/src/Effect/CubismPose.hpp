@@ -148,6 +148,11 @@ private:
 
     csmVector<PartData>             _partGroups;                ///< パーツグループ
     csmVector<csmInt32>             _partGroupCounts;           ///< それぞれのパーツグループの個数
+    csmVector<csmInt32>             _partIndices;               ///< _partGroupsと同じ並びのパーツのインデックス(Resetで解決)
+    csmVector<csmInt32>             _parameterIndices;          ///< _partGroupsと同じ並びのパラメータのインデックス(Resetで解決)
+    csmVector<csmFloat32>           _partOpacities;             ///< フェード計算用の不透明度の作業領域
+    csmVector<csmInt32>             _linkSourcePartIndices;     ///< 連動元のパーツのインデックス
+    csmVector<csmInt32>             _linkPartIndices;           ///< 連動先のパーツのインデックス
     csmFloat32                      _fadeTimeSeconds;           ///< フェード時間[秒]
     CubismModel*                    _lastModel;                 ///< 前回操作したモデル
 };
@@ -64,5 +64,18 @@ public:
      */
     virtual void DeallocateAligned(void* alignedMemory) = 0;
 
+    /**
+     * @brief モデルをまたいで共有されるオブジェクトの確保を開始します。
+     *
+     * モデルごとの領域から確保するアロケータは、EndSharedAllocationまでは共有の領域から確保してください。
+     * 呼び出しは入れ子になることがあります。
+     */
+    virtual void BeginSharedAllocation() {}
+
+    /**
+     * @brief BeginSharedAllocationで開始した共有の確保を終了します。
+     */
+    virtual void EndSharedAllocation() {}
+
 };
 }}}
@@ -65,6 +65,8 @@ const CubismId* CubismIdManager::RegisterId(const csmChar* id)
         return result;
     }
 
+    // IDは全てのモデルで共有するので、モデルごとの領域からは確保しない
+    CubismSharedAllocationScope sharedAllocation;
     result = CSM_NEW CubismId(id);
     _ids.PushBack(result);
 
@@ -6,9 +6,152 @@
  */
 
 #include "CubismMath.hpp"
+#include <float.h>
+#include "Utils/CubismDebug.hpp"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define CSM_BOUNDS_USE_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CSM_BOUNDS_USE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define CSM_BOUNDS_USE_NEON
+#endif
 
 namespace Live2D {namespace Cubism {namespace Framework {
 
+namespace {
+
+// スカラー実装。SIMD実装の端数処理と、デバッグ時の検証に使う
+void CalculateBoundsScalar(const csmFloat32* vertices, csmInt32 vertexCount,
+                           csmFloat32& minX, csmFloat32& minY, csmFloat32& maxX, csmFloat32& maxY)
+{
+    for (csmInt32 i = 0; i < vertexCount; ++i)
+    {
+        const csmFloat32 x = vertices[i * 2];
+        const csmFloat32 y = vertices[i * 2 + 1];
+        if (x < minX) minX = x;
+        if (x > maxX) maxX = x;
+        if (y < minY) minY = y;
+        if (y > maxY) maxY = y;
+    }
+}
+
+#if defined(CSM_BOUNDS_USE_SSE2) || defined(CSM_BOUNDS_USE_AVX)
+// レーンの並びは (x, y, x, y)。min/maxは第2引数にアキュムレータを渡すことで、
+// NaNが来たときにアキュムレータ側が残り、スカラー実装の比較と同じ結果になる
+void ReduceBounds(__m128 minXY, __m128 maxXY,
+                  csmFloat32& minX, csmFloat32& minY, csmFloat32& maxX, csmFloat32& maxY)
+{
+    minXY = _mm_min_ps(_mm_movehl_ps(minXY, minXY), minXY);
+    maxXY = _mm_max_ps(_mm_movehl_ps(maxXY, maxXY), maxXY);
+
+    csmFloat32 lanes[4];
+    _mm_storeu_ps(lanes, minXY);
+    if (lanes[0] < minX) minX = lanes[0];
+    if (lanes[1] < minY) minY = lanes[1];
+    _mm_storeu_ps(lanes, maxXY);
+    if (lanes[0] > maxX) maxX = lanes[0];
+    if (lanes[1] > maxY) maxY = lanes[1];
+}
+#endif
+
+#if defined(CSM_BOUNDS_USE_AVX)
+csmInt32 CalculateBoundsSimd(const csmFloat32* vertices, csmInt32 vertexCount,
+                             csmFloat32& minX, csmFloat32& minY, csmFloat32& maxX, csmFloat32& maxY)
+{
+    __m256 min0 = _mm256_set1_ps(FLT_MAX), min1 = min0;
+    __m256 max0 = _mm256_set1_ps(-FLT_MAX), max1 = max0;
+
+    // 1回のループで8頂点（16要素）を処理する
+    csmInt32 i = 0;
+    for (; i + 8 <= vertexCount; i += 8)
+    {
+        const __m256 v0 = _mm256_loadu_ps(vertices + i * 2);
+        const __m256 v1 = _mm256_loadu_ps(vertices + i * 2 + 8);
+        min0 = _mm256_min_ps(v0, min0);
+        max0 = _mm256_max_ps(v0, max0);
+        min1 = _mm256_min_ps(v1, min1);
+        max1 = _mm256_max_ps(v1, max1);
+    }
+    if (i + 4 <= vertexCount)
+    {
+        const __m256 v0 = _mm256_loadu_ps(vertices + i * 2);
+        min0 = _mm256_min_ps(v0, min0);
+        max0 = _mm256_max_ps(v0, max0);
+        i += 4;
+    }
+
+    min0 = _mm256_min_ps(min1, min0);
+    max0 = _mm256_max_ps(max1, max0);
+    ReduceBounds(_mm_min_ps(_mm256_extractf128_ps(min0, 1), _mm256_castps256_ps128(min0)),
+                 _mm_max_ps(_mm256_extractf128_ps(max0, 1), _mm256_castps256_ps128(max0)),
+                 minX, minY, maxX, maxY);
+    return i;
+}
+#elif defined(CSM_BOUNDS_USE_SSE2)
+csmInt32 CalculateBoundsSimd(const csmFloat32* vertices, csmInt32 vertexCount,
+                             csmFloat32& minX, csmFloat32& minY, csmFloat32& maxX, csmFloat32& maxY)
+{
+    __m128 min0 = _mm_set1_ps(FLT_MAX), min1 = min0;
+    __m128 max0 = _mm_set1_ps(-FLT_MAX), max1 = max0;
+
+    // 1回のループで4頂点（8要素）を処理する
+    csmInt32 i = 0;
+    for (; i + 4 <= vertexCount; i += 4)
+    {
+        const __m128 v0 = _mm_loadu_ps(vertices + i * 2);
+        const __m128 v1 = _mm_loadu_ps(vertices + i * 2 + 4);
+        min0 = _mm_min_ps(v0, min0);
+        max0 = _mm_max_ps(v0, max0);
+        min1 = _mm_min_ps(v1, min1);
+        max1 = _mm_max_ps(v1, max1);
+    }
+
+    ReduceBounds(_mm_min_ps(min1, min0), _mm_max_ps(max1, max0), minX, minY, maxX, maxY);
+    return i;
+}
+#elif defined(CSM_BOUNDS_USE_NEON)
+csmInt32 CalculateBoundsSimd(const csmFloat32* vertices, csmInt32 vertexCount,
+                             csmFloat32& minX, csmFloat32& minY, csmFloat32& maxX, csmFloat32& maxY)
+{
+    float32x4_t minXY = vdupq_n_f32(FLT_MAX);
+    float32x4_t maxXY = vdupq_n_f32(-FLT_MAX);
+
+    // vminq_f32はNaNを伝播するため、比較と選択でスカラー実装と同じ結果にする
+    csmInt32 i = 0;
+    for (; i + 2 <= vertexCount; i += 2)
+    {
+        const float32x4_t v = vld1q_f32(vertices + i * 2);
+        minXY = vbslq_f32(vcltq_f32(v, minXY), v, minXY);
+        maxXY = vbslq_f32(vcgtq_f32(v, maxXY), v, maxXY);
+    }
+
+    csmFloat32 lanes[4];
+    vst1q_f32(lanes, minXY);
+    if (lanes[0] < minX) minX = lanes[0];
+    if (lanes[1] < minY) minY = lanes[1];
+    if (lanes[2] < minX) minX = lanes[2];
+    if (lanes[3] < minY) minY = lanes[3];
+    vst1q_f32(lanes, maxXY);
+    if (lanes[0] > maxX) maxX = lanes[0];
+    if (lanes[1] > maxY) maxY = lanes[1];
+    if (lanes[2] > maxX) maxX = lanes[2];
+    if (lanes[3] > maxY) maxY = lanes[3];
+    return i;
+}
+#else
+csmInt32 CalculateBoundsSimd(const csmFloat32*, csmInt32,
+                             csmFloat32&, csmFloat32&, csmFloat32&, csmFloat32&)
+{
+    return 0;
+}
+#endif
+
+}
+
 const csmFloat32 CubismMath::Pi = 3.1415926535897932384626433832795f;
 const csmFloat32 CubismMath::Epsilon = 0.00001f;
 
@@ -161,4 +304,30 @@ csmFloat32 CubismMath::CardanoAlgorithmForBezier(csmFloat32 a, csmFloat32 b, csm
     return RangeF(root1, 0.0f, 1.0f);
 }
 
+csmBool CubismMath::CalculateBounds(const csmFloat32* vertices, csmInt32 vertexCount,
+                                    csmFloat32& minX, csmFloat32& minY, csmFloat32& maxX, csmFloat32& maxY)
+{
+    minX = FLT_MAX;
+    minY = FLT_MAX;
+    maxX = -FLT_MAX;
+    maxY = -FLT_MAX;
+
+    if (vertices == NULL || vertexCount <= 0)
+    {
+        return false;
+    }
+
+    // SIMDで処理しきれなかった端数の頂点はスカラーで処理する
+    const csmInt32 processed = CalculateBoundsSimd(vertices, vertexCount, minX, minY, maxX, maxY);
+    CalculateBoundsScalar(vertices + processed * 2, vertexCount - processed, minX, minY, maxX, maxY);
+
+#if defined(CSM_DEBUG)
+    csmFloat32 refMinX = FLT_MAX, refMinY = FLT_MAX, refMaxX = -FLT_MAX, refMaxY = -FLT_MAX;
+    CalculateBoundsScalar(vertices, vertexCount, refMinX, refMinY, refMaxX, refMaxY);
+    CSM_ASSERT(minX == refMinX && minY == refMinY && maxX == refMaxX && maxY == refMaxY);
+#endif
+
+    return minX != FLT_MAX;
+}
+
 }}}
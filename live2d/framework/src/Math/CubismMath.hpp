@@ -189,6 +189,23 @@ public:
     */
     static csmFloat32 CardanoAlgorithmForBezier(csmFloat32 a, csmFloat32 b, csmFloat32 c, csmFloat32 d);
 
+    /**
+    * @brief   xyが交互に並んだ頂点配列を囲む矩形（AABB）を求める。
+    *          ビルド対象がサポートしていればSSE2 / AVX / NEONで計算し、
+    *          結果はスカラー実装と完全に一致する。NaNの座標は無視される。
+    *
+    * @param   vertices    -> 頂点配列（x0, y0, x1, y1, ...）
+    * @param   vertexCount -> 頂点数
+    * @param   minX        -> X座標の最小値の格納先
+    * @param   minY        -> Y座標の最小値の格納先
+    * @param   maxX        -> X座標の最大値の格納先
+    * @param   maxY        -> Y座標の最大値の格納先
+    * @return  true    ->  有効な頂点が1つ以上あった
+    *          false   ->  有効な頂点がない（各値はFLT_MAX / -FLT_MAXのまま）
+    */
+    static csmBool CalculateBounds(const csmFloat32* vertices, csmInt32 vertexCount,
+                                   csmFloat32& minX, csmFloat32& minY, csmFloat32& maxX, csmFloat32& maxY);
+
 private:
     /**
      *@brief    privateコンストラクタ
@@ -69,11 +69,12 @@ void CubismModel::MultiplyParameterValue(csmInt32 parameterIndex, csmFloat32 val
 
 void CubismModel::Update() const
 {
-    // Update model.
-    Core::csmUpdateModel(_model);
-
     // Reset dynamic drawable flags.
+    // 更新の後にリセットするとDidChangeのフラグが常に落ちた状態になり、描画やヒットテストで変化を判定できない
     Core::csmResetDrawableDynamicFlags(_model);
+
+    // Update model.
+    Core::csmUpdateModel(_model);
 }
 
 void CubismModel::SetPartOpacity(CubismIdHandle partId, csmFloat32 opacity)
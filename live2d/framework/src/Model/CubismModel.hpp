@@ -60,6 +60,7 @@ public:
      * @brief モデルのパラメータの更新
      *
      * モデルのパラメータを更新する。
+     * Drawableの変化のフラグ(DidChange)は、この更新で前回の更新から変化したものを表す。
      */
     void    Update() const;
 
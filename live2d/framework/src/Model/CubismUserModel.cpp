@@ -8,6 +8,7 @@
 #include "CubismUserModel.hpp"
 #include "Motion/CubismMotion.hpp"
 #include "Physics/CubismPhysics.hpp"
+#include "Math/CubismMath.hpp"
 
 namespace Live2D { namespace Cubism { namespace Framework {
 
@@ -130,35 +131,10 @@ csmBool CubismUserModel::IsHit(CubismIdHandle drawableId, csmFloat32 pointX, csm
     const csmInt32    count = _model->GetDrawableVertexCount(drawIndex);
     const csmFloat32* vertices = _model->GetDrawableVertices(drawIndex);
 
-    csmFloat32 left = vertices[0];
-    csmFloat32 right = vertices[0];
-    csmFloat32 top = vertices[1];
-    csmFloat32 bottom = vertices[1];
-
-    for (csmInt32 j = 1; j < count; ++j)
+    csmFloat32 left, top, right, bottom;
+    if (!CubismMath::CalculateBounds(vertices, count, left, top, right, bottom))
     {
-        csmFloat32 x = vertices[Constant::VertexOffset + j * Constant::VertexStep];
-        csmFloat32 y = vertices[Constant::VertexOffset + j * Constant::VertexStep + 1];
-
-        if (x < left)
-        {
-            left = x; // Min x
-        }
-
-        if (x > right)
-        {
-            right = x; // Max x
-        }
-
-        if (y < top)
-        {
-            top = y; // Min y
-        }
-
-        if (y > bottom)
-        {
-            bottom = y; // Max y
-        }
+        return false; // 有効な頂点がない場合はfalse
     }
 
     const csmFloat32 tx = _modelMatrix->InvertTransformX(pointX);
@@ -12,6 +12,7 @@
 #include "Utils/CubismString.hpp"
 #include "Math/CubismMath.hpp"
 #include "Math/CubismVector2.hpp"
+#include <chrono>
 
 namespace Live2D { namespace Cubism { namespace Framework {
 
@@ -35,6 +36,26 @@ const csmFloat32 MovementThreshold = 0.001f;
 /// Constant of maximum allowed delta time
 const csmFloat32 MaxDeltaTime = 5.0f;
 
+/// Constant of fixed step used by Stabilize when physics3.json has no FPS.
+const csmFloat32 StabilizationDeltaTime = 1.0f / 30.0f;
+
+/// Constant of minimum substep rate scale of level of detail.
+const csmFloat32 MinimumSubstepRateScale = 0.25f;
+
+/// Constant of maximum sub-rig weight skipped by SetQuality.
+const csmFloat32 MaximumSkippedSubRigWeight = 0.5f;
+
+/// Constant of maximum substeps carried over to the next frame when the frame budget runs out.
+const csmFloat32 MaximumCarriedSubsteps = 4.0f;
+
+/// Gets a monotonic timestamp for the frame budget.
+///
+/// @return  Time in microseconds.
+double GetTimestampMicroseconds()
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 csmFloat32 GetRangeValue(csmFloat32 min, csmFloat32 max)
 {
     csmFloat32 maxValue = CubismMath::Max(min, max);
@@ -392,8 +413,16 @@ void UpdateOutputParameterValue(csmFloat32* parameterValue, csmFloat32 parameter
 
 }
 
+csmFloat32 CubismPhysics::s_frameBudgetMicroseconds = 0.0f;
+csmFloat32 CubismPhysics::s_frameElapsedMicroseconds = 0.0f;
+csmFloat32 CubismPhysics::s_frameWeight = 0.0f;
+csmFloat32 CubismPhysics::s_previousFrameWeight = 0.0f;
+
 CubismPhysics::CubismPhysics()
     : _physicsRig(NULL)
+    , _isParameterIndicesResolved(false)
+    , _averageSubstepMicroseconds(0.0f)
+    , _budgetCredit(0.0f)
 {
     // set default options.
     _options.Gravity.Y = -1.0f;
@@ -402,6 +431,9 @@ CubismPhysics::CubismPhysics()
     _options.Wind.Y = 0;
     _currentRemainTime = 0.0f;
     _parameterCache = csmVector<csmFloat32>(0);
+    _levelOfDetail.SubstepRateScale = 1.0f;
+    _levelOfDetail.MinimumSubRigWeight = 0.0f;
+    _levelOfDetail.InterpolateOnly = false;
 }
 
 CubismPhysics::~CubismPhysics()
@@ -558,6 +590,7 @@ void CubismPhysics::Parse(const csmByte* physicsJson, csmSizeInt size)
         // Output
         _physicsRig->Settings[i].OutputCount = json->GetOutputCount(i);
         _physicsRig->Settings[i].BaseOutputIndex = outputIndex;
+        _physicsRig->Settings[i].Weight = 0.0f;
 
         PhysicsOutput currentRigOutput;
         currentRigOutput.output.Resize(_physicsRig->Settings[i].OutputCount);
@@ -596,6 +629,8 @@ void CubismPhysics::Parse(const csmByte* physicsJson, csmSizeInt size)
             }
 
             _physicsRig->Outputs[outputIndex + j].Reflect = json->GetOutputReflect(i, j);
+
+            _physicsRig->Settings[i].Weight = CubismMath::Max(_physicsRig->Settings[i].Weight, _physicsRig->Outputs[outputIndex + j].Weight / MaximumWeight);
         }
         outputIndex += _physicsRig->Settings[i].OutputCount;
 
@@ -658,6 +693,86 @@ void CubismPhysics::Parse(const csmByte* physicsJson, csmSizeInt size)
 /// @param model
 /// @param deltaTimeSeconds  rendering delta time.
 void CubismPhysics::Evaluate(CubismModel* model, csmFloat32 deltaTimeSeconds)
+{
+    if (0.0f >= deltaTimeSeconds)
+    {
+        return;
+    }
+
+    csmFloat32 physicsDeltaTime;
+    _currentRemainTime += deltaTimeSeconds;
+    if (_currentRemainTime > MaxDeltaTime)
+    {
+        _currentRemainTime = 0.0f;
+    }
+
+    if (!_isParameterIndicesResolved)
+    {
+        ResolveParameterIndices(model);
+    }
+
+    if (_physicsRig->Fps > 0.0f)
+    {
+        physicsDeltaTime = 1.0f / (_physicsRig->Fps * _levelOfDetail.SubstepRateScale);
+    }
+    else
+    {
+        physicsDeltaTime = deltaTimeSeconds;
+    }
+
+    // LODにより振り子を進めない場合は、溜まった時間を捨てて補間のみ行う
+    if (_levelOfDetail.InterpolateOnly)
+    {
+        _currentRemainTime = fmodf(_currentRemainTime, physicsDeltaTime);
+    }
+    else if (s_frameBudgetMicroseconds > 0.0f)
+    {
+        // 予算を前のフレームの詳細度の比で分ける。初めてのフレームは残りの予算をすべて使える
+        // 取り分は1サブステップ分に届くまで貯められるので、取り分が小さいモデルも数フレームごとに進む
+        s_frameWeight += _levelOfDetail.SubstepRateScale;
+        const csmFloat32 share = (s_previousFrameWeight > 0.0f)
+                                     ? s_frameBudgetMicroseconds * _levelOfDetail.SubstepRateScale / s_previousFrameWeight
+                                     : s_frameBudgetMicroseconds - s_frameElapsedMicroseconds;
+        _budgetCredit = CubismMath::Min(_budgetCredit + CubismMath::Max(share, 0.0f),
+                                        CubismMath::Max(s_frameBudgetMicroseconds, _averageSubstepMicroseconds));
+    }
+
+    while (_currentRemainTime >= physicsDeltaTime)
+    {
+        if (s_frameBudgetMicroseconds <= 0.0f)
+        {
+            UpdateStep(model, physicsDeltaTime, _levelOfDetail.MinimumSubRigWeight);
+            _currentRemainTime -= physicsDeltaTime;
+            continue;
+        }
+
+        // 取り分に収まらないサブステップは次のフレームへ持ち越す。溜まりすぎた分は捨てる
+        if (_budgetCredit < _averageSubstepMicroseconds)
+        {
+            _currentRemainTime = CubismMath::Min(_currentRemainTime, physicsDeltaTime * MaximumCarriedSubsteps);
+            break;
+        }
+
+        const double substepBeginTime = GetTimestampMicroseconds();
+
+        UpdateStep(model, physicsDeltaTime, _levelOfDetail.MinimumSubRigWeight);
+
+        _currentRemainTime -= physicsDeltaTime;
+
+        const csmFloat32 substepTime = static_cast<csmFloat32>(GetTimestampMicroseconds() - substepBeginTime);
+        s_frameElapsedMicroseconds += substepTime;
+        _budgetCredit -= substepTime;
+        _averageSubstepMicroseconds = (_averageSubstepMicroseconds > 0.0f)
+                                          ? _averageSubstepMicroseconds * 0.9f + substepTime * 0.1f
+                                          : substepTime;
+    }
+
+    // 持ち越した時間がある間は最新の結果を表示する
+    const float alpha = CubismMath::Min(_currentRemainTime / physicsDeltaTime, 1.0f);
+    Interpolate(model, alpha);
+}
+
+void CubismPhysics::UpdateStep(CubismModel* model, csmFloat32 physicsDeltaTime, csmFloat32 minimumSubRigWeight)
 {
     csmFloat32 totalAngle;
     csmFloat32 weight;
@@ -670,155 +785,171 @@ void CubismPhysics::Evaluate(CubismModel* model, csmFloat32 deltaTimeSeconds)
     CubismPhysicsOutput* currentOutput;
     CubismPhysicsParticle* currentParticles;
 
-    if (0.0f >= deltaTimeSeconds)
-    {
-        return;
-    }
-
     csmFloat32* parameterValue;
     const csmFloat32* parameterMaximumValue;
     const csmFloat32* parameterMinimumValue;
     const csmFloat32* parameterDefaultValue;
 
-    csmFloat32 physicsDeltaTime;
-    _currentRemainTime += deltaTimeSeconds;
-    if (_currentRemainTime > MaxDeltaTime)
-    {
-        _currentRemainTime = 0.0f;
-    }
-
     parameterValue = Core::csmGetParameterValues(model->GetModel());
     parameterMaximumValue = Core::csmGetParameterMaximumValues(model->GetModel());
     parameterMinimumValue = Core::csmGetParameterMinimumValues(model->GetModel());
     parameterDefaultValue = Core::csmGetParameterDefaultValues(model->GetModel());
 
-    if (_parameterCache.GetSize() < model->GetParameterCount())
+    // copyRigOutputs _currentRigOutputs to _previousRigOutputs
+    for (settingIndex = 0; settingIndex < _physicsRig->SubRigCount; ++settingIndex)
     {
-        _parameterCache.Resize(model->GetParameterCount());
+        currentSetting = &_physicsRig->Settings[settingIndex];
+        currentOutput = &_physicsRig->Outputs[currentSetting->BaseOutputIndex];
+        for (i = 0; i < currentSetting->OutputCount; ++i)
+        {
+            _previousRigOutputs[settingIndex].output[i] = _currentRigOutputs[settingIndex].output[i];
+        }
     }
 
-    if (_physicsRig->Fps > 0.0f)
+    // copy parameter model to cache (物理演算が参照するパラメータのみ)
+    for (csmUint32 j = 0; j < _parameterCacheIndices.GetSize(); ++j)
     {
-        physicsDeltaTime = 1.0f / _physicsRig->Fps;
-    }
-    else
-    {
-        physicsDeltaTime = deltaTimeSeconds;
+        _parameterCache[_parameterCacheIndices[j]] = parameterValue[_parameterCacheIndices[j]];
     }
 
-    while (_currentRemainTime >= physicsDeltaTime)
+    for (settingIndex = 0; settingIndex < _physicsRig->SubRigCount; ++settingIndex)
     {
-        // copyRigOutputs _currentRigOutputs to _previousRigOutputs
-        for (settingIndex = 0; settingIndex < _physicsRig->SubRigCount; ++settingIndex)
+        totalAngle = 0.0f;
+        totalTranslation.X = 0.0f;
+        totalTranslation.Y = 0.0f;
+        currentSetting = &_physicsRig->Settings[settingIndex];
+
+        // 重みの小さいサブリグは前回の出力のまま据え置く
+        if (currentSetting->Weight < minimumSubRigWeight)
         {
-            currentSetting = &_physicsRig->Settings[settingIndex];
-            currentOutput = &_physicsRig->Outputs[currentSetting->BaseOutputIndex];
-            for (i = 0; i < currentSetting->OutputCount; ++i)
-            {
-                _previousRigOutputs[settingIndex].output[i] = _currentRigOutputs[settingIndex].output[i];
-            }
+            continue;
         }
 
-        // copy parameter model to cache
-        for (csmInt32 j = 0; j < model->GetParameterCount(); ++j)
+        currentInput = &_physicsRig->Inputs[currentSetting->BaseInputIndex];
+        currentOutput = &_physicsRig->Outputs[currentSetting->BaseOutputIndex];
+        currentParticles = &_physicsRig->Particles[currentSetting->BaseParticleIndex];
+
+        // Load input parameters.
+        for (i = 0; i < currentSetting->InputCount; ++i)
         {
-            _parameterCache[j] = parameterValue[j];
+            weight = currentInput[i].Weight / MaximumWeight;
+
+            currentInput[i].GetNormalizedParameterValue(
+                &totalTranslation,
+                &totalAngle,
+                _parameterCache[currentInput[i].SourceParameterIndex],
+                parameterMinimumValue[currentInput[i].SourceParameterIndex],
+                parameterMaximumValue[currentInput[i].SourceParameterIndex],
+                parameterDefaultValue[currentInput[i].SourceParameterIndex],
+                &currentSetting->NormalizationPosition,
+                &currentSetting->NormalizationAngle,
+                currentInput[i].Reflect,
+                weight
+            );
         }
 
-        for (settingIndex = 0; settingIndex < _physicsRig->SubRigCount; ++settingIndex)
+        radAngle = CubismMath::DegreesToRadian(-totalAngle);
+
+        totalTranslation.X = (totalTranslation.X * CubismMath::CosF(radAngle) - totalTranslation.Y * CubismMath::SinF(radAngle));
+        totalTranslation.Y = (totalTranslation.X * CubismMath::SinF(radAngle) + totalTranslation.Y * CubismMath::CosF(radAngle));
+
+        // Calculate particles position.
+        UpdateParticles(
+            currentParticles,
+            currentSetting->ParticleCount,
+            totalTranslation,
+            totalAngle,
+            _options.Wind,
+            MovementThreshold * currentSetting->NormalizationPosition.Maximum,
+            physicsDeltaTime,
+            AirResistance
+        );
+
+        // Update output parameters.
+        for (i = 0; i < currentSetting->OutputCount; ++i)
         {
-            totalAngle = 0.0f;
-            totalTranslation.X = 0.0f;
-            totalTranslation.Y = 0.0f;
-            currentSetting = &_physicsRig->Settings[settingIndex];
-            currentInput = &_physicsRig->Inputs[currentSetting->BaseInputIndex];
-            currentOutput = &_physicsRig->Outputs[currentSetting->BaseOutputIndex];
-            currentParticles = &_physicsRig->Particles[currentSetting->BaseParticleIndex];
-
-            // Load input parameters.
-            for (i = 0; i < currentSetting->InputCount; ++i)
+            particleIndex = currentOutput[i].VertexIndex;
+
+            if (particleIndex < 1 || particleIndex >= currentSetting->ParticleCount)
             {
-                weight = currentInput[i].Weight / MaximumWeight;
-
-                if (currentInput[i].SourceParameterIndex == -1)
-                {
-                    currentInput[i].SourceParameterIndex = model->GetParameterIndex(currentInput[i].Source.Id);
-                }
-
-                currentInput[i].GetNormalizedParameterValue(
-                    &totalTranslation,
-                    &totalAngle,
-                    _parameterCache[currentInput[i].SourceParameterIndex],
-                    parameterMinimumValue[currentInput[i].SourceParameterIndex],
-                    parameterMaximumValue[currentInput[i].SourceParameterIndex],
-                    parameterDefaultValue[currentInput[i].SourceParameterIndex],
-                    &currentSetting->NormalizationPosition,
-                    &currentSetting->NormalizationAngle,
-                    currentInput[i].Reflect,
-                    weight
-                );
+                break;
             }
 
-            radAngle = CubismMath::DegreesToRadian(-totalAngle);
-
-            totalTranslation.X = (totalTranslation.X * CubismMath::CosF(radAngle) - totalTranslation.Y * CubismMath::SinF(radAngle));
-            totalTranslation.Y = (totalTranslation.X * CubismMath::SinF(radAngle) + totalTranslation.Y * CubismMath::CosF(radAngle));
+            CubismVector2 translation;
+            translation.X = currentParticles[particleIndex].Position.X - currentParticles[particleIndex - 1].Position.X;
+            translation.Y = currentParticles[particleIndex].Position.Y - currentParticles[particleIndex - 1].Position.Y;
 
-            // Calculate particles position.
-            UpdateParticles(
+            outputValue = currentOutput[i].GetValue(
+                translation,
                 currentParticles,
-                currentSetting->ParticleCount,
-                totalTranslation,
-                totalAngle,
-                _options.Wind,
-                MovementThreshold * currentSetting->NormalizationPosition.Maximum,
-                physicsDeltaTime,
-                AirResistance
+                particleIndex,
+                currentOutput[i].Reflect,
+                _options.Gravity
             );
 
-            // Update output parameters.
-            for (i = 0; i < currentSetting->OutputCount; ++i)
+            _currentRigOutputs[settingIndex].output[i] = outputValue;
+
+            UpdateOutputParameterValue(
+                    &_parameterCache[currentOutput[i].DestinationParameterIndex],
+                    parameterMinimumValue[currentOutput[i].DestinationParameterIndex],
+                    parameterMaximumValue[currentOutput[i].DestinationParameterIndex],
+                    outputValue,
+                    &currentOutput[i]);
+        }
+    }
+}
+
+void CubismPhysics::ResolveParameterIndices(CubismModel* model)
+{
+    csmInt32 i, settingIndex;
+    CubismPhysicsSubRig* currentSetting;
+    CubismPhysicsInput* currentInput;
+    CubismPhysicsOutput* currentOutput;
+    const csmInt32 parameterCount = model->GetParameterCount();
+
+    // インデックスの重複を除くためのフラグ
+    csmVector<csmBool> isCached;
+    isCached.UpdateSize(parameterCount, false, false);
+
+    _parameterCacheIndices.Clear();
+
+    for (settingIndex = 0; settingIndex < _physicsRig->SubRigCount; ++settingIndex)
+    {
+        currentSetting = &_physicsRig->Settings[settingIndex];
+        currentInput = &_physicsRig->Inputs[currentSetting->BaseInputIndex];
+        currentOutput = &_physicsRig->Outputs[currentSetting->BaseOutputIndex];
+
+        for (i = 0; i < currentSetting->InputCount; ++i)
+        {
+            const csmInt32 index = model->GetParameterIndex(currentInput[i].Source.Id);
+            currentInput[i].SourceParameterIndex = index;
+
+            if (index < parameterCount && !isCached[index])
             {
-                particleIndex = currentOutput[i].VertexIndex;
-
-                if (particleIndex < 1 || particleIndex >= currentSetting->ParticleCount)
-                {
-                    break;
-                }
-
-                if (currentOutput[i].DestinationParameterIndex == -1)
-                {
-                    currentOutput[i].DestinationParameterIndex = model->GetParameterIndex(currentOutput[i].Destination.Id);
-                }
-
-                CubismVector2 translation;
-                translation.X = currentParticles[particleIndex].Position.X - currentParticles[particleIndex - 1].Position.X;
-                translation.Y = currentParticles[particleIndex].Position.Y - currentParticles[particleIndex - 1].Position.Y;
-
-                outputValue = currentOutput[i].GetValue(
-                    translation,
-                    currentParticles,
-                    particleIndex,
-                    currentOutput[i].Reflect,
-                    _options.Gravity
-                );
-
-                _currentRigOutputs[settingIndex].output[i] = outputValue;
-
-                UpdateOutputParameterValue(
-                        &_parameterCache[currentOutput[i].DestinationParameterIndex],
-                        parameterMinimumValue[currentOutput[i].DestinationParameterIndex],
-                        parameterMaximumValue[currentOutput[i].DestinationParameterIndex],
-                        outputValue,
-                        &currentOutput[i]);
+                isCached[index] = true;
+                _parameterCacheIndices.PushBack(index);
             }
         }
 
-        _currentRemainTime -= physicsDeltaTime;
+        for (i = 0; i < currentSetting->OutputCount; ++i)
+        {
+            const csmInt32 index = model->GetParameterIndex(currentOutput[i].Destination.Id);
+            currentOutput[i].DestinationParameterIndex = index;
+
+            if (index < parameterCount && !isCached[index])
+            {
+                isCached[index] = true;
+                _parameterCacheIndices.PushBack(index);
+            }
+        }
     }
 
-    const float alpha = _currentRemainTime / physicsDeltaTime;
-    Interpolate(model, alpha);
+    if (_parameterCache.GetSize() < static_cast<csmUint32>(parameterCount))
+    {
+        _parameterCache.Resize(parameterCount);
+    }
+
+    _isParameterIndicesResolved = true;
 }
 
 void CubismPhysics::Interpolate(CubismModel* model, csmFloat32 weight)
@@ -863,4 +994,117 @@ const CubismPhysics::Options& CubismPhysics::GetOptions() const
     return _options;
 }
 
+void CubismPhysics::SaveState(State& state) const
+{
+    state.Particles = _physicsRig->Particles;
+    state.CurrentRigOutputs = _currentRigOutputs;
+    state.PreviousRigOutputs = _previousRigOutputs;
+    state.CurrentRemainTime = _currentRemainTime;
+}
+
+csmBool CubismPhysics::RestoreState(const State& state)
+{
+    // 別のリグから保存された状態は適用しない。物理点は1つの配列で、サブリグごとの区切りはリグが持つ
+    // 出力はサブリグごとの配列なので、それぞれの数まで一致しなければUpdateStep/Interpolateが範囲外を読む
+    csmBool isMatched = state.Particles.GetSize() == _physicsRig->Particles.GetSize()
+                        && state.CurrentRigOutputs.GetSize() == _currentRigOutputs.GetSize()
+                        && state.PreviousRigOutputs.GetSize() == _previousRigOutputs.GetSize();
+
+    for (csmInt32 settingIndex = 0; isMatched && settingIndex < _physicsRig->SubRigCount; ++settingIndex)
+    {
+        const csmUint32 outputCount = static_cast<csmUint32>(_physicsRig->Settings[settingIndex].OutputCount);
+
+        isMatched = state.CurrentRigOutputs[settingIndex].output.GetSize() == outputCount
+                    && state.PreviousRigOutputs[settingIndex].output.GetSize() == outputCount;
+    }
+
+    if (!isMatched)
+    {
+        CubismLogWarning("Physics state does not match the rig.");
+        return false;
+    }
+
+    _physicsRig->Particles = state.Particles;
+    _currentRigOutputs = state.CurrentRigOutputs;
+    _previousRigOutputs = state.PreviousRigOutputs;
+    _currentRemainTime = state.CurrentRemainTime;
+
+    return true;
+}
+
+void CubismPhysics::Stabilize(CubismModel* model, csmFloat32 seconds)
+{
+    if (0.0f >= seconds)
+    {
+        return;
+    }
+
+    if (!_isParameterIndicesResolved)
+    {
+        ResolveParameterIndices(model);
+    }
+
+    const csmFloat32 physicsDeltaTime = (_physicsRig->Fps > 0.0f) ? 1.0f / _physicsRig->Fps : StabilizationDeltaTime;
+    const csmInt32 stepCount = static_cast<csmInt32>(seconds / physicsDeltaTime);
+
+    // 現在のパラメータを入力として振り子だけを進める。LODとフレーム予算は適用しない
+    for (csmInt32 i = 0; i < stepCount; ++i)
+    {
+        UpdateStep(model, physicsDeltaTime, 0.0f);
+    }
+
+    // 落ち着いた結果から補間が始まるようにする
+    for (csmUint32 settingIndex = 0; settingIndex < _currentRigOutputs.GetSize(); ++settingIndex)
+    {
+        _previousRigOutputs[settingIndex] = _currentRigOutputs[settingIndex];
+    }
+    _currentRemainTime = 0.0f;
+}
+
+void CubismPhysics::SetLevelOfDetail(const LevelOfDetail& lod)
+{
+    _levelOfDetail = lod;
+    _levelOfDetail.SubstepRateScale = CubismMath::RangeF(lod.SubstepRateScale, MinimumSubstepRateScale, 1.0f);
+}
+
+const CubismPhysics::LevelOfDetail& CubismPhysics::GetLevelOfDetail() const
+{
+    return _levelOfDetail;
+}
+
+void CubismPhysics::SetQuality(csmFloat32 quality)
+{
+    LevelOfDetail lod;
+
+    quality = CubismMath::RangeF(quality, 0.0f, 1.0f);
+
+    lod.SubstepRateScale = quality;
+    lod.MinimumSubRigWeight = (1.0f - quality) * MaximumSkippedSubRigWeight;
+    lod.InterpolateOnly = (quality <= 0.0f);
+
+    SetLevelOfDetail(lod);
+}
+
+void CubismPhysics::SetFrameBudget(csmFloat32 microseconds)
+{
+    s_frameBudgetMicroseconds = microseconds;
+}
+
+csmFloat32 CubismPhysics::GetFrameBudget()
+{
+    return s_frameBudgetMicroseconds;
+}
+
+void CubismPhysics::BeginFrame()
+{
+    s_frameElapsedMicroseconds = 0.0f;
+    s_previousFrameWeight = s_frameWeight;
+    s_frameWeight = 0.0f;
+}
+
+csmFloat32 CubismPhysics::GetFrameElapsedMicroseconds()
+{
+    return s_frameElapsedMicroseconds;
+}
+
 }}}
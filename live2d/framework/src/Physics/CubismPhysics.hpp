@@ -34,6 +34,18 @@ public:
         CubismVector2 Wind; ///< 風の方向
     };
 
+    /**
+     * @brief 詳細度(LOD)
+     *
+     * 物理演算の詳細度。画面上で小さいモデルや背面のモデルの負荷を下げるために使用する。
+     */
+    struct LevelOfDetail
+    {
+        csmFloat32 SubstepRateScale; ///< physics3.jsonのFPSに掛ける倍率(0.0より大きく1.0以下)
+        csmFloat32 MinimumSubRigWeight; ///< 出力の重みがこの値未満のサブリグは評価を省略する(0.0～1.0)
+        csmBool InterpolateOnly; ///< trueの場合は振り子を進めず、前回の結果の補間のみ行う
+    };
+
     /**
      * @brief 物理演算出力結果
      *
@@ -44,6 +56,19 @@ public:
         csmVector<csmFloat32> output;
     };
 
+    /**
+     * @brief 物理演算の状態
+     *
+     * SaveState/RestoreStateで保存・復元する振り子の状態。
+     */
+    struct State
+    {
+        csmVector<CubismPhysicsParticle> Particles; ///< 物理点の状態
+        csmVector<PhysicsOutput> CurrentRigOutputs; ///< 最新の振り子計算の結果
+        csmVector<PhysicsOutput> PreviousRigOutputs; ///< 一つ前の振り子計算の結果
+        csmFloat32 CurrentRemainTime; ///< 物理演算が処理していない時間
+    };
+
     /**
      * @brief インスタンスの作成
      *
@@ -99,6 +124,103 @@ public:
      */
     const Options& GetOptions() const;
 
+    /**
+     * @brief 状態の保存
+     *
+     * 振り子の状態を保存する。
+     *
+     * @param[out]  state   保存先
+     */
+    void SaveState(State& state) const;
+
+    /**
+     * @brief 状態の復元
+     *
+     * SaveStateで保存した振り子の状態を復元する。
+     * 物理点の数とサブリグごとの出力の数がこのリグと一致しない状態は復元しない。
+     *
+     * @param[in]   state   復元する状態
+     * @return  true    復元した
+     * @return  false   リグの構成が異なるため復元しなかった
+     */
+    csmBool RestoreState(const State& state);
+
+    /**
+     * @brief 振り子の安定化
+     *
+     * モデルの現在のパラメータを入力として、振り子だけを固定ステップで指定時間進める。
+     * モーションや描画は更新しないため、出現直後の揺れを事前に落ち着かせるのに使用する。
+     *
+     * @param[in]   model       入力となるパラメータを持つモデル
+     * @param[in]   seconds     進める時間[秒]
+     */
+    void Stabilize(CubismModel* model, csmFloat32 seconds);
+
+    /**
+     * @brief 詳細度の設定
+     *
+     * 詳細度を設定する。
+     *
+     * @param[in]   lod     詳細度
+     */
+    void SetLevelOfDetail(const LevelOfDetail& lod);
+
+    /**
+     * @brief 詳細度の取得
+     *
+     * 詳細度を取得する。
+     *
+     * @return 詳細度
+     */
+    const LevelOfDetail& GetLevelOfDetail() const;
+
+    /**
+     * @brief 品質の設定
+     *
+     * 0.0～1.0の品質から詳細度を設定する。
+     * 1.0で通常の評価、値が小さいほどサブステップを減らし重みの小さいサブリグを省略する。
+     * 0.0では補間のみ行う。
+     *
+     * @param[in]   quality     品質(0.0～1.0)
+     */
+    void SetQuality(csmFloat32 quality);
+
+    /**
+     * @brief フレーム予算の設定
+     *
+     * すべての物理演算インスタンスで共有する1フレームあたりの処理時間の上限を設定する。
+     * 予算は前のフレームで評価したインスタンスの詳細度(SubstepRateScale)の比で分け、
+     * 各インスタンスは自分の取り分の範囲でサブステップを進める。
+     * 取り分が足りずに進められなかった時間は次のフレームへ持ち越す。
+     *
+     * @param[in]   microseconds    1フレームあたりの予算[マイクロ秒]。0以下で無制限
+     */
+    static void SetFrameBudget(csmFloat32 microseconds);
+
+    /**
+     * @brief フレーム予算の取得
+     *
+     * @return 1フレームあたりの予算[マイクロ秒]
+     */
+    static csmFloat32 GetFrameBudget();
+
+    /**
+     * @brief フレームの開始
+     *
+     * フレーム予算の消費量をリセットする。毎フレームの更新前に一度呼ぶ。
+     */
+    static void BeginFrame();
+
+    /**
+     * @brief 消費時間の取得
+     *
+     * 現在のフレームですべてのインスタンスが物理演算に使用した時間を取得する。
+     * 計測はフレーム予算が設定されている場合のみ行う。
+     *
+     * @return 消費時間[マイクロ秒]
+     */
+    static csmFloat32 GetFrameElapsedMicroseconds();
+
 private:
     /**
      * @brief コンストラクタ
@@ -135,6 +257,27 @@ private:
      */
     void Initialize();
 
+    /**
+     * @brief パラメータのインデックスの解決
+     *
+     * 入力元と出力先のパラメータIDをインデックスに変換し、
+     * 物理演算が読み書きするパラメータのインデックスの一覧を作成する。
+     *
+     * @param model 物理演算の結果を適用するモデル
+     */
+    void ResolveParameterIndices(CubismModel* model);
+
+    /**
+     * @brief 振り子の更新
+     *
+     * 振り子を1ステップ進める。
+     *
+     * @param model                 入力となるパラメータを持つモデル
+     * @param physicsDeltaTime      ステップの時間[秒]
+     * @param minimumSubRigWeight   この重み未満のサブリグは省略する
+     */
+    void UpdateStep(CubismModel* model, csmFloat32 physicsDeltaTime, csmFloat32 minimumSubRigWeight);
+
     /**
      * @brief 物理演算結果の適用
      *
@@ -154,8 +297,19 @@ private:
     csmFloat32 _currentRemainTime; ///< 物理演算が処理していない時間
 
     csmVector<csmFloat32> _parameterCache; ///< Evaluateで利用するパラメータのキャッシュ
+    csmVector<csmInt32> _parameterCacheIndices; ///< 物理演算が読み書きするパラメータのインデックス(キャッシュへのコピー対象)
+    csmBool _isParameterIndicesResolved; ///< パラメータのインデックスを解決済みか
 
     csmBool _isJsonValid; ///< 正しくJsonデータが取得出来たか
+
+    LevelOfDetail _levelOfDetail; ///< 詳細度
+    csmFloat32 _averageSubstepMicroseconds; ///< 1サブステップの平均処理時間[マイクロ秒]
+    csmFloat32 _budgetCredit; ///< フレーム予算のうち、このインスタンスが使える残り[マイクロ秒]
+
+    static csmFloat32 s_frameBudgetMicroseconds; ///< 全インスタンス共通の1フレームの予算[マイクロ秒]
+    static csmFloat32 s_frameElapsedMicroseconds; ///< 現在のフレームで消費した時間[マイクロ秒]
+    static csmFloat32 s_frameWeight; ///< 現在のフレームで評価したインスタンスの詳細度の合計
+    static csmFloat32 s_previousFrameWeight; ///< 前のフレームで評価したインスタンスの詳細度の合計
 };
 
 }}}
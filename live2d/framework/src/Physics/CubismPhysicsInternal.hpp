@@ -104,6 +104,7 @@ struct CubismPhysicsSubRig
     csmInt32 BaseParticleIndex;                                 ///< 物理点の最初のインデックス
     CubismPhysicsNormalization NormalizationPosition;           ///< 正規化された位置
     CubismPhysicsNormalization NormalizationAngle;              ///< 正規化された角度
+    csmFloat32 Weight;                                          ///< 出力の重みの最大値(0.0～1.0)。LODの省略判定に使用
 };
 
 /**
@@ -103,7 +103,7 @@ void CubismOffscreenFrame_OpenGLES2::DestroyOffscreenFrame()
 
     if (_renderTexture!=0)
     {
-        rlUnloadTexture(_renderTexture);
+        rlUnloadFramebuffer(_renderTexture);
         _renderTexture = 0;
     }
 }
@@ -113,6 +113,11 @@ unsigned int CubismOffscreenFrame_OpenGLES2::GetColorBuffer() const
     return _colorBuffer;
 }
 
+unsigned int CubismOffscreenFrame_OpenGLES2::GetRenderTexture() const
+{
+    return _renderTexture;
+}
+
 csmUint32 CubismOffscreenFrame_OpenGLES2::GetBufferWidth() const
 {
     return _bufferWidth;
@@ -79,6 +79,11 @@ public:
      */
     unsigned int GetColorBuffer() const;
 
+    /**
+     * @brief   フレームバッファメンバーへのアクセッサ
+     */
+    unsigned int GetRenderTexture() const;
+
     /**
      * @brief   バッファ幅取得
      */
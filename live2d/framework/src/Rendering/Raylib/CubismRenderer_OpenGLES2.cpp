@@ -6,9 +6,11 @@
  */
 
 #include <cstdio>
+#include <cstring>
 
 #include "CubismRenderer_OpenGLES2.hpp"
 #include "Math/CubismMatrix44.hpp"
+#include "Math/CubismMath.hpp"
 #include "Type/csmVector.hpp"
 #include "Model/CubismModel.hpp"
 #include <float.h>
@@ -16,17 +18,18 @@
 
 #ifdef CSM_TARGET_WIN_GL
 #include <Windows.h>
+#else
+#include <chrono>
 #endif
 #include <cassert>
 
-#ifndef CSM_TARGET_WIN_GL
-#error Now this lib supports Windows platform only.
+#ifndef APIENTRY
+#define APIENTRY
 #endif
 
 #define CSM_FRAGMENT_SHADER_FP_PRECISION_HIGH "highp"
 #define CSM_FRAGMENT_SHADER_FP_PRECISION_MID "mediump"
 #define CSM_FRAGMENT_SHADER_FP_PRECISION_LOW "lowp"
-#define MAX_VERTEX_COUNT 8196
 
 #define CSM_FRAGMENT_SHADER_FP_PRECISION CSM_FRAGMENT_SHADER_FP_PRECISION_HIGH
 
@@ -39,12 +42,51 @@ namespace Live2D { namespace Cubism { namespace Framework { namespace Rendering
 ///< ファイルスコープの変数宣言
 namespace {
 const csmInt32 ColorChannelCount = 4;   ///< 実験時に1チャンネルの場合は1、RGBだけの場合は3、アルファも含める場合は4
+const csmFloat32 MaskBoundsMargin = 0.05f;      ///< マスクされる矩形の周囲に付けるマージン（矩形の大きさに対する割合）
+const csmInt32 MaskSlotGranularity = 16;        ///< マスク領域の大きさの刻み（ピクセル）。僅かな変化でレイアウトが変わり、マスクを描き直すのを防ぐ
+const csmInt32 MaskSlotMinSize = 16;            ///< マスク領域の最小の大きさ（ピクセル）
+const csmInt32 MaskPackMaxAttempts = 16;        ///< マスク領域が入りきらないときに縮小して詰め直す回数の上限
+const csmFloat32 MaskPackShrinkRate = 0.8f;     ///< 詰め直すときの縮小率
+
+/**
+ * @brief   指定したDrawableのいずれかの頂点位置が今回の更新で変化したか
+ */
+csmBool IsAnyVertexPositionChanged(const CubismModel& model, const csmInt32* drawableIndices, csmInt32 count)
+{
+    for (csmInt32 i = 0; i < count; i++)
+    {
+        if (model.GetDrawableDynamicFlagVertexPositionsDidChange(drawableIndices[i]))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+csmBool IsSameRect(const csmRectF& a, const csmRectF& b)
+{
+    return a.X == b.X && a.Y == b.Y && a.Width == b.Width && a.Height == b.Height;
+}
+
+/**
+ * @brief   マスク領域の大きさをMaskSlotGranularityの倍数に切り上げ、キャンバスに収まる範囲に制限する
+ */
+csmInt32 QuantizeMaskSlotSize(csmFloat32 size, csmInt32 canvasSize)
+{
+    csmInt32 quantized = static_cast<csmInt32>(ceilf(size / MaskSlotGranularity)) * MaskSlotGranularity;
+    if (quantized < MaskSlotMinSize) quantized = MaskSlotMinSize;
+    if (quantized > canvasSize) quantized = canvasSize;
+    return quantized;
+}
 }
 
 CubismClippingManager_OpenGLES2::CubismClippingManager_OpenGLES2() :
                                                                    _currentFrameNo(0)
                                                                    , _clippingMaskBufferSize(256, 256)
+                                                                   , _maskBufferCount(1)
 {
+    _isMaskBufferValid.PushBack(false, false);
+
     CubismRenderer::CubismTextureColor* tmp;
     tmp = CSM_NEW CubismRenderer::CubismTextureColor();
     tmp->R = 1.0f;
@@ -166,7 +208,28 @@ void CubismClippingManager_OpenGLES2::SetupClippingContext(CubismModel& model, C
         CubismClippingContext* cc = _clippingContextListForMask[clipIndex];
 
         // このクリップを利用する描画オブジェクト群全体を囲む矩形を計算
-        CalcClippedDrawTotalBounds(model, cc);
+        // 描画オブジェクトの頂点が変わっていなければ矩形も変わらないので計算を省く
+        if (!cc->_isBoundsValid
+            || IsAnyVertexPositionChanged(model, cc->_clippedDrawableIndexList->GetPtr(), cc->_clippedDrawableIndexList->GetSize()))
+        {
+            const csmRectF lastRect(cc->_allClippedDrawRect->X, cc->_allClippedDrawRect->Y, cc->_allClippedDrawRect->Width, cc->_allClippedDrawRect->Height);
+            const csmBool wasUsing = cc->_isUsing;
+
+            CalcClippedDrawTotalBounds(model, cc);
+
+            if (!cc->_isBoundsValid || wasUsing != cc->_isUsing || !IsSameRect(lastRect, *cc->_allClippedDrawRect))
+            {
+                cc->_isDirty = true;
+            }
+            cc->_isBoundsValid = true;
+        }
+
+        // マスクとなる描画オブジェクトの頂点が変われば描き直す
+        // 不透明度はマスク生成に使われないので見なくて良い
+        if (IsAnyVertexPositionChanged(model, cc->_clippingIdList, cc->_clippingIdCount))
+        {
+            cc->_isDirty = true;
+        }
 
         if (cc->_isUsing)
         {
@@ -177,36 +240,69 @@ void CubismClippingManager_OpenGLES2::SetupClippingContext(CubismModel& model, C
     // マスク作成処理
     if (usingClipCount > 0)
     {
-        if (!renderer->IsUsingHighPrecisionMask())
-        {
-            // 生成したFrameBufferと同じサイズでビューポートを設定
-            rlViewport(0, 0, _clippingMaskBufferSize.X, _clippingMaskBufferSize.Y);
+        const csmBool isHighPrecision = renderer->IsUsingHighPrecisionMask();
 
-            // モデル描画時にDrawMeshNowに渡される変換（モデルtoワールド座標変換）
-            CubismMatrix44 modelToWorldF = renderer->GetMvpMatrix();
+        // 各マスクのレイアウトを決定していく
+        // マスク領域は画面上の大きさに合わせて割り当てるので、モデル座標1単位が画面上で何ピクセルになるかを求める
+        CubismMatrix44 modelToWorldF = renderer->GetMvpMatrix();
+        const csmFloat32 pixelsPerUnitX = CubismMath::AbsF(modelToWorldF.GetScaleX()) * lastViewport[2] * 0.5f;
+        const csmFloat32 pixelsPerUnitY = CubismMath::AbsF(modelToWorldF.GetScaleY()) * lastViewport[3] * 0.5f;
+        SetupLayoutBounds(isHighPrecision ? 0 : usingClipCount, pixelsPerUnitX, pixelsPerUnitY);
 
-            renderer->PreDraw(); // バッファをクリアする
+        if (!isHighPrecision)
+        {
+            // 前回から変化したマスクを含むレンダーテクスチャだけを描き直す
+            // チャンネルごとの書き込み制御ができないため、描き直すときはレンダーテクスチャ全体を描き直す
+            for (csmUint32 clipIndex = 0; clipIndex < _clippingContextListForMask.GetSize(); clipIndex++)
+            {
+                CubismClippingContext* cc = _clippingContextListForMask[clipIndex];
+                if (!cc->_isUsing)
+                {
+                    continue;
+                }
 
-            // _offscreenFrameBufferへ切り替え
-            renderer->_offscreenFrameBuffer.BeginDraw(lastFBO);
+                if (cc->_isDirty
+                    || cc->_bufferIndex != cc->_lastBufferIndex
+                    || cc->_layoutChannelNo != cc->_lastLayoutChannelNo
+                    || !IsSameRect(*cc->_layoutBounds, cc->_lastLayoutBounds))
+                {
+                    _isMaskBufferValid[cc->_bufferIndex] = false;
+                }
+            }
 
-            // マスクをクリアする
-            // 1が無効（描かれない）領域、0が有効（描かれる）領域。（シェーダで Cd*Csで0に近い値をかけてマスクを作る。1をかけると何も起こらない）
-            renderer->_offscreenFrameBuffer.Clear(1.0f, 1.0f, 1.0f, 1.0f);
-        }
+            // 前回から何も変わっていなければ、フレームバッファに残っているマスクと行列をそのまま使う
+            csmBool isDirty = false;
+            for (csmUint32 clipIndex = 0; clipIndex < _clippingContextListForMask.GetSize() && !isDirty; clipIndex++)
+            {
+                CubismClippingContext* cc = _clippingContextListForMask[clipIndex];
+                isDirty = cc->_isUsing && !_isMaskBufferValid[cc->_bufferIndex];
+            }
 
-        // 各マスクのレイアウトを決定していく
-        SetupLayoutBounds(renderer->IsUsingHighPrecisionMask() ? 0 : usingClipCount);
+            if (!isDirty)
+            {
+                return;
+            }
+        }
+        else
+        {
+            // 高精細マスクでは描画オブジェクトごとにバッファを上書きするので、残っているマスクは使えない
+            InvalidateMaskBuffers();
+        }
 
-        // 実際にマスクを生成する
         // 全てのマスクをどの様にレイアウトして描くかを決定し、ClipContext , ClippedDrawContext に記憶する
         for (csmUint32 clipIndex = 0; clipIndex < _clippingContextListForMask.GetSize(); clipIndex++)
         {
-            // --- 実際に１つのマスクを描く ---
             CubismClippingContext* clipContext = _clippingContextListForMask[clipIndex];
+
+            // 描き直さないマスクの行列は前回のものをそのまま使う
+            if (!isHighPrecision && (!clipContext->_isUsing || _isMaskBufferValid[clipContext->_bufferIndex]))
+            {
+                continue;
+            }
+
             csmRectF* allClippedDrawRect = clipContext->_allClippedDrawRect; //このマスクを使う、全ての描画オブジェクトの論理座標上の囲み矩形
             csmRectF* layoutBoundsOnTex01 = clipContext->_layoutBounds; //この中にマスクを収める
-            const csmFloat32 MARGIN = 0.05f;
+            const csmFloat32 MARGIN = MaskBoundsMargin;
             csmFloat32 scaleX = 0.0f;
             csmFloat32 scaleY = 0.0f;
 
@@ -292,47 +388,72 @@ void CubismClippingManager_OpenGLES2::SetupClippingContext(CubismModel& model, C
             clipContext->_matrixForMask.SetMatrix(_tmpMatrixForMask.GetArray());
 
             clipContext->_matrixForDraw.SetMatrix(_tmpMatrixForDraw.GetArray());
+        }
+
+        if (!isHighPrecision)
+        {
+            // 実際にマスクを生成する
+            // 生成したFrameBufferと同じサイズでビューポートを設定
+            rlViewport(0, 0, _clippingMaskBufferSize.X, _clippingMaskBufferSize.Y);
 
-            if (!renderer->IsUsingHighPrecisionMask())
+            renderer->PreDraw(); // バッファをクリアする
+
+            const csmFloat32 bufferPixels = _clippingMaskBufferSize.X * _clippingMaskBufferSize.Y;
+            for (csmInt32 bufferIndex = 0; bufferIndex < _maskBufferCount; bufferIndex++)
             {
-                const csmInt32 clipDrawCount = clipContext->_clippingIdCount;
-                for (csmInt32 i = 0; i < clipDrawCount; i++)
+                if (_isMaskBufferValid[bufferIndex])
                 {
-                    const csmInt32 clipDrawIndex = clipContext->_clippingIdList[i];
+                    continue;
+                }
+
+                // _offscreenFrameBuffers[bufferIndex]へ切り替え
+                renderer->_offscreenFrameBuffers[bufferIndex].BeginDraw(lastFBO);
+
+                // マスクをクリアする
+                // 1が無効（描かれない）領域、0が有効（描かれる）領域。（シェーダで Cd*Csで0に近い値をかけてマスクを作る。1をかけると何も起こらない）
+                renderer->_offscreenFrameBuffers[bufferIndex].Clear(1.0f, 1.0f, 1.0f, 1.0f);
+                renderer->_frameStatistics.MaskPixelFill += static_cast<csmUint32>(bufferPixels);
 
-                    // 頂点情報が更新されておらず、信頼性がない場合は描画をパスする
-                    if (!model.GetDrawableDynamicFlagVertexPositionsDidChange(clipDrawIndex))
+                for (csmUint32 clipIndex = 0; clipIndex < _clippingContextListForMask.GetSize(); clipIndex++)
+                {
+                    // --- 実際に１つのマスクを描く ---
+                    CubismClippingContext* clipContext = _clippingContextListForMask[clipIndex];
+                    if (!clipContext->_isUsing || clipContext->_bufferIndex != bufferIndex)
                     {
                         continue;
                     }
 
-                    renderer->IsCulling(model.GetDrawableCulling(clipDrawIndex) != 0);
+                    clipContext->_isDirty = false;
+                    clipContext->_lastBufferIndex = clipContext->_bufferIndex;
+                    clipContext->_lastLayoutChannelNo = clipContext->_layoutChannelNo;
+                    clipContext->_lastLayoutBounds.SetRect(clipContext->_layoutBounds);
+                    renderer->_frameStatistics.MaskRedraws++;
+                    renderer->_frameStatistics.MaskPixelFill += static_cast<csmUint32>(bufferPixels * clipContext->_layoutBounds->Width * clipContext->_layoutBounds->Height);
 
-                    // 今回専用の変換を適用して描く
-                    // チャンネルも切り替える必要がある(A,R,G,B)
-                    renderer->SetClippingContextBufferForMask(clipContext);
-
-                    renderer->DrawMeshOpenGL(
-                        model.GetDrawableTextureIndex(clipDrawIndex),
-                        model.GetDrawableVertexIndexCount(clipDrawIndex),
-                        model.GetDrawableVertexCount(clipDrawIndex),
-                        const_cast<csmUint16*>(model.GetDrawableVertexIndices(clipDrawIndex)),
-                        const_cast<csmFloat32*>(model.GetDrawableVertices(clipDrawIndex)),
-                        reinterpret_cast<csmFloat32*>(const_cast<Core::csmVector2*>(model.GetDrawableVertexUvs(clipDrawIndex))),
-                        model.GetMultiplyColor(clipDrawIndex),
-                        model.GetScreenColor(clipDrawIndex),
-                        model.GetDrawableOpacity(clipDrawIndex),
-                        CubismRenderer::CubismBlendMode_Normal,   //クリッピングは通常描画を強制
-                        false   // マスク生成時はクリッピングの反転使用は全く関係がない
-                    );
+                    const csmInt32 clipDrawCount = clipContext->_clippingIdCount;
+                    for (csmInt32 i = 0; i < clipDrawCount; i++)
+                    {
+                        const csmInt32 clipDrawIndex = clipContext->_clippingIdList[i];
+
+                        // 頂点バッファには常に最後に更新された頂点が入っているので、今回頂点が変化していないマスクも描く
+                        // （レンダーテクスチャ全体を描き直すため、ここで省くとそのマスクが消えてしまう）
+
+                        renderer->IsCulling(model.GetDrawableCulling(clipDrawIndex) != 0);
+
+                        // 今回専用の変換を適用して描く
+                        // チャンネルも切り替える必要がある(A,R,G,B)
+                        renderer->SetClippingContextBufferForMask(clipContext);
+
+                        // マスク生成時は合成モード・反転の指定に関係なくマスク用シェーダで描かれる
+                        renderer->DrawMeshOpenGL(model, clipDrawIndex);
+                    }
                 }
+
+                renderer->_offscreenFrameBuffers[bufferIndex].EndDraw(); // 描画対象を戻す
+                _isMaskBufferValid[bufferIndex] = true;
             }
-        }
 
-        if (!renderer->IsUsingHighPrecisionMask())
-        {
             // --- 後処理 ---
-            renderer->_offscreenFrameBuffer.EndDraw(); // 描画対象を戻す
             renderer->SetClippingContextBufferForMask(NULL);
             rlViewport(lastViewport[0], lastViewport[1], lastViewport[2], lastViewport[3]);
         }
@@ -355,25 +476,14 @@ void CubismClippingManager_OpenGLES2::CalcClippedDrawTotalBounds(CubismModel& mo
         const csmInt32 drawableIndex = (*clippingContext->_clippedDrawableIndexList)[clippedDrawableIndex];
 
         const csmInt32 drawableVertexCount = model.GetDrawableVertexCount(drawableIndex);
-        csmFloat32* drawableVertexes = const_cast<csmFloat32*>(model.GetDrawableVertices(drawableIndex));
+        const csmFloat32* drawableVertexes = model.GetDrawableVertices(drawableIndex);
 
-        csmFloat32 minX = FLT_MAX, minY = FLT_MAX;
-        csmFloat32 maxX = -FLT_MAX, maxY = -FLT_MAX;
-
-        csmInt32 loop = drawableVertexCount * Constant::VertexStep;
-        for (csmInt32 pi = Constant::VertexOffset; pi < loop; pi += Constant::VertexStep)
+        csmFloat32 minX, minY, maxX, maxY;
+        if (!CubismMath::CalculateBounds(drawableVertexes, drawableVertexCount, minX, minY, maxX, maxY))
         {
-            csmFloat32 x = drawableVertexes[pi];
-            csmFloat32 y = drawableVertexes[pi + 1];
-            if (x < minX) minX = x;
-            if (x > maxX) maxX = x;
-            if (y < minY) minY = y;
-            if (y > maxY) maxY = y;
+            continue; //有効な点がひとつも取れなかったのでスキップする
         }
 
-        //
-        if (minX == FLT_MAX) continue; //有効な点がひとつも取れなかったのでスキップする
-
         // 全体の矩形に反映
         if (minX < clippedDrawTotalMinX) clippedDrawTotalMinX = minX;
         if (minY < clippedDrawTotalMinY) clippedDrawTotalMinY = minY;
@@ -400,13 +510,14 @@ void CubismClippingManager_OpenGLES2::CalcClippedDrawTotalBounds(CubismModel& mo
     }
 }
 
-void CubismClippingManager_OpenGLES2::SetupLayoutBounds(csmInt32 usingClipCount) const
+void CubismClippingManager_OpenGLES2::SetupLayoutBounds(csmInt32 usingClipCount, csmFloat32 pixelsPerUnitX, csmFloat32 pixelsPerUnitY)
 {
     if (usingClipCount <= 0)
     {// この場合は一つのマスクターゲットを毎回クリアして使用する
         for (csmUint32 index = 0; index < _clippingContextListForMask.GetSize(); index++)
         {
             CubismClippingContext* cc = _clippingContextListForMask[index];
+            cc->_bufferIndex = 0;
             cc->_layoutChannelNo = 0; // どうせ毎回消すので固定で良い
             cc->_layoutBounds->X = 0.0f;
             cc->_layoutBounds->Y = 0.0f;
@@ -416,106 +527,119 @@ void CubismClippingManager_OpenGLES2::SetupLayoutBounds(csmInt32 usingClipCount)
         return;
     }
 
-    // ひとつのRenderTextureを極力いっぱいに使ってマスクをレイアウトする
-    // マスクグループの数が4以下ならRGBA各チャンネルに１つずつマスクを配置し、5以上6以下ならRGBAを2,2,1,1と配置する
-
-    // RGBAを順番に使っていく。
-    const csmInt32 div = usingClipCount / ColorChannelCount; //１チャンネルに配置する基本のマスク個数
-    const csmInt32 mod = usingClipCount % ColorChannelCount; //余り、この番号のチャンネルまでに１つずつ配分する
-
-    // RGBAそれぞれのチャンネルを用意していく(0:R , 1:G , 2:B, 3:A, )
-    csmInt32 curClipIndex = 0; //順番に設定していく
-
-    for (csmInt32 channelNo = 0; channelNo < ColorChannelCount; channelNo++)
+    // 各マスクに必要な大きさを画面上の大きさから求め、高さの降順に並べる（同じ高さなら元の順）
+    // 棚詰めは背の高い矩形から置くと隙間が少なくなる
+    _layoutOrder.Resize(0);
+    for (csmUint32 index = 0; index < _clippingContextListForMask.GetSize(); index++)
     {
-        // このチャンネルにレイアウトする数
-        const csmInt32 layoutCount = div + (channelNo < mod ? 1 : 0);
-
-        // 分割方法を決定する
-        if (layoutCount == 0)
+        CubismClippingContext* cc = _clippingContextListForMask[index];
+        if (!cc->_isUsing)
         {
-            // 何もしない
+            continue;
         }
-        else if (layoutCount == 1)
+
+        cc->_layoutPixelSize.X = cc->_allClippedDrawRect->Width * (1.0f + MaskBoundsMargin * 2.0f) * pixelsPerUnitX;
+        cc->_layoutPixelSize.Y = cc->_allClippedDrawRect->Height * (1.0f + MaskBoundsMargin * 2.0f) * pixelsPerUnitY;
+
+        _layoutOrder.PushBack(cc, false);
+        for (csmInt32 i = _layoutOrder.GetSize() - 1; i > 0 && _layoutOrder[i - 1]->_layoutPixelSize.Y < cc->_layoutPixelSize.Y; i--)
         {
-            //全てをそのまま使う
-            CubismClippingContext* cc = _clippingContextListForMask[curClipIndex++];
-            cc->_layoutChannelNo = channelNo;
-            cc->_layoutBounds->X = 0.0f;
-            cc->_layoutBounds->Y = 0.0f;
-            cc->_layoutBounds->Width = 1.0f;
-            cc->_layoutBounds->Height = 1.0f;
+            _layoutOrder[i] = _layoutOrder[i - 1];
+            _layoutOrder[i - 1] = cc;
         }
-        else if (layoutCount == 2)
+    }
+
+    // まずは画面上と同じ解像度で配置し、入りきらなければ全体を縮小して詰め直す
+    csmFloat32 scale = 1.0f;
+    for (csmInt32 attempt = 0; attempt < MaskPackMaxAttempts; attempt++)
+    {
+        if (PackLayoutBounds(scale))
         {
-            for (csmInt32 i = 0; i < layoutCount; i++)
-            {
-                const csmInt32 xpos = i % 2;
+            return;
+        }
+        scale *= MaskPackShrinkRate;
+    }
 
-                CubismClippingContext* cc = _clippingContextListForMask[curClipIndex++];
-                cc->_layoutChannelNo = channelNo;
+    CubismLogError("not supported mask count : %d", usingClipCount);
 
-                cc->_layoutBounds->X = xpos * 0.5f;
-                cc->_layoutBounds->Y = 0.0f;
-                cc->_layoutBounds->Width = 0.5f;
-                cc->_layoutBounds->Height = 1.0f;
-                //UVを2つに分解して使う
-            }
-        }
-        else if (layoutCount <= 4)
-        {
-            //4分割して使う
-            for (csmInt32 i = 0; i < layoutCount; i++)
-            {
-                const csmInt32 xpos = i % 2;
-                const csmInt32 ypos = i / 2;
+    // 開発モードの場合は停止させる
+    CSM_ASSERT(0);
 
-                CubismClippingContext* cc = _clippingContextListForMask[curClipIndex++];
-                cc->_layoutChannelNo = channelNo;
+    // 引き続き実行する場合、 SetupShaderProgramでオーバーアクセスが発生するので仕方なく適当に入れておく
+    // もちろん描画結果はろくなことにならない
+    for (csmUint32 index = 0; index < _layoutOrder.GetSize(); index++)
+    {
+        CubismClippingContext* cc = _layoutOrder[index];
+        cc->_bufferIndex = 0;
+        cc->_layoutChannelNo = 0;
+        cc->_layoutBounds->X = 0.0f;
+        cc->_layoutBounds->Y = 0.0f;
+        cc->_layoutBounds->Width = 1.0f;
+        cc->_layoutBounds->Height = 1.0f;
+    }
+}
 
-                cc->_layoutBounds->X = xpos * 0.5f;
-                cc->_layoutBounds->Y = ypos * 0.5f;
-                cc->_layoutBounds->Width = 0.5f;
-                cc->_layoutBounds->Height = 0.5f;
-            }
+csmBool CubismClippingManager_OpenGLES2::PackLayoutBounds(csmFloat32 scale)
+{
+    // レンダーテクスチャのRGBA各チャンネルを1枚のキャンバスとして、順番に使っていく
+    // (0:R , 1:G , 2:B, 3:A, 4:2枚目のR, ...)
+    const csmInt32 canvasWidth = static_cast<csmInt32>(_clippingMaskBufferSize.X);
+    const csmInt32 canvasHeight = static_cast<csmInt32>(_clippingMaskBufferSize.Y);
+    const csmInt32 canvasCount = _maskBufferCount * ColorChannelCount;
+
+    csmInt32 canvasNo = 0;
+    csmInt32 shelfX = 0;
+    csmInt32 shelfY = 0;
+    csmInt32 shelfHeight = 0;
+
+    for (csmUint32 index = 0; index < _layoutOrder.GetSize(); index++)
+    {
+        CubismClippingContext* cc = _layoutOrder[index];
+        const csmInt32 width = QuantizeMaskSlotSize(cc->_layoutPixelSize.X * scale, canvasWidth);
+        const csmInt32 height = QuantizeMaskSlotSize(cc->_layoutPixelSize.Y * scale, canvasHeight);
+
+        // 今の棚に入らなければ次の棚へ、キャンバスに入らなければ次のキャンバスへ
+        if (shelfX + width > canvasWidth)
+        {
+            shelfY += shelfHeight;
+            shelfX = 0;
+            shelfHeight = 0;
         }
-        else if (layoutCount <= 9)
+        if (shelfY + height > canvasHeight)
         {
-            //9分割して使う
-            for (csmInt32 i = 0; i < layoutCount; i++)
-            {
-                const csmInt32 xpos = i % 3;
-                const csmInt32 ypos = i / 3;
-
-                CubismClippingContext* cc = _clippingContextListForMask[curClipIndex++];
-                cc->_layoutChannelNo = channelNo;
-
-                cc->_layoutBounds->X = xpos / 3.0f;
-                cc->_layoutBounds->Y = ypos / 3.0f;
-                cc->_layoutBounds->Width = 1.0f / 3.0f;
-                cc->_layoutBounds->Height = 1.0f / 3.0f;
-            }
+            canvasNo++;
+            shelfX = 0;
+            shelfY = 0;
+            shelfHeight = 0;
         }
-        else
+        if (canvasNo >= canvasCount)
         {
-            CubismLogError("not supported mask count : %d", layoutCount);
+            return false;
+        }
 
-            // 開発モードの場合は停止させる
-            CSM_ASSERT(0);
+        cc->_bufferIndex = canvasNo / ColorChannelCount;
+        cc->_layoutChannelNo = canvasNo % ColorChannelCount;
+        cc->_layoutBounds->X = static_cast<csmFloat32>(shelfX) / canvasWidth;
+        cc->_layoutBounds->Y = static_cast<csmFloat32>(shelfY) / canvasHeight;
+        cc->_layoutBounds->Width = static_cast<csmFloat32>(width) / canvasWidth;
+        cc->_layoutBounds->Height = static_cast<csmFloat32>(height) / canvasHeight;
 
-            // 引き続き実行する場合、 SetupShaderProgramでオーバーアクセスが発生するので仕方なく適当に入れておく
-            // もちろん描画結果はろくなことにならない
-            for (csmInt32 i = 0; i < layoutCount; i++)
-            {
-                CubismClippingContext* cc = _clippingContextListForMask[curClipIndex++];
-                cc->_layoutChannelNo = 0;
-                cc->_layoutBounds->X = 0.0f;
-                cc->_layoutBounds->Y = 0.0f;
-                cc->_layoutBounds->Width = 1.0f;
-                cc->_layoutBounds->Height = 1.0f;
-            }
+        shelfX += width;
+        if (height > shelfHeight)
+        {
+            shelfHeight = height;
         }
     }
+
+    return true;
+}
+
+void CubismClippingManager_OpenGLES2::InvalidateMaskBuffers()
+{
+    for (csmUint32 i = 0; i < _isMaskBufferValid.GetSize(); i++)
+    {
+        _isMaskBufferValid[i] = false;
+    }
 }
 
 CubismRenderer::CubismTextureColor* CubismClippingManager_OpenGLES2::GetChannelFlagAsColor(csmInt32 channelNo)
@@ -538,6 +662,18 @@ CubismVector2 CubismClippingManager_OpenGLES2::GetClippingMaskBufferSize() const
     return _clippingMaskBufferSize;
 }
 
+void CubismClippingManager_OpenGLES2::SetMaskBufferCount(csmInt32 count)
+{
+    _maskBufferCount = (count < 1) ? 1 : count;
+    _isMaskBufferValid.UpdateSize(_maskBufferCount, false, false);
+    InvalidateMaskBuffers();
+}
+
+csmInt32 CubismClippingManager_OpenGLES2::GetMaskBufferCount() const
+{
+    return _maskBufferCount;
+}
+
 /*********************************************************************************************************************
 *                                      CubismClippingContext
 ********************************************************************************************************************/
@@ -553,11 +689,17 @@ CubismClippingContext::CubismClippingContext(CubismClippingManager_OpenGLES2* ma
     _clippingIdCount = clipCount;
 
     _layoutChannelNo = 0;
+    _bufferIndex = 0;
 
     _allClippedDrawRect = CSM_NEW csmRectF();
     _layoutBounds = CSM_NEW csmRectF();
 
     _clippedDrawableIndexList = CSM_NEW csmVector<csmInt32>();
+
+    _isDirty = true;
+    _isBoundsValid = false;
+    _lastLayoutChannelNo = -1;
+    _lastBufferIndex = -1;
 }
 
 CubismClippingContext::~CubismClippingContext()
@@ -642,7 +784,7 @@ void CubismRendererProfile_OpenGLES2::Save()
     //// モデル描画直前のFBOとビューポートを保存
     //glGetIntegerv(GL_FRAMEBUFFER_BINDING, &_lastFBO);
     //glGetIntegerv(GL_VIEWPORT, _lastViewport);
-    _lastFBO = 0;
+    // _lastFBOはCubismRenderer_OpenGLES2::SetRenderTargetで設定する
     //_lastViewport[0] = 0;
     //_lastViewport[1] = 0;
     //_lastViewport[2] = 1600;
@@ -688,8 +830,142 @@ void CubismRendererProfile_OpenGLES2::Restore()
 *                                       CubismShader_OpenGLES2
 ********************************************************************************************************************/
 namespace {
-    const csmInt32 ShaderCount = 19; ///< シェーダの数 = マスク生成用 + (通常 + 加算 + 乗算) * (マスク無 + マスク有 + マスク有反転 + マスク無の乗算済アルファ対応版 + マスク有の乗算済アルファ対応版 + マスク有反転の乗算済アルファ対応版)
+    const csmInt32 ShaderCount = 21; ///< シェーダの数 = マスク生成用 + (通常 + 加算 + 乗算) * (マスク無 + マスク有 + マスク有反転 + マスク無の乗算済アルファ対応版 + マスク有の乗算済アルファ対応版 + マスク有反転の乗算済アルファ対応版) + インスタンス描画用 * (通常 + 乗算済アルファ対応版)
+    const csmInt32 InstanceAttributeFloats = 17; ///< インスタンスごとの属性の要素数 = MVP行列 + 不透明度
     CubismShader_OpenGLES2* s_instance;
+
+    // プログラムバイナリの保存・読み込みに使う、rlglに無いGLの関数と定数
+    const unsigned int GL_VENDOR = 0x1F00;
+    const unsigned int GL_RENDERER = 0x1F01;
+    const unsigned int GL_VERSION = 0x1F02;
+    const unsigned int GL_LINK_STATUS = 0x8B82;
+    const unsigned int GL_PROGRAM_BINARY_LENGTH = 0x8741;
+    const unsigned int GL_NUM_PROGRAM_BINARY_FORMATS = 0x87FE;
+
+    typedef const unsigned char* (APIENTRY *GetStringProc)(unsigned int name);
+    typedef void (APIENTRY *GetIntegervProc)(unsigned int pname, int* data);
+    typedef unsigned int (APIENTRY *CreateProgramProc)(void);
+    typedef void (APIENTRY *GetProgramivProc)(unsigned int program, unsigned int pname, int* params);
+    typedef void (APIENTRY *GetProgramBinaryProc)(unsigned int program, int bufSize, int* length, unsigned int* binaryFormat, void* binary);
+    typedef void (APIENTRY *ProgramBinaryProc)(unsigned int program, unsigned int binaryFormat, const void* binary, int length);
+
+    GetStringProc s_glGetString;
+    GetIntegervProc s_glGetIntegerv;
+    CreateProgramProc s_glCreateProgram;
+    GetProgramivProc s_glGetProgramiv;
+    GetProgramBinaryProc s_glGetProgramBinary;
+    ProgramBinaryProc s_glProgramBinary;
+    csmInt32 s_programBinarySupport = -1;    ///< プログラムバイナリに対応しているか。-1なら未確認
+    CubismRenderer_OpenGLES2::GLProcAddressLoader s_glProcAddressLoader;   ///< アプリケーションが設定したGLのローダ
+
+    const csmUint32 ProgramBinaryMagic = 0x42505343;            ///< キャッシュファイルの識別子（"CSPB"）。形式を変えたら値も変える
+    const csmUint64 ProgramBinaryHashSeed = 14695981039346656037ULL;  ///< FNV-1aの初期値
+    const csmUint64 ProgramBinaryHashPrime = 1099511628211ULL;        ///< FNV-1aの乗数
+
+    /**
+     * @brief   キャッシュファイルの先頭に置く情報
+     */
+    struct ProgramBinaryHeader
+    {
+        csmUint32 Magic;        ///< ProgramBinaryMagic
+        unsigned int Format;    ///< glGetProgramBinaryが返したバイナリの形式
+        csmUint32 Length;       ///< 続くバイナリのバイト数
+    };
+
+    /**
+     * @brief   プログラムバイナリの関数を取得する。ドライバが対応していなければfalse
+     */
+    csmBool LoadProgramBinaryFunctions()
+    {
+        if (s_programBinarySupport >= 0)
+        {
+            return s_programBinarySupport == 1;
+        }
+
+        if (s_glProcAddressLoader != NULL)
+        {
+            // アプリケーションが設定したローダから取得する。どのターゲットでも使える
+            s_glGetString = reinterpret_cast<GetStringProc>(s_glProcAddressLoader("glGetString"));
+            s_glGetIntegerv = reinterpret_cast<GetIntegervProc>(s_glProcAddressLoader("glGetIntegerv"));
+            s_glCreateProgram = reinterpret_cast<CreateProgramProc>(s_glProcAddressLoader("glCreateProgram"));
+            s_glGetProgramiv = reinterpret_cast<GetProgramivProc>(s_glProcAddressLoader("glGetProgramiv"));
+            s_glGetProgramBinary = reinterpret_cast<GetProgramBinaryProc>(s_glProcAddressLoader("glGetProgramBinary"));
+            s_glProgramBinary = reinterpret_cast<ProgramBinaryProc>(s_glProcAddressLoader("glProgramBinary"));
+        }
+#ifdef CSM_TARGET_WIN_GL
+        else
+        {
+            // GL 1.1の関数はopengl32.dllから、それ以降の関数はwglGetProcAddressから取得する
+            HMODULE opengl = GetModuleHandleA("opengl32.dll");
+            if (opengl != NULL)
+            {
+                s_glGetString = reinterpret_cast<GetStringProc>(GetProcAddress(opengl, "glGetString"));
+                s_glGetIntegerv = reinterpret_cast<GetIntegervProc>(GetProcAddress(opengl, "glGetIntegerv"));
+            }
+            s_glCreateProgram = reinterpret_cast<CreateProgramProc>(wglGetProcAddress("glCreateProgram"));
+            s_glGetProgramiv = reinterpret_cast<GetProgramivProc>(wglGetProcAddress("glGetProgramiv"));
+            s_glGetProgramBinary = reinterpret_cast<GetProgramBinaryProc>(wglGetProcAddress("glGetProgramBinary"));
+            s_glProgramBinary = reinterpret_cast<ProgramBinaryProc>(wglGetProcAddress("glProgramBinary"));
+        }
+#endif
+
+        // 形式が1つも無ければ、関数があってもバイナリを保存できない
+        int formatCount = 0;
+        if (s_glGetString != NULL && s_glGetIntegerv != NULL && s_glCreateProgram != NULL
+            && s_glGetProgramiv != NULL && s_glGetProgramBinary != NULL && s_glProgramBinary != NULL)
+        {
+            s_glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+        }
+
+        s_programBinarySupport = (formatCount > 0) ? 1 : 0;
+        if (s_programBinarySupport == 0)
+        {
+            CubismLogInfo("[Shader] program binaries are not supported by the driver, shaders are always compiled");
+        }
+
+        return s_programBinarySupport == 1;
+    }
+
+    /**
+     * @brief   文字列をFNV-1aのハッシュに加える
+     */
+    csmUint64 HashString(csmUint64 hash, const csmChar* text)
+    {
+        if (text != NULL)
+        {
+            for (; *text != '\0'; ++text)
+            {
+                hash ^= static_cast<csmUchar>(*text);
+                hash *= ProgramBinaryHashPrime;
+            }
+        }
+
+        // 区切りを入れ、連結すると同じになる別の文字列の組と区別する
+        hash ^= 0xFF;
+        hash *= ProgramBinaryHashPrime;
+        return hash;
+    }
+
+    /**
+     * @brief   時刻をマイクロ秒で取得する
+     */
+    csmUint64 GetTimeMicroseconds()
+    {
+#ifdef CSM_TARGET_WIN_GL
+        LARGE_INTEGER frequency;
+        LARGE_INTEGER counter;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&counter);
+
+        // そのまま100万を掛けると桁あふれするので、秒とその端数に分けて換算する
+        const csmUint64 seconds = counter.QuadPart / frequency.QuadPart;
+        const csmUint64 remainder = counter.QuadPart % frequency.QuadPart;
+        return seconds * 1000000 + remainder * 1000000 / frequency.QuadPart;
+#else
+        return static_cast<csmUint64>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
 }
 
 enum ShaderNames
@@ -720,19 +996,32 @@ enum ShaderNames
     ShaderNames_MultPremultipliedAlpha,
     ShaderNames_MultMaskedPremultipliedAlpha,
     ShaderNames_MultMaskedPremultipliedAlphaInverted,
+
+    //Instanced
+    ShaderNames_Instanced,
+    ShaderNames_InstancedPremultipliedAlpha,
 };
 
 void CubismShader_OpenGLES2::ReleaseShaderProgram()
 {
     for (csmUint32 i = 0; i < _shaderSets.GetSize(); i++)
     {
-        if (_shaderSets[i]->ShaderProgram)
+        CubismShaderSet* shaderSet = _shaderSets[i];
+
+        // 加算・乗算は通常と同じプログラム・VAOを共有しているので、所有しているセットだけが解放する
+        // 一度も使わなかったセットはプログラムを作っていない
+        if (shaderSet->IsProgramOwner && shaderSet->ShaderProgram != 0)
         {
-            rlUnloadShaderProgram(_shaderSets[i]->ShaderProgram);
-            _shaderSets[i]->ShaderProgram = 0;
-            CSM_DELETE(_shaderSets[i]);
+            rlUnloadShaderProgram(shaderSet->ShaderProgram);
+            rlUnloadVertexArray(shaderSet->VertexArrayObjectId);
+            CSM_DELETE(shaderSet->State);
         }
+
+        CSM_DELETE(shaderSet);
     }
+
+    _shaderSets.Clear();
+    InvalidateState();
 }
 
 // SetupMask
@@ -1135,8 +1424,73 @@ static const csmChar* FragShaderSrcMaskInvertedPremultipliedAlphaTegra =
         "}";
 #endif
 
-CubismShader_OpenGLES2::CubismShader_OpenGLES2()
-{ }
+#if !defined(CSM_TARGET_IPHONE_ES2) && !defined(CSM_TARGET_ANDROID_ES2)
+// Normal & Add & Mult 共通（インスタンス描画用）
+// 頂点座標はインスタンスごとにs_verticesから読む。テクセルは(x, y, Drawableの不透明度, 0)で、
+// インスタンスiの頂点はi * u_instanceStride番目のテクセルから並んでいる
+static const csmChar* VertShaderSrcInstanced =
+        "#version 330 core\n"
+        "attribute vec2 a_texCoord;"
+        "attribute mat4 a_instanceMatrix;"
+        "attribute float a_instanceOpacity;"
+        "varying vec2 v_texCoord;"
+        "varying float v_opacity;"
+        "uniform sampler2D s_vertices;"
+        "uniform int u_vertexOffset;"
+        "uniform int u_instanceStride;"
+        "void main()"
+        "{"
+        "int index = u_vertexOffset + gl_VertexID + gl_InstanceID * u_instanceStride;"
+        "int width = textureSize(s_vertices, 0).x;"
+        "vec4 vertex = texelFetch(s_vertices, ivec2(index % width, index / width), 0);"
+        "gl_Position = a_instanceMatrix * vec4(vertex.xy, 0.0, 1.0);"
+        "v_opacity = vertex.z * a_instanceOpacity;"
+        "v_texCoord = a_texCoord;"
+        "v_texCoord.y = 1.0 - v_texCoord.y;"
+        "}";
+
+// Normal & Add & Mult 共通（インスタンス描画用）
+static const csmChar* FragShaderSrcInstanced =
+        "#version 330 core\n"
+        "varying vec2 v_texCoord;"
+        "varying float v_opacity;"
+        "uniform sampler2D s_texture0;"
+        "uniform vec4 u_baseColor;"
+        "uniform vec4 u_multiplyColor;"
+        "uniform vec4 u_screenColor;"
+        "void main()"
+        "{"
+        "vec4 texColor = texture2D(s_texture0 , v_texCoord);"
+        "texColor.rgb = texColor.rgb * u_multiplyColor.rgb;"
+        "texColor.rgb = texColor.rgb + u_screenColor.rgb - (texColor.rgb * u_screenColor.rgb);"
+        "vec4 color = texColor * vec4(u_baseColor.rgb, u_baseColor.a * v_opacity);"
+        "gl_FragColor = vec4(color.rgb * color.a,  color.a);"
+        "}";
+
+// Normal & Add & Mult 共通（インスタンス描画用、PremultipliedAlpha）
+static const csmChar* FragShaderSrcInstancedPremultipliedAlpha =
+        "#version 330 core\n"
+        "varying vec2 v_texCoord;"
+        "varying float v_opacity;"
+        "uniform sampler2D s_texture0;"
+        "uniform vec4 u_baseColor;"
+        "uniform vec4 u_multiplyColor;"
+        "uniform vec4 u_screenColor;"
+        "void main()"
+        "{"
+        "vec4 texColor = texture2D(s_texture0 , v_texCoord);"
+        "texColor.rgb = texColor.rgb * u_multiplyColor.rgb;"
+        "texColor.rgb = (texColor.rgb + u_screenColor.rgb * texColor.a) - (texColor.rgb * u_screenColor.rgb);"
+        "gl_FragColor = texColor * u_baseColor * v_opacity;"
+        "}";
+#endif
+
+CubismShader_OpenGLES2::CubismShader_OpenGLES2() : _stateChangeCount(0)
+                                                 , _redundantStateCount(0)
+{
+    memset(&_programStatistics, 0, sizeof(_programStatistics));
+    InvalidateState();
+}
 
 CubismShader_OpenGLES2::~CubismShader_OpenGLES2()
 {
@@ -1147,6 +1501,7 @@ CubismShader_OpenGLES2* CubismShader_OpenGLES2::GetInstance()
 {
     if (s_instance == NULL)
     {
+        CubismSharedAllocationScope sharedAllocation;
         s_instance = CSM_NEW CubismShader_OpenGLES2();
     }
     return s_instance;
@@ -1174,442 +1529,1531 @@ void CubismShader_OpenGLES2::GenerateShaders()
 {
     for (csmInt32 i = 0; i < ShaderCount; i++)
     {
-        _shaderSets.PushBack(CSM_NEW CubismShaderSet());
-    }
-
-    _shaderSets[0]->ShaderProgram = rlLoadShaderCode(VertShaderSrcSetupMask, FragShaderSrcSetupMask);
-    _shaderSets[1]->ShaderProgram = rlLoadShaderCode(VertShaderSrc, FragShaderSrc);
-    _shaderSets[2]->ShaderProgram = rlLoadShaderCode(VertShaderSrcMasked, FragShaderSrcMask);
-    _shaderSets[3]->ShaderProgram = rlLoadShaderCode(VertShaderSrcMasked, FragShaderSrcMaskInverted);
-    _shaderSets[4]->ShaderProgram = rlLoadShaderCode(VertShaderSrc, FragShaderSrcPremultipliedAlpha);
-    _shaderSets[5]->ShaderProgram = rlLoadShaderCode(VertShaderSrcMasked, FragShaderSrcMaskPremultipliedAlpha);
-    _shaderSets[6]->ShaderProgram = rlLoadShaderCode(VertShaderSrcMasked, FragShaderSrcMaskInvertedPremultipliedAlpha);
-
-    // 加算も通常と同じシェーダーを利用する
-    _shaderSets[7]->ShaderProgram = _shaderSets[1]->ShaderProgram;
-    _shaderSets[8]->ShaderProgram = _shaderSets[2]->ShaderProgram;
-    _shaderSets[9]->ShaderProgram = _shaderSets[3]->ShaderProgram;
-    _shaderSets[10]->ShaderProgram = _shaderSets[4]->ShaderProgram;
-    _shaderSets[11]->ShaderProgram = _shaderSets[5]->ShaderProgram;
-    _shaderSets[12]->ShaderProgram = _shaderSets[6]->ShaderProgram;
-
-    // 乗算も通常と同じシェーダーを利用する
-    _shaderSets[13]->ShaderProgram = _shaderSets[1]->ShaderProgram;
-    _shaderSets[14]->ShaderProgram = _shaderSets[2]->ShaderProgram;
-    _shaderSets[15]->ShaderProgram = _shaderSets[3]->ShaderProgram;
-    _shaderSets[16]->ShaderProgram = _shaderSets[4]->ShaderProgram;
-    _shaderSets[17]->ShaderProgram = _shaderSets[5]->ShaderProgram;
-    _shaderSets[18]->ShaderProgram = _shaderSets[6]->ShaderProgram;
-
-    // SetupMask
-    _shaderSets[0]->AttributePositionLocation = rlGetLocationAttrib(_shaderSets[0]->ShaderProgram, "a_position");
-    _shaderSets[0]->AttributeTexCoordLocation = rlGetLocationAttrib(_shaderSets[0]->ShaderProgram, "a_texCoord");
-    _shaderSets[0]->SamplerTexture0Location = rlGetLocationUniform(_shaderSets[0]->ShaderProgram, "s_texture0");
-    _shaderSets[0]->UniformClipMatrixLocation = rlGetLocationUniform(_shaderSets[0]->ShaderProgram, "u_clipMatrix");
-    _shaderSets[0]->UnifromChannelFlagLocation = rlGetLocationUniform(_shaderSets[0]->ShaderProgram, "u_channelFlag");
-    _shaderSets[0]->UniformBaseColorLocation = rlGetLocationUniform(_shaderSets[0]->ShaderProgram, "u_baseColor");
-    _shaderSets[0]->UniformMultiplyColorLocation = rlGetLocationUniform(_shaderSets[0]->ShaderProgram, "u_multiplyColor");
-    _shaderSets[0]->UniformScreenColorLocation = rlGetLocationUniform(_shaderSets[0]->ShaderProgram, "u_screenColor");
-
-    // 通常
-    _shaderSets[1]->AttributePositionLocation = rlGetLocationAttrib(_shaderSets[1]->ShaderProgram, "a_position");
-    _shaderSets[1]->AttributeTexCoordLocation = rlGetLocationAttrib(_shaderSets[1]->ShaderProgram, "a_texCoord");
-    _shaderSets[1]->SamplerTexture0Location = rlGetLocationUniform(_shaderSets[1]->ShaderProgram, "s_texture0");
-    _shaderSets[1]->UniformMatrixLocation = rlGetLocationUniform(_shaderSets[1]->ShaderProgram, "u_matrix");
-    _shaderSets[1]->UniformBaseColorLocation = rlGetLocationUniform(_shaderSets[1]->ShaderProgram, "u_baseColor");
-    _shaderSets[1]->UniformMultiplyColorLocation = rlGetLocationUniform(_shaderSets[1]->ShaderProgram, "u_multiplyColor");
-    _shaderSets[1]->UniformScreenColorLocation = rlGetLocationUniform(_shaderSets[1]->ShaderProgram, "u_screenColor");
-
-    // 通常（クリッピング）
-    _shaderSets[2]->AttributePositionLocation = rlGetLocationAttrib(_shaderSets[2]->ShaderProgram, "a_position");
-    _shaderSets[2]->AttributeTexCoordLocation = rlGetLocationAttrib(_shaderSets[2]->ShaderProgram, "a_texCoord");
-    _shaderSets[2]->SamplerTexture0Location = rlGetLocationUniform(_shaderSets[2]->ShaderProgram, "s_texture0");
-    _shaderSets[2]->SamplerTexture1Location = rlGetLocationUniform(_shaderSets[2]->ShaderProgram, "s_texture1");
-    _shaderSets[2]->UniformMatrixLocation = rlGetLocationUniform(_shaderSets[2]->ShaderProgram, "u_matrix");
-    _shaderSets[2]->UniformClipMatrixLocation = rlGetLocationUniform(_shaderSets[2]->ShaderProgram, "u_clipMatrix");
-    _shaderSets[2]->UnifromChannelFlagLocation = rlGetLocationUniform(_shaderSets[2]->ShaderProgram, "u_channelFlag");
-    _shaderSets[2]->UniformBaseColorLocation = rlGetLocationUniform(_shaderSets[2]->ShaderProgram, "u_baseColor");
-    _shaderSets[2]->UniformMultiplyColorLocation = rlGetLocationUniform(_shaderSets[2]->ShaderProgram, "u_multiplyColor");
-    _shaderSets[2]->UniformScreenColorLocation = rlGetLocationUniform(_shaderSets[2]->ShaderProgram, "u_screenColor");
-
-    // 通常（クリッピング・反転）
-    _shaderSets[3]->AttributePositionLocation = rlGetLocationAttrib(_shaderSets[3]->ShaderProgram, "a_position");
-    _shaderSets[3]->AttributeTexCoordLocation = rlGetLocationAttrib(_shaderSets[3]->ShaderProgram, "a_texCoord");
-    _shaderSets[3]->SamplerTexture0Location = rlGetLocationUniform(_shaderSets[3]->ShaderProgram, "s_texture0");
-    _shaderSets[3]->SamplerTexture1Location = rlGetLocationUniform(_shaderSets[3]->ShaderProgram, "s_texture1");
-    _shaderSets[3]->UniformMatrixLocation = rlGetLocationUniform(_shaderSets[3]->ShaderProgram, "u_matrix");
-    _shaderSets[3]->UniformClipMatrixLocation = rlGetLocationUniform(_shaderSets[3]->ShaderProgram, "u_clipMatrix");
-    _shaderSets[3]->UnifromChannelFlagLocation = rlGetLocationUniform(_shaderSets[3]->ShaderProgram, "u_channelFlag");
-    _shaderSets[3]->UniformBaseColorLocation = rlGetLocationUniform(_shaderSets[3]->ShaderProgram, "u_baseColor");
-    _shaderSets[3]->UniformMultiplyColorLocation = rlGetLocationUniform(_shaderSets[3]->ShaderProgram, "u_multiplyColor");
-    _shaderSets[3]->UniformScreenColorLocation = rlGetLocationUniform(_shaderSets[3]->ShaderProgram, "u_screenColor");
-
-    // 通常（PremultipliedAlpha）
-    _shaderSets[4]->AttributePositionLocation = rlGetLocationAttrib(_shaderSets[4]->ShaderProgram, "a_position");
-    _shaderSets[4]->AttributeTexCoordLocation = rlGetLocationAttrib(_shaderSets[4]->ShaderProgram, "a_texCoord");
-    _shaderSets[4]->SamplerTexture0Location = rlGetLocationUniform(_shaderSets[4]->ShaderProgram, "s_texture0");
-    _shaderSets[4]->UniformMatrixLocation = rlGetLocationUniform(_shaderSets[4]->ShaderProgram, "u_matrix");
-    _shaderSets[4]->UniformBaseColorLocation = rlGetLocationUniform(_shaderSets[4]->ShaderProgram, "u_baseColor");
-    _shaderSets[4]->UniformMultiplyColorLocation = rlGetLocationUniform(_shaderSets[4]->ShaderProgram, "u_multiplyColor");
-    _shaderSets[4]->UniformScreenColorLocation = rlGetLocationUniform(_shaderSets[4]->ShaderProgram, "u_screenColor");
-
-    // 通常（クリッピング、PremultipliedAlpha）
-    _shaderSets[5]->AttributePositionLocation = rlGetLocationAttrib(_shaderSets[5]->ShaderProgram, "a_position");
-    _shaderSets[5]->AttributeTexCoordLocation = rlGetLocationAttrib(_shaderSets[5]->ShaderProgram, "a_texCoord");
-    _shaderSets[5]->SamplerTexture0Location = rlGetLocationUniform(_shaderSets[5]->ShaderProgram, "s_texture0");
-    _shaderSets[5]->SamplerTexture1Location = rlGetLocationUniform(_shaderSets[5]->ShaderProgram, "s_texture1");
-    _shaderSets[5]->UniformMatrixLocation = rlGetLocationUniform(_shaderSets[5]->ShaderProgram, "u_matrix");
-    _shaderSets[5]->UniformClipMatrixLocation = rlGetLocationUniform(_shaderSets[5]->ShaderProgram, "u_clipMatrix");
-    _shaderSets[5]->UnifromChannelFlagLocation = rlGetLocationUniform(_shaderSets[5]->ShaderProgram, "u_channelFlag");
-    _shaderSets[5]->UniformBaseColorLocation = rlGetLocationUniform(_shaderSets[5]->ShaderProgram, "u_baseColor");
-    _shaderSets[5]->UniformMultiplyColorLocation = rlGetLocationUniform(_shaderSets[5]->ShaderProgram, "u_multiplyColor");
-    _shaderSets[5]->UniformScreenColorLocation = rlGetLocationUniform(_shaderSets[5]->ShaderProgram, "u_screenColor");
-
-    // 通常（クリッピング・反転、PremultipliedAlpha）
-    _shaderSets[6]->AttributePositionLocation = rlGetLocationAttrib(_shaderSets[6]->ShaderProgram, "a_position");
-    _shaderSets[6]->AttributeTexCoordLocation = rlGetLocationAttrib(_shaderSets[6]->ShaderProgram, "a_texCoord");
-    _shaderSets[6]->SamplerTexture0Location = rlGetLocationUniform(_shaderSets[6]->ShaderProgram, "s_texture0");
-    _shaderSets[6]->SamplerTexture1Location = rlGetLocationUniform(_shaderSets[6]->ShaderProgram, "s_texture1");
-    _shaderSets[6]->UniformMatrixLocation = rlGetLocationUniform(_shaderSets[6]->ShaderProgram, "u_matrix");
-    _shaderSets[6]->UniformClipMatrixLocation = rlGetLocationUniform(_shaderSets[6]->ShaderProgram, "u_clipMatrix");
-    _shaderSets[6]->UnifromChannelFlagLocation = rlGetLocationUniform(_shaderSets[6]->ShaderProgram, "u_channelFlag");
-    _shaderSets[6]->UniformBaseColorLocation = rlGetLocationUniform(_shaderSets[6]->ShaderProgram, "u_baseColor");
-    _shaderSets[6]->UniformMultiplyColorLocation = rlGetLocationUniform(_shaderSets[6]->ShaderProgram, "u_multiplyColor");
-    _shaderSets[6]->UniformScreenColorLocation = rlGetLocationUniform(_shaderSets[6]->ShaderProgram, "u_screenColor");
-
-    // 加算
-    _shaderSets[7]->AttributePositionLocation = rlGetLocationAttrib(_shaderSets[7]->ShaderProgram, "a_position");
-    _shaderSets[7]->AttributeTexCoordLocation = rlGetLocationAttrib(_shaderSets[7]->ShaderProgram, "a_texCoord");
-    _shaderSets[7]->SamplerTexture0Location = rlGetLocationUniform(_shaderSets[7]->ShaderProgram, "s_texture0");
-    _shaderSets[7]->UniformMatrixLocation = rlGetLocationUniform(_shaderSets[7]->ShaderProgram, "u_matrix");
-    _shaderSets[7]->UniformBaseColorLocation = rlGetLocationUniform(_shaderSets[7]->ShaderProgram, "u_baseColor");
-    _shaderSets[7]->UniformMultiplyColorLocation = rlGetLocationUniform(_shaderSets[7]->ShaderProgram, "u_multiplyColor");
-    _shaderSets[7]->UniformScreenColorLocation = rlGetLocationUniform(_shaderSets[7]->ShaderProgram, "u_screenColor");
-
-    // 加算（クリッピング）
-    _shaderSets[8]->AttributePositionLocation = rlGetLocationAttrib(_shaderSets[8]->ShaderProgram, "a_position");
-    _shaderSets[8]->AttributeTexCoordLocation = rlGetLocationAttrib(_shaderSets[8]->ShaderProgram, "a_texCoord");
-    _shaderSets[8]->SamplerTexture0Location = rlGetLocationUniform(_shaderSets[8]->ShaderProgram, "s_texture0");
-    _shaderSets[8]->SamplerTexture1Location = rlGetLocationUniform(_shaderSets[8]->ShaderProgram, "s_texture1");
-    _shaderSets[8]->UniformMatrixLocation = rlGetLocationUniform(_shaderSets[8]->ShaderProgram, "u_matrix");
-    _shaderSets[8]->UniformClipMatrixLocation = rlGetLocationUniform(_shaderSets[8]->ShaderProgram, "u_clipMatrix");
-    _shaderSets[8]->UnifromChannelFlagLocation = rlGetLocationUniform(_shaderSets[8]->ShaderProgram, "u_channelFlag");
-    _shaderSets[8]->UniformBaseColorLocation = rlGetLocationUniform(_shaderSets[8]->ShaderProgram, "u_baseColor");
-    _shaderSets[8]->UniformMultiplyColorLocation = rlGetLocationUniform(_shaderSets[8]->ShaderProgram, "u_multiplyColor");
-    _shaderSets[8]->UniformScreenColorLocation = rlGetLocationUniform(_shaderSets[8]->ShaderProgram, "u_screenColor");
-
-    // 加算（クリッピング・反転）
-    _shaderSets[9]->AttributePositionLocation = rlGetLocationAttrib(_shaderSets[9]->ShaderProgram, "a_position");
-    _shaderSets[9]->AttributeTexCoordLocation = rlGetLocationAttrib(_shaderSets[9]->ShaderProgram, "a_texCoord");
-    _shaderSets[9]->SamplerTexture0Location = rlGetLocationUniform(_shaderSets[9]->ShaderProgram, "s_texture0");
-    _shaderSets[9]->SamplerTexture1Location = rlGetLocationUniform(_shaderSets[9]->ShaderProgram, "s_texture1");
-    _shaderSets[9]->UniformMatrixLocation = rlGetLocationUniform(_shaderSets[9]->ShaderProgram, "u_matrix");
-    _shaderSets[9]->UniformClipMatrixLocation = rlGetLocationUniform(_shaderSets[9]->ShaderProgram, "u_clipMatrix");
-    _shaderSets[9]->UnifromChannelFlagLocation = rlGetLocationUniform(_shaderSets[9]->ShaderProgram, "u_channelFlag");
-    _shaderSets[9]->UniformBaseColorLocation = rlGetLocationUniform(_shaderSets[9]->ShaderProgram, "u_baseColor");
-    _shaderSets[9]->UniformMultiplyColorLocation = rlGetLocationUniform(_shaderSets[9]->ShaderProgram, "u_multiplyColor");
-    _shaderSets[9]->UniformScreenColorLocation = rlGetLocationUniform(_shaderSets[9]->ShaderProgram, "u_screenColor");
-
-    // 加算（PremultipliedAlpha）
-    _shaderSets[10]->AttributePositionLocation = rlGetLocationAttrib(_shaderSets[10]->ShaderProgram, "a_position");
-    _shaderSets[10]->AttributeTexCoordLocation = rlGetLocationAttrib(_shaderSets[10]->ShaderProgram, "a_texCoord");
-    _shaderSets[10]->SamplerTexture0Location = rlGetLocationUniform(_shaderSets[10]->ShaderProgram, "s_texture0");
-    _shaderSets[10]->UniformMatrixLocation = rlGetLocationUniform(_shaderSets[10]->ShaderProgram, "u_matrix");
-    _shaderSets[10]->UniformBaseColorLocation = rlGetLocationUniform(_shaderSets[10]->ShaderProgram, "u_baseColor");
-    _shaderSets[10]->UniformMultiplyColorLocation = rlGetLocationUniform(_shaderSets[10]->ShaderProgram, "u_multiplyColor");
-    _shaderSets[10]->UniformScreenColorLocation = rlGetLocationUniform(_shaderSets[10]->ShaderProgram, "u_screenColor");
-
-    // 加算（クリッピング、PremultipliedAlpha）
-    _shaderSets[11]->AttributePositionLocation = rlGetLocationAttrib(_shaderSets[11]->ShaderProgram, "a_position");
-    _shaderSets[11]->AttributeTexCoordLocation = rlGetLocationAttrib(_shaderSets[11]->ShaderProgram, "a_texCoord");
-    _shaderSets[11]->SamplerTexture0Location = rlGetLocationUniform(_shaderSets[11]->ShaderProgram, "s_texture0");
-    _shaderSets[11]->SamplerTexture1Location = rlGetLocationUniform(_shaderSets[11]->ShaderProgram, "s_texture1");
-    _shaderSets[11]->UniformMatrixLocation = rlGetLocationUniform(_shaderSets[11]->ShaderProgram, "u_matrix");
-    _shaderSets[11]->UniformClipMatrixLocation = rlGetLocationUniform(_shaderSets[11]->ShaderProgram, "u_clipMatrix");
-    _shaderSets[11]->UnifromChannelFlagLocation = rlGetLocationUniform(_shaderSets[11]->ShaderProgram, "u_channelFlag");
-    _shaderSets[11]->UniformBaseColorLocation = rlGetLocationUniform(_shaderSets[11]->ShaderProgram, "u_baseColor");
-    _shaderSets[11]->UniformMultiplyColorLocation = rlGetLocationUniform(_shaderSets[11]->ShaderProgram, "u_multiplyColor");
-    _shaderSets[11]->UniformScreenColorLocation = rlGetLocationUniform(_shaderSets[11]->ShaderProgram, "u_screenColor");
-
-    // 加算（クリッピング・反転、PremultipliedAlpha）
-    _shaderSets[12]->AttributePositionLocation = rlGetLocationAttrib(_shaderSets[12]->ShaderProgram, "a_position");
-    _shaderSets[12]->AttributeTexCoordLocation = rlGetLocationAttrib(_shaderSets[12]->ShaderProgram, "a_texCoord");
-    _shaderSets[12]->SamplerTexture0Location = rlGetLocationUniform(_shaderSets[12]->ShaderProgram, "s_texture0");
-    _shaderSets[12]->SamplerTexture1Location = rlGetLocationUniform(_shaderSets[12]->ShaderProgram, "s_texture1");
-    _shaderSets[12]->UniformMatrixLocation = rlGetLocationUniform(_shaderSets[12]->ShaderProgram, "u_matrix");
-    _shaderSets[12]->UniformClipMatrixLocation = rlGetLocationUniform(_shaderSets[12]->ShaderProgram, "u_clipMatrix");
-    _shaderSets[12]->UnifromChannelFlagLocation = rlGetLocationUniform(_shaderSets[12]->ShaderProgram, "u_channelFlag");
-    _shaderSets[12]->UniformBaseColorLocation = rlGetLocationUniform(_shaderSets[12]->ShaderProgram, "u_baseColor");
-    _shaderSets[12]->UniformMultiplyColorLocation = rlGetLocationUniform(_shaderSets[12]->ShaderProgram, "u_multiplyColor");
-    _shaderSets[12]->UniformScreenColorLocation = rlGetLocationUniform(_shaderSets[12]->ShaderProgram, "u_screenColor");
-
-    // 乗算
-    _shaderSets[13]->AttributePositionLocation = rlGetLocationAttrib(_shaderSets[13]->ShaderProgram, "a_position");
-    _shaderSets[13]->AttributeTexCoordLocation = rlGetLocationAttrib(_shaderSets[13]->ShaderProgram, "a_texCoord");
-    _shaderSets[13]->SamplerTexture0Location = rlGetLocationUniform(_shaderSets[13]->ShaderProgram, "s_texture0");
-    _shaderSets[13]->UniformMatrixLocation = rlGetLocationUniform(_shaderSets[13]->ShaderProgram, "u_matrix");
-    _shaderSets[13]->UniformBaseColorLocation = rlGetLocationUniform(_shaderSets[13]->ShaderProgram, "u_baseColor");
-    _shaderSets[13]->UniformMultiplyColorLocation = rlGetLocationUniform(_shaderSets[13]->ShaderProgram, "u_multiplyColor");
-    _shaderSets[13]->UniformScreenColorLocation = rlGetLocationUniform(_shaderSets[13]->ShaderProgram, "u_screenColor");
-
-    // 乗算（クリッピング）
-    _shaderSets[14]->AttributePositionLocation = rlGetLocationAttrib(_shaderSets[14]->ShaderProgram, "a_position");
-    _shaderSets[14]->AttributeTexCoordLocation = rlGetLocationAttrib(_shaderSets[14]->ShaderProgram, "a_texCoord");
-    _shaderSets[14]->SamplerTexture0Location = rlGetLocationUniform(_shaderSets[14]->ShaderProgram, "s_texture0");
-    _shaderSets[14]->SamplerTexture1Location = rlGetLocationUniform(_shaderSets[14]->ShaderProgram, "s_texture1");
-    _shaderSets[14]->UniformMatrixLocation = rlGetLocationUniform(_shaderSets[14]->ShaderProgram, "u_matrix");
-    _shaderSets[14]->UniformClipMatrixLocation = rlGetLocationUniform(_shaderSets[14]->ShaderProgram, "u_clipMatrix");
-    _shaderSets[14]->UnifromChannelFlagLocation = rlGetLocationUniform(_shaderSets[14]->ShaderProgram, "u_channelFlag");
-    _shaderSets[14]->UniformBaseColorLocation = rlGetLocationUniform(_shaderSets[14]->ShaderProgram, "u_baseColor");
-    _shaderSets[14]->UniformMultiplyColorLocation = rlGetLocationUniform(_shaderSets[14]->ShaderProgram, "u_multiplyColor");
-    _shaderSets[14]->UniformScreenColorLocation = rlGetLocationUniform(_shaderSets[14]->ShaderProgram, "u_screenColor");
-
-    // 乗算（クリッピング・反転）
-    _shaderSets[15]->AttributePositionLocation = rlGetLocationAttrib(_shaderSets[15]->ShaderProgram, "a_position");
-    _shaderSets[15]->AttributeTexCoordLocation = rlGetLocationAttrib(_shaderSets[15]->ShaderProgram, "a_texCoord");
-    _shaderSets[15]->SamplerTexture0Location = rlGetLocationUniform(_shaderSets[15]->ShaderProgram, "s_texture0");
-    _shaderSets[15]->SamplerTexture1Location = rlGetLocationUniform(_shaderSets[15]->ShaderProgram, "s_texture1");
-    _shaderSets[15]->UniformMatrixLocation = rlGetLocationUniform(_shaderSets[15]->ShaderProgram, "u_matrix");
-    _shaderSets[15]->UniformClipMatrixLocation = rlGetLocationUniform(_shaderSets[15]->ShaderProgram, "u_clipMatrix");
-    _shaderSets[15]->UnifromChannelFlagLocation = rlGetLocationUniform(_shaderSets[15]->ShaderProgram, "u_channelFlag");
-    _shaderSets[15]->UniformBaseColorLocation = rlGetLocationUniform(_shaderSets[15]->ShaderProgram, "u_baseColor");
-    _shaderSets[15]->UniformMultiplyColorLocation = rlGetLocationUniform(_shaderSets[15]->ShaderProgram, "u_multiplyColor");
-    _shaderSets[15]->UniformScreenColorLocation = rlGetLocationUniform(_shaderSets[15]->ShaderProgram, "u_screenColor");
-
-    // 乗算（PremultipliedAlpha）
-    _shaderSets[16]->AttributePositionLocation = rlGetLocationAttrib(_shaderSets[16]->ShaderProgram, "a_position");
-    _shaderSets[16]->AttributeTexCoordLocation = rlGetLocationAttrib(_shaderSets[16]->ShaderProgram, "a_texCoord");
-    _shaderSets[16]->SamplerTexture0Location = rlGetLocationUniform(_shaderSets[16]->ShaderProgram, "s_texture0");
-    _shaderSets[16]->UniformMatrixLocation = rlGetLocationUniform(_shaderSets[16]->ShaderProgram, "u_matrix");
-    _shaderSets[16]->UniformBaseColorLocation = rlGetLocationUniform(_shaderSets[16]->ShaderProgram, "u_baseColor");
-    _shaderSets[16]->UniformMultiplyColorLocation = rlGetLocationUniform(_shaderSets[16]->ShaderProgram, "u_multiplyColor");
-    _shaderSets[16]->UniformScreenColorLocation = rlGetLocationUniform(_shaderSets[16]->ShaderProgram, "u_screenColor");
-
-    // 乗算（クリッピング、PremultipliedAlpha）
-    _shaderSets[17]->AttributePositionLocation = rlGetLocationAttrib(_shaderSets[17]->ShaderProgram, "a_position");
-    _shaderSets[17]->AttributeTexCoordLocation = rlGetLocationAttrib(_shaderSets[17]->ShaderProgram, "a_texCoord");
-    _shaderSets[17]->SamplerTexture0Location = rlGetLocationUniform(_shaderSets[17]->ShaderProgram, "s_texture0");
-    _shaderSets[17]->SamplerTexture1Location = rlGetLocationUniform(_shaderSets[17]->ShaderProgram, "s_texture1");
-    _shaderSets[17]->UniformMatrixLocation = rlGetLocationUniform(_shaderSets[17]->ShaderProgram, "u_matrix");
-    _shaderSets[17]->UniformClipMatrixLocation = rlGetLocationUniform(_shaderSets[17]->ShaderProgram, "u_clipMatrix");
-    _shaderSets[17]->UnifromChannelFlagLocation = rlGetLocationUniform(_shaderSets[17]->ShaderProgram, "u_channelFlag");
-    _shaderSets[17]->UniformBaseColorLocation = rlGetLocationUniform(_shaderSets[17]->ShaderProgram, "u_baseColor");
-    _shaderSets[17]->UniformMultiplyColorLocation = rlGetLocationUniform(_shaderSets[17]->ShaderProgram, "u_multiplyColor");
-    _shaderSets[17]->UniformScreenColorLocation = rlGetLocationUniform(_shaderSets[17]->ShaderProgram, "u_screenColor");
-
-    // 乗算（クリッピング・反転、PremultipliedAlpha）
-    _shaderSets[18]->AttributePositionLocation = rlGetLocationAttrib(_shaderSets[18]->ShaderProgram, "a_position");
-    _shaderSets[18]->AttributeTexCoordLocation = rlGetLocationAttrib(_shaderSets[18]->ShaderProgram, "a_texCoord");
-    _shaderSets[18]->SamplerTexture0Location = rlGetLocationUniform(_shaderSets[18]->ShaderProgram, "s_texture0");
-    _shaderSets[18]->SamplerTexture1Location = rlGetLocationUniform(_shaderSets[18]->ShaderProgram, "s_texture1");
-    _shaderSets[18]->UniformMatrixLocation = rlGetLocationUniform(_shaderSets[18]->ShaderProgram, "u_matrix");
-    _shaderSets[18]->UniformClipMatrixLocation = rlGetLocationUniform(_shaderSets[18]->ShaderProgram, "u_clipMatrix");
-    _shaderSets[18]->UnifromChannelFlagLocation = rlGetLocationUniform(_shaderSets[18]->ShaderProgram, "u_channelFlag");
-    _shaderSets[18]->UniformBaseColorLocation = rlGetLocationUniform(_shaderSets[18]->ShaderProgram, "u_baseColor");
-    _shaderSets[18]->UniformMultiplyColorLocation = rlGetLocationUniform(_shaderSets[18]->ShaderProgram, "u_multiplyColor");
-    _shaderSets[18]->UniformScreenColorLocation = rlGetLocationUniform(_shaderSets[18]->ShaderProgram, "u_screenColor");
-
-    for (csmInt32 i = 0; i < ShaderCount; i++)
-    {
-        CubismShaderSet* shaderSet = _shaderSets[i];
-
-        // VAO Allocate
-        shaderSet->VertexArrayObjectId = rlLoadVertexArray();
-        rlEnableVertexArray(shaderSet->VertexArrayObjectId);
-
-        // 頂点配列の設定
-        shaderSet->VertexBufferPositionId = rlLoadVertexBuffer(NULL, sizeof(csmFloat32) * MAX_VERTEX_COUNT * 2, true);
-        rlEnableVertexAttribute(shaderSet->AttributePositionLocation);
-        rlSetVertexAttribute(shaderSet->AttributePositionLocation, 2, RL_FLOAT, false, sizeof(csmFloat32) * 2, NULL);
-
-        // テクスチャ頂点の設定
-        shaderSet->VertexBufferTexcoordId = rlLoadVertexBuffer(NULL, sizeof(csmFloat32) * MAX_VERTEX_COUNT * 2, true);
-        rlEnableVertexAttribute(shaderSet->AttributeTexCoordLocation);
-        rlSetVertexAttribute(shaderSet->AttributeTexCoordLocation, 2, RL_FLOAT, false, sizeof(csmFloat32) * 2, NULL);
+        CubismShaderSet* shaderSet = CSM_NEW CubismShaderSet();
+        memset(shaderSet, 0, sizeof(CubismShaderSet));
+        _shaderSets.PushBack(shaderSet);
+    }
 
-        // EBO
-        shaderSet->VertexBufferElementId = rlLoadVertexBufferElement(NULL, sizeof(csmUint16) * MAX_VERTEX_COUNT, true);
+    // 加算・乗算は通常と同じシェーダーを利用するので、ソースは通常のセットにだけ設定する
+    _shaderSets[ShaderNames_SetupMask]->VertexShaderSource = VertShaderSrcSetupMask;
+    _shaderSets[ShaderNames_SetupMask]->FragmentShaderSource = FragShaderSrcSetupMask;
+    _shaderSets[ShaderNames_Normal]->VertexShaderSource = VertShaderSrc;
+    _shaderSets[ShaderNames_Normal]->FragmentShaderSource = FragShaderSrc;
+    _shaderSets[ShaderNames_NormalMasked]->VertexShaderSource = VertShaderSrcMasked;
+    _shaderSets[ShaderNames_NormalMasked]->FragmentShaderSource = FragShaderSrcMask;
+    _shaderSets[ShaderNames_NormalMaskedInverted]->VertexShaderSource = VertShaderSrcMasked;
+    _shaderSets[ShaderNames_NormalMaskedInverted]->FragmentShaderSource = FragShaderSrcMaskInverted;
+    _shaderSets[ShaderNames_NormalPremultipliedAlpha]->VertexShaderSource = VertShaderSrc;
+    _shaderSets[ShaderNames_NormalPremultipliedAlpha]->FragmentShaderSource = FragShaderSrcPremultipliedAlpha;
+    _shaderSets[ShaderNames_NormalMaskedPremultipliedAlpha]->VertexShaderSource = VertShaderSrcMasked;
+    _shaderSets[ShaderNames_NormalMaskedPremultipliedAlpha]->FragmentShaderSource = FragShaderSrcMaskPremultipliedAlpha;
+    _shaderSets[ShaderNames_NormalMaskedInvertedPremultipliedAlpha]->VertexShaderSource = VertShaderSrcMasked;
+    _shaderSets[ShaderNames_NormalMaskedInvertedPremultipliedAlpha]->FragmentShaderSource = FragShaderSrcMaskInvertedPremultipliedAlpha;
+
+#if !defined(CSM_TARGET_IPHONE_ES2) && !defined(CSM_TARGET_ANDROID_ES2)
+    // インスタンス描画（GLSL 3.30以降が必要なので、ES2ではソースを設定せずプログラムを作らない）
+    _shaderSets[ShaderNames_Instanced]->VertexShaderSource = VertShaderSrcInstanced;
+    _shaderSets[ShaderNames_Instanced]->FragmentShaderSource = FragShaderSrcInstanced;
+    _shaderSets[ShaderNames_InstancedPremultipliedAlpha]->VertexShaderSource = VertShaderSrcInstanced;
+    _shaderSets[ShaderNames_InstancedPremultipliedAlpha]->FragmentShaderSource = FragShaderSrcInstancedPremultipliedAlpha;
+#endif
 
-        rlDisableVertexArray();
-        rlDisableVertexBuffer();
-        rlDisableVertexBufferElement();
-    }
+    InvalidateState();
 }
 
-const int GL_ZERO = 0;
-const int GL_ONE = 1;
-const int GL_ONE_MINUS_SRC_COLOR = 0x301;
-const int GL_ONE_MINUS_SRC_ALPHA = 0x303;
-const int GL_DST_COLOR = 0x306;
-const int GL_FUNC_ADD = 0x8006;
-
-void CubismShader_OpenGLES2::SetupShaderProgram(CubismRenderer_OpenGLES2* renderer, unsigned int textureId
-                                                , csmInt32 indexCount, csmUint16* indexArray
-                                                , csmInt32 vertexCount, csmFloat32* vertexArray
-                                                , csmFloat32* uvArray, csmFloat32 opacity
-                                                , CubismRenderer::CubismBlendMode colorBlendMode
-                                                , CubismRenderer::CubismTextureColor baseColor
-                                                , CubismRenderer::CubismTextureColor multiplyColor
-                                                , CubismRenderer::CubismTextureColor screenColor
-                                                , csmBool isPremultipliedAlpha, CubismMatrix44 matrix4x4
-                                                , csmBool invertedMask)
+CubismShader_OpenGLES2::CubismShaderSet* CubismShader_OpenGLES2::GetShaderSet(csmInt32 index)
 {
     if (_shaderSets.GetSize() == 0)
     {
         GenerateShaders();
     }
 
-    const int uniform0 = 0;
-    CubismShaderSet* shaderSet;
-
-    if (renderer->GetClippingContextBufferForMask() != NULL) // マスク生成時
+    if (!_shaderSets[index]->IsLoaded)
     {
-        shaderSet = _shaderSets[ShaderNames_SetupMask];
-        rlSetBlendFactorsSeparate(GL_ZERO, GL_ONE_MINUS_SRC_COLOR, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA, GL_FUNC_ADD, GL_FUNC_ADD);
-        rlSetBlendMode(RL_BLEND_CUSTOM_SEPARATE);
-        rlEnableShader(shaderSet->ShaderProgram);
-        rlEnableVertexArray(shaderSet->VertexArrayObjectId);
+        LoadShaderSet(index);
+    }
 
-        //テクスチャ設定
-        rlActiveTextureSlot(0);
-        rlEnableTexture(textureId);
-        rlSetUniform(shaderSet->SamplerTexture0Location, &uniform0, RL_SHADER_UNIFORM_INT, 1);
+    return _shaderSets[index];
+}
 
-        // チャンネル
-        const csmInt32 channelNo = renderer->GetClippingContextBufferForMask()->_layoutChannelNo;
-        CubismRenderer::CubismTextureColor* colorChannel = renderer->GetClippingContextBufferForMask()->GetClippingManager()->GetChannelFlagAsColor(channelNo);
-        rlSetUniform(shaderSet->UnifromChannelFlagLocation, &colorChannel->R, RL_SHADER_UNIFORM_VEC4, 1);
-        rlSetUniformMatrixDirectly(shaderSet->UniformClipMatrixLocation, renderer->GetClippingContextBufferForMask()->_matrixForMask.GetArray());
+void CubismShader_OpenGLES2::LoadShaderSet(csmInt32 index)
+{
+    CubismShaderSet* shaderSet = _shaderSets[index];
 
-        csmRectF* rect = renderer->GetClippingContextBufferForMask()->_layoutBounds;
-        float uniformBaseColor[4] = { rect->X * 2.0f - 1.0f, rect->Y * 2.0f - 1.0f, rect->GetRight() * 2.0f - 1.0f, rect->GetBottom() * 2.0f - 1.0f };
-        rlSetUniform(shaderSet->UniformBaseColorLocation, uniformBaseColor, RL_SHADER_UNIFORM_VEC4, 1);
-        rlSetUniform(shaderSet->UniformMultiplyColorLocation, &multiplyColor.R, RL_SHADER_UNIFORM_VEC4, 1);
-        rlSetUniform(shaderSet->UniformScreenColorLocation, &screenColor.R, RL_SHADER_UNIFORM_VEC4, 1);
+    if (index >= ShaderNames_Add && index <= ShaderNames_MultMaskedPremultipliedAlphaInverted)
+    {
+        // 加算・乗算は通常のセットとプログラムが同じなので、VAOとシャドウステートも共有する
+        const CubismShaderSet* owner = GetShaderSet((index - ShaderNames_Normal) % (ShaderNames_Add - ShaderNames_Normal) + ShaderNames_Normal);
+        *shaderSet = *owner;
+        shaderSet->IsProgramOwner = false;
+        return;
+    }
+
+    shaderSet->IsLoaded = true;
+    shaderSet->IsProgramOwner = true;
+
+    if (shaderSet->VertexShaderSource == NULL)
+    {
+        return;
+    }
+
+    const unsigned int program = LoadProgram(shaderSet->VertexShaderSource, shaderSet->FragmentShaderSource);
+    shaderSet->ShaderProgram = program;
+
+    // 使わない変数のアドレスは-1になる
+    shaderSet->AttributePositionLocation = rlGetLocationAttrib(program, "a_position");
+    shaderSet->AttributeTexCoordLocation = rlGetLocationAttrib(program, "a_texCoord");
+    shaderSet->SamplerTexture0Location = rlGetLocationUniform(program, "s_texture0");
+    shaderSet->SamplerTexture1Location = rlGetLocationUniform(program, "s_texture1");
+    shaderSet->UniformMatrixLocation = rlGetLocationUniform(program, "u_matrix");
+    shaderSet->UniformClipMatrixLocation = rlGetLocationUniform(program, "u_clipMatrix");
+    shaderSet->UnifromChannelFlagLocation = rlGetLocationUniform(program, "u_channelFlag");
+    shaderSet->UniformBaseColorLocation = rlGetLocationUniform(program, "u_baseColor");
+    shaderSet->UniformMultiplyColorLocation = rlGetLocationUniform(program, "u_multiplyColor");
+    shaderSet->UniformScreenColorLocation = rlGetLocationUniform(program, "u_screenColor");
+    shaderSet->AttributeInstanceMatrixLocation = rlGetLocationAttrib(program, "a_instanceMatrix");
+    shaderSet->AttributeInstanceOpacityLocation = rlGetLocationAttrib(program, "a_instanceOpacity");
+    shaderSet->SamplerVerticesLocation = rlGetLocationUniform(program, "s_vertices");
+    shaderSet->UniformVertexOffsetLocation = rlGetLocationUniform(program, "u_vertexOffset");
+    shaderSet->UniformInstanceStrideLocation = rlGetLocationUniform(program, "u_instanceStride");
+
+    // VAO Allocate
+    // 頂点・UV・インデックスのバッファはモデルごとにレンダラが持つので、ここではアトリビュートの有効化だけ行う
+    shaderSet->VertexArrayObjectId = rlLoadVertexArray();
+    rlEnableVertexArray(shaderSet->VertexArrayObjectId);
+
+    if (index == ShaderNames_Instanced || index == ShaderNames_InstancedPremultipliedAlpha)
+    {
+        // 頂点座標はテクスチャから読むので、UVとインスタンスごとの属性だけを有効にする
+        // インスタンスごとの属性はインスタンス1つにつき1回進める。行列はmat4なので連続する4つを使う
+        rlEnableVertexAttribute(shaderSet->AttributeTexCoordLocation);
+        for (csmUint32 column = 0; column < 4; column++)
+        {
+            rlEnableVertexAttribute(shaderSet->AttributeInstanceMatrixLocation + column);
+            rlSetVertexAttributeDivisor(shaderSet->AttributeInstanceMatrixLocation + column, 1);
+        }
+        rlEnableVertexAttribute(shaderSet->AttributeInstanceOpacityLocation);
+        rlSetVertexAttributeDivisor(shaderSet->AttributeInstanceOpacityLocation, 1);
+    }
+    else
+    {
+        rlEnableVertexAttribute(shaderSet->AttributePositionLocation);
+        rlEnableVertexAttribute(shaderSet->AttributeTexCoordLocation);
+    }
+
+    rlDisableVertexArray();
+
+    shaderSet->State = CSM_NEW CubismProgramState();
+    memset(shaderSet->State, 0, sizeof(CubismProgramState));
+
+    // サンプラーのユニットは固定なので、ここで一度だけ設定しておく
+    const int uniform0 = 0;
+    const int uniform1 = 1;
+    rlEnableShader(program);
+    rlSetUniform(shaderSet->SamplerTexture0Location, &uniform0, RL_SHADER_UNIFORM_INT, 1);
+    if (shaderSet->SamplerTexture1Location >= 0)
+    {
+        rlSetUniform(shaderSet->SamplerTexture1Location, &uniform1, RL_SHADER_UNIFORM_INT, 1);
+    }
+    if (shaderSet->SamplerVerticesLocation >= 0)
+    {
+        rlSetUniform(shaderSet->SamplerVerticesLocation, &uniform1, RL_SHADER_UNIFORM_INT, 1);
+    }
+    rlDisableShader();
+
+    // プログラムとVAOの切り替えをこのクラスの外で行ったので、次の設定を必ずGLに送らせる
+    _currentProgram = 0;
+    _currentVertexArray = 0;
+}
+
+unsigned int CubismShader_OpenGLES2::LoadProgram(const csmChar* vertexShaderSource, const csmChar* fragmentShaderSource)
+{
+    const csmString path = GetProgramCachePath(vertexShaderSource, fragmentShaderSource);
+
+    csmUint64 start = GetTimeMicroseconds();
+    unsigned int program = (path.GetLength() > 0) ? LoadProgramBinary(path) : 0;
+    if (program != 0)
+    {
+        const csmFloat32 milliseconds = (GetTimeMicroseconds() - start) / 1000.0f;
+        _programStatistics.CachedPrograms++;
+        _programStatistics.CacheLoadMilliseconds += milliseconds;
+        CubismLogDebug("[Shader] loaded program %u from cache in %.2f ms", program, milliseconds);
+        return program;
+    }
+
+    start = GetTimeMicroseconds();
+    program = rlLoadShaderCode(vertexShaderSource, fragmentShaderSource);
+    const csmFloat32 milliseconds = (GetTimeMicroseconds() - start) / 1000.0f;
+    _programStatistics.CompiledPrograms++;
+    _programStatistics.CompileMilliseconds += milliseconds;
+    CubismLogDebug("[Shader] compiled program %u in %.2f ms", program, milliseconds);
+
+    if (path.GetLength() > 0)
+    {
+        SaveProgramBinary(path, program);
+    }
+
+    return program;
+}
+
+csmString CubismShader_OpenGLES2::GetProgramCachePath(const csmChar* vertexShaderSource, const csmChar* fragmentShaderSource) const
+{
+    if (_programCacheDirectory.GetLength() == 0 || !LoadProgramBinaryFunctions())
+    {
+        return csmString();
+    }
+
+    // バイナリはドライバごとに互換性が無いので、ドライバの情報もハッシュに含める
+    csmUint64 hash = HashString(ProgramBinaryHashSeed, reinterpret_cast<const csmChar*>(s_glGetString(GL_VENDOR)));
+    hash = HashString(hash, reinterpret_cast<const csmChar*>(s_glGetString(GL_RENDERER)));
+    hash = HashString(hash, reinterpret_cast<const csmChar*>(s_glGetString(GL_VERSION)));
+    hash = HashString(hash, vertexShaderSource);
+    hash = HashString(hash, fragmentShaderSource);
+
+    csmChar fileName[32];
+    snprintf(fileName, sizeof(fileName), "/%016llx.bin", hash);
+
+    return _programCacheDirectory + fileName;
+}
+
+unsigned int CubismShader_OpenGLES2::LoadProgramBinary(const csmString& path)
+{
+    FILE* file = fopen(path.GetRawString(), "rb");
+    if (file == NULL)
+    {
+        return 0;
+    }
+
+    ProgramBinaryHeader header;
+    csmByte* binary = NULL;
+    csmBool isRead = fread(&header, sizeof(header), 1, file) == 1
+        && header.Magic == ProgramBinaryMagic
+        && header.Length > 0;
+
+    if (isRead)
+    {
+        binary = static_cast<csmByte*>(CSM_MALLOC(header.Length));
+        isRead = fread(binary, 1, header.Length, file) == header.Length;
+    }
+    fclose(file);
+
+    unsigned int program = 0;
+    if (isRead)
+    {
+        program = s_glCreateProgram();
+        s_glProgramBinary(program, header.Format, binary, static_cast<int>(header.Length));
+
+        // ドライバの更新などで受け付けられなければコンパイルし直す
+        int linkStatus = 0;
+        s_glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+        if (linkStatus == 0)
+        {
+            CubismLogInfo("[Shader] cached program binary was rejected by the driver: %s", path.GetRawString());
+            rlUnloadShaderProgram(program);
+            program = 0;
+            _programStatistics.RejectedBinaries++;
+        }
+    }
+
+    if (binary != NULL)
+    {
+        CSM_FREE(binary);
+    }
+
+    return program;
+}
+
+void CubismShader_OpenGLES2::SaveProgramBinary(const csmString& path, unsigned int shaderProgram) const
+{
+    int length = 0;
+    s_glGetProgramiv(shaderProgram, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+
+    ProgramBinaryHeader header;
+    header.Magic = ProgramBinaryMagic;
+    csmByte* binary = static_cast<csmByte*>(CSM_MALLOC(length));
+    int written = 0;
+    s_glGetProgramBinary(shaderProgram, length, &written, &header.Format, binary);
+    header.Length = static_cast<csmUint32>(written);
+
+    // 取得できなければ保存しない。次回もコンパイルする
+    FILE* file = (written > 0) ? fopen(path.GetRawString(), "wb") : NULL;
+    if (file != NULL)
+    {
+        const csmBool isWritten = fwrite(&header, sizeof(header), 1, file) == 1
+            && fwrite(binary, 1, header.Length, file) == header.Length;
+        fclose(file);
+
+        // 書きかけのファイルを次回読まないよう消しておく
+        if (!isWritten)
+        {
+            remove(path.GetRawString());
+        }
+    }
+    else if (written > 0)
+    {
+        CubismLogWarning("[Shader] failed to write program binary: %s", path.GetRawString());
+    }
+
+    CSM_FREE(binary);
+}
+
+const int GL_ZERO = 0;
+const int GL_ONE = 1;
+const int GL_ONE_MINUS_SRC_COLOR = 0x301;
+const int GL_ONE_MINUS_SRC_ALPHA = 0x303;
+const int GL_DST_COLOR = 0x306;
+const int GL_FUNC_ADD = 0x8006;
+
+void CubismShader_OpenGLES2::InvalidateState()
+{
+    _currentProgram = 0;
+    _currentVertexArray = 0;
+    _currentTextureSlot = -1;
+    _isTextureValid[0] = false;
+    _isTextureValid[1] = false;
+    _isBlendValid = false;
+    _currentCulling = -1;
+
+    // プログラムごとのユニフォームはGL側に残っているが、他者が同じプログラムを使う可能性は無いため
+    // VAOのバッファ設定だけを無効にする（バッファのIDは解放後に再利用されることがある）
+    for (csmUint32 i = 0; i < _shaderSets.GetSize(); i++)
+    {
+        CubismProgramState* state = _shaderSets[i]->State;
+        if (state == NULL || !_shaderSets[i]->IsProgramOwner)
+        {
+            continue;
+        }
+        state->PositionBufferId = 0;
+        state->TexCoordBufferId = 0;
+        state->ElementBufferId = 0;
+        state->InstanceBufferId = 0;
+    }
+}
+
+void CubismShader_OpenGLES2::UseShaderSet(CubismShaderSet* shaderSet)
+{
+    if (_currentVertexArray != shaderSet->VertexArrayObjectId)
+    {
+        rlEnableVertexArray(shaderSet->VertexArrayObjectId);
+        _currentVertexArray = shaderSet->VertexArrayObjectId;
+        _stateChangeCount++;
+    }
+    else
+    {
+        _redundantStateCount++;
+    }
+
+    if (_currentProgram != shaderSet->ShaderProgram)
+    {
+        rlEnableShader(shaderSet->ShaderProgram);
+        _currentProgram = shaderSet->ShaderProgram;
+        _stateChangeCount++;
+    }
+    else
+    {
+        _redundantStateCount++;
+    }
+}
+
+void CubismShader_OpenGLES2::BindTexture(csmInt32 slot, unsigned int textureId)
+{
+    // バインド済みならアクティブなユニットの切り替えも不要
+    if (_isTextureValid[slot] && _currentTextures[slot] == textureId)
+    {
+        _redundantStateCount++;
+        return;
+    }
+
+    if (_currentTextureSlot != slot)
+    {
+        rlActiveTextureSlot(slot);
+        _currentTextureSlot = slot;
+    }
+    rlEnableTexture(textureId);
+    _currentTextures[slot] = textureId;
+    _isTextureValid[slot] = true;
+    _stateChangeCount++;
+}
+
+void CubismShader_OpenGLES2::SetBlendFactors(int srcRgb, int dstRgb, int srcAlpha, int dstAlpha)
+{
+    if (_isBlendValid
+        && _currentBlendFactors[0] == srcRgb && _currentBlendFactors[1] == dstRgb
+        && _currentBlendFactors[2] == srcAlpha && _currentBlendFactors[3] == dstAlpha)
+    {
+        _redundantStateCount++;
+        return;
+    }
+
+    rlSetBlendFactorsSeparate(srcRgb, dstRgb, srcAlpha, dstAlpha, GL_FUNC_ADD, GL_FUNC_ADD);
+    rlSetBlendMode(RL_BLEND_CUSTOM_SEPARATE);
+
+    _currentBlendFactors[0] = srcRgb;
+    _currentBlendFactors[1] = dstRgb;
+    _currentBlendFactors[2] = srcAlpha;
+    _currentBlendFactors[3] = dstAlpha;
+    _isBlendValid = true;
+    _stateChangeCount++;
+}
+
+void CubismShader_OpenGLES2::SetCulling(csmBool isCulling)
+{
+    const csmInt32 culling = isCulling ? 1 : 0;
+    if (_currentCulling == culling)
+    {
+        _redundantStateCount++;
+        return;
+    }
+
+    if (isCulling)
+    {
+        rlEnableBackfaceCulling();
+    }
+    else
+    {
+        rlDisableBackfaceCulling();
+    }
+    _currentCulling = culling;
+    _stateChangeCount++;
+}
+
+void CubismShader_OpenGLES2::SetUniformVector(CubismShaderSet* shaderSet, UniformSlot slot, int location, const csmFloat32* value)
+{
+    CubismProgramState* state = shaderSet->State;
+    if (state->IsUniformValid[slot] && memcmp(state->UniformValues[slot], value, sizeof(csmFloat32) * 4) == 0)
+    {
+        _redundantStateCount++;
+        return;
+    }
+
+    rlSetUniform(location, value, RL_SHADER_UNIFORM_VEC4, 1);
+    memcpy(state->UniformValues[slot], value, sizeof(csmFloat32) * 4);
+    state->IsUniformValid[slot] = true;
+    _stateChangeCount++;
+}
+
+void CubismShader_OpenGLES2::SetUniformMatrix(CubismShaderSet* shaderSet, UniformSlot slot, int location, const csmFloat32* value)
+{
+    CubismProgramState* state = shaderSet->State;
+    if (state->IsUniformValid[slot] && memcmp(state->UniformValues[slot], value, sizeof(csmFloat32) * 16) == 0)
+    {
+        _redundantStateCount++;
+        return;
+    }
+
+    rlSetUniformMatrixDirectly(location, value);
+    memcpy(state->UniformValues[slot], value, sizeof(csmFloat32) * 16);
+    state->IsUniformValid[slot] = true;
+    _stateChangeCount++;
+}
+
+void CubismShader_OpenGLES2::SetUniformInt(CubismShaderSet* shaderSet, UniformSlot slot, int location, csmInt32 value)
+{
+    // 頂点数程度の値しか送らないので、floatで保持しても誤差は出ない
+    CubismProgramState* state = shaderSet->State;
+    const csmFloat32 stored = static_cast<csmFloat32>(value);
+    if (state->IsUniformValid[slot] && state->UniformValues[slot][0] == stored)
+    {
+        _redundantStateCount++;
+        return;
+    }
+
+    rlSetUniform(location, &value, RL_SHADER_UNIFORM_INT, 1);
+    state->UniformValues[slot][0] = stored;
+    state->IsUniformValid[slot] = true;
+    _stateChangeCount++;
+}
+
+void CubismShader_OpenGLES2::SetVertexBuffers(CubismShaderSet* shaderSet, unsigned int positionBufferId, csmSizeType positionOffset
+                                              , unsigned int texCoordBufferId, csmSizeType texCoordOffset, unsigned int elementBufferId)
+{
+    // VAOが有効になっている前提。アトリビュートの設定はVAOに記録される
+    CubismProgramState* state = shaderSet->State;
+
+    if (state->PositionBufferId != positionBufferId || state->PositionOffset != positionOffset)
+    {
+        rlEnableVertexBuffer(positionBufferId);
+        rlSetVertexAttribute(shaderSet->AttributePositionLocation, 2, RL_FLOAT, false, sizeof(csmFloat32) * 2, reinterpret_cast<const void*>(positionOffset));
+        state->PositionBufferId = positionBufferId;
+        state->PositionOffset = positionOffset;
+        _stateChangeCount++;
+    }
+    else
+    {
+        _redundantStateCount++;
+    }
+
+    if (state->TexCoordBufferId != texCoordBufferId || state->TexCoordOffset != texCoordOffset)
+    {
+        rlEnableVertexBuffer(texCoordBufferId);
+        rlSetVertexAttribute(shaderSet->AttributeTexCoordLocation, 2, RL_FLOAT, false, sizeof(csmFloat32) * 2, reinterpret_cast<const void*>(texCoordOffset));
+        state->TexCoordBufferId = texCoordBufferId;
+        state->TexCoordOffset = texCoordOffset;
+        _stateChangeCount++;
+    }
+    else
+    {
+        _redundantStateCount++;
+    }
+
+    if (state->ElementBufferId != elementBufferId)
+    {
+        rlEnableVertexBufferElement(elementBufferId);
+        state->ElementBufferId = elementBufferId;
+        _stateChangeCount++;
+    }
+    else
+    {
+        _redundantStateCount++;
+    }
+}
+
+void CubismShader_OpenGLES2::SetupShaderProgram(CubismRenderer_OpenGLES2* renderer, unsigned int textureId
+                                                , csmInt32 baseVertex, unsigned int elementBufferId, csmFloat32 opacity
+                                                , CubismRenderer::CubismBlendMode colorBlendMode
+                                                , CubismRenderer::CubismTextureColor baseColor
+                                                , CubismRenderer::CubismTextureColor multiplyColor
+                                                , CubismRenderer::CubismTextureColor screenColor
+                                                , csmBool isPremultipliedAlpha, CubismMatrix44 matrix4x4
+                                                , csmBool invertedMask)
+{
+    CubismShaderSet* shaderSet;
+
+    // ブレンドの変更はraylibのバッチを描画させることがあるので、シェーダ等の設定より先に行う
+    if (renderer->GetClippingContextBufferForMask() != NULL) // マスク生成時
+    {
+        shaderSet = GetShaderSet(ShaderNames_SetupMask);
+        SetBlendFactors(GL_ZERO, GL_ONE_MINUS_SRC_COLOR, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+        UseShaderSet(shaderSet);
+
+        //テクスチャ設定
+        BindTexture(0, textureId);
+
+        // チャンネル
+        const csmInt32 channelNo = renderer->GetClippingContextBufferForMask()->_layoutChannelNo;
+        CubismRenderer::CubismTextureColor* colorChannel = renderer->GetClippingContextBufferForMask()->GetClippingManager()->GetChannelFlagAsColor(channelNo);
+        SetUniformVector(shaderSet, UniformSlot_ChannelFlag, shaderSet->UnifromChannelFlagLocation, &colorChannel->R);
+        SetUniformMatrix(shaderSet, UniformSlot_ClipMatrix, shaderSet->UniformClipMatrixLocation, renderer->GetClippingContextBufferForMask()->_matrixForMask.GetArray());
+
+        csmRectF* rect = renderer->GetClippingContextBufferForMask()->_layoutBounds;
+        float uniformBaseColor[4] = { rect->X * 2.0f - 1.0f, rect->Y * 2.0f - 1.0f, rect->GetRight() * 2.0f - 1.0f, rect->GetBottom() * 2.0f - 1.0f };
+        SetUniformVector(shaderSet, UniformSlot_BaseColor, shaderSet->UniformBaseColorLocation, uniformBaseColor);
+        SetUniformVector(shaderSet, UniformSlot_MultiplyColor, shaderSet->UniformMultiplyColorLocation, &multiplyColor.R);
+        SetUniformVector(shaderSet, UniformSlot_ScreenColor, shaderSet->UniformScreenColorLocation, &screenColor.R);
+    }
+    else // マスク生成以外の場合
+    {
+        const csmBool masked = renderer->GetClippingContextBufferForDraw() != NULL;  // この描画オブジェクトはマスク対象か
+        const csmInt32 offset = (masked ? ( invertedMask ? 2 : 1 ) : 0) + (isPremultipliedAlpha ? 3 : 0);
+
+        switch (colorBlendMode)
+        {
+        case CubismRenderer::CubismBlendMode_Normal:
+        default:
+            shaderSet = GetShaderSet(ShaderNames_Normal + offset);
+            SetBlendFactors(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            break;
+
+        case CubismRenderer::CubismBlendMode_Additive:
+            shaderSet = GetShaderSet(ShaderNames_Add + offset);
+            SetBlendFactors(GL_ONE, GL_ONE, GL_ZERO, GL_ONE);
+            break;
+
+        case CubismRenderer::CubismBlendMode_Multiplicative:
+            shaderSet = GetShaderSet(ShaderNames_Mult + offset);
+            SetBlendFactors(GL_DST_COLOR, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE);
+            break;
+        }
+
+        UseShaderSet(shaderSet);
+
+        if (masked)
+        {
+            // frameBufferに書かれたテクスチャ
+            BindTexture(1, renderer->_offscreenFrameBuffers[renderer->GetClippingContextBufferForDraw()->_bufferIndex].GetColorBuffer());
+
+            // View座標をClippingContextの座標に変換するための行列を設定
+            SetUniformMatrix(shaderSet, UniformSlot_ClipMatrix, shaderSet->UniformClipMatrixLocation, renderer->GetClippingContextBufferForDraw()->_matrixForDraw.GetArray());
+
+            // 使用するカラーチャンネルを設定
+            const csmInt32 channelNo = renderer->GetClippingContextBufferForDraw()->_layoutChannelNo;
+            CubismRenderer::CubismTextureColor* colorChannel = renderer->GetClippingContextBufferForDraw()->GetClippingManager()->GetChannelFlagAsColor(channelNo);
+            SetUniformVector(shaderSet, UniformSlot_ChannelFlag, shaderSet->UnifromChannelFlagLocation, &colorChannel->R);
+        }
+
+        //テクスチャ設定
+        BindTexture(0, textureId);
+
+        //座標変換
+        SetUniformMatrix(shaderSet, UniformSlot_Matrix, shaderSet->UniformMatrixLocation, matrix4x4.GetArray());
+        SetUniformVector(shaderSet, UniformSlot_BaseColor, shaderSet->UniformBaseColorLocation, &baseColor.R);
+        SetUniformVector(shaderSet, UniformSlot_MultiplyColor, shaderSet->UniformMultiplyColorLocation, &multiplyColor.R);
+        SetUniformVector(shaderSet, UniformSlot_ScreenColor, shaderSet->UniformScreenColorLocation, &screenColor.R);
+    }
+
+    // 頂点配列&テクスチャ頂点の設定
+    // バッファはモデル内の全Drawableを並べたものなので、アトリビュートの先頭を基準頂点に合わせる
+    // インデックスは基準頂点からの相対値になっている
+    // 頂点座標は全モデル共有のストリーミングバッファ上にあるので、モデルの書き込み位置を加える
+    const csmSizeType vertexOffset = sizeof(csmFloat32) * 2 * baseVertex;
+    const csmSizeType streamOffset = renderer->_streamOffset + vertexOffset;
+
+    SetVertexBuffers(shaderSet
+        , CubismVertexStream_OpenGLES2::GetInstance()->GetBufferId(), streamOffset
+        , renderer->_vertexBufferTexcoordId, vertexOffset
+        , elementBufferId);
+}
+
+void CubismShader_OpenGLES2::SetupInstancedShaderProgram(CubismRenderer_OpenGLES2* renderer, unsigned int textureId, csmInt32 baseVertex
+                                                         , CubismRenderer::CubismBlendMode colorBlendMode
+                                                         , CubismRenderer::CubismTextureColor baseColor
+                                                         , CubismRenderer::CubismTextureColor multiplyColor
+                                                         , CubismRenderer::CubismTextureColor screenColor
+                                                         , csmBool isPremultipliedAlpha)
+{
+    CubismShaderSet* shaderSet = GetShaderSet(isPremultipliedAlpha ? ShaderNames_InstancedPremultipliedAlpha : ShaderNames_Instanced);
+
+    // ブレンドの変更はraylibのバッチを描画させることがあるので、シェーダ等の設定より先に行う
+    switch (colorBlendMode)
+    {
+    case CubismRenderer::CubismBlendMode_Normal:
+    default:
+        SetBlendFactors(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        break;
+
+    case CubismRenderer::CubismBlendMode_Additive:
+        SetBlendFactors(GL_ONE, GL_ONE, GL_ZERO, GL_ONE);
+        break;
+
+    case CubismRenderer::CubismBlendMode_Multiplicative:
+        SetBlendFactors(GL_DST_COLOR, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE);
+        break;
+    }
+
+    UseShaderSet(shaderSet);
+
+    //テクスチャ設定
+    BindTexture(0, textureId);
+    BindTexture(1, renderer->_instanceVertexTextureId);
+
+    SetUniformInt(shaderSet, UniformSlot_VertexOffset, shaderSet->UniformVertexOffsetLocation, baseVertex);
+    SetUniformInt(shaderSet, UniformSlot_InstanceStride, shaderSet->UniformInstanceStrideLocation, renderer->_vertexStaging.GetSize() / 2);
+    SetUniformVector(shaderSet, UniformSlot_BaseColor, shaderSet->UniformBaseColorLocation, &baseColor.R);
+    SetUniformVector(shaderSet, UniformSlot_MultiplyColor, shaderSet->UniformMultiplyColorLocation, &multiplyColor.R);
+    SetUniformVector(shaderSet, UniformSlot_ScreenColor, shaderSet->UniformScreenColorLocation, &screenColor.R);
+
+    // UVとインデックスは通常の描画と同じバッファを使う
+    CubismProgramState* state = shaderSet->State;
+    const csmSizeType texCoordOffset = sizeof(csmFloat32) * 2 * baseVertex;
+
+    if (state->TexCoordBufferId != renderer->_vertexBufferTexcoordId || state->TexCoordOffset != texCoordOffset)
+    {
+        rlEnableVertexBuffer(renderer->_vertexBufferTexcoordId);
+        rlSetVertexAttribute(shaderSet->AttributeTexCoordLocation, 2, RL_FLOAT, false, sizeof(csmFloat32) * 2, reinterpret_cast<const void*>(texCoordOffset));
+        state->TexCoordBufferId = renderer->_vertexBufferTexcoordId;
+        state->TexCoordOffset = texCoordOffset;
+        _stateChangeCount++;
+    }
+    else
+    {
+        _redundantStateCount++;
+    }
+
+    if (state->InstanceBufferId != renderer->_instanceBufferId)
+    {
+        const int stride = sizeof(csmFloat32) * InstanceAttributeFloats;
+        rlEnableVertexBuffer(renderer->_instanceBufferId);
+        for (csmUint32 column = 0; column < 4; column++)
+        {
+            rlSetVertexAttribute(shaderSet->AttributeInstanceMatrixLocation + column, 4, RL_FLOAT, false, stride, reinterpret_cast<const void*>(sizeof(csmFloat32) * 4 * column));
+        }
+        rlSetVertexAttribute(shaderSet->AttributeInstanceOpacityLocation, 1, RL_FLOAT, false, stride, reinterpret_cast<const void*>(sizeof(csmFloat32) * 16));
+        state->InstanceBufferId = renderer->_instanceBufferId;
+        _stateChangeCount++;
+    }
+    else
+    {
+        _redundantStateCount++;
+    }
+
+    if (state->ElementBufferId != renderer->_vertexBufferElementId)
+    {
+        rlEnableVertexBufferElement(renderer->_vertexBufferElementId);
+        state->ElementBufferId = renderer->_vertexBufferElementId;
+        _stateChangeCount++;
+    }
+    else
+    {
+        _redundantStateCount++;
+    }
+}
+
+
+/*********************************************************************************************************************
+ *                                      CubismVertexStream_OpenGLES2
+ ********************************************************************************************************************/
+namespace {
+    const csmInt32 VertexStreamInitialCapacity = 1024 * 1024; ///< ストリーミングバッファの初期容量（バイト）
+    CubismVertexStream_OpenGLES2* s_vertexStreamInstance;
+}
+
+CubismVertexStream_OpenGLES2::CubismVertexStream_OpenGLES2() : _bufferId(0)
+                                                             , _capacity(0)
+                                                             , _cursor(0)
+                                                             , _lap(0)
+{ }
+
+CubismVertexStream_OpenGLES2::~CubismVertexStream_OpenGLES2()
+{
+    if (_bufferId != 0)
+    {
+        rlUnloadVertexBuffer(_bufferId);
+        _bufferId = 0;
+    }
+}
+
+CubismVertexStream_OpenGLES2* CubismVertexStream_OpenGLES2::GetInstance()
+{
+    if (s_vertexStreamInstance == NULL)
+    {
+        CubismSharedAllocationScope sharedAllocation;
+        s_vertexStreamInstance = CSM_NEW CubismVertexStream_OpenGLES2();
+    }
+    return s_vertexStreamInstance;
+}
+
+void CubismVertexStream_OpenGLES2::DeleteInstance()
+{
+    if (s_vertexStreamInstance)
+    {
+        CSM_DELETE_SELF(CubismVertexStream_OpenGLES2, s_vertexStreamInstance);
+        s_vertexStreamInstance = NULL;
+    }
+}
+
+csmInt32 CubismVertexStream_OpenGLES2::Append(const void* data, csmInt32 size, csmUint32& lap)
+{
+    if (_bufferId == 0 || _cursor + size > _capacity)
+    {
+        // 末尾に達したらバッファごと作り直す
+        // 描画中の古いバッファはドライバが保持するので、GPUの読み出しを待たずに書き込める
+        csmInt32 capacity = (_capacity > 0) ? _capacity : VertexStreamInitialCapacity;
+        while (capacity < size)
+        {
+            capacity *= 2;
+        }
+
+        if (_bufferId != 0)
+        {
+            rlUnloadVertexBuffer(_bufferId);
+        }
+
+        _bufferId = rlLoadVertexBuffer(NULL, capacity, true);
+        _capacity = capacity;
+        _cursor = 0;
+        _lap++;
+    }
+
+    const csmInt32 offset = _cursor;
+    rlUpdateVertexBuffer(_bufferId, data, size, offset);
+
+    // 頂点属性のオフセットとして使うので、頂点1つ分の境界に揃えておく
+    _cursor += (size + 15) & ~15;
+    lap = _lap;
+
+    return offset;
+}
+
+csmBool CubismVertexStream_OpenGLES2::IsValid(csmUint32 lap) const
+{
+    return _bufferId != 0 && lap == _lap;
+}
+
+unsigned int CubismVertexStream_OpenGLES2::GetBufferId() const
+{
+    return _bufferId;
+}
+
+
+/*********************************************************************************************************************
+ *                                      CubismRenderer_OpenGLES2
+ ********************************************************************************************************************/
+namespace {
+    const csmInt32 InstanceVertexTextureWidth = 1024; ///< インスタンスごとの頂点座標を並べるテクスチャの幅（テクセル）
+}
+
+CubismRenderer* CubismRenderer::Create()
+{
+    return CSM_NEW CubismRenderer_OpenGLES2();
+}
+
+void CubismRenderer::StaticRelease()
+{
+    CubismRenderer_OpenGLES2::DoStaticRelease();
+}
+
+CubismRenderer_OpenGLES2::CubismRenderer_OpenGLES2() : _clippingManager(NULL)
+                                                     , _clippingContextBufferForMask(NULL)
+                                                     , _clippingContextBufferForDraw(NULL)
+                                                     , _vertexBufferTexcoordId(0)
+                                                     , _vertexBufferElementId(0)
+                                                     , _streamOffset(0)
+                                                     , _streamLap(0)
+                                                     , _isStreamWritten(false)
+                                                     , _isVertexStagingValid(false)
+                                                     , _batchElementBufferId(0)
+                                                     , _batchElementCapacity(0)
+                                                     , _instanceVertexTextureId(0)
+                                                     , _instanceVertexTextureHeight(0)
+                                                     , _instanceBufferId(0)
+                                                     , _instanceBufferCapacity(0)
+                                                     , _isDrawableCullingEnabled(false)
+                                                     , _cullingMinOpacity(0.0f)
+                                                     , _cullingMinPixelArea(0.0f)
+{
+    // テクスチャ対応マップの容量を確保しておく.
+    _textures.PrepareCapacity(32, true);
+
+    memset(&_frameStatistics, 0, sizeof(_frameStatistics));
+}
+
+CubismRenderer_OpenGLES2::~CubismRenderer_OpenGLES2()
+{
+    CSM_DELETE_SELF(CubismClippingManager_OpenGLES2, _clippingManager);
+
+    ReleaseVertexBuffers();
+
+    for (csmUint32 i = 0; i < _offscreenFrameBuffers.GetSize(); i++)
+    {
+        if (_offscreenFrameBuffers[i].IsValid())
+        {
+            _offscreenFrameBuffers[i].DestroyOffscreenFrame();
+        }
+    }
+}
+
+void CubismRenderer_OpenGLES2::DoStaticRelease()
+{
+    CubismShader_OpenGLES2::DeleteInstance();
+    CubismVertexStream_OpenGLES2::DeleteInstance();
+}
+
+void CubismRenderer_OpenGLES2::Initialize(CubismModel* model)
+{
+
+    if (model->IsUsingMasking())
+    {
+        _clippingManager = CSM_NEW CubismClippingManager_OpenGLES2();  //クリッピングマスク・バッファ前処理方式を初期化
+        _clippingManager->Initialize(
+            *model,
+            model->GetDrawableCount(),
+            model->GetDrawableMasks(),
+            model->GetDrawableMaskCounts()
+        );
+
+        // マスク用のフレームバッファは最初の描画時に作る
+    }
+
+    _sortedDrawableIndexList.Resize(model->GetDrawableCount(), 0);
+
+    // 頂点バッファ上の各Drawableの位置を決めておく
+    // バッファ自体は最初の描画時に作る
+    const csmInt32 drawableCount = model->GetDrawableCount();
+    csmInt32 vertexOffset = 0;
+    csmInt32 indexOffset = 0;
+    _drawableVertexOffsets.Resize(drawableCount, 0);
+    _drawableIndexOffsets.Resize(drawableCount, 0);
+    for (csmInt32 i = 0; i < drawableCount; ++i)
+    {
+        _drawableVertexOffsets[i] = vertexOffset;
+        _drawableIndexOffsets[i] = indexOffset;
+        vertexOffset += model->GetDrawableVertexCount(i);
+        indexOffset += model->GetDrawableVertexIndexCount(i);
+    }
+
+    CubismRenderer::Initialize(model);  //親クラスの処理を呼ぶ
+}
+
+void CubismRenderer_OpenGLES2::CreateVertexBuffers()
+{
+    const CubismModel* model = GetModel();
+    const csmInt32 drawableCount = model->GetDrawableCount();
+
+    csmInt32 vertexTotal = 0;
+    csmInt32 indexTotal = 0;
+    if (drawableCount > 0)
+    {
+        vertexTotal = _drawableVertexOffsets[drawableCount - 1] + model->GetDrawableVertexCount(drawableCount - 1);
+        indexTotal = _drawableIndexOffsets[drawableCount - 1] + model->GetDrawableVertexIndexCount(drawableCount - 1);
+    }
+
+    // UVとインデックスは以後書き換えない
+    // 頂点座標はCPU側の写しに集めておき、共有のストリーミングバッファへ変化した範囲だけを転送する
+    _vertexBufferTexcoordId = rlLoadVertexBuffer(NULL, sizeof(csmFloat32) * 2 * vertexTotal, false);
+    _vertexBufferElementId = rlLoadVertexBufferElement(NULL, sizeof(csmUint16) * indexTotal, false);
+    _vertexStaging.Resize(vertexTotal * 2, 0.0f);
+
+    for (csmInt32 i = 0; i < drawableCount; ++i)
+    {
+        const csmInt32 vertexCount = model->GetDrawableVertexCount(i);
+        const csmInt32 indexCount = model->GetDrawableVertexIndexCount(i);
+
+        if (vertexCount > 0)
+        {
+            const csmInt32 vertexBytes = sizeof(csmFloat32) * 2 * vertexCount;
+
+            memcpy(_vertexStaging.GetPtr() + _drawableVertexOffsets[i] * 2, model->GetDrawableVertices(i), vertexBytes);
+
+            rlUpdateVertexBuffer(_vertexBufferTexcoordId, model->GetDrawableVertexUvs(i), vertexBytes, sizeof(csmFloat32) * 2 * _drawableVertexOffsets[i]);
+            _frameStatistics.UploadCalls++;
+            _frameStatistics.UploadedUvBytes += vertexBytes;
+        }
+
+        if (indexCount > 0)
+        {
+            const csmInt32 indexBytes = sizeof(csmUint16) * indexCount;
+
+            rlUpdateVertexBufferElements(_vertexBufferElementId, model->GetDrawableVertexIndices(i), indexBytes, sizeof(csmUint16) * _drawableIndexOffsets[i]);
+            _frameStatistics.UploadCalls++;
+            _frameStatistics.UploadedIndexBytes += indexBytes;
+        }
+    }
+
+    rlDisableVertexBuffer();
+    rlDisableVertexBufferElement();
+}
+
+void CubismRenderer_OpenGLES2::ReleaseVertexBuffers()
+{
+    if (_vertexBufferTexcoordId != 0)
+    {
+        rlUnloadVertexBuffer(_vertexBufferTexcoordId);
+        _vertexBufferTexcoordId = 0;
+    }
+
+    if (_vertexBufferElementId != 0)
+    {
+        rlUnloadVertexBuffer(_vertexBufferElementId);
+        _vertexBufferElementId = 0;
+    }
+
+    if (_batchElementBufferId != 0)
+    {
+        rlUnloadVertexBuffer(_batchElementBufferId);
+        _batchElementBufferId = 0;
+        _batchElementCapacity = 0;
+    }
+
+    if (_instanceVertexTextureId != 0)
+    {
+        rlUnloadTexture(_instanceVertexTextureId);
+        _instanceVertexTextureId = 0;
+        _instanceVertexTextureHeight = 0;
+    }
+
+    if (_instanceBufferId != 0)
+    {
+        rlUnloadVertexBuffer(_instanceBufferId);
+        _instanceBufferId = 0;
+        _instanceBufferCapacity = 0;
+    }
+
+    _isStreamWritten = false;
+    _previousBatchLayout.Resize(0);
+}
+
+void CubismRenderer_OpenGLES2::UpdateVertexBuffers()
+{
+    CubismVertexStream_OpenGLES2* stream = CubismVertexStream_OpenGLES2::GetInstance();
+    csmBool isDirty = false;
+
+    if (_vertexBufferTexcoordId == 0)
+    {
+        // 初回は全Drawableを写しに集めるので差分の確認は不要
+        CreateVertexBuffers();
+        isDirty = true;
+    }
+    else
+    {
+        const CubismModel* model = GetModel();
+        const csmInt32 drawableCount = model->GetDrawableCount();
+
+        // 前回書き込んだ領域が残っていれば、変化したDrawableの範囲だけを上書きする
+        // DrawInstancesで描いていた間は写しを更新していないので、全Drawableを集め直して追記する
+        const csmBool isInPlace = _isVertexStagingValid && _isStreamWritten && stream->IsValid(_streamLap);
+        csmInt32 rangeBegin = 0;
+        csmInt32 rangeEnd = 0;
+
+        for (csmInt32 i = 0; i < drawableCount; ++i)
+        {
+            // 頂点位置が変化していなければ写しの内容をそのまま使う
+            if (_isVertexStagingValid && !model->GetDrawableDynamicFlagVertexPositionsDidChange(i))
+            {
+                continue;
+            }
+
+            const csmInt32 vertexCount = model->GetDrawableVertexCount(i);
+            if (vertexCount <= 0)
+            {
+                continue;
+            }
+
+            const csmInt32 firstVertex = _drawableVertexOffsets[i];
+            memcpy(_vertexStaging.GetPtr() + firstVertex * 2, model->GetDrawableVertices(i), sizeof(csmFloat32) * 2 * vertexCount);
+            isDirty = true;
+
+            if (!isInPlace)
+            {
+                continue;
+            }
+
+            // 直前の範囲と隣り合っていれば1回の転送にまとめる
+            if (rangeEnd != firstVertex)
+            {
+                UploadVertexRange(rangeBegin, rangeEnd - rangeBegin);
+                rangeBegin = firstVertex;
+            }
+            rangeEnd = firstVertex + vertexCount;
+        }
+
+        if (isInPlace)
+        {
+            UploadVertexRange(rangeBegin, rangeEnd - rangeBegin);
+            if (isDirty)
+            {
+                rlDisableVertexBuffer();
+            }
+            return;
+        }
+    }
+
+    _isVertexStagingValid = true;
+
+    // 変化がなく、前回書き込んだ領域がまだ上書きされていなければそのまま使う
+    if (!isDirty && _isStreamWritten && stream->IsValid(_streamLap))
+    {
+        return;
+    }
+
+    if (_vertexStaging.GetSize() == 0)
+    {
+        return;
+    }
+
+    const csmInt32 vertexBytes = sizeof(csmFloat32) * _vertexStaging.GetSize();
+    _streamOffset = stream->Append(_vertexStaging.GetPtr(), vertexBytes, _streamLap);
+    _isStreamWritten = true;
+    _frameStatistics.UploadCalls++;
+    _frameStatistics.UploadedVertexBytes += vertexBytes;
+
+    rlDisableVertexBuffer();
+}
+
+void CubismRenderer_OpenGLES2::UploadVertexRange(csmInt32 firstVertex, csmInt32 vertexCount)
+{
+    if (vertexCount <= 0)
+    {
+        return;
+    }
+
+    const csmInt32 rangeBytes = sizeof(csmFloat32) * 2 * vertexCount;
+    rlUpdateVertexBuffer(CubismVertexStream_OpenGLES2::GetInstance()->GetBufferId(), _vertexStaging.GetPtr() + firstVertex * 2, rangeBytes, _streamOffset + sizeof(csmFloat32) * 2 * firstVertex);
+    _frameStatistics.UploadCalls++;
+    _frameStatistics.UploadedVertexBytes += rangeBytes;
+}
+
+void CubismRenderer_OpenGLES2::BuildDrawBatches()
+{
+    const CubismModel* model = GetModel();
+    const csmInt32 drawableCount = model->GetDrawableCount();
+
+    // 高精細マスクではDrawableごとにマスクを描き直すのでまとめられない
+    const csmBool canMerge = !IsUsingHighPrecisionMask();
+
+    _drawBatches.Resize(0);
+    _batchMembers.Resize(0);
+    _batchLayout.Resize(0);
+
+    CubismMatrix44 mvp = GetMvpMatrix();
+    const csmFloat32* mvpArray = mvp.GetArray();
+
+    csmInt32 batchEndVertex = 0;   // 現在のバッチが参照する頂点の終端
+    for (csmInt32 i = 0; i < drawableCount; ++i)
+    {
+        const csmInt32 drawableIndex = _sortedDrawableIndexList[i];
+
+        // Drawableが表示状態でなければ処理をパスする
+        if (!model->GetDrawableDynamicFlagIsVisible(drawableIndex))
+        {
+            continue;
+        }
+
+        // 描いても見えないDrawableも除く。マスクの生成はクリッピングマネージャが別に行うので影響しない
+        if (_isDrawableCullingEnabled && IsDrawableCulled(drawableIndex, mvpArray))
+        {
+            continue;
+        }
+
+        const csmInt32 vertexBegin = _drawableVertexOffsets[drawableIndex];
+        const csmInt32 vertexEnd = vertexBegin + model->GetDrawableVertexCount(drawableIndex);
+
+        if (canMerge && _drawBatches.GetSize() > 0)
+        {
+            DrawBatch& last = _drawBatches[_drawBatches.GetSize() - 1];
+            const csmInt32 lastMember = _batchMembers[_batchMembers.GetSize() - 1];
+
+            // インデックスは16bitなので、基準頂点からの範囲がそれに収まる場合だけまとめる
+            const csmInt32 baseVertex = (vertexBegin < last.BaseVertex) ? vertexBegin : last.BaseVertex;
+            const csmInt32 endVertex = (vertexEnd > batchEndVertex) ? vertexEnd : batchEndVertex;
+
+            if (endVertex - baseVertex <= 0xFFFF + 1 && IsBatchable(lastMember, drawableIndex))
+            {
+                last.BaseVertex = baseVertex;
+                last.DrawableCount++;
+                last.IndexCount += model->GetDrawableVertexIndexCount(drawableIndex);
+                batchEndVertex = endVertex;
+                _batchMembers.PushBack(drawableIndex, false);
+                continue;
+            }
+        }
+
+        DrawBatch batch;
+        batch.DrawableIndex = drawableIndex;
+        batch.FirstMember = _batchMembers.GetSize();
+        batch.DrawableCount = 1;
+        batch.BaseVertex = vertexBegin;
+        batch.IndexOffset = _drawableIndexOffsets[drawableIndex];
+        batch.IndexCount = model->GetDrawableVertexIndexCount(drawableIndex);
+        _drawBatches.PushBack(batch);
+        _batchMembers.PushBack(drawableIndex, false);
+        batchEndVertex = vertexEnd;
+    }
+
+    // 結合したバッチの構成を並べ、インデックスの置き場所を決める
+    csmInt32 mergedIndexCount = 0;
+    for (csmUint32 i = 0; i < _drawBatches.GetSize(); ++i)
+    {
+        DrawBatch& batch = _drawBatches[i];
+        if (batch.DrawableCount <= 1)
+        {
+            continue;
+        }
+
+        batch.IndexOffset = mergedIndexCount;
+        mergedIndexCount += batch.IndexCount;
+
+        _batchLayout.PushBack(batch.DrawableCount, false);
+        _batchLayout.PushBack(batch.BaseVertex, false);
+        for (csmInt32 j = 0; j < batch.DrawableCount; ++j)
+        {
+            _batchLayout.PushBack(_batchMembers[batch.FirstMember + j], false);
+        }
+    }
+
+    if (mergedIndexCount == 0)
+    {
+        return;
+    }
+
+    // 構成が前回と同じなら転送済みのインデックスをそのまま使う
+    csmBool isSameLayout = (_batchLayout.GetSize() == _previousBatchLayout.GetSize());
+    for (csmUint32 i = 0; isSameLayout && i < _batchLayout.GetSize(); ++i)
+    {
+        isSameLayout = (_batchLayout[i] == _previousBatchLayout[i]);
+    }
+
+    if (isSameLayout && _batchElementBufferId != 0)
+    {
+        return;
+    }
+
+    // 各Drawableのインデックスを基準頂点からの相対値に直して連結する
+    _batchIndices.Resize(0);
+    for (csmUint32 i = 0; i < _drawBatches.GetSize(); ++i)
+    {
+        const DrawBatch& batch = _drawBatches[i];
+        if (batch.DrawableCount <= 1)
+        {
+            continue;
+        }
+
+        for (csmInt32 j = 0; j < batch.DrawableCount; ++j)
+        {
+            const csmInt32 member = _batchMembers[batch.FirstMember + j];
+            const csmUint16 rebase = static_cast<csmUint16>(_drawableVertexOffsets[member] - batch.BaseVertex);
+            const csmUint16* indices = model->GetDrawableVertexIndices(member);
+            const csmInt32 indexCount = model->GetDrawableVertexIndexCount(member);
+
+            for (csmInt32 k = 0; k < indexCount; ++k)
+            {
+                _batchIndices.PushBack(static_cast<csmUint16>(indices[k] + rebase), false);
+            }
+        }
+    }
+
+    if (_batchElementBufferId == 0 || _batchElementCapacity < mergedIndexCount)
+    {
+        if (_batchElementBufferId != 0)
+        {
+            rlUnloadVertexBuffer(_batchElementBufferId);
+        }
+
+        // 構成が少し変わるたびに作り直さないよう、余裕を持って確保する
+        _batchElementCapacity = mergedIndexCount + mergedIndexCount / 2;
+        _batchElementBufferId = rlLoadVertexBufferElement(NULL, sizeof(csmUint16) * _batchElementCapacity, true);
+    }
+
+    rlDisableVertexArray();
+    rlUpdateVertexBufferElements(_batchElementBufferId, _batchIndices.GetPtr(), sizeof(csmUint16) * mergedIndexCount, 0);
+    rlDisableVertexBufferElement();
+    _frameStatistics.UploadCalls++;
+    _frameStatistics.UploadedIndexBytes += sizeof(csmUint16) * mergedIndexCount;
+
+    _previousBatchLayout.Resize(_batchLayout.GetSize());
+    for (csmUint32 i = 0; i < _batchLayout.GetSize(); ++i)
+    {
+        _previousBatchLayout[i] = _batchLayout[i];
+    }
+
+    // インデックスバッファのバインドが変わったので、VAOに記録したものも無効にする
+    CubismShader_OpenGLES2::GetInstance()->InvalidateState();
+}
+
+csmBool CubismRenderer_OpenGLES2::IsBatchable(csmInt32 a, csmInt32 b) const
+{
+    const CubismModel* model = GetModel();
+
+    if (model->GetDrawableTextureIndex(a) != model->GetDrawableTextureIndex(b)
+        || model->GetDrawableBlendMode(a) != model->GetDrawableBlendMode(b)
+        || model->GetDrawableCulling(a) != model->GetDrawableCulling(b)
+        || model->GetDrawableOpacity(a) != model->GetDrawableOpacity(b))
+    {
+        return false;
+    }
+
+    // 同じマスクを同じ向きで使っている必要がある
+    if (_clippingManager != NULL)
+    {
+        CubismClippingContext* clipA = (*_clippingManager->GetClippingContextListForDraw())[a];
+        CubismClippingContext* clipB = (*_clippingManager->GetClippingContextListForDraw())[b];
+        if (clipA != clipB)
+        {
+            return false;
+        }
+        if (clipA != NULL && model->GetDrawableInvertedMask(a) != model->GetDrawableInvertedMask(b))
+        {
+            return false;
+        }
+    }
+
+    const CubismTextureColor multiplyA = model->GetMultiplyColor(a);
+    const CubismTextureColor multiplyB = model->GetMultiplyColor(b);
+    const CubismTextureColor screenA = model->GetScreenColor(a);
+    const CubismTextureColor screenB = model->GetScreenColor(b);
+
+    return multiplyA.R == multiplyB.R && multiplyA.G == multiplyB.G && multiplyA.B == multiplyB.B && multiplyA.A == multiplyB.A
+        && screenA.R == screenB.R && screenA.G == screenB.G && screenA.B == screenB.B && screenA.A == screenB.A;
+}
+
+void CubismRenderer_OpenGLES2::UpdateDrawableBounds()
+{
+    const CubismModel* model = GetModel();
+    const csmInt32 drawableCount = model->GetDrawableCount();
+
+    // 初回は全Drawable、以降は頂点が動いたものだけ計算する
+    const csmBool isFirst = (_drawableBounds.GetSize() != static_cast<csmUint32>(drawableCount * 4));
+    if (isFirst)
+    {
+        _drawableBounds.Resize(drawableCount * 4, 0.0f);
+        _hasDrawableBounds.Resize(drawableCount, false);
     }
-    else // マスク生成以外の場合
+
+    for (csmInt32 i = 0; i < drawableCount; ++i)
     {
-        const csmBool masked = renderer->GetClippingContextBufferForDraw() != NULL;  // この描画オブジェクトはマスク対象か
-        const csmInt32 offset = (masked ? ( invertedMask ? 2 : 1 ) : 0) + (isPremultipliedAlpha ? 3 : 0);
+        if (!isFirst && !model->GetDrawableDynamicFlagVertexPositionsDidChange(i))
+        {
+            continue;
+        }
 
-        switch (colorBlendMode)
+        csmFloat32* bounds = &_drawableBounds[i * 4];
+        _hasDrawableBounds[i] = CubismMath::CalculateBounds(model->GetDrawableVertices(i), model->GetDrawableVertexCount(i),
+                                                            bounds[0], bounds[1], bounds[2], bounds[3]);
+    }
+}
+
+csmBool CubismRenderer_OpenGLES2::IsDrawableCulled(csmInt32 drawableIndex, const csmFloat32* mvp)
+{
+    const CubismModel* model = GetModel();
+
+    if (model->GetDrawableOpacity(drawableIndex) * GetModelColor().A < _cullingMinOpacity)
+    {
+        _frameStatistics.CulledByOpacity++;
+        return true;
+    }
+
+    // 有効な頂点が無いDrawableは判定しない
+    if (!_hasDrawableBounds[drawableIndex])
+    {
+        return false;
+    }
+    const csmFloat32* bounds = &_drawableBounds[drawableIndex * 4];
+
+    // 外接矩形の4隅をクリップ座標へ変換し、その外接矩形で判定する
+    csmFloat32 minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+    for (csmInt32 corner = 0; corner < 4; ++corner)
+    {
+        const csmFloat32 x = bounds[(corner & 1) ? 2 : 0];
+        const csmFloat32 y = bounds[(corner & 2) ? 3 : 1];
+        const csmFloat32 w = mvp[3] * x + mvp[7] * y + mvp[15];
+
+        // 視点の後ろに回る頂点があれば正しく判定できないので描く
+        if (w <= 0.0f)
         {
-        case CubismRenderer::CubismBlendMode_Normal:
-        default:
-            shaderSet = _shaderSets[ShaderNames_Normal + offset];
-            rlSetBlendFactorsSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_FUNC_ADD, GL_FUNC_ADD);
-            break;
+            return false;
+        }
 
-        case CubismRenderer::CubismBlendMode_Additive:
-            shaderSet = _shaderSets[ShaderNames_Add + offset];
-            rlSetBlendFactorsSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE, GL_FUNC_ADD, GL_FUNC_ADD);
-            break;
+        const csmFloat32 clipX = (mvp[0] * x + mvp[4] * y + mvp[12]) / w;
+        const csmFloat32 clipY = (mvp[1] * x + mvp[5] * y + mvp[13]) / w;
+        if (clipX < minX) minX = clipX;
+        if (clipX > maxX) maxX = clipX;
+        if (clipY < minY) minY = clipY;
+        if (clipY > maxY) maxY = clipY;
+    }
 
-        case CubismRenderer::CubismBlendMode_Multiplicative:
-            shaderSet = _shaderSets[ShaderNames_Mult + offset];
-            rlSetBlendFactorsSeparate(GL_DST_COLOR, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE, GL_FUNC_ADD, GL_FUNC_ADD);
-            break;
+    if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f)
+    {
+        _frameStatistics.CulledByViewport++;
+        return true;
+    }
+
+    // ビューポートが未設定なら面積では判定しない
+    const csmFloat32 viewportWidth = static_cast<csmFloat32>(_rendererProfile._lastViewport[2]);
+    const csmFloat32 viewportHeight = static_cast<csmFloat32>(_rendererProfile._lastViewport[3]);
+    if (_cullingMinPixelArea > 0.0f && viewportWidth > 0.0f && viewportHeight > 0.0f)
+    {
+        const csmFloat32 pixelArea = (maxX - minX) * 0.5f * viewportWidth * (maxY - minY) * 0.5f * viewportHeight;
+        if (pixelArea < _cullingMinPixelArea)
+        {
+            _frameStatistics.CulledBySize++;
+            return true;
         }
-        rlSetBlendMode(RL_BLEND_CUSTOM_SEPARATE);
+    }
 
-        rlEnableVertexArray(shaderSet->VertexArrayObjectId);
-        rlEnableShader(shaderSet->ShaderProgram);
+    return false;
+}
 
-        if (masked)
+csmBool CubismRenderer_OpenGLES2::IsInstanceCompatible(const CubismModel* model) const
+{
+    const CubismModel* templateModel = GetModel();
+
+    // マスクはモデルごとに形が変わるので、モデルごとに描き直す必要がある
+    if (model->IsUsingMasking())
+    {
+        return false;
+    }
+
+    const csmInt32 drawableCount = templateModel->GetDrawableCount();
+    if (model->GetDrawableCount() != drawableCount)
+    {
+        return false;
+    }
+
+    // UVとインデックスはこのレンダラのものを使うので、頂点の並びが一致している必要がある
+    for (csmInt32 i = 0; i < drawableCount; ++i)
+    {
+        if (model->GetDrawableVertexCount(i) != templateModel->GetDrawableVertexCount(i)
+            || model->GetDrawableVertexIndexCount(i) != templateModel->GetDrawableVertexIndexCount(i))
         {
-            rlActiveTextureSlot(1);
+            return false;
+        }
+    }
 
-            // frameBufferに書かれたテクスチャ
-            unsigned int tex = renderer->_offscreenFrameBuffer.GetColorBuffer();
+    return true;
+}
 
-            const int uniform1 = 1;
-            rlEnableTexture(tex);
-            rlSetUniform(shaderSet->SamplerTexture1Location, &uniform1, RL_SHADER_UNIFORM_INT, 1);
+void CubismRenderer_OpenGLES2::UpdateInstanceBuffers(const CubismModel* const* models, CubismMatrix44* mvps, const csmFloat32* opacities, csmInt32 count)
+{
+    const csmInt32 drawableCount = GetModel()->GetDrawableCount();
+    const csmInt32 instanceStride = _vertexStaging.GetSize() / 2;
+    const csmInt32 texelCount = instanceStride * count;
+    const csmInt32 rows = (texelCount + InstanceVertexTextureWidth - 1) / InstanceVertexTextureWidth;
 
-            // View座標をClippingContextの座標に変換するための行列を設定
-            rlSetUniformMatrixDirectly(shaderSet->UniformClipMatrixLocation, renderer->GetClippingContextBufferForDraw()->_matrixForDraw.GetArray());
+    // テクセルは(x, y, Drawableの不透明度, 0)。非表示のDrawableは不透明度0として描く
+    _instanceVertexStaging.Resize(rows * InstanceVertexTextureWidth * 4, 0.0f);
+    _isInstanceDrawableVisible.Resize(0);
+    _isInstanceDrawableVisible.Resize(drawableCount, false);
 
-            // 使用するカラーチャンネルを設定
-            const csmInt32 channelNo = renderer->GetClippingContextBufferForDraw()->_layoutChannelNo;
-            CubismRenderer::CubismTextureColor* colorChannel = renderer->GetClippingContextBufferForDraw()->GetClippingManager()->GetChannelFlagAsColor(channelNo);
-            rlSetUniform(shaderSet->UnifromChannelFlagLocation, &colorChannel->R, RL_SHADER_UNIFORM_VEC4, 1);
+    for (csmInt32 instance = 0; instance < count; ++instance)
+    {
+        const CubismModel* model = models[instance];
+        csmFloat32* texels = _instanceVertexStaging.GetPtr() + instance * instanceStride * 4;
+
+        for (csmInt32 i = 0; i < drawableCount; ++i)
+        {
+            const csmInt32 vertexCount = model->GetDrawableVertexCount(i);
+            const csmFloat32* vertices = model->GetDrawableVertices(i);
+            const csmFloat32 opacity = model->GetDrawableDynamicFlagIsVisible(i) ? model->GetDrawableOpacity(i) : 0.0f;
+            csmFloat32* texel = texels + _drawableVertexOffsets[i] * 4;
+
+            for (csmInt32 j = 0; j < vertexCount; ++j)
+            {
+                texel[0] = vertices[j * 2];
+                texel[1] = vertices[j * 2 + 1];
+                texel[2] = opacity;
+                texel[3] = 0.0f;
+                texel += 4;
+            }
+
+            if (opacity > 0.0f)
+            {
+                _isInstanceDrawableVisible[i] = true;
+            }
         }
+    }
 
-        //テクスチャ設定
-        rlActiveTextureSlot(0);
-        rlEnableTexture(textureId);
-        rlSetUniform(shaderSet->SamplerTexture0Location, &uniform0, RL_SHADER_UNIFORM_INT, 1);
+    if (_instanceVertexTextureId == 0 || _instanceVertexTextureHeight < rows)
+    {
+        if (_instanceVertexTextureId != 0)
+        {
+            rlUnloadTexture(_instanceVertexTextureId);
+        }
 
-        //座標変換
-        rlSetUniformMatrixDirectly(shaderSet->UniformMatrixLocation, matrix4x4.GetArray());
-        rlSetUniform(shaderSet->UniformBaseColorLocation, &baseColor.R, RL_SHADER_UNIFORM_VEC4, 1);
-        rlSetUniform(shaderSet->UniformMultiplyColorLocation, &multiplyColor.R, RL_SHADER_UNIFORM_VEC4, 1);
-        rlSetUniform(shaderSet->UniformScreenColorLocation, &screenColor.R, RL_SHADER_UNIFORM_VEC4, 1);
+        // インスタンス数が少し増えるたびに作り直さないよう、余裕を持って確保する
+        _instanceVertexTextureHeight = rows + rows / 2;
+        _instanceVertexTextureId = rlLoadTexture(NULL, InstanceVertexTextureWidth, _instanceVertexTextureHeight, RL_PIXELFORMAT_UNCOMPRESSED_R32G32B32A32, 1);
     }
 
-    // 頂点配列&テクスチャ頂点の設定
-    rlUpdateVertexBuffer(shaderSet->VertexBufferPositionId, vertexArray, sizeof(csmFloat32) * vertexCount * 2, 0);
-    rlUpdateVertexBuffer(shaderSet->VertexBufferTexcoordId, uvArray, sizeof(csmFloat32) * vertexCount * 2, 0);
-    rlUpdateVertexBufferElements(shaderSet->VertexBufferElementId, indexArray, sizeof(csmUint16) * indexCount, 0);
-}
+    rlUpdateTexture(_instanceVertexTextureId, 0, 0, InstanceVertexTextureWidth, rows, RL_PIXELFORMAT_UNCOMPRESSED_R32G32B32A32, _instanceVertexStaging.GetPtr());
+    _frameStatistics.UploadCalls++;
+    _frameStatistics.UploadedVertexBytes += sizeof(csmFloat32) * _instanceVertexStaging.GetSize();
 
+    // インスタンスごとのMVP行列と不透明度
+    _instanceStaging.Resize(count * InstanceAttributeFloats, 0.0f);
+    for (csmInt32 instance = 0; instance < count; ++instance)
+    {
+        csmFloat32* attributes = _instanceStaging.GetPtr() + instance * InstanceAttributeFloats;
+        memcpy(attributes, mvps[instance].GetArray(), sizeof(csmFloat32) * 16);
+        attributes[16] = opacities[instance];
+    }
 
-/*********************************************************************************************************************
- *                                      CubismRenderer_OpenGLES2
- ********************************************************************************************************************/
+    const csmInt32 instanceBytes = sizeof(csmFloat32) * _instanceStaging.GetSize();
+    if (_instanceBufferId == 0 || _instanceBufferCapacity < instanceBytes)
+    {
+        if (_instanceBufferId != 0)
+        {
+            rlUnloadVertexBuffer(_instanceBufferId);
+        }
 
-CubismRenderer* CubismRenderer::Create()
-{
-    return CSM_NEW CubismRenderer_OpenGLES2();
-}
+        _instanceBufferCapacity = instanceBytes + instanceBytes / 2;
+        _instanceBufferId = rlLoadVertexBuffer(NULL, _instanceBufferCapacity, true);
+    }
 
-void CubismRenderer::StaticRelease()
-{
-    CubismRenderer_OpenGLES2::DoStaticRelease();
+    rlUpdateVertexBuffer(_instanceBufferId, _instanceStaging.GetPtr(), instanceBytes, 0);
+    rlDisableVertexBuffer();
+    _frameStatistics.UploadCalls++;
+    _frameStatistics.UploadedVertexBytes += instanceBytes;
 }
 
-CubismRenderer_OpenGLES2::CubismRenderer_OpenGLES2() : _clippingManager(NULL)
-                                                     , _clippingContextBufferForMask(NULL)
-                                                     , _clippingContextBufferForDraw(NULL)
+csmBool CubismRenderer_OpenGLES2::DrawInstances(const CubismModel* const* models, CubismMatrix44* mvps, const csmFloat32* opacities, csmInt32 count)
 {
-    // テクスチャ対応マップの容量を確保しておく.
-    _textures.PrepareCapacity(32, true);
-}
+#if defined(CSM_TARGET_IPHONE_ES2) || defined(CSM_TARGET_ANDROID_ES2)
+    // ES2にはインスタンス描画も頂点シェーダでのテクスチャ読み出しも無い
+    return false;
+#else
+    if (GetModel() == NULL || count <= 0 || _clippingManager != NULL)
+    {
+        return false;
+    }
 
-CubismRenderer_OpenGLES2::~CubismRenderer_OpenGLES2()
-{
-    CSM_DELETE_SELF(CubismClippingManager_OpenGLES2, _clippingManager);
+    for (csmInt32 i = 0; i < count; ++i)
+    {
+        if (!IsInstanceCompatible(models[i]))
+        {
+            return false;
+        }
+    }
+
+    memset(&_frameStatistics, 0, sizeof(_frameStatistics));
 
-    if (_offscreenFrameBuffer.IsValid())
+    CubismShader_OpenGLES2* shader = CubismShader_OpenGLES2::GetInstance();
+    const csmUint32 stateChangeCount = shader->_stateChangeCount;
+    const csmUint32 redundantStateCount = shader->_redundantStateCount;
+
+    SaveProfile();
+
+    // UVとインデックスはこのレンダラのバッファを使う
+    if (_vertexBufferTexcoordId == 0)
     {
-        _offscreenFrameBuffer.DestroyOffscreenFrame();
+        CreateVertexBuffers();
     }
-}
 
-void CubismRenderer_OpenGLES2::DoStaticRelease()
-{
-    CubismShader_OpenGLES2::DeleteInstance();
-}
+    // テクスチャの転送はアクティブなユニットのバインドを変えるので、シャドウステートを捨てるPreDrawより先に行う
+    UpdateInstanceBuffers(models, mvps, opacities, count);
 
-void CubismRenderer_OpenGLES2::Initialize(CubismModel* model)
-{
+    PreDraw();
 
-    if (model->IsUsingMasking())
+    const CubismModel* model = GetModel();
+    const csmInt32 drawableCount = model->GetDrawableCount();
+    const csmInt32* renderOrder = model->GetDrawableRenderOrders();
+
+    // 描画順はこのレンダラのモデルのものを全インスタンスで使う
+    for (csmInt32 i = 0; i < drawableCount; ++i)
     {
-        _clippingManager = CSM_NEW CubismClippingManager_OpenGLES2();  //クリッピングマスク・バッファ前処理方式を初期化
-        _clippingManager->Initialize(
-            *model,
-            model->GetDrawableCount(),
-            model->GetDrawableMasks(),
-            model->GetDrawableMaskCounts()
+        _sortedDrawableIndexList[renderOrder[i]] = i;
+    }
+
+    CubismTextureColor modelColorRGBA = GetModelColor();
+    if (IsPremultipliedAlpha())
+    {
+        modelColorRGBA.R *= modelColorRGBA.A;
+        modelColorRGBA.G *= modelColorRGBA.A;
+        modelColorRGBA.B *= modelColorRGBA.A;
+    }
+
+    for (csmInt32 i = 0; i < drawableCount; ++i)
+    {
+        const csmInt32 drawableIndex = _sortedDrawableIndexList[i];
+
+        // どのインスタンスでも見えていなければ描かない
+        if (!_isInstanceDrawableVisible[drawableIndex])
+        {
+            continue;
+        }
+
+        const csmInt32 textureNo = model->GetDrawableTextureIndex(drawableIndex);
+        if (_textures[textureNo] == 0)
+        {
+            continue;
+        }
+
+        shader->SetCulling(model->GetDrawableCulling(drawableIndex) != 0);
+        shader->SetupInstancedShaderProgram(
+            this, _textures[textureNo], _drawableVertexOffsets[drawableIndex]
+            , model->GetDrawableBlendMode(drawableIndex), modelColorRGBA
+            , model->GetMultiplyColor(drawableIndex), model->GetScreenColor(drawableIndex)
+            , IsPremultipliedAlpha()
         );
 
-        _offscreenFrameBuffer.CreateOffscreenFrame(_clippingManager->GetClippingMaskBufferSize().X, _clippingManager->GetClippingMaskBufferSize().Y);
+        rlDrawVertexArrayElementsInstanced(_drawableIndexOffsets[drawableIndex], model->GetDrawableVertexIndexCount(drawableIndex), NULL, count);
+        _frameStatistics.DrawCalls++;
     }
 
-    _sortedDrawableIndexList.Resize(model->GetDrawableCount(), 0);
+    PostDraw();
+    RestoreProfile();
 
-    CubismRenderer::Initialize(model);  //親クラスの処理を呼ぶ
+    // 頂点座標の写しはDoDrawModelでしか更新しないので、次に1体で描くときに集め直させる
+    _isVertexStagingValid = false;
+
+    _frameStatistics.Instances = count;
+    _frameStatistics.StateChanges = shader->_stateChangeCount - stateChangeCount;
+    _frameStatistics.RedundantStateChanges = shader->_redundantStateCount - redundantStateCount;
+
+    return true;
+#endif
 }
 
 void CubismRenderer_OpenGLES2::PreDraw()
@@ -1621,9 +3065,14 @@ void CubismRenderer_OpenGLES2::PreDraw()
     rlEnableColorBlend();
     // glColorMask(1, 1, 1, 1); //TODO: not found in raylib. I think no one will change this in HuiDesktop light
 
+    // VAOを外してからでないと、下のインデックスバッファの解除がVAOに記録されてしまう
+    rlDisableVertexArray();
     rlDisableVertexBufferElement();
     rlDisableVertexBuffer(); //前にバッファがバインドされていたら破棄する必要がある
 
+    // ここまでの間にraylib等がGLのステートを変えているかもしれないので、シャドウステートを捨てる
+    CubismShader_OpenGLES2::GetInstance()->InvalidateState();
+
     //異方性フィルタリング。プラットフォームのOpenGLによっては未対応の場合があるので、未設定のときは設定しない
     if (GetAnisotropy() > 0.0f)
     {
@@ -1637,18 +3086,41 @@ void CubismRenderer_OpenGLES2::PreDraw()
 
 void CubismRenderer_OpenGLES2::DoDrawModel()
 {
+    memset(&_frameStatistics, 0, sizeof(_frameStatistics));
+
+    CubismShader_OpenGLES2* shader = CubismShader_OpenGLES2::GetInstance();
+    const csmUint32 stateChangeCount = shader->_stateChangeCount;
+    const csmUint32 redundantStateCount = shader->_redundantStateCount;
+
+    // 描画に使う頂点をGPUへ転送する。マスクの描画もこのバッファを参照する
+    UpdateVertexBuffers();
+
     //------------ クリッピングマスク・バッファ前処理方式の場合 ------------
     if (_clippingManager != NULL)
     {
         PreDraw();
 
-        // サイズが違う場合はここで作成しなおし
-        if (_offscreenFrameBuffer.GetBufferWidth() != static_cast<csmUint32>(_clippingManager->GetClippingMaskBufferSize().X) ||
-            _offscreenFrameBuffer.GetBufferHeight() != static_cast<csmUint32>(_clippingManager->GetClippingMaskBufferSize().Y))
+        // 枚数かサイズが違う場合はここで作成しなおし
+        const csmUint32 maskBufferWidth = static_cast<csmUint32>(_clippingManager->GetClippingMaskBufferSize().X);
+        const csmUint32 maskBufferHeight = static_cast<csmUint32>(_clippingManager->GetClippingMaskBufferSize().Y);
+        if (_offscreenFrameBuffers.GetSize() != static_cast<csmUint32>(_clippingManager->GetMaskBufferCount()) ||
+            _offscreenFrameBuffers[0].GetBufferWidth() != maskBufferWidth ||
+            _offscreenFrameBuffers[0].GetBufferHeight() != maskBufferHeight)
         {
-            _offscreenFrameBuffer.DestroyOffscreenFrame();
-            _offscreenFrameBuffer.CreateOffscreenFrame(
-                static_cast<csmUint32>(_clippingManager->GetClippingMaskBufferSize().X), static_cast<csmUint32>(_clippingManager->GetClippingMaskBufferSize().Y));
+            for (csmUint32 i = 0; i < _offscreenFrameBuffers.GetSize(); i++)
+            {
+                _offscreenFrameBuffers[i].DestroyOffscreenFrame();
+            }
+            _offscreenFrameBuffers.Clear();
+
+            for (csmInt32 i = 0; i < _clippingManager->GetMaskBufferCount(); i++)
+            {
+                _offscreenFrameBuffers.PushBack(CubismOffscreenFrame_OpenGLES2());
+                _offscreenFrameBuffers[i].CreateOffscreenFrame(maskBufferWidth, maskBufferHeight);
+            }
+
+            // 作り直したバッファにはマスクが残っていない
+            _clippingManager->InvalidateMaskBuffers();
         }
 
         _clippingManager->SetupClippingContext(*GetModel(), this, _rendererProfile._lastFBO, _rendererProfile._lastViewport);
@@ -1667,16 +3139,19 @@ void CubismRenderer_OpenGLES2::DoDrawModel()
         _sortedDrawableIndexList[order] = i;
     }
 
-    // 描画
-    for (csmInt32 i = 0; i < drawableCount; ++i)
+    // 連続していてステートが同じDrawableを1回の描画にまとめる
+    // 非表示のDrawableと、描いても見えないDrawableはここで除かれる
+    if (_isDrawableCullingEnabled)
     {
-        const csmInt32 drawableIndex = _sortedDrawableIndexList[i];
+        UpdateDrawableBounds();
+    }
+    BuildDrawBatches();
 
-        // Drawableが表示状態でなければ処理をパスする
-        if (!GetModel()->GetDrawableDynamicFlagIsVisible(drawableIndex))
-        {
-            continue;
-        }
+    // 描画
+    for (csmUint32 batchIndex = 0; batchIndex < _drawBatches.GetSize(); ++batchIndex)
+    {
+        const DrawBatch& batch = _drawBatches[batchIndex];
+        const csmInt32 drawableIndex = batch.DrawableIndex;
 
         // クリッピングマスク
         CubismClippingContext* clipContext = (_clippingManager != NULL)
@@ -1692,11 +3167,14 @@ void CubismRenderer_OpenGLES2::DoDrawModel()
 
                 PreDraw(); // バッファをクリアする
 
-                _offscreenFrameBuffer.BeginDraw(_rendererProfile._lastFBO);
+                _frameStatistics.MaskRedraws++;
+                _frameStatistics.MaskPixelFill += static_cast<csmUint32>(_clippingManager->GetClippingMaskBufferSize().X * _clippingManager->GetClippingMaskBufferSize().Y) * 2;
+
+                _offscreenFrameBuffers[0].BeginDraw(_rendererProfile._lastFBO);
 
                 // マスクをクリアする
                 // 1が無効（描かれない）領域、0が有効（描かれる）領域。（シェーダで Cd*Csで0に近い値をかけてマスクを作る。1をかけると何も起こらない）
-                _offscreenFrameBuffer.Clear(1.0f, 1.0f, 1.0f, 1.0f);
+                _offscreenFrameBuffers[0].Clear(1.0f, 1.0f, 1.0f, 1.0f);
             }
 
             {
@@ -1705,11 +3183,7 @@ void CubismRenderer_OpenGLES2::DoDrawModel()
                 {
                     const csmInt32 clipDrawIndex = clipContext->_clippingIdList[index];
 
-                    // 頂点情報が更新されておらず、信頼性がない場合は描画をパスする
-                    if (!GetModel()->GetDrawableDynamicFlagVertexPositionsDidChange(clipDrawIndex))
-                    {
-                        continue;
-                    }
+                    // 頂点バッファには常に最後に更新された頂点が入っているので、今回頂点が変化していないマスクも描く
 
                     IsCulling(GetModel()->GetDrawableCulling(clipDrawIndex) != 0);
 
@@ -1717,25 +3191,14 @@ void CubismRenderer_OpenGLES2::DoDrawModel()
                     // チャンネルも切り替える必要がある(A,R,G,B)
                     SetClippingContextBufferForMask(clipContext);
 
-                    DrawMeshOpenGL(
-                        GetModel()->GetDrawableTextureIndex(clipDrawIndex),
-                        GetModel()->GetDrawableVertexIndexCount(clipDrawIndex),
-                        GetModel()->GetDrawableVertexCount(clipDrawIndex),
-                        const_cast<csmUint16*>(GetModel()->GetDrawableVertexIndices(clipDrawIndex)),
-                        const_cast<csmFloat32*>(GetModel()->GetDrawableVertices(clipDrawIndex)),
-                        reinterpret_cast<csmFloat32*>(const_cast<Core::csmVector2*>(GetModel()->GetDrawableVertexUvs(clipDrawIndex))),
-                        GetModel()->GetMultiplyColor(clipDrawIndex),
-                        GetModel()->GetScreenColor(clipDrawIndex),
-                        GetModel()->GetDrawableOpacity(clipDrawIndex),
-                        CubismRenderer::CubismBlendMode_Normal,   //クリッピングは通常描画を強制
-                        false // マスク生成時はクリッピングの反転使用は全く関係がない
-                    );
+                    // マスク生成時は合成モード・反転の指定に関係なくマスク用シェーダで描かれる
+                    DrawMeshOpenGL(*GetModel(), clipDrawIndex);
                 }
             }
 
             {
                 // --- 後処理 ---
-                _offscreenFrameBuffer.EndDraw();
+                _offscreenFrameBuffers[0].EndDraw();
                 SetClippingContextBufferForMask(NULL);
                 rlViewport(_rendererProfile._lastViewport[0], _rendererProfile._lastViewport[1], _rendererProfile._lastViewport[2], _rendererProfile._lastViewport[3]);
 
@@ -1748,22 +3211,33 @@ void CubismRenderer_OpenGLES2::DoDrawModel()
 
         IsCulling(GetModel()->GetDrawableCulling(drawableIndex) != 0);
 
-        DrawMeshOpenGL(
-            GetModel()->GetDrawableTextureIndex(drawableIndex),
-            GetModel()->GetDrawableVertexIndexCount(drawableIndex),
-            GetModel()->GetDrawableVertexCount(drawableIndex),
-            const_cast<csmUint16*>(GetModel()->GetDrawableVertexIndices(drawableIndex)),
-            const_cast<csmFloat32*>(GetModel()->GetDrawableVertices(drawableIndex)),
-            reinterpret_cast<csmFloat32*>(const_cast<Core::csmVector2*>(GetModel()->GetDrawableVertexUvs(drawableIndex))),
-            GetModel()->GetMultiplyColor(drawableIndex),
-            GetModel()->GetScreenColor(drawableIndex),
-            GetModel()->GetDrawableOpacity(drawableIndex),
-            GetModel()->GetDrawableBlendMode(drawableIndex),
-            GetModel()->GetDrawableInvertedMask(drawableIndex) // マスクを反転使用するか
-        );
+        if (batch.DrawableCount > 1)
+        {
+            DrawMeshOpenGL(*GetModel(), drawableIndex, batch.BaseVertex, _batchElementBufferId, batch.IndexOffset, batch.IndexCount);
+            _frameStatistics.BatchedDrawables += batch.DrawableCount;
+        }
+        else
+        {
+            DrawMeshOpenGL(*GetModel(), drawableIndex);
+        }
     }
 
     PostDraw();
+
+    _frameStatistics.StateChanges = shader->_stateChangeCount - stateChangeCount;
+    _frameStatistics.RedundantStateChanges = shader->_redundantStateCount - redundantStateCount;
+}
+
+void CubismRenderer_OpenGLES2::PostDraw()
+{
+    // DrawMeshOpenGLでバインドしたままにしたものを外す
+    rlDisableVertexArray();
+    rlDisableVertexBuffer();
+    rlDisableVertexBufferElement();
+    rlDisableShader();
+    rlActiveTextureSlot(0);
+
+    CubismShader_OpenGLES2::GetInstance()->InvalidateState();
 }
 
 void CubismRenderer_OpenGLES2::DrawMesh(csmInt32 textureNo, csmInt32 indexCount, csmInt32 vertexCount
@@ -1774,25 +3248,23 @@ void CubismRenderer_OpenGLES2::DrawMesh(csmInt32 textureNo, csmInt32 indexCount,
     CSM_ASSERT(0);
 }
 
-void CubismRenderer_OpenGLES2::DrawMeshOpenGL(csmInt32 textureNo, csmInt32 indexCount, csmInt32 vertexCount
-                                        , csmUint16* indexArray, csmFloat32* vertexArray, csmFloat32* uvArray
-                                        , const CubismTextureColor& multiplyColor, const CubismTextureColor& screenColor
-                                        , csmFloat32 opacity, CubismBlendMode colorBlendMode, csmBool invertedMask)
+void CubismRenderer_OpenGLES2::DrawMeshOpenGL(const CubismModel& model, const csmInt32 index)
+{
+    DrawMeshOpenGL(model, index, _drawableVertexOffsets[index], _vertexBufferElementId, _drawableIndexOffsets[index], model.GetDrawableVertexIndexCount(index));
+}
+
+void CubismRenderer_OpenGLES2::DrawMeshOpenGL(const CubismModel& model, const csmInt32 index, csmInt32 baseVertex
+                                              , unsigned int elementBufferId, csmInt32 indexOffset, csmInt32 indexCount)
 {
+    const csmInt32 textureNo = model.GetDrawableTextureIndex(index);
+    const csmFloat32 opacity = model.GetDrawableOpacity(index);
 
 #ifndef CSM_DEBUG
     if (_textures[textureNo] == 0) return;    // モデルが参照するテクスチャがバインドされていない場合は描画をスキップする
 #endif
 
     // 裏面描画の有効・無効
-    if (IsCulling())
-    {
-        rlEnableBackfaceCulling();
-    }
-    else
-    {
-        rlDisableBackfaceCulling();
-    }
+    CubismShader_OpenGLES2::GetInstance()->SetCulling(IsCulling());
 
     // glFrontFace(GL_CCW);    // Cubism SDK OpenGLはマスク・アートメッシュ共にCCWが表面 //TODO: this should be never changed
 
@@ -1824,18 +3296,16 @@ void CubismRenderer_OpenGLES2::DrawMeshOpenGL(csmInt32 textureNo, csmInt32 index
 
     // Set VBOs & EBO
     CubismShader_OpenGLES2::GetInstance()->SetupShaderProgram(
-        this, drawTextureId,indexCount, indexArray, vertexCount, vertexArray, uvArray
-        , opacity, colorBlendMode, modelColorRGBA, multiplyColor, screenColor, IsPremultipliedAlpha()
-        , GetMvpMatrix(), invertedMask
+        this, drawTextureId, baseVertex, elementBufferId
+        , opacity, model.GetDrawableBlendMode(index), modelColorRGBA, model.GetMultiplyColor(index), model.GetScreenColor(index)
+        , IsPremultipliedAlpha(), GetMvpMatrix(), model.GetDrawableInvertedMask(index)
     );
     // Draw
-    rlDrawVertexArrayElements(0, indexCount, NULL);
+    rlDrawVertexArrayElements(indexOffset, indexCount, NULL);
+    _frameStatistics.DrawCalls++;
 
     // 後処理
-    rlDisableVertexArray();
-    rlDisableVertexBuffer();
-    rlDisableVertexBufferElement();
-    rlDisableShader();
+    // シェーダ・VAO・テクスチャは次の描画で同じものを使うことが多いので、バインドしたままにしてPostDrawでまとめて外す
     SetClippingContextBufferForDraw(NULL);
     SetClippingContextBufferForMask(NULL);
 }
@@ -1853,6 +3323,12 @@ void CubismRenderer_OpenGLES2::RestoreProfile()
 void CubismRenderer_OpenGLES2::BindTexture(csmUint32 modelTextureNo, unsigned int glTextureNo)
 {
     _textures[modelTextureNo] = glTextureNo;
+
+    // マスクはテクスチャのアルファから作るので描き直させる
+    if (_clippingManager != NULL)
+    {
+        _clippingManager->InvalidateMaskBuffers();
+    }
 }
 
 const csmMap<csmInt32, unsigned int>& CubismRenderer_OpenGLES2::GetBindedTextures() const
@@ -1863,11 +3339,13 @@ const csmMap<csmInt32, unsigned int>& CubismRenderer_OpenGLES2::GetBindedTexture
 void CubismRenderer_OpenGLES2::SetClippingMaskBufferSize(csmFloat32 width, csmFloat32 height)
 {
     //FrameBufferのサイズを変更するためにインスタンスを破棄・再作成する
+    const csmInt32 maskBufferCount = (_clippingManager != NULL) ? _clippingManager->GetMaskBufferCount() : 1;
     CSM_DELETE_SELF(CubismClippingManager_OpenGLES2, _clippingManager);
 
     _clippingManager = CSM_NEW CubismClippingManager_OpenGLES2();
 
     _clippingManager->SetClippingMaskBufferSize(width, height);
+    _clippingManager->SetMaskBufferCount(maskBufferCount);
 
     _clippingManager->Initialize(
         *GetModel(),
@@ -1882,9 +3360,92 @@ CubismVector2 CubismRenderer_OpenGLES2::GetClippingMaskBufferSize() const
     return _clippingManager->GetClippingMaskBufferSize();
 }
 
-const CubismOffscreenFrame_OpenGLES2* CubismRenderer_OpenGLES2::GetMaskBuffer() const
+void CubismRenderer_OpenGLES2::SetMaskBufferCount(csmInt32 count)
+{
+    if (_clippingManager == NULL)
+    {
+        return; // マスクを使わないモデルではバッファを作らない
+    }
+
+    _clippingManager->SetMaskBufferCount(count);
+}
+
+csmInt32 CubismRenderer_OpenGLES2::GetMaskBufferCount() const
+{
+    return (_clippingManager != NULL) ? _clippingManager->GetMaskBufferCount() : 0;
+}
+
+const CubismOffscreenFrame_OpenGLES2* CubismRenderer_OpenGLES2::GetMaskBuffer(csmInt32 index) const
+{
+    if (index < 0 || static_cast<csmUint32>(index) >= _offscreenFrameBuffers.GetSize())
+    {
+        return NULL;
+    }
+
+    return &_offscreenFrameBuffers[index];
+}
+
+csmBool CubismRenderer_OpenGLES2::GetMaskLayout(csmInt32 drawableIndex, csmInt32& bufferIndex, csmInt32& channelNo, csmRectF& bounds) const
+{
+    if (_clippingManager == NULL || drawableIndex < 0
+        || static_cast<csmUint32>(drawableIndex) >= _clippingManager->GetClippingContextListForDraw()->GetSize())
+    {
+        return false;
+    }
+
+    const CubismClippingContext* clipContext = (*_clippingManager->GetClippingContextListForDraw())[drawableIndex];
+    if (clipContext == NULL || !clipContext->_isUsing)
+    {
+        return false;
+    }
+
+    bufferIndex = clipContext->_bufferIndex;
+    channelNo = clipContext->_layoutChannelNo;
+    bounds.SetRect(clipContext->_layoutBounds);
+    return true;
+}
+
+void CubismRenderer_OpenGLES2::SetShaderCacheDirectory(const csmChar* directory)
+{
+    CubismShader_OpenGLES2::GetInstance()->_programCacheDirectory = (directory != NULL) ? directory : "";
+}
+
+void CubismRenderer_OpenGLES2::SetGLProcAddressLoader(GLProcAddressLoader loader)
+{
+    s_glProcAddressLoader = loader;
+
+    // 次にプログラムを作るときに、新しいローダで関数を取得し直す
+    s_glGetString = NULL;
+    s_glGetIntegerv = NULL;
+    s_glCreateProgram = NULL;
+    s_glGetProgramiv = NULL;
+    s_glGetProgramBinary = NULL;
+    s_glProgramBinary = NULL;
+    s_programBinarySupport = -1;
+}
+
+const CubismShader_OpenGLES2::ProgramStatistics& CubismRenderer_OpenGLES2::GetShaderStatistics()
+{
+    return CubismShader_OpenGLES2::GetInstance()->_programStatistics;
+}
+
+const CubismRenderer_OpenGLES2::FrameStatistics& CubismRenderer_OpenGLES2::GetFrameStatistics() const
+{
+    return _frameStatistics;
+}
+
+void CubismRenderer_OpenGLES2::SetDrawableCulling(csmBool enabled, csmFloat32 minOpacity, csmFloat32 minPixelArea)
 {
-    return &_offscreenFrameBuffer;
+    // 無効の間は外接矩形を更新していないので、次に使うときに全て計算し直す
+    if (enabled && !_isDrawableCullingEnabled)
+    {
+        _drawableBounds.Clear();
+        _hasDrawableBounds.Clear();
+    }
+
+    _isDrawableCullingEnabled = enabled;
+    _cullingMinOpacity = minOpacity;
+    _cullingMinPixelArea = minPixelArea;
 }
 
 void CubismRenderer_OpenGLES2::SetClippingContextBufferForMask(CubismClippingContext* clip)
@@ -14,6 +14,7 @@
 #include "Type/csmRectF.hpp"
 #include "Math/CubismVector2.hpp"
 #include "Type/csmMap.hpp"
+#include "Type/csmString.hpp"
 
 #ifdef CSM_TARGET_ANDROID_ES2
 static_assert(false);
@@ -104,12 +105,27 @@ private:
 
     /**
      * @brief   クリッピングコンテキストを配置するレイアウト。<br>
-     *           ひとつのレンダーテクスチャを極力いっぱいに使ってマスクをレイアウトする。<br>
-     *           マスクグループの数が4以下ならRGBA各チャンネルに１つずつマスクを配置し、5以上6以下ならRGBAを2,2,1,1と配置する。
+     *           マスク用のレンダーテクスチャのRGBA各チャンネルを1枚のキャンバスとみなし、<br>
+     *           画面上の大きさに応じた矩形を棚詰めで配置する。入りきらない場合は全体を縮小して詰め直す。
      *
-     * @param[in]   usingClipCount  ->  配置するクリッピングコンテキストの数
+     * @param[in]   usingClipCount  ->  配置するクリッピングコンテキストの数。0なら全て1枚目のRチャンネル全体に配置する
+     * @param[in]   pixelsPerUnitX  ->  モデル座標の1単位が画面上で何ピクセルになるか（X方向）
+     * @param[in]   pixelsPerUnitY  ->  モデル座標の1単位が画面上で何ピクセルになるか（Y方向）
      */
-    void SetupLayoutBounds(csmInt32 usingClipCount) const;
+    void SetupLayoutBounds(csmInt32 usingClipCount, csmFloat32 pixelsPerUnitX, csmFloat32 pixelsPerUnitY);
+
+    /**
+     * @brief   SetupLayoutBoundsで求めた大きさの矩形を、指定した縮小率で棚詰めする
+     *
+     * @param[in]   scale   ->  矩形に掛ける縮小率
+     * @return  全ての矩形を配置できたらtrue
+     */
+    csmBool PackLayoutBounds(csmFloat32 scale);
+
+    /**
+     * @brief   全てのマスク用バッファに残っているマスクを無効にし、次の描画で描き直させる
+     */
+    void InvalidateMaskBuffers();
 
     /**
      * @brief   画面描画に使用するクリッピングマスクのリストを取得する
@@ -134,6 +150,22 @@ private:
      */
     CubismVector2 GetClippingMaskBufferSize() const;
 
+    /**
+     *@brief  マスクを描くレンダーテクスチャの枚数を設定する
+     *
+     *@param  count -> レンダーテクスチャの枚数（1以上）
+     *
+     */
+    void SetMaskBufferCount(csmInt32 count);
+
+    /**
+     *@brief  マスクを描くレンダーテクスチャの枚数を取得する
+     *
+     *@return レンダーテクスチャの枚数
+     *
+     */
+    csmInt32 GetMaskBufferCount() const;
+
     csmInt32    _currentFrameNo;         ///< マスクテクスチャに与えるフレーム番号
 
     csmVector<CubismRenderer::CubismTextureColor*>  _channelColors;
@@ -146,6 +178,10 @@ private:
     CubismMatrix44  _tmpMatrixForDraw;       ///< マスク計算用の行列
     csmRectF        _tmpBoundsOnModel;       ///< マスク配置計算用の矩形
 
+    csmInt32                            _maskBufferCount;      ///< マスクを描くレンダーテクスチャの枚数（初期値:1）
+    csmVector<csmBool>                  _isMaskBufferValid;    ///< レンダーテクスチャごとに、前回描いたマスクが残っているならtrue
+    csmVector<CubismClippingContext*>   _layoutOrder;          ///< レイアウト計算用。配置するコンテキストを高さの降順に並べたもの
+
 };
 
 /**
@@ -187,6 +223,8 @@ private:
     const csmInt32* _clippingIdList;                 ///< クリッピングマスクのIDリスト
     csmInt32 _clippingIdCount;                       ///< クリッピングマスクの数
     csmInt32 _layoutChannelNo;                       ///< RGBAのいずれのチャンネルにこのクリップを配置するか(0:R , 1:G , 2:B , 3:A)
+    csmInt32 _bufferIndex;                           ///< いずれのレンダーテクスチャにこのクリップを配置するか
+    CubismVector2 _layoutPixelSize;                  ///< 画面上の大きさから求めた、マスクに必要な矩形の大きさ（ピクセル）
     csmRectF* _layoutBounds;                         ///< マスク用チャンネルのどの領域にマスクを入れるか(View座標-1..1, UVは0..1に直す)
     csmRectF* _allClippedDrawRect;                   ///< このクリッピングで、クリッピングされる全ての描画オブジェクトの囲み矩形（毎回更新）
     CubismMatrix44 _matrixForMask;                   ///< マスクの位置計算結果を保持する行列
@@ -194,6 +232,12 @@ private:
     csmVector<csmInt32>* _clippedDrawableIndexList;  ///< このマスクにクリップされる描画オブジェクトのリスト
 
     CubismClippingManager_OpenGLES2* _owner;        ///< このマスクを管理しているマネージャのインスタンス
+
+    csmBool _isDirty;                                ///< 前回描いたマスクから変化があり、描き直す必要があるならtrue
+    csmBool _isBoundsValid;                          ///< _allClippedDrawRectが計算済みならtrue
+    csmInt32 _lastLayoutChannelNo;                   ///< 前回マスクを描いたときの_layoutChannelNo
+    csmRectF _lastLayoutBounds;                      ///< 前回マスクを描いたときの_layoutBounds
+    csmInt32 _lastBufferIndex;                       ///< 前回マスクを描いたときの_bufferIndex
 };
 
 /**
@@ -205,6 +249,19 @@ class CubismShader_OpenGLES2
 {
     friend class CubismRenderer_OpenGLES2;
 
+public:
+    /**
+     * @brief   シェーダプログラムの読み込みにかかった時間を保持する構造体
+     */
+    struct ProgramStatistics
+    {
+        csmUint32 CompiledPrograms;         ///< ソースからコンパイルしたプログラムの数
+        csmUint32 CachedPrograms;           ///< キャッシュしたバイナリから読み込んだプログラムの数
+        csmUint32 RejectedBinaries;         ///< ドライバに受け付けられず、コンパイルし直したバイナリの数
+        csmFloat32 CompileMilliseconds;     ///< コンパイルにかかった時間の合計[ミリ秒]
+        csmFloat32 CacheLoadMilliseconds;   ///< バイナリの読み込みにかかった時間の合計[ミリ秒]
+    };
+
 private:
     /**
      * @brief   インスタンスを取得する（シングルトン）。
@@ -218,19 +275,53 @@ private:
      */
     static void DeleteInstance();
 
+    /**
+     * @brief   シャドウステートで値を保持するユニフォームの種類
+     */
+    enum UniformSlot
+    {
+        UniformSlot_Matrix,             ///< u_matrix
+        UniformSlot_ClipMatrix,         ///< u_clipMatrix
+        UniformSlot_BaseColor,          ///< u_baseColor
+        UniformSlot_MultiplyColor,      ///< u_multiplyColor
+        UniformSlot_ScreenColor,        ///< u_screenColor
+        UniformSlot_ChannelFlag,        ///< u_channelFlag
+        UniformSlot_VertexOffset,       ///< u_vertexOffset
+        UniformSlot_InstanceStride,     ///< u_instanceStride
+        UniformSlot_Count
+    };
+
+    /**
+     * @brief   シェーダプログラムとそのVAOに最後に設定した値を保持する構造体<br>
+     *           同じプログラムを共有するシェーダセットはこの構造体も共有する。
+     */
+    struct CubismProgramState
+    {
+        csmFloat32 UniformValues[UniformSlot_Count][16];  ///< 最後に送ったユニフォームの値
+        csmBool IsUniformValid[UniformSlot_Count];        ///< UniformValuesが有効か
+        unsigned int PositionBufferId;                    ///< VAOに設定した頂点座標のバッファ
+        csmSizeType PositionOffset;                       ///< VAOに設定した頂点座標のオフセット
+        unsigned int TexCoordBufferId;                    ///< VAOに設定したUVのバッファ
+        csmSizeType TexCoordOffset;                       ///< VAOに設定したUVのオフセット
+        unsigned int ElementBufferId;                     ///< VAOに設定したインデックスバッファ
+        unsigned int InstanceBufferId;                    ///< VAOに設定したインスタンスごとの属性のバッファ
+    };
+
     /**
     * @bref    シェーダープログラムとシェーダ変数のアドレスを保持する構造体
     *
     */
     struct CubismShaderSet
     {
+        const csmChar* VertexShaderSource;        ///< 頂点シェーダのソース
+        const csmChar* FragmentShaderSource;      ///< フラグメントシェーダのソース
+        csmBool IsLoaded;                         ///< プログラムを読み込み、変数のアドレスを取得済みか
         unsigned int ShaderProgram;               ///< シェーダプログラムのアドレス
         unsigned int AttributePositionLocation;   ///< シェーダプログラムに渡す変数のアドレス(Position)
         unsigned int AttributeTexCoordLocation;   ///< シェーダプログラムに渡す変数のアドレス(TexCoord)
-        unsigned int VertexArrayObjectId;
-        unsigned int VertexBufferPositionId;
-        unsigned int VertexBufferTexcoordId;
-        unsigned int VertexBufferElementId;
+        unsigned int VertexArrayObjectId;         ///< アトリビュートの有効状態を保持するVAO。バッファはレンダラ側が保持する
+        csmBool IsProgramOwner;                   ///< ShaderProgram・VAO・Stateを所有しているか。falseなら他のセットと共有している
+        CubismProgramState* State;                ///< シャドウステート
         int UniformMatrixLocation;        ///< シェーダプログラムに渡す変数のアドレス(Matrix)
         int UniformClipMatrixLocation;    ///< シェーダプログラムに渡す変数のアドレス(ClipMatrix)
         int SamplerTexture0Location;      ///< シェーダプログラムに渡す変数のアドレス(Texture0)
@@ -239,6 +330,11 @@ private:
         int UniformMultiplyColorLocation; ///< シェーダプログラムに渡す変数のアドレス(MultiplyColor)
         int UniformScreenColorLocation;   ///< シェーダプログラムに渡す変数のアドレス(ScreenColor)
         int UnifromChannelFlagLocation;   ///< シェーダプログラムに渡す変数のアドレス(ChannelFlag)
+        unsigned int AttributeInstanceMatrixLocation;   ///< シェーダプログラムに渡す変数のアドレス(InstanceMatrix)。mat4なので連続する4つを使う
+        unsigned int AttributeInstanceOpacityLocation;  ///< シェーダプログラムに渡す変数のアドレス(InstanceOpacity)
+        int SamplerVerticesLocation;        ///< シェーダプログラムに渡す変数のアドレス(Vertices)
+        int UniformVertexOffsetLocation;    ///< シェーダプログラムに渡す変数のアドレス(VertexOffset)
+        int UniformInstanceStrideLocation;  ///< シェーダプログラムに渡す変数のアドレス(InstanceStride)
     };
 
     /**
@@ -256,9 +352,8 @@ private:
      *
      * @param[in]   renderer              ->  レンダラのインスタンス
      * @param[in]   textureId             ->  GPUのテクスチャID
-     * @param[in]   vertexCount           ->  ポリゴンメッシュの頂点数
-     * @param[in]   vertexArray           ->  ポリゴンメッシュの頂点配列
-     * @param[in]   uvArray               ->  uv配列
+     * @param[in]   baseVertex            ->  レンダラの頂点バッファ上の基準頂点。インデックスはここからの相対値
+     * @param[in]   elementBufferId       ->  描画に使うインデックスバッファ
      * @param[in]   opacity               ->  不透明度
      * @param[in]   colorBlendMode        ->  カラーブレンディングのタイプ
      * @param[in]   baseColor             ->  ベースカラー
@@ -267,9 +362,7 @@ private:
      * @param[in]   invertedMask           ->  マスクを反転して使用するフラグ
      */
     void SetupShaderProgram(CubismRenderer_OpenGLES2* renderer, unsigned int textureId
-                            , csmInt32 indexCount, csmUint16* indexArray
-                            , csmInt32 vertexCount, csmFloat32* vertexArray
-                            , csmFloat32* uvArray, csmFloat32 opacity
+                            , csmInt32 baseVertex, unsigned int elementBufferId, csmFloat32 opacity
                             , CubismRenderer::CubismBlendMode colorBlendMode
                             , CubismRenderer::CubismTextureColor baseColor
                             , CubismRenderer::CubismTextureColor multiplyColor
@@ -277,16 +370,141 @@ private:
                             , csmBool isPremultipliedAlpha, CubismMatrix44 matrix4x4
                             , csmBool invertedMask);
 
+    /**
+     * @brief   インスタンス描画用のシェーダプログラムの一連のセットアップを実行する<br>
+     *           頂点座標はレンダラがインスタンスごとに並べたテクスチャから読む。
+     *
+     * @param[in]   renderer              ->  レンダラのインスタンス
+     * @param[in]   textureId             ->  GPUのテクスチャID
+     * @param[in]   baseVertex            ->  Drawableの先頭頂点
+     * @param[in]   colorBlendMode        ->  カラーブレンディングのタイプ
+     * @param[in]   baseColor             ->  ベースカラー。不透明度はインスタンスごとの値を掛ける
+     * @param[in]   isPremultipliedAlpha  ->  乗算済みアルファかどうか
+     */
+    void SetupInstancedShaderProgram(CubismRenderer_OpenGLES2* renderer, unsigned int textureId, csmInt32 baseVertex
+                                     , CubismRenderer::CubismBlendMode colorBlendMode
+                                     , CubismRenderer::CubismTextureColor baseColor
+                                     , CubismRenderer::CubismTextureColor multiplyColor
+                                     , CubismRenderer::CubismTextureColor screenColor
+                                     , csmBool isPremultipliedAlpha);
+
     /**
      * @brief   シェーダプログラムを解放する
      */
     void ReleaseShaderProgram();
 
     /**
-     * @brief   シェーダプログラムを初期化する
+     * @brief   シャドウステートを無効にする<br>
+     *           レンダラ以外がGLのステートを変更した可能性がある時点で呼び、次の設定を必ずGLに送らせる。
+     */
+    void InvalidateState();
+
+    /**
+     * @brief   シェーダプログラムとVAOを有効にする。既に有効なら何もしない
+     *
+     * @param[in]   shaderSet   ->  有効にするシェーダセット
+     */
+    void UseShaderSet(CubismShaderSet* shaderSet);
+
+    /**
+     * @brief   テクスチャユニットにテクスチャをバインドする。既にバインド済みなら何もしない
+     *
+     * @param[in]   slot        ->  テクスチャユニット
+     * @param[in]   textureId   ->  テクスチャID
+     */
+    void BindTexture(csmInt32 slot, unsigned int textureId);
+
+    /**
+     * @brief   ブレンド係数を設定する。式は常に加算。既に同じ係数なら何もしない
+     */
+    void SetBlendFactors(int srcRgb, int dstRgb, int srcAlpha, int dstAlpha);
+
+    /**
+     * @brief   裏面カリングの有効・無効を設定する。既に同じなら何もしない
+     *
+     * @param[in]   isCulling   ->  trueなら裏面カリングを有効にする
+     */
+    void SetCulling(csmBool isCulling);
+
+    /**
+     * @brief   vec4のユニフォームを設定する。プログラムに同じ値を送っていれば何もしない
+     */
+    void SetUniformVector(CubismShaderSet* shaderSet, UniformSlot slot, int location, const csmFloat32* value);
+
+    /**
+     * @brief   mat4のユニフォームを設定する。プログラムに同じ値を送っていれば何もしない
+     */
+    void SetUniformMatrix(CubismShaderSet* shaderSet, UniformSlot slot, int location, const csmFloat32* value);
+
+    /**
+     * @brief   intのユニフォームを設定する。プログラムに同じ値を送っていれば何もしない
+     */
+    void SetUniformInt(CubismShaderSet* shaderSet, UniformSlot slot, int location, csmInt32 value);
+
+    /**
+     * @brief   VAOに頂点座標・UV・インデックスのバッファを設定する。既に同じ設定なら何もしない
+     */
+    void SetVertexBuffers(CubismShaderSet* shaderSet, unsigned int positionBufferId, csmSizeType positionOffset
+                          , unsigned int texCoordBufferId, csmSizeType texCoordOffset, unsigned int elementBufferId);
+
+    /**
+     * @brief   シェーダセットを初期化する<br>
+     *           各セットのソースを決めるだけで、プログラムは初めて使うときにLoadShaderSetで作る。
      */
     void GenerateShaders();
 
+    /**
+     * @brief   シェーダセットを取得する。プログラムを読み込んでいなければここで読み込む
+     *
+     * @param[in]   index   ->  シェーダセットの番号
+     *
+     * @return  シェーダセット
+     */
+    CubismShaderSet* GetShaderSet(csmInt32 index);
+
+    /**
+     * @brief   シェーダセットのプログラムを読み込み、変数のアドレスを取得してVAOを作る<br>
+     *           加算・乗算のセットは、通常のセットを読み込んでその内容を共有する。
+     *
+     * @param[in]   index   ->  シェーダセットの番号
+     */
+    void LoadShaderSet(csmInt32 index);
+
+    /**
+     * @brief   シェーダプログラムを作る。キャッシュにバイナリがあればそれを使い、無ければコンパイルしてバイナリを保存する
+     *
+     * @param[in]   vertexShaderSource      ->  頂点シェーダのソース
+     * @param[in]   fragmentShaderSource    ->  フラグメントシェーダのソース
+     *
+     * @return  シェーダプログラムのアドレス
+     */
+    unsigned int LoadProgram(const csmChar* vertexShaderSource, const csmChar* fragmentShaderSource);
+
+    /**
+     * @brief   キャッシュのファイル名を求める<br>
+     *           ドライバ（ベンダー・レンダラ・バージョン）とソースのハッシュから作るので、どれかが変われば別のファイルになる。
+     *
+     * @return  キャッシュのパス。キャッシュを使わない場合は空
+     */
+    csmString GetProgramCachePath(const csmChar* vertexShaderSource, const csmChar* fragmentShaderSource) const;
+
+    /**
+     * @brief   キャッシュのバイナリからシェーダプログラムを作る
+     *
+     * @param[in]   path    ->  キャッシュのパス
+     *
+     * @return  シェーダプログラムのアドレス。ファイルが無いか、ドライバが受け付けなかった場合は0
+     */
+    unsigned int LoadProgramBinary(const csmString& path);
+
+    /**
+     * @brief   シェーダプログラムのバイナリをキャッシュに保存する
+     *
+     * @param[in]   path            ->  キャッシュのパス
+     * @param[in]   shaderProgram   ->  保存するシェーダプログラム
+     */
+    void SaveProgramBinary(const csmString& path, unsigned int shaderProgram) const;
+
     /**
      * @brief   シェーダプログラムをリンクする
      *
@@ -324,6 +542,87 @@ private:
 
     csmVector<CubismShaderSet*> _shaderSets;   ///< ロードしたシェーダプログラムを保持する変数
 
+    csmString           _programCacheDirectory;     ///< シェーダプログラムのバイナリを保存するディレクトリ。空ならキャッシュしない
+    ProgramStatistics   _programStatistics;         ///< シェーダプログラムの読み込みにかかった時間
+
+    unsigned int    _currentProgram;            ///< 有効にしているシェーダプログラム
+    unsigned int    _currentVertexArray;        ///< 有効にしているVAO
+    csmInt32        _currentTextureSlot;        ///< アクティブなテクスチャユニット
+    unsigned int    _currentTextures[2];        ///< テクスチャユニットごとのバインド中のテクスチャ
+    csmBool         _isTextureValid[2];         ///< _currentTexturesが有効か
+    int             _currentBlendFactors[4];    ///< 設定中のブレンド係数
+    csmBool         _isBlendValid;              ///< _currentBlendFactorsが有効か
+    csmInt32        _currentCulling;            ///< 裏面カリングの状態。-1なら不明
+    csmUint32       _stateChangeCount;          ///< GLに送ったステート変更の数
+    csmUint32       _redundantStateCount;       ///< 同じ値だったため省略したステート変更の数
+};
+
+/**
+ * @brief   全モデルの頂点座標を書き込むストリーミング用の頂点バッファ<br>
+ *           シングルトンなクラスであり、CubismVertexStream_OpenGLES2::GetInstance()からアクセスする。<br>
+ *           リングバッファとして先頭から順に追記し、末尾に達したらバッファを作り直して（orphan）先頭に戻る。
+ *
+ */
+class CubismVertexStream_OpenGLES2
+{
+    friend class CubismRenderer_OpenGLES2;
+    friend class CubismShader_OpenGLES2;
+
+private:
+    /**
+     * @brief   インスタンスを取得する（シングルトン）。
+     *
+     * @return  インスタンスのポインタ
+     */
+    static CubismVertexStream_OpenGLES2* GetInstance();
+
+    /**
+     * @brief   インスタンスを解放する（シングルトン）。
+     */
+    static void DeleteInstance();
+
+    /**
+     * @brief   privateなコンストラクタ
+     */
+    CubismVertexStream_OpenGLES2();
+
+    /**
+     * @brief   privateなデストラクタ
+     */
+    virtual ~CubismVertexStream_OpenGLES2();
+
+    /**
+     * @brief   データをバッファの末尾に追記する<br>
+     *           収まらない場合はバッファを作り直すので、それ以前に追記した領域は無効になる。
+     *
+     * @param[in]   data    ->  書き込むデータ
+     * @param[in]   size    ->  書き込むバイト数
+     * @param[out]  lap     ->  書き込んだ時点の周回番号
+     *
+     * @return  書き込んだ位置のバイトオフセット
+     */
+    csmInt32 Append(const void* data, csmInt32 size, csmUint32& lap);
+
+    /**
+     * @brief   指定した周回で書き込んだ領域がまだ有効か
+     *
+     * @param[in]   lap     ->  Appendで受け取った周回番号
+     *
+     * @return  有効ならtrue
+     */
+    csmBool IsValid(csmUint32 lap) const;
+
+    /**
+     * @brief   頂点バッファのIDを取得する
+     *
+     * @return  頂点バッファのID
+     */
+    unsigned int GetBufferId() const;
+
+    unsigned int    _bufferId;      ///< 頂点バッファのID
+    csmInt32        _capacity;      ///< バッファの容量（バイト）
+    csmInt32        _cursor;        ///< 次に書き込む位置（バイト）
+    csmUint32       _lap;           ///< バッファを作り直した回数。これが変わると以前の領域は無効
 };
 
 /**
@@ -338,7 +637,7 @@ private:
     /**
      * @biref   privateなコンストラクタ
      */
-    CubismRendererProfile_OpenGLES2() {};
+    CubismRendererProfile_OpenGLES2() : _lastFBO(0) {};
 
     /**
      * @biref   privateなデストラクタ
@@ -444,13 +743,131 @@ public:
      */
     CubismVector2 GetClippingMaskBufferSize() const;
 
+    /**
+     * @brief  マスクを描くレンダーテクスチャの枚数を設定する<br>
+     *         マスクの数が多いモデルでは枚数を増やすと、1つあたりのマスクの解像度が上がる。<br>
+     *         レンダーテクスチャは次の描画時に作り直される。
+     *
+     * @param[in]  count -> レンダーテクスチャの枚数（1以上）
+     *
+     */
+    void SetMaskBufferCount(csmInt32 count);
+
+    /**
+     * @brief  マスクを描くレンダーテクスチャの枚数を取得する
+     *
+     * @return レンダーテクスチャの枚数
+     *
+     */
+    csmInt32 GetMaskBufferCount() const;
+
     /**
      * @brief  クリッピングマスクのバッファを取得する
      *
-     * @return クリッピングマスクのバッファへのポインタ
+     * @param[in]  index -> レンダーテクスチャの番号
+     * @return クリッピングマスクのバッファへのポインタ。存在しなければNULL
+     *
+     */
+    const CubismOffscreenFrame_OpenGLES2* GetMaskBuffer(csmInt32 index = 0) const;
+
+    /**
+     * @brief  Drawableが参照するマスクの、直前の描画での配置を取得する
+     *
+     * @param[in]  drawableIndex -> マスクを使うDrawableのインデックス
+     * @param[out] bufferIndex   -> マスクを描いたレンダーテクスチャの番号
+     * @param[out] channelNo     -> マスクを描いたカラーチャンネル(0:R , 1:G , 2:B, 3:A)
+     * @param[out] bounds        -> レンダーテクスチャ上の矩形（0.0～1.0）
+     * @return マスクを使っていて配置が決まっていればtrue
+     *
+     */
+    csmBool GetMaskLayout(csmInt32 drawableIndex, csmInt32& bufferIndex, csmInt32& channelNo, csmRectF& bounds) const;
+
+    /**
+     * @brief   シェーダプログラムのバイナリを保存するディレクトリを設定する<br>
+     *           次回以降の起動ではコンパイルせずにバイナリを読み込む。最初のモデルを描画する前に呼ぶこと。
+     *
+     * @param[in]   directory   ->  ディレクトリのパス（末尾の区切り文字は不要）。NULLか空ならキャッシュしない
+     */
+    static void SetShaderCacheDirectory(const csmChar* directory);
+
+    /**
+     * @brief   GLの関数のアドレスを返す関数（glfwGetProcAddress・eglGetProcAddressなど）
+     */
+    typedef void* (*GLProcAddressLoader)(const csmChar* name);
+
+    /**
+     * @brief   プログラムバイナリの関数を取得するローダを設定する<br>
+     *           プログラムバイナリの関数はrlglに無いため、このローダから取得する。
+     *           設定しない場合、CSM_TARGET_WIN_GLではopengl32.dllとwglGetProcAddressから取得し、
+     *           それ以外のターゲットではキャッシュを使わずに毎回コンパイルする。最初のモデルを描画する前に呼ぶこと。
+     *
+     * @param[in]   loader  ->  ローダ。NULLなら既定の取得方法に戻す
+     */
+    static void SetGLProcAddressLoader(GLProcAddressLoader loader);
+
+    /**
+     * @brief   シェーダプログラムの読み込みにかかった時間を取得する
+     *
+     * @return  コンパイルとキャッシュからの読み込みそれぞれの数と時間
+     */
+    static const CubismShader_OpenGLES2::ProgramStatistics& GetShaderStatistics();
+
+    /**
+     * @brief   このレンダラのモデルと同じモデルデータから作ったモデルを、インスタンス描画でまとめて描画する<br>
+     *           テクスチャ・UV・インデックス・描画順・合成モード・カリング・乗算色・スクリーン色はこのレンダラのモデルのものを使い、
+     *           頂点座標・Drawableの不透明度・MVP行列・不透明度だけをモデルごとに変える。<br>
+     *           描画命令の数はDrawableの数だけで、モデルの数によらない。
+     *           Drawableごとに全インスタンスを描くので、インスタンス同士が重なるとDrawable単位で前後関係が混ざる。
+     *
+     * @param[in]   models      ->  描画するモデルの配列。Updateを済ませておくこと
+     * @param[in]   mvps        ->  モデルごとのModel-View-Projection行列
+     * @param[in]   opacities   ->  モデルごとの不透明度
+     * @param[in]   count       ->  モデルの数
+     *
+     * @retval      true        ->  描画した
+     * @retval      false       ->  マスクを使うモデルや、Drawableの構成が異なるモデルが含まれるので何もしていない。呼び出し側で1体ずつ描画する
+     */
+    csmBool DrawInstances(const CubismModel* const* models, CubismMatrix44* mvps, const csmFloat32* opacities, csmInt32 count);
+
+    /**
+     * @brief   1フレーム分の描画で発生したGPUへの転送量を保持する構造体
+     */
+    struct FrameStatistics
+    {
+        csmUint32 UploadCalls;            ///< バッファ転送の呼び出し回数
+        csmUint32 UploadedVertexBytes;    ///< 転送した頂点座標のバイト数
+        csmUint32 UploadedUvBytes;        ///< 転送したUVのバイト数
+        csmUint32 UploadedIndexBytes;     ///< 転送したインデックスのバイト数
+        csmUint32 StateChanges;           ///< GLに送ったステート変更（シェーダ・テクスチャ・ブレンド・ユニフォーム等）の数
+        csmUint32 RedundantStateChanges;  ///< 直前と同じ値だったため省略したステート変更の数
+        csmUint32 DrawCalls;              ///< 描画命令の数（マスク生成分を含む）
+        csmUint32 BatchedDrawables;       ///< 他のDrawableとまとめて描画したDrawableの数
+        csmUint32 MaskRedraws;            ///< マスクを描き直したクリッピングコンテキストの数
+        csmUint32 MaskPixelFill;          ///< マスクの生成で塗ったピクセル数（クリアと各マスク領域の合計）
+        csmUint32 Instances;              ///< DrawInstancesでまとめて描画したモデルの数
+        csmUint32 CulledByOpacity;        ///< 不透明度がほぼ0のため描かなかったDrawableの数
+        csmUint32 CulledByViewport;       ///< ビューポートの外にあるため描かなかったDrawableの数
+        csmUint32 CulledBySize;           ///< 画面上の大きさが閾値未満のため描かなかったDrawableの数
+    };
+
+    /**
+     * @brief   直前のDrawModelで発生したGPUへの転送量を取得する
+     *
+     * @return  転送量の統計
+     */
+    const FrameStatistics& GetFrameStatistics() const;
+
+    /**
+     * @brief   表示状態でも描いても見えないDrawableを、描画の前に除くかを設定する。<br>
+     *           頂点の外接矩形をMVP行列で変換し、ビューポートの外にあるものと画面上の面積が閾値未満のものを除く。
+     *           除いたDrawableもマスクの生成には使われるので、それでクリッピングされるDrawableの見た目は変わらない。<br>
+     *           既定では除かない。DrawInstancesには適用されない。
      *
+     * @param[in]   enabled         ->  trueなら除く
+     * @param[in]   minOpacity      ->  この値未満の不透明度のDrawableを除く
+     * @param[in]   minPixelArea    ->  外接矩形の画面上の面積[ピクセル]がこの値未満のDrawableを除く。0なら面積では除かない
      */
-    const CubismOffscreenFrame_OpenGLES2* GetMaskBuffer() const;
+    void SetDrawableCulling(csmBool enabled, csmFloat32 minOpacity, csmFloat32 minPixelArea);
 
     void SetViewport(int w, int h) {
         _rendererProfile._lastViewport[0] = 0;
@@ -459,6 +876,16 @@ public:
         _rendererProfile._lastViewport[3] = h;
     }
 
+    /**
+     * @brief   モデルを描画するフレームバッファを設定する。<br>
+     *          マスクの生成後はこのフレームバッファに戻してモデルを描く。
+     *
+     * @param[in]   fbo     フレームバッファ。0なら既定のフレームバッファ
+     */
+    void SetRenderTarget(int fbo) {
+        _rendererProfile._lastFBO = fbo;
+    }
+
 protected:
     /**
      * @brief   コンストラクタ
@@ -481,27 +908,29 @@ protected:
             , csmFloat32 opacity, CubismBlendMode colorBlendMode, csmBool invertedMask) override;
 
     /**
-     * @brief   [オーバーライド]<br>
-     *           描画オブジェクト（アートメッシュ）を描画する。<br>
-     *           ポリゴンメッシュとテクスチャ番号をセットで渡す。
+     * @brief   描画オブジェクト（アートメッシュ）を描画する。<br>
+     *           頂点・UV・インデックスはレンダラが保持するバッファ上のものを使う。
      *
-     * @param[in]   textureNo       ->  描画するテクスチャ番号
-     * @param[in]   indexCount      ->  描画オブジェクトのインデックス値
-     * @param[in]   vertexCount     ->  ポリゴンメッシュの頂点数
-     * @param[in]   indexArray      ->  ポリゴンメッシュのインデックス配列
-     * @param[in]   vertexArray     ->  ポリゴンメッシュの頂点配列
-     * @param[in]   uvArray         ->  uv配列
-     * @param[in]   multiplyColor    ->  乗算色
-     * @param[in]   screenColor         ->  スクリーン色
-     * @param[in]   opacity         ->  不透明度
-     * @param[in]   colorBlendMode  ->  カラー合成タイプ
-     * @param[in]   invertedMask     ->  マスク使用時のマスクの反転使用
+     * @param[in]   model           ->  描画するモデル
+     * @param[in]   index           ->  描画するDrawableのインデックス
      *
      */
-    void DrawMeshOpenGL(csmInt32 textureNo, csmInt32 indexCount, csmInt32 vertexCount
-                  , csmUint16* indexArray, csmFloat32* vertexArray, csmFloat32* uvArray
-                  , const CubismTextureColor& multiplyColor, const CubismTextureColor& screenColor
-                  , csmFloat32 opacity, CubismBlendMode colorBlendMode, csmBool invertedMask);
+    void DrawMeshOpenGL(const CubismModel& model, const csmInt32 index);
+
+    /**
+     * @brief   描画オブジェクト（アートメッシュ）を、指定したインデックス範囲で描画する。<br>
+     *           描画ステートはindexのDrawableのものを使うので、まとめて描画するDrawable同士はステートが一致している必要がある。
+     *
+     * @param[in]   model           ->  描画するモデル
+     * @param[in]   index           ->  描画ステートを決めるDrawableのインデックス
+     * @param[in]   baseVertex      ->  頂点バッファ上の基準頂点
+     * @param[in]   elementBufferId ->  インデックスバッファ
+     * @param[in]   indexOffset     ->  インデックスバッファ上の先頭
+     * @param[in]   indexCount      ->  インデックス数
+     *
+     */
+    void DrawMeshOpenGL(const CubismModel& model, const csmInt32 index, csmInt32 baseVertex
+                        , unsigned int elementBufferId, csmInt32 indexOffset, csmInt32 indexCount);
 
 
 #ifdef CSM_TARGET_ANDROID_ES2
@@ -541,7 +970,77 @@ private:
      * @brief   描画完了後の追加処理。
      *
      */
-    void PostDraw(){};
+    void PostDraw();
+
+    /**
+     * @brief   モデル単位の頂点・UV・インデックスバッファを生成し、全Drawable分を転送する<br>
+     *           UVとインデックスはロード後に変化しないので、ここで一度だけ転送する。
+     */
+    void CreateVertexBuffers();
+
+    /**
+     * @brief   モデル単位の頂点・UV・インデックスバッファを破棄する
+     */
+    void ReleaseVertexBuffers();
+
+    /**
+     * @brief   頂点位置が更新されたDrawableの頂点を、共有のストリーミングバッファへ転送する<br>
+     *           前回書き込んだ領域が有効なら、更新されたDrawableの範囲だけをその領域へ上書きする。
+     *           頂点バッファ上で隣り合うDrawableの範囲は1回の転送にまとめる。
+     *           領域が無効になっていれば、モデルの頂点をまとめてストリーミングバッファへ追記する。
+     */
+    void UpdateVertexBuffers();
+
+    /**
+     * @brief   CPU側の写しの指定範囲を、ストリーミングバッファ上のこのモデルの領域へ上書きする
+     *
+     * @param[in]   firstVertex  先頭の頂点（モデル全体での通し番号）
+     * @param[in]   vertexCount  頂点の数
+     */
+    void UploadVertexRange(csmInt32 firstVertex, csmInt32 vertexCount);
+
+    /**
+     * @brief   描画順に並べたDrawableのうち、連続していて描画ステートが同じものを1回の描画にまとめる<br>
+     *           まとめ方が前のフレームから変わった場合だけ、結合したインデックスを転送する。
+     */
+    void BuildDrawBatches();
+
+    /**
+     * @brief   2つのDrawableを1回の描画にまとめられるか
+     *
+     * @param[in]   a   ->  先に描画するDrawableのインデックス
+     * @param[in]   b   ->  後に描画するDrawableのインデックス
+     *
+     * @return  テクスチャ・合成モード・カリング・クリッピング・不透明度・乗算色・スクリーン色が一致していればtrue
+     */
+    csmBool IsBatchable(csmInt32 a, csmInt32 b) const;
+
+    /**
+     * @brief   頂点位置が更新されたDrawableの外接矩形を計算し直す
+     */
+    void UpdateDrawableBounds();
+
+    /**
+     * @brief   Drawableを描いても見えないか。見えない場合は理由ごとの統計を加算する
+     *
+     * @param[in]   drawableIndex   ->  Drawableのインデックス
+     * @param[in]   mvp             ->  Model-View-Projection行列の配列
+     *
+     * @return  不透明度がほぼ0、ビューポートの外、または画面上の面積が閾値未満ならtrue
+     */
+    csmBool IsDrawableCulled(csmInt32 drawableIndex, const csmFloat32* mvp);
+
+    /**
+     * @brief   モデルをこのレンダラのバッファでインスタンス描画できるか
+     *
+     * @return  マスクを使わず、Drawableの数と各Drawableの頂点数が一致していればtrue
+     */
+    csmBool IsInstanceCompatible(const CubismModel* model) const;
+
+    /**
+     * @brief   インスタンスごとの頂点座標・不透明度とMVP行列を転送する
+     */
+    void UpdateInstanceBuffers(const CubismModel* const* models, CubismMatrix44* mvps, const csmFloat32* opacities, csmInt32 count);
 
     /**
      * @brief   モデル描画直前のOpenGLES2のステートを保持する
@@ -584,7 +1083,51 @@ private:
     CubismClippingContext*              _clippingContextBufferForMask;  ///< マスクテクスチャに描画するためのクリッピングコンテキスト
     CubismClippingContext*              _clippingContextBufferForDraw;  ///< 画面上描画するためのクリッピングコンテキスト
 
-    CubismOffscreenFrame_OpenGLES2      _offscreenFrameBuffer;          ///< マスク描画用のフレームバッファ
+    csmVector<CubismOffscreenFrame_OpenGLES2> _offscreenFrameBuffers;   ///< マスク描画用のフレームバッファ
+
+    unsigned int                        _vertexBufferTexcoordId;        ///< 全DrawableのUVを並べた頂点バッファ（ロード後は不変）
+    unsigned int                        _vertexBufferElementId;         ///< 全Drawableのインデックスを並べたインデックスバッファ（ロード後は不変）
+    csmVector<csmInt32>                 _drawableVertexOffsets;         ///< Drawableごとの頂点バッファ上の先頭頂点
+    csmVector<csmInt32>                 _drawableIndexOffsets;          ///< Drawableごとのインデックスバッファ上の先頭インデックス
+    csmVector<csmFloat32>               _vertexStaging;                 ///< 全Drawableの頂点座標を並べたCPU側の写し
+    csmInt32                            _streamOffset;                  ///< ストリーミングバッファ上のこのモデルの頂点の先頭（バイト）
+    csmUint32                           _streamLap;                     ///< _streamOffsetを書き込んだときの周回番号
+    csmBool                             _isStreamWritten;               ///< ストリーミングバッファへ一度でも書き込んだか
+    csmBool                             _isVertexStagingValid;          ///< _vertexStagingが前回の描画時点の頂点座標を保持しているか
+    FrameStatistics                     _frameStatistics;               ///< 直前のフレームの転送量
+
+    /**
+     * @brief   1回の描画にまとめたDrawableの範囲
+     */
+    struct DrawBatch
+    {
+        csmInt32 DrawableIndex;     ///< 描画ステートを決める先頭のDrawable
+        csmInt32 FirstMember;       ///< _batchMembers上の先頭
+        csmInt32 DrawableCount;     ///< まとめたDrawableの数
+        csmInt32 BaseVertex;        ///< 頂点バッファ上の基準頂点
+        csmInt32 IndexOffset;       ///< 結合したインデックスバッファ上の先頭
+        csmInt32 IndexCount;        ///< インデックス数
+    };
+
+    csmVector<DrawBatch>                _drawBatches;                   ///< 今回のフレームの描画単位
+    csmVector<csmInt32>                 _batchMembers;                  ///< 表示中のDrawableを描画順に並べたもの
+    csmVector<csmInt32>                 _batchLayout;                   ///< 結合したバッチの構成。変化の検出に使う
+    csmVector<csmInt32>                 _previousBatchLayout;           ///< 前回インデックスを転送したときのバッチの構成
+    csmVector<csmUint16>                _batchIndices;                  ///< 結合したインデックスのCPU側の写し
+    unsigned int                        _batchElementBufferId;          ///< 結合したインデックスのバッファ
+    csmInt32                            _batchElementCapacity;          ///< _batchElementBufferIdの容量（インデックス数）
+    unsigned int                        _instanceVertexTextureId;       ///< インスタンスごとの頂点座標とDrawableの不透明度を並べたテクスチャ
+    csmInt32                            _instanceVertexTextureHeight;   ///< _instanceVertexTextureIdの高さ
+    csmVector<csmFloat32>               _instanceVertexStaging;         ///< _instanceVertexTextureIdのCPU側の写し
+    unsigned int                        _instanceBufferId;              ///< インスタンスごとのMVP行列と不透明度を並べた頂点バッファ
+    csmInt32                            _instanceBufferCapacity;        ///< _instanceBufferIdの容量（バイト）
+    csmVector<csmFloat32>               _instanceStaging;               ///< _instanceBufferIdのCPU側の写し
+    csmVector<csmBool>                  _isInstanceDrawableVisible;     ///< Drawableがいずれかのインスタンスで見えているか
+    csmBool                             _isDrawableCullingEnabled;      ///< 見えないDrawableを描画の前に除くか
+    csmFloat32                          _cullingMinOpacity;             ///< この値未満の不透明度のDrawableを除く
+    csmFloat32                          _cullingMinPixelArea;           ///< 画面上の面積[ピクセル]がこの値未満のDrawableを除く
+    csmVector<csmFloat32>               _drawableBounds;                ///< Drawableごとの頂点の外接矩形（最小X, 最小Y, 最大X, 最大Y）
+    csmVector<csmBool>                  _hasDrawableBounds;             ///< Drawableに有効な頂点があり、_drawableBoundsが使えるか
 };
 
 }}}}
@@ -0,0 +1,1013 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+#include "CubismRlglRecorder.hpp"
+#include <cstring>
+#include <string>
+#include <vector>
+#include "rlgl.h"
+
+using namespace Live2D::Cubism::Framework;
+using namespace Live2D::Cubism::Framework::Rendering;
+
+//------------ ファイルスコープ ------------
+namespace {
+    const csmInt32 MaxAttributes = 16;     ///< 頂点配列が持つ属性の数
+    const csmInt32 MaxTextureSlots = 8;    ///< テクスチャのスロットの数
+    const csmInt32 UnknownState = -1;      ///< InvalidateStateの後、まだ設定されていないステート
+    const unsigned int DefaultProgramBinaryFormat = 0x5243;        ///< 記録用のプログラムバイナリの形式
+    const csmChar ProgramBinaryTag[] = "CubismRlglRecorderProgram"; ///< 記録用のプログラムバイナリの中身
+
+    // プログラムバイナリの保存・読み込みに使う、rlglに無いGLの定数
+    const unsigned int GL_VENDOR = 0x1F00;
+    const unsigned int GL_RENDERER = 0x1F01;
+    const unsigned int GL_VERSION = 0x1F02;
+    const unsigned int GL_LINK_STATUS = 0x8B82;
+    const unsigned int GL_PROGRAM_BINARY_LENGTH = 0x8741;
+    const unsigned int GL_NUM_PROGRAM_BINARY_FORMATS = 0x87FE;
+
+    /**
+     * @brief   GLのオブジェクトの種類
+     */
+    enum ObjectType
+    {
+        ObjectType_None,
+        ObjectType_Program,
+        ObjectType_VertexArray,
+        ObjectType_VertexBuffer,
+        ObjectType_ElementBuffer,
+        ObjectType_Texture,
+        ObjectType_Framebuffer,
+    };
+
+    /**
+     * @brief   頂点配列の1つの属性の設定
+     */
+    struct Attribute
+    {
+        csmInt64 BufferId;      ///< 設定したときのGL_ARRAY_BUFFER。UnknownStateなら未設定
+        csmSizeType Offset;
+        csmInt32 Size;
+        csmInt32 Type;
+        csmInt32 Stride;
+        csmBool Normalized;
+    };
+
+    /**
+     * @brief   プログラムの1つのユニフォームの値
+     */
+    struct Uniform
+    {
+        csmBool IsValid;
+        csmUint32 Bytes;
+        csmFloat32 Value[16];
+    };
+
+    /**
+     * @brief   GLのオブジェクト。IDを添字にして保持する
+     */
+    struct Object
+    {
+        ObjectType Type;
+        csmInt32 Size;                              ///< バッファのバイト数、テクスチャの幅×高さ
+        csmInt64 ElementBufferId;                   ///< 頂点配列に結び付いたインデックスバッファ
+        Attribute Attributes[MaxAttributes];        ///< 頂点配列の属性
+        std::vector<Uniform> Uniforms;              ///< プログラムのユニフォーム。ロケーションを添字にする
+        csmBool IsLinked;                           ///< プログラムがリンク済みか
+    };
+
+    /**
+     * @brief   記録用のGLのステート
+     */
+    struct State
+    {
+        std::vector<Object> Objects;        ///< 0番はデフォルトの頂点配列
+        std::vector<std::string> UniformNames;  ///< ユニフォームの名前。ロケーションを添字にする
+        csmUint32 LiveObjects;
+        csmInt64 Program;
+        csmInt64 VertexArray;
+        csmInt64 ArrayBuffer;
+        csmInt32 ActiveTextureSlot;
+        csmInt64 Textures[MaxTextureSlots];
+        csmInt64 Framebuffer;
+        csmInt32 Culling;
+        csmInt32 BlendMode;
+        csmInt32 BlendFactors[4];
+        csmInt32 PendingBlendFactors[4];
+        csmInt32 ImmediateVertices;        ///< rlBeginからの、まだ描いていない即時描画の頂点の数
+        unsigned int ProgramBinaryFormat;  ///< glProgramBinaryが受け付けるバイナリの形式
+        CubismRlglRecorder::Statistics Statistics;
+        csmVector<CubismRlglCommand>* Commands;
+
+        State()
+            : LiveObjects(0)
+            , ImmediateVertices(0)
+            , ProgramBinaryFormat(DefaultProgramBinaryFormat)
+            , Commands(NULL)
+        {
+            Object defaultVertexArray;
+            ResetVertexArray(defaultVertexArray);
+            defaultVertexArray.Type = ObjectType_VertexArray;
+            Objects.push_back(defaultVertexArray);
+
+            Program = 0;
+            VertexArray = 0;
+            ArrayBuffer = 0;
+            ActiveTextureSlot = 0;
+            for (csmInt32 i = 0; i < MaxTextureSlots; i++)
+            {
+                Textures[i] = 0;
+            }
+            Framebuffer = 0;
+            Culling = 0;
+            BlendMode = RL_BLEND_ALPHA;
+            for (csmInt32 i = 0; i < 4; i++)
+            {
+                BlendFactors[i] = 0;
+                PendingBlendFactors[i] = 0;
+            }
+            memset(&Statistics, 0, sizeof(Statistics));
+        }
+
+        static void ResetVertexArray(Object& object)
+        {
+            object.Type = ObjectType_None;
+            object.Size = 0;
+            object.ElementBufferId = 0;
+            for (csmInt32 i = 0; i < MaxAttributes; i++)
+            {
+                object.Attributes[i].BufferId = UnknownState;
+            }
+            object.Uniforms.clear();
+            object.IsLinked = false;
+        }
+    };
+
+    State& GetState()
+    {
+        static State state;
+        return state;
+    }
+
+    unsigned int CreateObject(ObjectType type, csmInt32 size)
+    {
+        State& state = GetState();
+        Object object;
+        State::ResetVertexArray(object);
+        object.Type = type;
+        object.Size = size;
+        state.Objects.push_back(object);
+        state.LiveObjects++;
+        return static_cast<unsigned int>(state.Objects.size() - 1);
+    }
+
+    Object* FindObject(csmInt64 id, ObjectType type)
+    {
+        State& state = GetState();
+        if (id < 0 || id >= static_cast<csmInt64>(state.Objects.size()) || state.Objects[id].Type != type)
+        {
+            return NULL;
+        }
+        return &state.Objects[id];
+    }
+
+    void DeleteObject(unsigned int id, ObjectType type)
+    {
+        Object* object = FindObject(id, type);
+        if (object == NULL)
+        {
+            // 0はGLでも無視される。それ以外は別の種類のオブジェクトか解放済みのIDを渡している
+            if (id != 0)
+            {
+                GetState().Statistics.InvalidCalls++;
+            }
+            return;
+        }
+        State::ResetVertexArray(*object);
+        GetState().LiveObjects--;
+    }
+
+    void Record(CubismRlglCommandType type, csmUint32 target, csmInt32 offset, csmInt32 count, csmBool isRedundant)
+    {
+        csmVector<CubismRlglCommand>* commands = GetState().Commands;
+        if (commands == NULL)
+        {
+            return;
+        }
+
+        CubismRlglCommand command;
+        command.Type = type;
+        command.Target = target;
+        command.Offset = offset;
+        command.Count = count;
+        command.IsRedundant = isRedundant;
+        commands->PushBack(command, false);
+    }
+
+    /**
+     * @brief   ステートを設定する呼び出しを数える
+     *
+     * @param[in]   isRedundant ->  設定前と同じ値だったか
+     */
+    void CountState(CubismRlglCommandType type, csmUint32 target, csmInt32 offset, csmBool isRedundant)
+    {
+        State& state = GetState();
+        if (isRedundant)
+        {
+            state.Statistics.RedundantStateChanges++;
+        }
+        else
+        {
+            state.Statistics.StateChanges++;
+        }
+        Record(type, target, offset, 0, isRedundant);
+    }
+
+    void CountUpload(CubismRlglCommandType type, csmUint32 target, csmInt32 offset, csmInt32 bytes)
+    {
+        State& state = GetState();
+        state.Statistics.UploadCalls++;
+        switch (type)
+        {
+        case CubismRlglCommandType_UploadVertices:
+            state.Statistics.UploadedVertexBytes += bytes;
+            break;
+        case CubismRlglCommandType_UploadIndices:
+            state.Statistics.UploadedIndexBytes += bytes;
+            break;
+        default:
+            state.Statistics.UploadedTextureBytes += bytes;
+            break;
+        }
+        Record(type, target, offset, bytes, false);
+    }
+
+    /**
+     * @brief   インデックスバッファを現在の頂点配列に結び付ける。rlglはGL_ELEMENT_ARRAY_BUFFERを頂点配列ごとに持つ
+     */
+    void BindElementBuffer(csmInt64 id)
+    {
+        State& state = GetState();
+        if (state.VertexArray == UnknownState)
+        {
+            return;
+        }
+        state.Objects[state.VertexArray].ElementBufferId = id;
+    }
+
+    /**
+     * @brief   テクスチャを結び付けたまま返さないrlglの関数の後に、現在のスロットのテクスチャを更新する
+     */
+    void BindTextureToActiveSlot(csmInt64 id)
+    {
+        State& state = GetState();
+        if (state.ActiveTextureSlot >= 0 && state.ActiveTextureSlot < MaxTextureSlots)
+        {
+            state.Textures[state.ActiveTextureSlot] = id;
+        }
+    }
+
+    csmInt32 GetPixelBytes(int format)
+    {
+        switch (format)
+        {
+        case RL_PIXELFORMAT_UNCOMPRESSED_GRAYSCALE:
+            return 1;
+        case RL_PIXELFORMAT_UNCOMPRESSED_R32G32B32A32:
+            return 16;
+        default:
+            return 4;
+        }
+    }
+
+    csmUint32 GetUniformBytes(int uniformType)
+    {
+        switch (uniformType)
+        {
+        case RL_SHADER_UNIFORM_VEC2:
+            return sizeof(csmFloat32) * 2;
+        case RL_SHADER_UNIFORM_VEC3:
+            return sizeof(csmFloat32) * 3;
+        case RL_SHADER_UNIFORM_VEC4:
+            return sizeof(csmFloat32) * 4;
+        default:
+            return sizeof(csmFloat32);
+        }
+    }
+
+    void SetUniform(int location, const void* value, csmUint32 bytes)
+    {
+        State& state = GetState();
+        Object* program = FindObject(state.Program, ObjectType_Program);
+        if (location < 0 || program == NULL)
+        {
+            // ロケーションが-1ならGLは何もせず、プログラムが無ければエラーになる
+            if (location >= 0)
+            {
+                state.Statistics.InvalidCalls++;
+            }
+            return;
+        }
+
+        if (program->Uniforms.size() <= static_cast<size_t>(location))
+        {
+            Uniform empty;
+            empty.IsValid = false;
+            empty.Bytes = 0;
+            program->Uniforms.resize(location + 1, empty);
+        }
+
+        Uniform& uniform = program->Uniforms[location];
+        const csmBool isRedundant = uniform.IsValid && uniform.Bytes == bytes && memcmp(uniform.Value, value, bytes) == 0;
+        memcpy(uniform.Value, value, bytes);
+        uniform.Bytes = bytes;
+        uniform.IsValid = true;
+        CountState(CubismRlglCommandType_SetUniform, location, static_cast<csmInt32>(state.Program), isRedundant);
+    }
+
+    void Draw(CubismRlglCommandType type, int offset, int count, int instances)
+    {
+        State& state = GetState();
+        state.Statistics.DrawCalls++;
+        state.Statistics.DrawnIndices += count;
+        if (type == CubismRlglCommandType_DrawInstanced)
+        {
+            state.Statistics.InstancedDrawCalls++;
+            state.Statistics.DrawnInstances += instances;
+        }
+
+        // プログラム・頂点配列・インデックスバッファが揃っていない描画と、インデックスバッファの外を読む描画
+        const Object* vertexArray = (state.VertexArray == UnknownState) ? NULL : &state.Objects[state.VertexArray];
+        const Object* elements = (vertexArray == NULL) ? NULL : FindObject(vertexArray->ElementBufferId, ObjectType_ElementBuffer);
+        if (FindObject(state.Program, ObjectType_Program) == NULL || state.VertexArray <= 0 || elements == NULL
+            || offset < 0 || static_cast<csmInt64>(offset + count) * sizeof(csmUint16) > static_cast<csmUint64>(elements->Size))
+        {
+            state.Statistics.InvalidCalls++;
+        }
+
+        Record(type, static_cast<csmUint32>(state.VertexArray), offset, count, false);
+    }
+
+    void SetBlendMode(int mode, const csmInt32* factors)
+    {
+        State& state = GetState();
+        const csmBool isCustom = (mode == RL_BLEND_CUSTOM || mode == RL_BLEND_CUSTOM_SEPARATE);
+        const csmBool isRedundant = state.BlendMode == mode
+            && (!isCustom || memcmp(state.BlendFactors, factors, sizeof(state.BlendFactors)) == 0);
+        state.BlendMode = mode;
+        memcpy(state.BlendFactors, factors, sizeof(state.BlendFactors));
+        CountState(CubismRlglCommandType_SetBlend, mode, 0, isRedundant);
+    }
+
+    void FlushImmediate()
+    {
+        State& state = GetState();
+        if (state.ImmediateVertices == 0)
+        {
+            return;
+        }
+
+        // raylibのバッチは自分のプログラムと頂点配列で描き、終わると外す
+        state.Statistics.DrawCalls++;
+        state.Statistics.DrawnIndices += state.ImmediateVertices;
+        Record(CubismRlglCommandType_Draw, 0, 0, state.ImmediateVertices, false);
+        state.ImmediateVertices = 0;
+        state.Program = 0;
+        state.VertexArray = 0;
+        BindTextureToActiveSlot(0);
+    }
+
+    // 以下はGetGLProcAddressで渡す、プログラムバイナリの関数
+    const unsigned char* GetString(unsigned int name)
+    {
+        switch (name)
+        {
+        case GL_VENDOR:
+            return reinterpret_cast<const unsigned char*>("Live2D");
+        case GL_RENDERER:
+            return reinterpret_cast<const unsigned char*>("CubismRlglRecorder");
+        case GL_VERSION:
+            return reinterpret_cast<const unsigned char*>("OpenGL ES 2.0 Recording");
+        default:
+            return NULL;
+        }
+    }
+
+    void GetIntegerv(unsigned int pname, int* data)
+    {
+        if (pname == GL_NUM_PROGRAM_BINARY_FORMATS)
+        {
+            *data = 1;
+        }
+    }
+
+    unsigned int CreateProgram()
+    {
+        return CreateObject(ObjectType_Program, 0);
+    }
+
+    void GetProgramiv(unsigned int program, unsigned int pname, int* params)
+    {
+        const Object* object = FindObject(program, ObjectType_Program);
+        if (object == NULL)
+        {
+            GetState().Statistics.InvalidCalls++;
+            return;
+        }
+
+        if (pname == GL_LINK_STATUS)
+        {
+            *params = object->IsLinked ? 1 : 0;
+        }
+        else if (pname == GL_PROGRAM_BINARY_LENGTH)
+        {
+            *params = object->IsLinked ? static_cast<int>(sizeof(ProgramBinaryTag)) : 0;
+        }
+    }
+
+    void GetProgramBinary(unsigned int program, int bufSize, int* length, unsigned int* binaryFormat, void* binary)
+    {
+        const Object* object = FindObject(program, ObjectType_Program);
+        if (object == NULL || !object->IsLinked || bufSize < static_cast<int>(sizeof(ProgramBinaryTag)))
+        {
+            GetState().Statistics.InvalidCalls++;
+            *length = 0;
+            return;
+        }
+
+        memcpy(binary, ProgramBinaryTag, sizeof(ProgramBinaryTag));
+        *length = static_cast<int>(sizeof(ProgramBinaryTag));
+        *binaryFormat = GetState().ProgramBinaryFormat;
+    }
+
+    void ProgramBinary(unsigned int program, unsigned int binaryFormat, const void* binary, int length)
+    {
+        Object* object = FindObject(program, ObjectType_Program);
+        if (object == NULL)
+        {
+            GetState().Statistics.InvalidCalls++;
+            return;
+        }
+
+        // GLと同じく、受け付けないバイナリはエラーにせずリンクの失敗として返す
+        object->IsLinked = binaryFormat == GetState().ProgramBinaryFormat
+            && length == static_cast<int>(sizeof(ProgramBinaryTag))
+            && memcmp(binary, ProgramBinaryTag, sizeof(ProgramBinaryTag)) == 0;
+    }
+}
+
+//------------ LIVE2D NAMESPACE ------------
+namespace Live2D { namespace Cubism { namespace Framework { namespace Rendering {
+
+void CubismRlglRecorder::ResetStatistics()
+{
+    State& state = GetState();
+    memset(&state.Statistics, 0, sizeof(state.Statistics));
+    if (state.Commands != NULL)
+    {
+        state.Commands->Clear();
+    }
+}
+
+void CubismRlglRecorder::InvalidateState()
+{
+    // 他の描画はバッファを作り直してIDを再利用することがあるので、頂点配列に結び付いたバッファも不明にする
+    State& state = GetState();
+    for (size_t i = 0; i < state.Objects.size(); i++)
+    {
+        if (state.Objects[i].Type != ObjectType_VertexArray && i != 0)
+        {
+            continue;
+        }
+        state.Objects[i].ElementBufferId = UnknownState;
+        for (csmInt32 j = 0; j < MaxAttributes; j++)
+        {
+            state.Objects[i].Attributes[j].BufferId = UnknownState;
+        }
+    }
+
+    state.Program = UnknownState;
+    state.VertexArray = UnknownState;
+    state.ArrayBuffer = UnknownState;
+    state.ActiveTextureSlot = UnknownState;
+    for (csmInt32 i = 0; i < MaxTextureSlots; i++)
+    {
+        state.Textures[i] = UnknownState;
+    }
+    state.Framebuffer = UnknownState;
+    state.Culling = UnknownState;
+    state.BlendMode = UnknownState;
+}
+
+const CubismRlglRecorder::Statistics& CubismRlglRecorder::GetStatistics()
+{
+    return GetState().Statistics;
+}
+
+void CubismRlglRecorder::SetCommandRecording(csmBool enabled)
+{
+    State& state = GetState();
+    if (enabled && state.Commands == NULL)
+    {
+        state.Commands = CSM_NEW csmVector<CubismRlglCommand>();
+    }
+    else if (!enabled && state.Commands != NULL)
+    {
+        CSM_DELETE(state.Commands);
+        state.Commands = NULL;
+    }
+}
+
+const csmVector<CubismRlglCommand>& CubismRlglRecorder::GetCommands()
+{
+    static const csmVector<CubismRlglCommand> empty;
+    const State& state = GetState();
+    return (state.Commands != NULL) ? *state.Commands : empty;
+}
+
+csmUint32 CubismRlglRecorder::GetLiveObjectCount()
+{
+    return GetState().LiveObjects;
+}
+
+void* CubismRlglRecorder::GetGLProcAddress(const csmChar* name)
+{
+    if (strcmp(name, "glGetString") == 0)
+    {
+        return reinterpret_cast<void*>(&GetString);
+    }
+    if (strcmp(name, "glGetIntegerv") == 0)
+    {
+        return reinterpret_cast<void*>(&GetIntegerv);
+    }
+    if (strcmp(name, "glCreateProgram") == 0)
+    {
+        return reinterpret_cast<void*>(&CreateProgram);
+    }
+    if (strcmp(name, "glGetProgramiv") == 0)
+    {
+        return reinterpret_cast<void*>(&GetProgramiv);
+    }
+    if (strcmp(name, "glGetProgramBinary") == 0)
+    {
+        return reinterpret_cast<void*>(&GetProgramBinary);
+    }
+    if (strcmp(name, "glProgramBinary") == 0)
+    {
+        return reinterpret_cast<void*>(&ProgramBinary);
+    }
+    return NULL;
+}
+
+void CubismRlglRecorder::SetProgramBinaryFormat(unsigned int format)
+{
+    GetState().ProgramBinaryFormat = format;
+}
+
+const csmChar* CubismRlglRecorder::GetCommandName(CubismRlglCommandType type)
+{
+    switch (type)
+    {
+    case CubismRlglCommandType_UseProgram:
+        return "UseProgram";
+    case CubismRlglCommandType_BindVertexArray:
+        return "BindVertexArray";
+    case CubismRlglCommandType_SetVertexAttribute:
+        return "SetVertexAttribute";
+    case CubismRlglCommandType_BindElementBuffer:
+        return "BindElementBuffer";
+    case CubismRlglCommandType_BindTexture:
+        return "BindTexture";
+    case CubismRlglCommandType_SetBlend:
+        return "SetBlend";
+    case CubismRlglCommandType_SetCulling:
+        return "SetCulling";
+    case CubismRlglCommandType_SetUniform:
+        return "SetUniform";
+    case CubismRlglCommandType_UploadVertices:
+        return "UploadVertices";
+    case CubismRlglCommandType_UploadIndices:
+        return "UploadIndices";
+    case CubismRlglCommandType_UploadTexture:
+        return "UploadTexture";
+    case CubismRlglCommandType_BindFramebuffer:
+        return "BindFramebuffer";
+    case CubismRlglCommandType_Viewport:
+        return "Viewport";
+    case CubismRlglCommandType_Clear:
+        return "Clear";
+    case CubismRlglCommandType_Draw:
+        return "Draw";
+    case CubismRlglCommandType_DrawInstanced:
+        return "DrawInstanced";
+    default:
+        return "Unknown";
+    }
+}
+
+}}}}
+//------------ LIVE2D NAMESPACE ------------
+
+//------------ rlgl ------------
+extern "C" {
+
+unsigned int rlLoadShaderCode(const char* vsCode, const char* fsCode)
+{
+    if (vsCode == NULL || fsCode == NULL)
+    {
+        return 0;
+    }
+    const unsigned int id = CreateObject(ObjectType_Program, 0);
+    GetState().Objects[id].IsLinked = true;
+    return id;
+}
+
+void rlUnloadShaderProgram(unsigned int id)
+{
+    State& state = GetState();
+    if (state.Program == id)
+    {
+        state.Program = 0;
+    }
+    DeleteObject(id, ObjectType_Program);
+}
+
+int rlGetLocationAttrib(unsigned int /*shaderId*/, const char* attribName)
+{
+    // 行列の属性は4つのロケーションを続けて使うので、名前ごとに固定の位置を返す
+    static const char* const names[] = { "a_position", "a_texCoord", "a_instanceOpacity", "a_instanceMatrix" };
+    for (csmInt32 i = 0; i < 4; i++)
+    {
+        if (strcmp(names[i], attribName) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int rlGetLocationUniform(unsigned int /*shaderId*/, const char* uniformName)
+{
+    std::vector<std::string>& names = GetState().UniformNames;
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        if (names[i] == uniformName)
+        {
+            return static_cast<int>(i);
+        }
+    }
+    names.push_back(uniformName);
+    return static_cast<int>(names.size() - 1);
+}
+
+void rlEnableShader(unsigned int id)
+{
+    State& state = GetState();
+    const csmBool isRedundant = state.Program == id;
+    state.Program = id;
+    CountState(CubismRlglCommandType_UseProgram, id, 0, isRedundant);
+}
+
+void rlDisableShader(void)
+{
+    GetState().Program = 0;
+}
+
+void rlSetUniform(int locIndex, const void* value, int uniformType, int count)
+{
+    SetUniform(locIndex, value, GetUniformBytes(uniformType) * count);
+}
+
+void rlSetUniformMatrixDirectly(int locIndex, const float* mat)
+{
+    SetUniform(locIndex, mat, sizeof(csmFloat32) * 16);
+}
+
+unsigned int rlLoadVertexArray(void)
+{
+    return CreateObject(ObjectType_VertexArray, 0);
+}
+
+bool rlEnableVertexArray(unsigned int vaoId)
+{
+    State& state = GetState();
+    const csmBool isRedundant = state.VertexArray == vaoId;
+    state.VertexArray = vaoId;
+    CountState(CubismRlglCommandType_BindVertexArray, vaoId, 0, isRedundant);
+    return true;
+}
+
+void rlDisableVertexArray(void)
+{
+    GetState().VertexArray = 0;
+}
+
+void rlUnloadVertexArray(unsigned int vaoId)
+{
+    GetState().VertexArray = 0;
+    DeleteObject(vaoId, ObjectType_VertexArray);
+}
+
+unsigned int rlLoadVertexBuffer(const void* buffer, int size, bool /*dynamic*/)
+{
+    const unsigned int id = CreateObject(ObjectType_VertexBuffer, size);
+    GetState().ArrayBuffer = id;
+    GetState().Statistics.BufferAllocations++;
+    if (buffer != NULL)
+    {
+        CountUpload(CubismRlglCommandType_UploadVertices, id, 0, size);
+    }
+    return id;
+}
+
+unsigned int rlLoadVertexBufferElement(const void* buffer, int size, bool /*dynamic*/)
+{
+    const unsigned int id = CreateObject(ObjectType_ElementBuffer, size);
+    BindElementBuffer(id);
+    GetState().Statistics.BufferAllocations++;
+    if (buffer != NULL)
+    {
+        CountUpload(CubismRlglCommandType_UploadIndices, id, 0, size);
+    }
+    return id;
+}
+
+void rlUpdateVertexBuffer(unsigned int bufferId, const void* /*data*/, int dataSize, int offset)
+{
+    const Object* buffer = FindObject(bufferId, ObjectType_VertexBuffer);
+    GetState().ArrayBuffer = bufferId;
+    if (buffer == NULL || offset < 0 || offset + dataSize > buffer->Size)
+    {
+        GetState().Statistics.InvalidCalls++;
+    }
+    CountUpload(CubismRlglCommandType_UploadVertices, bufferId, offset, dataSize);
+}
+
+void rlUpdateVertexBufferElements(unsigned int id, const void* /*data*/, int dataSize, int offset)
+{
+    // rlglはGL_ELEMENT_ARRAY_BUFFERに結び付けて転送するので、有効な頂点配列の設定も変わる
+    const Object* buffer = FindObject(id, ObjectType_ElementBuffer);
+    BindElementBuffer(id);
+    if (buffer == NULL || offset < 0 || offset + dataSize > buffer->Size)
+    {
+        GetState().Statistics.InvalidCalls++;
+    }
+    CountUpload(CubismRlglCommandType_UploadIndices, id, offset, dataSize);
+}
+
+void rlEnableVertexBuffer(unsigned int id)
+{
+    GetState().ArrayBuffer = id;
+}
+
+void rlDisableVertexBuffer(void)
+{
+    GetState().ArrayBuffer = 0;
+}
+
+void rlEnableVertexBufferElement(unsigned int id)
+{
+    State& state = GetState();
+    const csmBool isRedundant = state.VertexArray != UnknownState && state.Objects[state.VertexArray].ElementBufferId == id;
+    BindElementBuffer(id);
+    CountState(CubismRlglCommandType_BindElementBuffer, id, 0, isRedundant);
+}
+
+void rlDisableVertexBufferElement(void)
+{
+    BindElementBuffer(0);
+}
+
+void rlUnloadVertexBuffer(unsigned int vboId)
+{
+    State& state = GetState();
+    if (state.ArrayBuffer == vboId)
+    {
+        state.ArrayBuffer = 0;
+    }
+    DeleteObject(vboId, (FindObject(vboId, ObjectType_ElementBuffer) != NULL) ? ObjectType_ElementBuffer : ObjectType_VertexBuffer);
+}
+
+void rlSetVertexAttribute(unsigned int index, int compSize, int type, bool normalized, int stride, const void* pointer)
+{
+    State& state = GetState();
+    if (state.VertexArray == UnknownState || index >= static_cast<unsigned int>(MaxAttributes))
+    {
+        return;
+    }
+
+    Attribute& attribute = state.Objects[state.VertexArray].Attributes[index];
+    const csmSizeType offset = reinterpret_cast<csmSizeType>(pointer);
+    const csmBool isRedundant = attribute.BufferId != UnknownState && attribute.BufferId == state.ArrayBuffer
+        && attribute.Offset == offset && attribute.Size == compSize && attribute.Type == type
+        && attribute.Stride == stride && attribute.Normalized == normalized;
+    attribute.BufferId = state.ArrayBuffer;
+    attribute.Offset = offset;
+    attribute.Size = compSize;
+    attribute.Type = type;
+    attribute.Stride = stride;
+    attribute.Normalized = normalized;
+    CountState(CubismRlglCommandType_SetVertexAttribute, index, static_cast<csmInt32>(offset), isRedundant);
+}
+
+void rlSetVertexAttributeDivisor(unsigned int /*index*/, int /*divisor*/)
+{
+}
+
+void rlEnableVertexAttribute(unsigned int /*index*/)
+{
+}
+
+void rlDisableVertexAttribute(unsigned int /*index*/)
+{
+}
+
+void rlDrawVertexArrayElements(int offset, int count, const void* /*buffer*/)
+{
+    Draw(CubismRlglCommandType_Draw, offset, count, 1);
+}
+
+void rlDrawVertexArrayElementsInstanced(int offset, int count, const void* /*buffer*/, int instances)
+{
+    Draw(CubismRlglCommandType_DrawInstanced, offset, count, instances);
+}
+
+unsigned int rlLoadTexture(const void* data, int width, int height, int format, int /*mipmapCount*/)
+{
+    const unsigned int id = CreateObject(ObjectType_Texture, width * height);
+    if (data != NULL)
+    {
+        CountUpload(CubismRlglCommandType_UploadTexture, id, 0, width * height * GetPixelBytes(format));
+    }
+
+    // rlLoadTextureは結び付けたテクスチャを外して返る
+    BindTextureToActiveSlot(0);
+    return id;
+}
+
+void rlUpdateTexture(unsigned int id, int offsetX, int offsetY, int width, int height, int format, const void* /*data*/)
+{
+    BindTextureToActiveSlot(id);
+    CountUpload(CubismRlglCommandType_UploadTexture, id, offsetY * width + offsetX, width * height * GetPixelBytes(format));
+}
+
+void rlUnloadTexture(unsigned int id)
+{
+    DeleteObject(id, ObjectType_Texture);
+}
+
+void rlTextureParameters(unsigned int /*id*/, int /*param*/, int /*value*/)
+{
+    BindTextureToActiveSlot(0);
+}
+
+void rlActiveTextureSlot(int slot)
+{
+    GetState().ActiveTextureSlot = slot;
+}
+
+void rlEnableTexture(unsigned int id)
+{
+    State& state = GetState();
+    const csmBool isRedundant = state.ActiveTextureSlot >= 0 && state.ActiveTextureSlot < MaxTextureSlots
+        && state.Textures[state.ActiveTextureSlot] == id;
+    BindTextureToActiveSlot(id);
+    CountState(CubismRlglCommandType_BindTexture, id, state.ActiveTextureSlot, isRedundant);
+}
+
+void rlDisableTexture(void)
+{
+    BindTextureToActiveSlot(0);
+}
+
+unsigned int rlLoadFramebuffer(void)
+{
+    GetState().Framebuffer = 0;
+    return CreateObject(ObjectType_Framebuffer, 0);
+}
+
+void rlFramebufferAttach(unsigned int /*fboId*/, unsigned int /*texId*/, int /*attachType*/, int /*texType*/, int /*mipLevel*/)
+{
+    GetState().Framebuffer = 0;
+}
+
+void rlEnableFramebuffer(unsigned int id)
+{
+    State& state = GetState();
+    if (state.Framebuffer != id)
+    {
+        state.Statistics.FramebufferBinds++;
+    }
+    state.Framebuffer = id;
+    Record(CubismRlglCommandType_BindFramebuffer, id, 0, 0, false);
+}
+
+void rlDisableFramebuffer(void)
+{
+    rlEnableFramebuffer(0);
+}
+
+void rlUnloadFramebuffer(unsigned int id)
+{
+    DeleteObject(id, ObjectType_Framebuffer);
+}
+
+unsigned char rlReadScreenPixelAlpha(int /*x*/, int /*y*/, int /*h*/)
+{
+    return 0;
+}
+
+void rlSetBlendMode(int mode)
+{
+    FlushImmediate();
+    SetBlendMode(mode, GetState().PendingBlendFactors);
+}
+
+void rlSetBlendFactorsSeparate(int glSrcRGB, int glDstRGB, int glSrcAlpha, int glDstAlpha, int /*glEqRGB*/, int /*glEqAlpha*/)
+{
+    csmInt32* factors = GetState().PendingBlendFactors;
+    factors[0] = glSrcRGB;
+    factors[1] = glDstRGB;
+    factors[2] = glSrcAlpha;
+    factors[3] = glDstAlpha;
+}
+
+void rlEnableColorBlend(void)
+{
+}
+
+void rlEnableBackfaceCulling(void)
+{
+    State& state = GetState();
+    const csmBool isRedundant = state.Culling == 1;
+    state.Culling = 1;
+    CountState(CubismRlglCommandType_SetCulling, 1, 0, isRedundant);
+}
+
+void rlDisableBackfaceCulling(void)
+{
+    State& state = GetState();
+    const csmBool isRedundant = state.Culling == 0;
+    state.Culling = 0;
+    CountState(CubismRlglCommandType_SetCulling, 0, 0, isRedundant);
+}
+
+void rlDisableDepthTest(void)
+{
+}
+
+void rlDisableScissorTest(void)
+{
+}
+
+void rlViewport(int x, int /*y*/, int width, int /*height*/)
+{
+    Record(CubismRlglCommandType_Viewport, 0, x, width, false);
+}
+
+void rlClearColor(unsigned char /*r*/, unsigned char /*g*/, unsigned char /*b*/, unsigned char /*a*/)
+{
+}
+
+void rlClearScreenBuffers(void)
+{
+    GetState().Statistics.Clears++;
+    Record(CubismRlglCommandType_Clear, static_cast<csmUint32>(GetState().Framebuffer), 0, 0, false);
+}
+
+void rlBegin(int /*mode*/)
+{
+}
+
+void rlEnd(void)
+{
+}
+
+void rlSetTexture(unsigned int /*id*/)
+{
+}
+
+void rlColor4ub(unsigned char /*r*/, unsigned char /*g*/, unsigned char /*b*/, unsigned char /*a*/)
+{
+}
+
+void rlTexCoord2f(float /*x*/, float /*y*/)
+{
+}
+
+void rlVertex2f(float /*x*/, float /*y*/)
+{
+    GetState().ImmediateVertices++;
+}
+
+void rlDrawRenderBatchActive(void)
+{
+    FlushImmediate();
+}
+
+}
+//------------ rlgl ------------
@@ -0,0 +1,151 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+#pragma once
+
+#include "CubismFramework.hpp"
+#include "Type/csmVector.hpp"
+
+//------------ LIVE2D NAMESPACE ------------
+namespace Live2D { namespace Cubism { namespace Framework { namespace Rendering {
+
+/**
+ * @brief   記録用のrlglが記録する呼び出しの種類
+ */
+enum CubismRlglCommandType
+{
+    CubismRlglCommandType_UseProgram,           ///< rlEnableShader
+    CubismRlglCommandType_BindVertexArray,      ///< rlEnableVertexArray
+    CubismRlglCommandType_SetVertexAttribute,   ///< rlSetVertexAttribute
+    CubismRlglCommandType_BindElementBuffer,    ///< rlEnableVertexBufferElement
+    CubismRlglCommandType_BindTexture,          ///< rlEnableTexture
+    CubismRlglCommandType_SetBlend,             ///< rlSetBlendMode
+    CubismRlglCommandType_SetCulling,           ///< rlEnableBackfaceCulling / rlDisableBackfaceCulling
+    CubismRlglCommandType_SetUniform,           ///< rlSetUniform / rlSetUniformMatrixDirectly
+    CubismRlglCommandType_UploadVertices,       ///< rlLoadVertexBuffer / rlUpdateVertexBuffer
+    CubismRlglCommandType_UploadIndices,        ///< rlLoadVertexBufferElement / rlUpdateVertexBufferElements
+    CubismRlglCommandType_UploadTexture,        ///< rlLoadTexture / rlUpdateTexture
+    CubismRlglCommandType_BindFramebuffer,      ///< rlEnableFramebuffer / rlDisableFramebuffer
+    CubismRlglCommandType_Viewport,             ///< rlViewport
+    CubismRlglCommandType_Clear,                ///< rlClearScreenBuffers
+    CubismRlglCommandType_Draw,                 ///< rlDrawVertexArrayElements
+    CubismRlglCommandType_DrawInstanced,        ///< rlDrawVertexArrayElementsInstanced
+};
+
+/**
+ * @brief   記録用のrlglが記録した1つの呼び出し
+ */
+struct CubismRlglCommand
+{
+    CubismRlglCommandType Type;     ///< 呼び出しの種類
+    csmUint32 Target;               ///< 対象のID（プログラム・頂点配列・バッファ・テクスチャ・フレームバッファ）。ユニフォームと属性ではロケーション
+    csmInt32 Offset;                ///< 転送先のバイト位置、描画の先頭インデックス、テクスチャのスロット
+    csmInt32 Count;                 ///< 転送したバイト数、描画したインデックス数
+    csmBool IsRedundant;            ///< GLのステートが変わらない呼び出しだったか
+};
+
+/**
+ * @brief   rlglの呼び出しを、GPUの代わりにGLのステートに当てはめて記録するクラス<br>
+ *           FRAMEWORK_SOURCEにRecordingを指定すると、OpenGLES2のレンダラがそのままこのrlglの上で動く。
+ *           バッチ化・カリング・ストリームバッファ・マスクのアトラス・インスタンス描画を含めて、
+ *           実際に発行された呼び出しを数えるので、ウィンドウもGLのコンテキストも無い環境で描画量を検証できる。<br>
+ *           ステートを設定する呼び出しは、直前と同じ値なら冗長として数える。
+ */
+class CubismRlglRecorder
+{
+public:
+    /**
+     * @brief   記録した呼び出しの量
+     */
+    struct Statistics
+    {
+        csmUint32 DrawCalls;                ///< 描画命令の数（インスタンス描画を含む）
+        csmUint32 InstancedDrawCalls;       ///< インスタンス描画の命令の数
+        csmUint32 DrawnIndices;             ///< 描画したインデックスの数（インスタンス数は掛けない）
+        csmUint32 DrawnInstances;           ///< インスタンス描画で描いたインスタンスの数
+        csmUint32 InvalidCalls;             ///< GLならエラーか範囲外へのアクセスになる呼び出し（描画・転送・ユニフォームの設定）の数
+        csmUint32 UploadCalls;              ///< バッファとテクスチャへの転送の呼び出し回数
+        csmUint32 UploadedVertexBytes;      ///< 頂点バッファへ転送したバイト数
+        csmUint32 UploadedIndexBytes;       ///< インデックスバッファへ転送したバイト数
+        csmUint32 UploadedTextureBytes;     ///< テクスチャへ転送したバイト数
+        csmUint32 BufferAllocations;        ///< バッファを確保した回数
+        csmUint32 StateChanges;             ///< GLのステートを変えた呼び出しの数
+        csmUint32 RedundantStateChanges;    ///< 直前と同じ値を設定した呼び出しの数
+        csmUint32 FramebufferBinds;         ///< 描画先のフレームバッファを切り替えた回数
+        csmUint32 Clears;                   ///< 描画先をクリアした回数
+    };
+
+    /**
+     * @brief   統計と記録した呼び出しを空にする。GLのステートとオブジェクトはそのまま
+     */
+    static void ResetStatistics();
+
+    /**
+     * @brief   記録用のGLのステートを不明な状態にする。<br>
+     *           アプリケーションが他の描画でステートを変えた場合と同じになり、次の設定は冗長として数えない。
+     */
+    static void InvalidateState();
+
+    /**
+     * @brief   記録した呼び出しの量を取得する
+     *
+     * @return  ResetStatisticsからの統計
+     */
+    static const Statistics& GetStatistics();
+
+    /**
+     * @brief   呼び出しを1つずつ記録するかを設定する。既定では統計だけを取る
+     *
+     * @param[in]   enabled ->  trueなら記録する
+     */
+    static void SetCommandRecording(csmBool enabled);
+
+    /**
+     * @brief   記録した呼び出しを取得する
+     *
+     * @return  ResetStatisticsからの呼び出し
+     */
+    static const csmVector<CubismRlglCommand>& GetCommands();
+
+    /**
+     * @brief   解放されていないGLのオブジェクト（プログラム・頂点配列・バッファ・テクスチャ・フレームバッファ）の数を取得する
+     *
+     * @return  オブジェクトの数
+     */
+    static csmUint32 GetLiveObjectCount();
+
+    /**
+     * @brief   rlglに無いGLの関数のアドレスを取得する。CubismRenderer_OpenGLES2::SetGLProcAddressLoaderに渡す<br>
+     *           プログラムバイナリの保存・読み込みに使う関数だけを持つ。
+     *           glGetProgramBinaryは記録用の形式のバイナリを返し、glProgramBinaryは同じ形式のものだけをリンクする。
+     *
+     * @param[in]   name    ->  関数の名前
+     *
+     * @return  関数のアドレス。持っていない関数ならNULL
+     */
+    static void* GetGLProcAddress(const csmChar* name);
+
+    /**
+     * @brief   glProgramBinaryが受け付けるバイナリの形式を変える<br>
+     *           ドライバの更新で、以前に保存したバイナリを受け付けなくなった場合を再現する。
+     *
+     * @param[in]   format  ->  バイナリの形式
+     */
+    static void SetProgramBinaryFormat(unsigned int format);
+
+    /**
+     * @brief   呼び出しの種類の名前を取得する
+     *
+     * @param[in]   type    ->  呼び出しの種類
+     *
+     * @return  名前
+     */
+    static const csmChar* GetCommandName(CubismRlglCommandType type);
+};
+
+}}}}
+//------------ LIVE2D NAMESPACE ------------
@@ -0,0 +1,139 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+#pragma once
+
+/**
+ * @brief   GPUを使わない記録用のrlgl<br>
+ *           FRAMEWORK_SOURCEにRecordingを指定すると、raylibのrlgl.hの代わりにこのヘッダが読まれる。
+ *           宣言はraylibのrlgl.hのうち、OpenGLES2のレンダラとサンプルが使うものだけを同じシグネチャで持つ。
+ *           実装はCubismRlglRecorder.cppにあり、呼び出しをGLのステートに当てはめて記録する。
+ */
+
+#include <stdbool.h>
+
+#define RL_FLOAT                        0x1406
+#define RL_UNSIGNED_BYTE                0x1401
+
+#define RL_TEXTURE_MAG_FILTER           0x2800
+#define RL_TEXTURE_MIN_FILTER           0x2801
+#define RL_TEXTURE_FILTER_LINEAR        0x2601
+#define RL_TEXTURE_FILTER_ANISOTROPIC   0x3000
+
+#define RL_TRIANGLES                    0x0004
+#define RL_QUADS                        0x0007
+
+typedef enum {
+    RL_SHADER_UNIFORM_FLOAT = 0,
+    RL_SHADER_UNIFORM_VEC2,
+    RL_SHADER_UNIFORM_VEC3,
+    RL_SHADER_UNIFORM_VEC4,
+    RL_SHADER_UNIFORM_INT,
+} rlShaderUniformDataType;
+
+typedef enum {
+    RL_BLEND_ALPHA = 0,
+    RL_BLEND_ADDITIVE,
+    RL_BLEND_MULTIPLIED,
+    RL_BLEND_ADD_COLORS,
+    RL_BLEND_SUBTRACT_COLORS,
+    RL_BLEND_ALPHA_PREMULTIPLY,
+    RL_BLEND_CUSTOM,
+    RL_BLEND_CUSTOM_SEPARATE,
+} rlBlendMode;
+
+typedef enum {
+    RL_ATTACHMENT_COLOR_CHANNEL0 = 0,
+} rlFramebufferAttachType;
+
+typedef enum {
+    RL_ATTACHMENT_TEXTURE2D = 100,
+    RL_ATTACHMENT_RENDERBUFFER = 200,
+} rlFramebufferAttachTextureType;
+
+typedef enum {
+    RL_PIXELFORMAT_UNCOMPRESSED_GRAYSCALE = 1,
+    RL_PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 = 7,
+    RL_PIXELFORMAT_UNCOMPRESSED_R32G32B32A32 = 10,
+} rlPixelFormat;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// シェーダ
+unsigned int rlLoadShaderCode(const char* vsCode, const char* fsCode);
+void rlUnloadShaderProgram(unsigned int id);
+int rlGetLocationAttrib(unsigned int shaderId, const char* attribName);
+int rlGetLocationUniform(unsigned int shaderId, const char* uniformName);
+void rlEnableShader(unsigned int id);
+void rlDisableShader(void);
+void rlSetUniform(int locIndex, const void* value, int uniformType, int count);
+void rlSetUniformMatrixDirectly(int locIndex, const float* mat);
+
+// 頂点配列とバッファ
+unsigned int rlLoadVertexArray(void);
+bool rlEnableVertexArray(unsigned int vaoId);
+void rlDisableVertexArray(void);
+void rlUnloadVertexArray(unsigned int vaoId);
+unsigned int rlLoadVertexBuffer(const void* buffer, int size, bool dynamic);
+unsigned int rlLoadVertexBufferElement(const void* buffer, int size, bool dynamic);
+void rlUpdateVertexBuffer(unsigned int bufferId, const void* data, int dataSize, int offset);
+void rlUpdateVertexBufferElements(unsigned int id, const void* data, int dataSize, int offset);
+void rlEnableVertexBuffer(unsigned int id);
+void rlDisableVertexBuffer(void);
+void rlEnableVertexBufferElement(unsigned int id);
+void rlDisableVertexBufferElement(void);
+void rlUnloadVertexBuffer(unsigned int vboId);
+void rlSetVertexAttribute(unsigned int index, int compSize, int type, bool normalized, int stride, const void* pointer);
+void rlSetVertexAttributeDivisor(unsigned int index, int divisor);
+void rlEnableVertexAttribute(unsigned int index);
+void rlDisableVertexAttribute(unsigned int index);
+
+// 描画
+void rlDrawVertexArrayElements(int offset, int count, const void* buffer);
+void rlDrawVertexArrayElementsInstanced(int offset, int count, const void* buffer, int instances);
+
+// テクスチャとフレームバッファ
+unsigned int rlLoadTexture(const void* data, int width, int height, int format, int mipmapCount);
+void rlUpdateTexture(unsigned int id, int offsetX, int offsetY, int width, int height, int format, const void* data);
+void rlUnloadTexture(unsigned int id);
+void rlTextureParameters(unsigned int id, int param, int value);
+void rlActiveTextureSlot(int slot);
+void rlEnableTexture(unsigned int id);
+void rlDisableTexture(void);
+unsigned int rlLoadFramebuffer(void);
+void rlFramebufferAttach(unsigned int fboId, unsigned int texId, int attachType, int texType, int mipLevel);
+void rlEnableFramebuffer(unsigned int id);
+void rlDisableFramebuffer(void);
+void rlUnloadFramebuffer(unsigned int id);
+unsigned char rlReadScreenPixelAlpha(int x, int y, int h);
+
+// ステート
+void rlSetBlendMode(int mode);
+void rlSetBlendFactorsSeparate(int glSrcRGB, int glDstRGB, int glSrcAlpha, int glDstAlpha, int glEqRGB, int glEqAlpha);
+void rlEnableColorBlend(void);
+void rlEnableBackfaceCulling(void);
+void rlDisableBackfaceCulling(void);
+void rlDisableDepthTest(void);
+void rlDisableScissorTest(void);
+void rlViewport(int x, int y, int width, int height);
+void rlClearColor(unsigned char r, unsigned char g, unsigned char b, unsigned char a);
+void rlClearScreenBuffers(void);
+
+// 即時描画（サンプルがオフスクリーンの結果を貼るのに使う）
+void rlBegin(int mode);
+void rlEnd(void);
+void rlSetTexture(unsigned int id);
+void rlColor4ub(unsigned char r, unsigned char g, unsigned char b, unsigned char a);
+void rlTexCoord2f(float x, float y);
+void rlVertex2f(float x, float y);
+void rlDrawRenderBatchActive(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -9,14 +9,290 @@
 
 using namespace Csm;
 
+namespace {
+const csmSizeType HeaderSize = 16;              ///< 領域の前に置くヘッダの大きさ。返すアドレスを16バイト境界に揃える
+const csmSizeType MinClassSize = 16;            ///< 最小のプールのサイズ
+const csmSizeType PageSize = 64 * 1024;         ///< プールのページの大きさ
+const csmSizeType ChunkSize = 256 * 1024;       ///< アリーナのチャンクの大きさ
+const csmUint32 KindLarge = 0xFFFFFFFF;         ///< ヒープから直接確保した領域
+
+/**
+ * @brief   確保した領域の前に置くヘッダ
+ */
+struct BlockHeader
+{
+    void* Owner;            ///< アリーナから確保した場合はアリーナ。共有のプールとヒープならNULL
+    csmUint32 Kind;         ///< プールのサイズの番号かKindLarge
+    csmUint32 Size;         ///< 要求された大きさ
+};
+
+csmSizeType ClassSize(csmUint32 sizeClass)
+{
+    return MinClassSize << sizeClass;
+}
+
+csmUint32 GetSizeClass(csmSizeType size)
+{
+    csmUint32 sizeClass = 0;
+    while (ClassSize(sizeClass) < size)
+    {
+        sizeClass++;
+    }
+    return sizeClass;
+}
+
+void* PopFreeBlock(void*& freeList)
+{
+    void* block = freeList;
+    if (block != NULL)
+    {
+        freeList = *static_cast<void**>(block);
+    }
+    return block;
+}
+
+BlockHeader* GetHeader(void* memory)
+{
+    return reinterpret_cast<BlockHeader*>(static_cast<csmByte*>(memory) - HeaderSize);
+}
+}
+
+/**
+ * @brief   アリーナのチャンク。領域はこの構造体の直後から並ぶ
+ */
+struct ArenaChunk
+{
+    ArenaChunk* Next;       ///< 前に作成したチャンク
+    csmSizeType Capacity;   ///< 領域の大きさ
+    csmSizeType Used;       ///< 使用済みの大きさ
+    csmSizeType Padding;    ///< 領域を16バイト境界に揃える
+
+    csmByte* GetData()
+    {
+        return reinterpret_cast<csmByte*>(this + 1);
+    }
+};
+
+struct LAppAllocator::Arena
+{
+    ArenaChunk* Chunks;                 ///< 確保に使うチャンク。先頭が最新
+    csmSizeType Reserved;               ///< チャンクの合計の大きさ
+    void* FreeLists[SizeClassCount];    ///< サイズごとの解放済みの領域の連結リスト。読み込み中の一時的な領域を使い回す
+};
+
+LAppAllocator::ArenaScope::ArenaScope(LAppAllocator& allocator, Arena* arena)
+    : _allocator(allocator)
+    , _previous(NULL)
+{
+    if (arena != NULL)
+    {
+        _previous = _allocator.SetArena(arena);
+    }
+    else
+    {
+        _previous = _allocator._arena;
+    }
+}
+
+LAppAllocator::ArenaScope::~ArenaScope()
+{
+    _allocator.SetArena(_previous);
+}
+
+LAppAllocator::LAppAllocator()
+    : _pages(NULL)
+    , _arena(NULL)
+    , _sharedDepth(0)
+{
+    for (csmUint32 i = 0; i < SizeClassCount; ++i)
+    {
+        _freeLists[i] = NULL;
+    }
+    _statistics.PoolReservedBytes = 0;
+    _statistics.PoolUsedBytes = 0;
+    _statistics.LargeUsedBytes = 0;
+    _statistics.ArenaReservedBytes = 0;
+    _statistics.ArenaCount = 0;
+}
+
+LAppAllocator::~LAppAllocator()
+{
+    while (_pages != NULL)
+    {
+        void* next = *static_cast<void**>(_pages);
+        free(_pages);
+        _pages = next;
+    }
+}
+
+LAppAllocator::Arena* LAppAllocator::CreateArena()
+{
+    Arena* arena = static_cast<Arena*>(malloc(sizeof(Arena)));
+    arena->Chunks = NULL;
+    arena->Reserved = 0;
+    for (csmUint32 i = 0; i < SizeClassCount; ++i)
+    {
+        arena->FreeLists[i] = NULL;
+    }
+    _statistics.ArenaCount++;
+    return arena;
+}
+
+void LAppAllocator::ReleaseArena(Arena* arena)
+{
+    if (arena == NULL)
+    {
+        return;
+    }
+
+    if (_arena == arena)
+    {
+        _arena = NULL;
+    }
+
+    // 個々の領域はたどらず、チャンクごとに解放する
+    while (arena->Chunks != NULL)
+    {
+        ArenaChunk* next = arena->Chunks->Next;
+        free(arena->Chunks);
+        arena->Chunks = next;
+    }
+    _statistics.ArenaReservedBytes -= arena->Reserved;
+    _statistics.ArenaCount--;
+    free(arena);
+}
+
+LAppAllocator::Arena* LAppAllocator::SetArena(Arena* arena)
+{
+    Arena* previous = _arena;
+    _arena = arena;
+    return previous;
+}
+
+LAppAllocator::Statistics LAppAllocator::GetStatistics() const
+{
+    return _statistics;
+}
+
 void* LAppAllocator::Allocate(const csmSizeType  size)
 {
-    return malloc(size);
+    BlockHeader* header;
+
+    if (size <= ClassSize(SizeClassCount - 1))
+    {
+        // アリーナを設定している間は、そのアリーナの空きリストとチャンクから確保する
+        const csmUint32 sizeClass = GetSizeClass(size);
+        Arena* arena = (_sharedDepth == 0) ? _arena : NULL;
+        void* block = (arena != NULL) ? AllocateFromArena(arena, sizeClass) : AllocateFromPool(sizeClass);
+        if (block == NULL)
+        {
+            return NULL;
+        }
+
+        header = GetHeader(block);
+        header->Owner = arena;
+        header->Kind = sizeClass;
+    }
+    else
+    {
+        // 大きな領域はアリーナを設定していてもヒープから確保し、解放されたらすぐに返す。
+        // 読み込み中のファイルのバッファなどの一時的な領域がアリーナに残らない
+        header = static_cast<BlockHeader*>(malloc(HeaderSize + size));
+        if (header == NULL)
+        {
+            return NULL;
+        }
+        _statistics.LargeUsedBytes += size;
+        header->Owner = NULL;
+        header->Kind = KindLarge;
+    }
+
+    header->Size = static_cast<csmUint32>(size);
+    return reinterpret_cast<csmByte*>(header) + HeaderSize;
 }
 
 void LAppAllocator::Deallocate(void* memory)
 {
-    free(memory);
+    BlockHeader* header = GetHeader(memory);
+
+    if (header->Kind == KindLarge)
+    {
+        _statistics.LargeUsedBytes -= header->Size;
+        free(header);
+        return;
+    }
+
+    // 確保したアリーナかプールの空きリストに戻し、同じサイズの確保に使い回す
+    void** freeList;
+    if (header->Owner != NULL)
+    {
+        freeList = &static_cast<Arena*>(header->Owner)->FreeLists[header->Kind];
+    }
+    else
+    {
+        freeList = &_freeLists[header->Kind];
+        _statistics.PoolUsedBytes -= ClassSize(header->Kind);
+    }
+    *static_cast<void**>(memory) = *freeList;
+    *freeList = memory;
+}
+
+void* LAppAllocator::AllocateFromPool(csmUint32 sizeClass)
+{
+    if (_freeLists[sizeClass] == NULL)
+    {
+        // ページを同じサイズの領域に切り分けて空きリストにつなぐ。ページの先頭はページの連結リストに使う
+        csmByte* page = static_cast<csmByte*>(malloc(PageSize));
+        if (page == NULL)
+        {
+            return NULL;
+        }
+        *reinterpret_cast<void**>(page) = _pages;
+        _pages = page;
+        _statistics.PoolReservedBytes += PageSize;
+
+        const csmSizeType blockSize = HeaderSize + ClassSize(sizeClass);
+        for (csmSizeType offset = HeaderSize; offset + blockSize <= PageSize; offset += blockSize)
+        {
+            void* block = page + offset + HeaderSize;
+            *static_cast<void**>(block) = _freeLists[sizeClass];
+            _freeLists[sizeClass] = block;
+        }
+    }
+
+    _statistics.PoolUsedBytes += ClassSize(sizeClass);
+    return PopFreeBlock(_freeLists[sizeClass]);
+}
+
+void* LAppAllocator::AllocateFromArena(Arena* arena, csmUint32 sizeClass)
+{
+    void* block = PopFreeBlock(arena->FreeLists[sizeClass]);
+    if (block != NULL)
+    {
+        return block;
+    }
+
+    // 空きが無ければチャンクの末尾から切り出す。収まらない残りは使わずに次のチャンクへ進む
+    const csmSizeType blockSize = HeaderSize + ClassSize(sizeClass);
+    ArenaChunk* chunk = arena->Chunks;
+    if (chunk == NULL || chunk->Capacity - chunk->Used < blockSize)
+    {
+        chunk = static_cast<ArenaChunk*>(malloc(sizeof(ArenaChunk) + ChunkSize));
+        if (chunk == NULL)
+        {
+            return NULL;
+        }
+        chunk->Capacity = ChunkSize;
+        chunk->Used = 0;
+        chunk->Next = arena->Chunks;
+        arena->Chunks = chunk;
+        arena->Reserved += sizeof(ArenaChunk) + ChunkSize;
+        _statistics.ArenaReservedBytes += sizeof(ArenaChunk) + ChunkSize;
+    }
+
+    block = chunk->GetData() + chunk->Used + HeaderSize;
+    chunk->Used += blockSize;
+    return block;
 }
 
 void* LAppAllocator::AllocateAligned(const csmSizeType size, const csmUint32 alignment)
@@ -52,3 +328,13 @@ void LAppAllocator::DeallocateAligned(void* alignedMemory)
 
     Deallocate(preamble[-1]);
 }
+
+void LAppAllocator::BeginSharedAllocation()
+{
+    _sharedDepth++;
+}
+
+void LAppAllocator::EndSharedAllocation()
+{
+    _sharedDepth--;
+}
@@ -16,9 +16,88 @@
 * メモリ確保・解放処理のインターフェースの実装。
 * フレームワークから呼び出される。
 *
+* 小さい領域はサイズごとのプールから確保し、解放された領域は同じサイズの確保に使い回す。
+* アリーナを設定している間は、小さい領域をアリーナのチャンクにまとめ、アリーナごと一度に解放できるようにする。
+* アリーナもサイズごとの空きリストを持ち、読み込み中に解放された一時的な領域はそのアリーナの中で使い回す。
+* プールに入らない大きさの領域は、アリーナを設定していてもヒープから確保し、解放されたらすぐに返す。
+* 1つのスレッドからのみ使用する。
+*
 */
 class LAppAllocator : public Csm::ICubismAllocator
 {
+public:
+    struct Arena;
+
+    /**
+    * @brief 確保している領域の状態
+    */
+    struct Statistics
+    {
+        Csm::csmSizeType PoolReservedBytes;     ///< プールが確保しているページの合計
+        Csm::csmSizeType PoolUsedBytes;         ///< プールの領域のうち使用中のもの
+        Csm::csmSizeType LargeUsedBytes;        ///< プールに入らない大きさで確保した領域の合計
+        Csm::csmSizeType ArenaReservedBytes;    ///< アリーナが確保しているチャンクの合計
+        Csm::csmUint32 ArenaCount;              ///< 解放されていないアリーナの数
+    };
+
+    /**
+    * @brief スコープの間、アリーナから確保させるクラス
+    */
+    class ArenaScope
+    {
+    public:
+        /**
+        * @param[in]   allocator   対象のアロケータ
+        * @param[in]   arena       確保に使うアリーナ。NULLなら何もしない
+        */
+        ArenaScope(LAppAllocator& allocator, Arena* arena);
+        ~ArenaScope();
+
+    private:
+        ArenaScope(const ArenaScope&);
+        ArenaScope& operator=(const ArenaScope&);
+
+        LAppAllocator& _allocator;  ///< 対象のアロケータ
+        Arena* _previous;           ///< スコープに入る前のアリーナ
+    };
+
+    /**
+    * @brief コンストラクタ
+    */
+    LAppAllocator();
+
+    /**
+    * @brief デストラクタ。プールのページを全て解放する
+    */
+    virtual ~LAppAllocator();
+
+    /**
+    * @brief 空のアリーナを作成する。
+    */
+    Arena* CreateArena();
+
+    /**
+    * @brief アリーナのチャンクをまとめて解放する。<br>
+    *         アリーナを設定している間に確保したオブジェクトは、先に破棄しておくこと。
+    *
+    * @param[in]   arena   解放するアリーナ。NULLなら何もしない
+    */
+    void ReleaseArena(Arena* arena);
+
+    /**
+    * @brief 以降の確保に使うアリーナを設定する。
+    *
+    * @param[in]   arena   アリーナ。NULLならプールとヒープから確保する
+    * @return  それまで設定されていたアリーナ
+    */
+    Arena* SetArena(Arena* arena);
+
+    /**
+    * @brief 確保している領域の状態を取得する。
+    */
+    Statistics GetStatistics() const;
+
+private:
     /**
     * @brief  メモリ領域を割り当てる。
     *
@@ -49,4 +128,39 @@ class LAppAllocator : public Csm::ICubismAllocator
     * @param[in]   alignedMemory    解放するメモリ。
     */
     void DeallocateAligned(void* alignedMemory);
+
+    /**
+    * @brief   共有のプールからサイズごとの領域を確保する。空きが無ければページを切り分ける
+    *
+    * @param[in]   sizeClass    プールのサイズの番号
+    * @return  ヘッダの直後のアドレス
+    */
+    void* AllocateFromPool(Csm::csmUint32 sizeClass);
+
+    /**
+    * @brief   アリーナからサイズごとの領域を確保する。空きが無ければチャンクから切り出す
+    *
+    * @param[in]   arena        確保に使うアリーナ
+    * @param[in]   sizeClass    プールのサイズの番号
+    * @return  ヘッダの直後のアドレス
+    */
+    void* AllocateFromArena(Arena* arena, Csm::csmUint32 sizeClass);
+
+    /**
+    * @brief   共有の確保を開始する。入れ子の間はアリーナを使わない
+    */
+    void BeginSharedAllocation();
+
+    /**
+    * @brief   共有の確保を終了する。
+    */
+    void EndSharedAllocation();
+
+    static const Csm::csmUint32 SizeClassCount = 6;    ///< プールのサイズの種類。16バイトから512バイトまでの2のべき乗
+
+    void* _freeLists[SizeClassCount];           ///< サイズごとの解放済みの領域の連結リスト
+    void* _pages;                               ///< プールのページの連結リスト
+    Arena* _arena;                              ///< 確保に使うアリーナ
+    Csm::csmInt32 _sharedDepth;                 ///< BeginSharedAllocationの入れ子の深さ
+    Statistics _statistics;                     ///< 確保している領域の状態
 };
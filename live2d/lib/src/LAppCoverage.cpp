@@ -0,0 +1,408 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+#include "LAppCoverage.hpp"
+#include <cstring>
+#include "LAppPal.hpp"
+
+#ifdef CSM_TARGET_WIN_GL
+#include "rlgl.h"
+#include <Windows.h>
+#endif
+
+using namespace Csm;
+
+namespace {
+#ifdef CSM_TARGET_WIN_GL
+// ピクセルバッファとフレームバッファの転送に使う、rlglに無いGLの関数と定数
+const unsigned int GL_READ_FRAMEBUFFER = 0x8CA8;
+const unsigned int GL_DRAW_FRAMEBUFFER = 0x8CA9;
+const unsigned int GL_FRAMEBUFFER = 0x8D40;
+const unsigned int GL_COLOR_BUFFER_BIT = 0x00004000;
+const unsigned int GL_LINEAR = 0x2601;
+const unsigned int GL_RGBA = 0x1908;
+const unsigned int GL_UNSIGNED_BYTE = 0x1401;
+const unsigned int GL_PIXEL_PACK_BUFFER = 0x88EB;
+const unsigned int GL_STREAM_READ = 0x88E1;
+const unsigned int GL_READ_ONLY = 0x88B8;
+
+typedef void (APIENTRY *BindFramebufferProc)(unsigned int target, unsigned int framebuffer);
+typedef void (APIENTRY *BlitFramebufferProc)(int srcX0, int srcY0, int srcX1, int srcY1, int dstX0, int dstY0, int dstX1, int dstY1, unsigned int mask, unsigned int filter);
+typedef void (APIENTRY *GenBuffersProc)(int n, unsigned int* buffers);
+typedef void (APIENTRY *DeleteBuffersProc)(int n, const unsigned int* buffers);
+typedef void (APIENTRY *BindBufferProc)(unsigned int target, unsigned int buffer);
+typedef void (APIENTRY *BufferDataProc)(unsigned int target, ptrdiff_t size, const void* data, unsigned int usage);
+typedef void* (APIENTRY *MapBufferProc)(unsigned int target, unsigned int access);
+typedef unsigned char (APIENTRY *UnmapBufferProc)(unsigned int target);
+typedef void (APIENTRY *ReadPixelsProc)(int x, int y, int width, int height, unsigned int format, unsigned int type, void* pixels);
+
+BindFramebufferProc s_glBindFramebuffer;
+BlitFramebufferProc s_glBlitFramebuffer;
+GenBuffersProc s_glGenBuffers;
+DeleteBuffersProc s_glDeleteBuffers;
+BindBufferProc s_glBindBuffer;
+BufferDataProc s_glBufferData;
+MapBufferProc s_glMapBuffer;
+UnmapBufferProc s_glUnmapBuffer;
+ReadPixelsProc s_glReadPixels;
+csmInt32 s_pixelBufferSupport = -1;    ///< ピクセルバッファが使えるか。-1なら未確認
+
+/**
+ * @brief   ピクセルバッファの関数を取得する。ドライバが対応していなければfalse
+ */
+csmBool LoadPixelBufferFunctions()
+{
+    if (s_pixelBufferSupport >= 0)
+    {
+        return s_pixelBufferSupport == 1;
+    }
+
+    // GL 1.1の関数はopengl32.dllから、それ以降の関数はwglGetProcAddressから取得する
+    HMODULE opengl = GetModuleHandleA("opengl32.dll");
+    if (opengl != NULL)
+    {
+        s_glReadPixels = reinterpret_cast<ReadPixelsProc>(GetProcAddress(opengl, "glReadPixels"));
+    }
+    s_glBindFramebuffer = reinterpret_cast<BindFramebufferProc>(wglGetProcAddress("glBindFramebuffer"));
+    s_glBlitFramebuffer = reinterpret_cast<BlitFramebufferProc>(wglGetProcAddress("glBlitFramebuffer"));
+    s_glGenBuffers = reinterpret_cast<GenBuffersProc>(wglGetProcAddress("glGenBuffers"));
+    s_glDeleteBuffers = reinterpret_cast<DeleteBuffersProc>(wglGetProcAddress("glDeleteBuffers"));
+    s_glBindBuffer = reinterpret_cast<BindBufferProc>(wglGetProcAddress("glBindBuffer"));
+    s_glBufferData = reinterpret_cast<BufferDataProc>(wglGetProcAddress("glBufferData"));
+    s_glMapBuffer = reinterpret_cast<MapBufferProc>(wglGetProcAddress("glMapBuffer"));
+    s_glUnmapBuffer = reinterpret_cast<UnmapBufferProc>(wglGetProcAddress("glUnmapBuffer"));
+
+    s_pixelBufferSupport = (s_glReadPixels != NULL && s_glBindFramebuffer != NULL && s_glBlitFramebuffer != NULL
+                            && s_glGenBuffers != NULL && s_glDeleteBuffers != NULL && s_glBindBuffer != NULL
+                            && s_glBufferData != NULL && s_glMapBuffer != NULL && s_glUnmapBuffer != NULL) ? 1 : 0;
+    if (s_pixelBufferSupport == 0)
+    {
+        LAppPal::PrintLog("[APP]pixel buffers are not supported, coverage is rasterized on the CPU");
+    }
+
+    return s_pixelBufferSupport == 1;
+}
+#endif
+
+csmFloat32 EdgeFunction(const csmFloat32* a, const csmFloat32* b, csmFloat32 x, csmFloat32 y)
+{
+    return (b[0] - a[0]) * (y - a[1]) - (b[1] - a[1]) * (x - a[0]);
+}
+}
+
+LAppCoverage::LAppCoverage()
+    : _screenWidth(0)
+    , _screenHeight(0)
+    , _downsample(1)
+    , _width(0)
+    , _height(0)
+    , _isGpuReadback(false)
+    , _downsampleTexture(0)
+    , _downsampleFramebuffer(0)
+    , _writeIndex(0)
+{
+    _pixelBuffers[0] = _pixelBuffers[1] = 0;
+    _isPixelBufferFilled[0] = _isPixelBufferFilled[1] = false;
+}
+
+LAppCoverage::~LAppCoverage()
+{
+    Release();
+}
+
+void LAppCoverage::Initialize(csmInt32 width, csmInt32 height, csmInt32 downsample, csmBool useGpu)
+{
+    Release();
+
+    if (width <= 0 || height <= 0)
+    {
+        return;
+    }
+
+    _screenWidth = width;
+    _screenHeight = height;
+    _downsample = (downsample > 0) ? downsample : 1;
+    _width = (width + _downsample - 1) / _downsample;
+    _height = (height + _downsample - 1) / _downsample;
+    _mask.Resize(_width * _height, 0);
+
+    _isGpuReadback = useGpu && CreateGpuResources();
+    if (!_isGpuReadback)
+    {
+        _rasterTarget.Resize(_width * _height, 0);
+    }
+}
+
+void LAppCoverage::Release()
+{
+#ifdef CSM_TARGET_WIN_GL
+    if (_pixelBuffers[0] != 0)
+    {
+        s_glDeleteBuffers(2, _pixelBuffers);
+    }
+    if (_downsampleFramebuffer != 0)
+    {
+        rlUnloadFramebuffer(_downsampleFramebuffer);
+    }
+    if (_downsampleTexture != 0)
+    {
+        rlUnloadTexture(_downsampleTexture);
+    }
+#endif
+
+    _pixelBuffers[0] = _pixelBuffers[1] = 0;
+    _isPixelBufferFilled[0] = _isPixelBufferFilled[1] = false;
+    _downsampleFramebuffer = 0;
+    _downsampleTexture = 0;
+    _writeIndex = 0;
+    _isGpuReadback = false;
+    _width = _height = 0;
+    _mask.Clear();
+    _rasterTarget.Clear();
+}
+
+csmBool LAppCoverage::IsValid() const
+{
+    return _width > 0;
+}
+
+csmBool LAppCoverage::IsGpuReadback() const
+{
+    return _isGpuReadback;
+}
+
+void LAppCoverage::BeginFrame()
+{
+    if (!IsValid() || _isGpuReadback)
+    {
+        return;
+    }
+    memset(_rasterTarget.GetPtr(), 0, _rasterTarget.GetSize());
+}
+
+void LAppCoverage::RasterizeUpperBound(const CubismModel& model, CubismMatrix44& mvp, csmFloat32 opacity)
+{
+    if (!IsValid() || _isGpuReadback)
+    {
+        return;
+    }
+
+    const csmFloat32* m = mvp.GetArray();
+    const csmInt32 drawableCount = model.GetDrawableCount();
+    for (csmInt32 i = 0; i < drawableCount; ++i)
+    {
+        if (!model.GetDrawableDynamicFlagIsVisible(i))
+        {
+            continue;
+        }
+
+        const csmInt32 value = static_cast<csmInt32>(model.GetDrawableOpacity(i) * opacity * 255.0f + 0.5f);
+        if (value <= 0)
+        {
+            continue;
+        }
+
+        // テクスチャとクリッピングは見ないので、三角形全体がDrawableの不透明度で描かれたものとみなす
+        // 頂点をマスク上の座標へ変換する。画面は正射影で描くので、wでは割らない
+        const csmInt32 vertexCount = model.GetDrawableVertexCount(i);
+        const csmFloat32* vertices = model.GetDrawableVertices(i);
+        _rasterVertices.Resize(vertexCount * 2);
+        for (csmInt32 j = 0; j < vertexCount; ++j)
+        {
+            const csmFloat32 x = vertices[j * 2];
+            const csmFloat32 y = vertices[j * 2 + 1];
+            const csmFloat32 clipX = m[0] * x + m[4] * y + m[12];
+            const csmFloat32 clipY = m[1] * x + m[5] * y + m[13];
+            _rasterVertices[j * 2] = (clipX + 1.0f) * 0.5f * _width;
+            _rasterVertices[j * 2 + 1] = (1.0f - clipY) * 0.5f * _height;
+        }
+
+        const csmUint16* indices = model.GetDrawableVertexIndices(i);
+        const csmInt32 indexCount = model.GetDrawableVertexIndexCount(i);
+        const csmUint8 fill = static_cast<csmUint8>((value < 255) ? value : 255);
+        for (csmInt32 j = 0; j + 2 < indexCount; j += 3)
+        {
+            FillTriangleUpperBound(&_rasterVertices[indices[j] * 2], &_rasterVertices[indices[j + 1] * 2], &_rasterVertices[indices[j + 2] * 2], fill);
+        }
+    }
+}
+
+void LAppCoverage::EndFrame(unsigned int sourceFbo)
+{
+    if (!IsValid())
+    {
+        return;
+    }
+
+    if (!_isGpuReadback)
+    {
+        memcpy(_mask.GetPtr(), _rasterTarget.GetPtr(), _mask.GetSize());
+        return;
+    }
+
+#ifdef CSM_TARGET_WIN_GL
+    // rlglに溜まっている描画を先に流す
+    rlDrawRenderBatchActive();
+
+    // 画面を縮小して描き、今回のピクセルバッファへ読み出す。読み出しは描画の完了を待たずに返る
+    s_glBindFramebuffer(GL_READ_FRAMEBUFFER, sourceFbo);
+    s_glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _downsampleFramebuffer);
+    s_glBlitFramebuffer(0, 0, _screenWidth, _screenHeight, 0, 0, _width, _height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+    s_glBindFramebuffer(GL_READ_FRAMEBUFFER, _downsampleFramebuffer);
+    s_glBindBuffer(GL_PIXEL_PACK_BUFFER, _pixelBuffers[_writeIndex]);
+    s_glReadPixels(0, 0, _width, _height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    _isPixelBufferFilled[_writeIndex] = true;
+
+    // 前のフレームで読み出したピクセルバッファは転送が済んでいるので、待たずにマップできる
+    const csmInt32 readIndex = _writeIndex ^ 1;
+    if (_isPixelBufferFilled[readIndex])
+    {
+        s_glBindBuffer(GL_PIXEL_PACK_BUFFER, _pixelBuffers[readIndex]);
+        const csmUint8* pixels = static_cast<const csmUint8*>(s_glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+        if (pixels != NULL)
+        {
+            // GLは下の行から並ぶので、上下を反転してアルファだけを取り出す
+            for (csmInt32 y = 0; y < _height; ++y)
+            {
+                const csmUint8* source = pixels + (_height - 1 - y) * _width * 4;
+                csmUint8* destination = _mask.GetPtr() + y * _width;
+                for (csmInt32 x = 0; x < _width; ++x)
+                {
+                    destination[x] = source[x * 4 + 3];
+                }
+            }
+            s_glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+    }
+    _writeIndex = readIndex;
+
+    s_glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    s_glBindFramebuffer(GL_FRAMEBUFFER, sourceFbo);
+#endif
+}
+
+csmUint8 LAppCoverage::Query(csmFloat32 x, csmFloat32 y) const
+{
+    if (!IsValid() || x < 0.0f || y < 0.0f)
+    {
+        return 0;
+    }
+
+    const csmInt32 column = static_cast<csmInt32>(x) / _downsample;
+    const csmInt32 row = static_cast<csmInt32>(y) / _downsample;
+    if (column >= _width || row >= _height)
+    {
+        return 0;
+    }
+    return _mask[row * _width + column];
+}
+
+const csmUint8* LAppCoverage::GetMask() const
+{
+    return IsValid() ? &_mask[0] : NULL;
+}
+
+csmInt32 LAppCoverage::GetWidth() const
+{
+    return _width;
+}
+
+csmInt32 LAppCoverage::GetHeight() const
+{
+    return _height;
+}
+
+csmInt32 LAppCoverage::GetScreenWidth() const
+{
+    return _screenWidth;
+}
+
+csmInt32 LAppCoverage::GetScreenHeight() const
+{
+    return _screenHeight;
+}
+
+csmBool LAppCoverage::CreateGpuResources()
+{
+#ifdef CSM_TARGET_WIN_GL
+    if (!LoadPixelBufferFunctions())
+    {
+        return false;
+    }
+
+    _downsampleTexture = rlLoadTexture(NULL, _width, _height, RL_PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, 1);
+    _downsampleFramebuffer = rlLoadFramebuffer();
+    rlFramebufferAttach(_downsampleFramebuffer, _downsampleTexture, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_TEXTURE2D, 0);
+    rlDisableFramebuffer();
+
+    s_glGenBuffers(2, _pixelBuffers);
+    for (csmInt32 i = 0; i < 2; ++i)
+    {
+        s_glBindBuffer(GL_PIXEL_PACK_BUFFER, _pixelBuffers[i]);
+        s_glBufferData(GL_PIXEL_PACK_BUFFER, _width * _height * 4, NULL, GL_STREAM_READ);
+    }
+    s_glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void LAppCoverage::FillTriangleUpperBound(const csmFloat32* p0, const csmFloat32* p1, const csmFloat32* p2, csmUint8 value)
+{
+    // 裏向きの三角形も塗るよう、向きを揃える
+    const csmFloat32 area = EdgeFunction(p0, p1, p2[0], p2[1]);
+    if (area == 0.0f)
+    {
+        return;
+    }
+    if (area < 0.0f)
+    {
+        const csmFloat32* swap = p1;
+        p1 = p2;
+        p2 = swap;
+    }
+
+    csmFloat32 minX = p0[0], maxX = p0[0], minY = p0[1], maxY = p0[1];
+    const csmFloat32* others[2] = { p1, p2 };
+    for (csmInt32 k = 0; k < 2; ++k)
+    {
+        if (others[k][0] < minX) minX = others[k][0];
+        if (others[k][0] > maxX) maxX = others[k][0];
+        if (others[k][1] < minY) minY = others[k][1];
+        if (others[k][1] > maxY) maxY = others[k][1];
+    }
+
+    csmInt32 x0 = static_cast<csmInt32>(minX);
+    csmInt32 x1 = static_cast<csmInt32>(maxX);
+    csmInt32 y0 = static_cast<csmInt32>(minY);
+    csmInt32 y1 = static_cast<csmInt32>(maxY);
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 >= _width) x1 = _width - 1;
+    if (y1 >= _height) y1 = _height - 1;
+
+    // ピクセルの中心が三角形に含まれるかで判定する
+    for (csmInt32 y = y0; y <= y1; ++y)
+    {
+        const csmFloat32 centerY = y + 0.5f;
+        csmUint8* row = _rasterTarget.GetPtr() + y * _width;
+        for (csmInt32 x = x0; x <= x1; ++x)
+        {
+            const csmFloat32 centerX = x + 0.5f;
+            if (EdgeFunction(p0, p1, centerX, centerY) >= 0.0f
+                && EdgeFunction(p1, p2, centerX, centerY) >= 0.0f
+                && EdgeFunction(p2, p0, centerX, centerY) >= 0.0f
+                && row[x] < value)
+            {
+                row[x] = value;
+            }
+        }
+    }
+}
@@ -0,0 +1,143 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+#pragma once
+
+#include <CubismFramework.hpp>
+#include <Model/CubismModel.hpp>
+#include <Math/CubismMatrix44.hpp>
+#include <Type/csmVector.hpp>
+
+/**
+ * @brief   画面の不透明な部分を縮小したマスクとして保持するクラス<br>
+ *           クリックを透過するウィンドウで、カーソルの下にモデルが描かれているかを調べるのに使う。<br>
+ *           GPUで読み出す場合は、縮小したフレームバッファを2つのピクセルバッファへ交互に読み出し、
+ *           1フレーム前に読み出したものを使う。描画の完了を待たないので、マスクは1フレーム遅れる。<br>
+ *           ピクセルバッファが使えない場合は、描いたモデルの三角形をCPUで塗ってマスクを作る。
+ *           この場合はクリッピングとテクスチャの透明部分を考慮しない粗い上界で、マスクは実際より広く、値は実際以上になる。
+ */
+class LAppCoverage
+{
+public:
+    /**
+     * @brief   コンストラクタ
+     */
+    LAppCoverage();
+
+    /**
+     * @brief   デストラクタ
+     */
+    ~LAppCoverage();
+
+    /**
+     * @brief   マスクを作成する。作成済みなら作り直す。
+     *
+     * @param[in]   width       画面の幅[ピクセル]
+     * @param[in]   height      画面の高さ[ピクセル]
+     * @param[in]   downsample  縮小率。マスクの1ピクセルが画面のこの数×この数のピクセルに当たる
+     * @param[in]   useGpu      trueならGPUで読み出す。使えない場合はCPUで塗る
+     */
+    void Initialize(Csm::csmInt32 width, Csm::csmInt32 height, Csm::csmInt32 downsample, Csm::csmBool useGpu);
+
+    /**
+     * @brief   マスクとGPUの資源を破棄する。
+     */
+    void Release();
+
+    /**
+     * @brief   作成済みか
+     */
+    Csm::csmBool IsValid() const;
+
+    /**
+     * @brief   GPUで読み出しているか。falseならRasterizeUpperBoundで描いたモデルを塗る必要がある
+     */
+    Csm::csmBool IsGpuReadback() const;
+
+    /**
+     * @brief   フレームの描画の前に呼ぶ。CPUで塗る場合は塗り先を消去する。
+     */
+    void BeginFrame();
+
+    /**
+     * @brief   描画したモデルの三角形をCPUで塗る。GPUで読み出す場合は何もしない。<br>
+     *           三角形全体をDrawableの不透明度で塗るだけで、テクスチャの透明部分とクリッピングマスクは見ない。
+     *           そのため結果は実際の不透明度の粗い上界になる。
+     *
+     * @param[in]   model       モデル
+     * @param[in]   mvp         描画に使ったModel-View-Projection行列
+     * @param[in]   opacity     モデルの不透明度
+     */
+    void RasterizeUpperBound(const Csm::CubismModel& model, Csm::CubismMatrix44& mvp, Csm::csmFloat32 opacity);
+
+    /**
+     * @brief   フレームの描画の後、画面を表示する前に呼び、マスクを更新する。
+     *
+     * @param[in]   sourceFbo   モデルを描いたフレームバッファ。0なら既定のフレームバッファ
+     */
+    void EndFrame(unsigned int sourceFbo);
+
+    /**
+     * @brief   画面上の座標の不透明度を取得する。
+     *
+     * @param[in]   x   X座標[ピクセル]。左端が0
+     * @param[in]   y   Y座標[ピクセル]。上端が0
+     * @return  不透明度(0～255)。範囲外なら0。CPUで塗った場合は実際の不透明度以上の値
+     */
+    Csm::csmUint8 Query(Csm::csmFloat32 x, Csm::csmFloat32 y) const;
+
+    /**
+     * @brief   マスクを取得する。上の行から並べた1ピクセル1バイトの不透明度
+     */
+    const Csm::csmUint8* GetMask() const;
+
+    /**
+     * @brief   マスクの幅を取得する。
+     */
+    Csm::csmInt32 GetWidth() const;
+
+    /**
+     * @brief   マスクの高さを取得する。
+     */
+    Csm::csmInt32 GetHeight() const;
+
+    /**
+     * @brief   作成時の画面の幅を取得する。
+     */
+    Csm::csmInt32 GetScreenWidth() const;
+
+    /**
+     * @brief   作成時の画面の高さを取得する。
+     */
+    Csm::csmInt32 GetScreenHeight() const;
+
+private:
+    /**
+     * @brief   ピクセルバッファを作成する。使えなければfalse
+     */
+    Csm::csmBool CreateGpuResources();
+
+    /**
+     * @brief   三角形を塗り先に一様な値で塗る。重なった部分は大きい方の値を残す
+     */
+    void FillTriangleUpperBound(const Csm::csmFloat32* p0, const Csm::csmFloat32* p1, const Csm::csmFloat32* p2, Csm::csmUint8 value);
+
+    Csm::csmInt32 _screenWidth;                       ///< 画面の幅
+    Csm::csmInt32 _screenHeight;                      ///< 画面の高さ
+    Csm::csmInt32 _downsample;                        ///< 縮小率
+    Csm::csmInt32 _width;                             ///< マスクの幅
+    Csm::csmInt32 _height;                            ///< マスクの高さ
+    Csm::csmVector<Csm::csmUint8> _mask;              ///< 公開しているマスク
+    Csm::csmVector<Csm::csmUint8> _rasterTarget;      ///< CPUで塗る場合の塗り先。EndFrameで_maskへ写す
+    Csm::csmVector<Csm::csmFloat32> _rasterVertices;  ///< CPUで塗る場合の、マスク上の座標に変換した頂点
+    Csm::csmBool _isGpuReadback;                      ///< GPUで読み出しているか
+    unsigned int _downsampleTexture;                  ///< 縮小した画面を描くテクスチャ
+    unsigned int _downsampleFramebuffer;              ///< 縮小した画面を描くフレームバッファ
+    unsigned int _pixelBuffers[2];                    ///< 交互に読み出すピクセルバッファ
+    Csm::csmBool _isPixelBufferFilled[2];             ///< ピクセルバッファに読み出し済みか
+    Csm::csmInt32 _writeIndex;                        ///< 今回読み出すピクセルバッファ
+};
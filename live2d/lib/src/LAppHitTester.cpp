@@ -0,0 +1,277 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+#include "LAppHitTester.hpp"
+#include <float.h>
+#include <Math/CubismMath.hpp>
+
+using namespace Csm;
+
+namespace {
+const csmFloat32 TrianglesPerCell = 2.0f;   ///< 1セルあたりの三角形の数の目安
+const csmInt32 MaxGridSize = 64;            ///< グリッドの列数・行数の上限
+
+csmInt32 ClampCell(csmFloat32 value, csmInt32 count)
+{
+    const csmInt32 cell = static_cast<csmInt32>(value);
+    if (cell < 0) return 0;
+    if (cell >= count) return count - 1;
+    return cell;
+}
+}
+
+LAppHitTester::LAppHitTester()
+    : _alphaThreshold(0.0f)
+{
+}
+
+LAppHitTester::~LAppHitTester()
+{
+    Release();
+}
+
+void LAppHitTester::Initialize(const CubismModel& model)
+{
+    Release();
+    _grids.Resize(model.GetDrawableCount(), NULL);
+}
+
+void LAppHitTester::Update(const CubismModel& model)
+{
+    for (csmUint32 i = 0; i < _grids.GetSize(); ++i)
+    {
+        if (_grids[i] != NULL && model.GetDrawableDynamicFlagVertexPositionsDidChange(i))
+        {
+            _grids[i]->IsDirty = true;
+        }
+    }
+}
+
+void LAppHitTester::SetTextureAlpha(csmInt32 textureIndex, const csmUint8* alpha, csmInt32 width, csmInt32 height)
+{
+    if (textureIndex < 0)
+    {
+        return;
+    }
+
+    if (static_cast<csmUint32>(textureIndex) >= _textureAlphas.GetSize())
+    {
+        TextureAlpha empty;
+        empty.Alpha = NULL;
+        empty.Width = 0;
+        empty.Height = 0;
+        _textureAlphas.Resize(textureIndex + 1, empty);
+    }
+
+    _textureAlphas[textureIndex].Alpha = alpha;
+    _textureAlphas[textureIndex].Width = width;
+    _textureAlphas[textureIndex].Height = height;
+}
+
+void LAppHitTester::SetAlphaThreshold(csmFloat32 threshold)
+{
+    _alphaThreshold = CubismMath::RangeF(threshold, 0.0f, 1.0f);
+}
+
+csmBool LAppHitTester::IsHit(const CubismModel& model, csmInt32 drawableIndex, csmFloat32 x, csmFloat32 y)
+{
+    if (drawableIndex < 0 || static_cast<csmUint32>(drawableIndex) >= _grids.GetSize())
+    {
+        return false;
+    }
+
+    // 初めて判定するDrawableか、頂点が動いた後ならグリッドを作り直す
+    Grid* grid = _grids[drawableIndex];
+    if (grid == NULL)
+    {
+        grid = CSM_NEW Grid();
+        _grids[drawableIndex] = grid;
+        grid->IsDirty = true;
+    }
+    if (grid->IsDirty)
+    {
+        BuildGrid(model, drawableIndex, *grid);
+    }
+
+    if (grid->Columns == 0 || x < grid->MinX || x > grid->MaxX || y < grid->MinY || y > grid->MaxY)
+    {
+        return false;
+    }
+
+    const csmInt32 column = ClampCell((x - grid->MinX) * grid->InvCellWidth, grid->Columns);
+    const csmInt32 row = ClampCell((y - grid->MinY) * grid->InvCellHeight, grid->Rows);
+    const csmInt32 cell = row * grid->Columns + column;
+
+    const csmFloat32* vertices = model.GetDrawableVertices(drawableIndex);
+    const csmUint16* indices = model.GetDrawableVertexIndices(drawableIndex);
+
+    // アルファを見る場合のテクスチャ
+    const TextureAlpha* texture = NULL;
+    if (_alphaThreshold > 0.0f)
+    {
+        const csmInt32 textureIndex = model.GetDrawableTextureIndex(drawableIndex);
+        if (textureIndex >= 0 && static_cast<csmUint32>(textureIndex) < _textureAlphas.GetSize() && _textureAlphas[textureIndex].Alpha != NULL)
+        {
+            texture = &_textureAlphas[textureIndex];
+        }
+    }
+
+    for (csmInt32 i = grid->CellStarts[cell]; i < grid->CellStarts[cell + 1]; ++i)
+    {
+        const csmInt32 triangle = grid->CellTriangles[i];
+        const csmInt32 i0 = indices[triangle * 3];
+        const csmInt32 i1 = indices[triangle * 3 + 1];
+        const csmInt32 i2 = indices[triangle * 3 + 2];
+        const csmFloat32 x0 = vertices[i0 * 2], y0 = vertices[i0 * 2 + 1];
+        const csmFloat32 x1 = vertices[i1 * 2], y1 = vertices[i1 * 2 + 1];
+        const csmFloat32 x2 = vertices[i2 * 2], y2 = vertices[i2 * 2 + 1];
+
+        // 重心座標で内外を判定する。辺上は内側とみなす
+        const csmFloat32 denominator = (y1 - y2) * (x0 - x2) + (x2 - x1) * (y0 - y2);
+        if (denominator == 0.0f)
+        {
+            continue;
+        }
+        const csmFloat32 a = ((y1 - y2) * (x - x2) + (x2 - x1) * (y - y2)) / denominator;
+        const csmFloat32 b = ((y2 - y0) * (x - x2) + (x0 - x2) * (y - y2)) / denominator;
+        const csmFloat32 c = 1.0f - a - b;
+        if (a < 0.0f || b < 0.0f || c < 0.0f)
+        {
+            continue;
+        }
+
+        if (texture == NULL)
+        {
+            return true;
+        }
+
+        // UVを補間してアルファを読む。テクスチャは上の行から並んでいるのでVを反転する
+        const Live2D::Cubism::Core::csmVector2* uvs = model.GetDrawableVertexUvs(drawableIndex);
+        const csmFloat32 u = a * uvs[i0].X + b * uvs[i1].X + c * uvs[i2].X;
+        const csmFloat32 v = a * uvs[i0].Y + b * uvs[i1].Y + c * uvs[i2].Y;
+        const csmInt32 px = ClampCell(u * texture->Width, texture->Width);
+        const csmInt32 py = ClampCell((1.0f - v) * texture->Height, texture->Height);
+        if (texture->Alpha[py * texture->Width + px] >= _alphaThreshold * 255.0f)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void LAppHitTester::BuildGrid(const CubismModel& model, csmInt32 drawableIndex, Grid& grid)
+{
+    const csmInt32 vertexCount = model.GetDrawableVertexCount(drawableIndex);
+    const csmFloat32* vertices = model.GetDrawableVertices(drawableIndex);
+    const csmUint16* indices = model.GetDrawableVertexIndices(drawableIndex);
+    const csmInt32 triangleCount = model.GetDrawableVertexIndexCount(drawableIndex) / 3;
+
+    grid.IsDirty = false;
+    grid.Columns = 0;
+    grid.Rows = 0;
+    grid.CellStarts.Resize(0);
+    grid.CellTriangles.Resize(0);
+
+    csmFloat32 left, top, right, bottom;
+    if (triangleCount == 0 || !CubismMath::CalculateBounds(vertices, vertexCount, left, top, right, bottom))
+    {
+        return; // 有効な三角形がない場合は常に外れ
+    }
+    grid.MinX = left;
+    grid.MinY = top;
+    grid.MaxX = right;
+    grid.MaxY = bottom;
+
+    // セルが正方形に近くなるよう、外接矩形の縦横比で列数と行数を分ける
+    const csmFloat32 width = right - left;
+    const csmFloat32 height = bottom - top;
+    const csmFloat32 cellCount = triangleCount / TrianglesPerCell;
+    csmFloat32 columns = 1.0f;
+    if (width > 0.0f && height > 0.0f)
+    {
+        columns = CubismMath::SqrtF(cellCount * width / height);
+    }
+    else if (width > 0.0f)
+    {
+        columns = cellCount;
+    }
+    grid.Columns = static_cast<csmInt32>(CubismMath::RangeF(columns + 0.5f, 1.0f, static_cast<csmFloat32>(MaxGridSize)));
+    grid.Rows = (height > 0.0f) ? static_cast<csmInt32>(CubismMath::RangeF(cellCount / grid.Columns + 0.5f, 1.0f, static_cast<csmFloat32>(MaxGridSize))) : 1;
+    grid.InvCellWidth = (width > 0.0f) ? grid.Columns / width : 0.0f;
+    grid.InvCellHeight = (height > 0.0f) ? grid.Rows / height : 0.0f;
+
+    // 三角形の外接矩形が掛かるセルへ振り分ける。1回目で数を数え、2回目で詰める
+    const csmInt32 gridCellCount = grid.Columns * grid.Rows;
+    grid.CellStarts.Resize(gridCellCount + 1, 0);
+    for (csmInt32 pass = 0; pass < 2; ++pass)
+    {
+        if (pass == 1)
+        {
+            // 数から先頭位置を求め、詰めながら先頭位置を進める
+            csmInt32 total = 0;
+            for (csmInt32 cell = 0; cell <= gridCellCount; ++cell)
+            {
+                const csmInt32 count = grid.CellStarts[cell];
+                grid.CellStarts[cell] = total;
+                total += count;
+            }
+            grid.CellTriangles.Resize(total, 0);
+        }
+
+        for (csmInt32 triangle = 0; triangle < triangleCount; ++triangle)
+        {
+            csmFloat32 minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+            for (csmInt32 k = 0; k < 3; ++k)
+            {
+                const csmInt32 index = indices[triangle * 3 + k];
+                const csmFloat32 vx = vertices[index * 2];
+                const csmFloat32 vy = vertices[index * 2 + 1];
+                if (vx < minX) minX = vx;
+                if (vx > maxX) maxX = vx;
+                if (vy < minY) minY = vy;
+                if (vy > maxY) maxY = vy;
+            }
+
+            const csmInt32 column0 = ClampCell((minX - left) * grid.InvCellWidth, grid.Columns);
+            const csmInt32 column1 = ClampCell((maxX - left) * grid.InvCellWidth, grid.Columns);
+            const csmInt32 row0 = ClampCell((minY - top) * grid.InvCellHeight, grid.Rows);
+            const csmInt32 row1 = ClampCell((maxY - top) * grid.InvCellHeight, grid.Rows);
+            for (csmInt32 row = row0; row <= row1; ++row)
+            {
+                for (csmInt32 column = column0; column <= column1; ++column)
+                {
+                    const csmInt32 cell = row * grid.Columns + column;
+                    if (pass == 0)
+                    {
+                        grid.CellStarts[cell]++;
+                    }
+                    else
+                    {
+                        grid.CellTriangles[grid.CellStarts[cell]++] = triangle;
+                    }
+                }
+            }
+        }
+    }
+
+    // 詰めるときに各セルの先頭を次のセルの先頭まで進めたので、1つずらして戻す
+    for (csmInt32 cell = gridCellCount; cell > 0; --cell)
+    {
+        grid.CellStarts[cell] = grid.CellStarts[cell - 1];
+    }
+    grid.CellStarts[0] = 0;
+}
+
+void LAppHitTester::Release()
+{
+    for (csmUint32 i = 0; i < _grids.GetSize(); ++i)
+    {
+        CSM_DELETE(_grids[i]);
+    }
+    _grids.Clear();
+}
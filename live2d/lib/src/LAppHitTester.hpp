@@ -0,0 +1,118 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+#pragma once
+
+#include <CubismFramework.hpp>
+#include <Model/CubismModel.hpp>
+#include <Type/csmVector.hpp>
+
+/**
+ * @brief   Drawableの三角形単位で当たり判定を行うクラス<br>
+ *           Drawableごとに三角形を一様グリッドへ振り分けておき、座標を含むセルの三角形だけを調べる。
+ *           グリッドは判定に使われたDrawableについてだけ作り、頂点が動いた後の最初の判定で作り直す。<br>
+ *           テクスチャのアルファのCPU側の写しを与えると、透明な部分は当たりにしない。<br>
+ *           GLには触れないので、モデルがあれば単体で動作を確認できる。
+ */
+class LAppHitTester
+{
+public:
+    /**
+     * @brief   コンストラクタ
+     */
+    LAppHitTester();
+
+    /**
+     * @brief   デストラクタ
+     */
+    ~LAppHitTester();
+
+    /**
+     * @brief   モデルのDrawableの数に合わせて初期化する。作成済みのグリッドは破棄する。
+     *
+     * @param[in]   model   判定するモデル
+     */
+    void Initialize(const Csm::CubismModel& model);
+
+    /**
+     * @brief   モデルの更新後に呼び、頂点が動いたDrawableのグリッドを作り直すよう記録する。
+     *
+     * @param[in]   model   判定するモデル
+     */
+    void Update(const Csm::CubismModel& model);
+
+    /**
+     * @brief   テクスチャのアルファの写しを設定する。
+     *
+     * @param[in]   textureIndex    モデルのテクスチャ番号
+     * @param[in]   alpha           1ピクセル1バイトのアルファ。上の行から並べたもの。NULLなら解除する。呼び出し側で保持すること
+     * @param[in]   width           幅
+     * @param[in]   height          高さ
+     */
+    void SetTextureAlpha(Csm::csmInt32 textureIndex, const Csm::csmUint8* alpha, Csm::csmInt32 width, Csm::csmInt32 height);
+
+    /**
+     * @brief   当たりにするアルファの下限を設定する。
+     *
+     * @param[in]   threshold   アルファの下限(0.0～1.0)。0ならアルファを見ない
+     */
+    void SetAlphaThreshold(Csm::csmFloat32 threshold);
+
+    /**
+     * @brief   座標がDrawableのいずれかの三角形に含まれるか判定する。
+     *
+     * @param[in]   model           判定するモデル
+     * @param[in]   drawableIndex   Drawableのインデックス
+     * @param[in]   x               モデル座標系のX座標
+     * @param[in]   y               モデル座標系のY座標
+     * @return  含まれればtrue。アルファを見る場合は、その位置のテクスチャが下限以上のアルファを持つこと
+     */
+    Csm::csmBool IsHit(const Csm::CubismModel& model, Csm::csmInt32 drawableIndex, Csm::csmFloat32 x, Csm::csmFloat32 y);
+
+private:
+    /**
+     * @brief   Drawable1つ分のグリッド
+     */
+    struct Grid
+    {
+        Csm::csmBool IsDirty;                          ///< 頂点が動いたため作り直す必要があるか
+        Csm::csmFloat32 MinX;                          ///< 外接矩形の最小X
+        Csm::csmFloat32 MinY;                          ///< 外接矩形の最小Y
+        Csm::csmFloat32 MaxX;                          ///< 外接矩形の最大X
+        Csm::csmFloat32 MaxY;                          ///< 外接矩形の最大Y
+        Csm::csmFloat32 InvCellWidth;                  ///< セルの幅の逆数
+        Csm::csmFloat32 InvCellHeight;                 ///< セルの高さの逆数
+        Csm::csmInt32 Columns;                         ///< 列数
+        Csm::csmInt32 Rows;                            ///< 行数
+        Csm::csmVector<Csm::csmInt32> CellStarts;      ///< セルごとのCellTriangles上の先頭。末尾に総数を置く
+        Csm::csmVector<Csm::csmInt32> CellTriangles;   ///< セルごとに並べた三角形の番号
+    };
+
+    /**
+     * @brief   テクスチャのアルファの写し
+     */
+    struct TextureAlpha
+    {
+        const Csm::csmUint8* Alpha;                    ///< アルファ。NULLなら無し
+        Csm::csmInt32 Width;                           ///< 幅
+        Csm::csmInt32 Height;                          ///< 高さ
+    };
+
+    /**
+     * @brief   Drawableの三角形をグリッドへ振り分ける。
+     */
+    void BuildGrid(const Csm::CubismModel& model, Csm::csmInt32 drawableIndex, Grid& grid);
+
+    /**
+     * @brief   破棄する。
+     */
+    void Release();
+
+    Csm::csmVector<Grid*> _grids;                  ///< Drawableごとのグリッド。未作成ならNULL
+    Csm::csmVector<TextureAlpha> _textureAlphas;   ///< テクスチャごとのアルファの写し
+    Csm::csmFloat32 _alphaThreshold;               ///< 当たりにするアルファの下限。0ならアルファを見ない
+};
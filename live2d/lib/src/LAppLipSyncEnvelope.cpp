@@ -0,0 +1,190 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+#include "LAppLipSyncEnvelope.hpp"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include "LAppWavFileHandler.hpp"
+
+using namespace Csm;
+
+namespace {
+const csmChar* EnvelopeExtension = ".lip";     ///< wavファイルのパスに付ける拡張子
+const csmChar Signature[4] = { 'L', 'I', 'P', 'E' };
+const csmUint16 FormatVersion = 1;
+const csmUint32 HeaderSize = 12;
+
+// 小さい音の分解能を残すため、平方根を量子化する
+csmUint8 Quantize(csmFloat32 rms)
+{
+    const csmFloat32 value = sqrtf((rms < 1.0f) ? rms : 1.0f) * 255.0f + 0.5f;
+    return static_cast<csmUint8>(value);
+}
+
+csmFloat32 Dequantize(csmUint8 value)
+{
+    const csmFloat32 root = value / 255.0f;
+    return root * root;
+}
+
+void Put16(csmByte* p, csmUint16 value)
+{
+    p[0] = static_cast<csmByte>(value);
+    p[1] = static_cast<csmByte>(value >> 8);
+}
+
+void Put32(csmByte* p, csmUint32 value)
+{
+    Put16(p, static_cast<csmUint16>(value));
+    Put16(p + 2, static_cast<csmUint16>(value >> 16));
+}
+
+csmUint16 Get16(const csmByte* p)
+{
+    return static_cast<csmUint16>(p[0] | (p[1] << 8));
+}
+
+csmUint32 Get32(const csmByte* p)
+{
+    return Get16(p) | (static_cast<csmUint32>(Get16(p + 2)) << 16);
+}
+}
+
+LAppLipSyncEnvelope::LAppLipSyncEnvelope()
+    : _frameRate(0)
+    , _userTimeSeconds(0.0f)
+    , _lastRms(0.0f)
+{
+}
+
+csmBool LAppLipSyncEnvelope::Bake(const csmString& wavFilePath, csmUint16 frameRate)
+{
+    if (frameRate == 0)
+    {
+        return false;
+    }
+
+    // 再生時と同じ計算になるよう、wavファイルハンドラを1フレームずつ進めてRMSを取る
+    LAppWavFileHandler wavFileHandler;
+    wavFileHandler.Start(wavFilePath);
+
+    csmVector<csmByte> data;
+    data.Resize(HeaderSize, 0);
+    const csmFloat32 frameSeconds = 1.0f / frameRate;
+    while (wavFileHandler.Update(frameSeconds))
+    {
+        data.PushBack(Quantize(wavFileHandler.GetRms()), false);
+    }
+
+    const csmUint32 frameCount = data.GetSize() - HeaderSize;
+    if (frameCount == 0)
+    {
+        return false;
+    }
+
+    memcpy(&data[0], Signature, sizeof(Signature));
+    Put16(&data[4], FormatVersion);
+    Put16(&data[6], frameRate);
+    Put32(&data[8], frameCount);
+
+    std::ofstream file(GetEnvelopePath(wavFilePath).GetRawString(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&data[0]), data.GetSize());
+    return file.good();
+}
+
+csmString LAppLipSyncEnvelope::GetEnvelopePath(const csmString& wavFilePath)
+{
+    return wavFilePath + EnvelopeExtension;
+}
+
+csmBool LAppLipSyncEnvelope::Start(const csmString& wavFilePath)
+{
+    Stop();
+    return Load(GetEnvelopePath(wavFilePath));
+}
+
+void LAppLipSyncEnvelope::Stop()
+{
+    _frames.Clear();
+    _frameRate = 0;
+    _userTimeSeconds = 0.0f;
+    _lastRms = 0.0f;
+}
+
+csmBool LAppLipSyncEnvelope::Update(csmFloat32 deltaTimeSeconds)
+{
+    if (_frames.GetSize() == 0)
+    {
+        _lastRms = 0.0f;
+        return false;
+    }
+
+    _userTimeSeconds += deltaTimeSeconds;
+
+    // フレームiは[i, i+1)/frameRateの区間のRMS。wavファイルから求めるRMSは直前のdeltaTimeSeconds間のものなので、
+    // その区間の中心の時刻を、フレームの中心どうしで線形補間する
+    const csmFloat32 position = (_userTimeSeconds - deltaTimeSeconds * 0.5f) * _frameRate - 0.5f;
+    const csmInt32 last = _frames.GetSize() - 1;
+    if (position >= last + 1.0f)
+    {
+        _frames.Clear();
+        _lastRms = 0.0f;
+        return false;
+    }
+
+    const csmInt32 index = (position > 0.0f) ? static_cast<csmInt32>(position) : 0;
+    const csmFloat32 t = (position > 0.0f) ? position - index : 0.0f;
+    const csmFloat32 current = Dequantize(_frames[index]);
+    const csmFloat32 next = (index < last) ? Dequantize(_frames[index + 1]) : current;
+    _lastRms = current + (next - current) * t;
+    return true;
+}
+
+csmFloat32 LAppLipSyncEnvelope::GetRms() const
+{
+    return _lastRms;
+}
+
+csmBool LAppLipSyncEnvelope::Load(const csmString& envelopePath)
+{
+    // 包絡線のファイルが無いのは通常のことなので、ログは出さない
+    std::ifstream file(envelopePath.GetRawString(), std::ios::in | std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    csmByte header[HeaderSize];
+    if (!file.read(reinterpret_cast<char*>(header), HeaderSize)
+        || memcmp(header, Signature, sizeof(Signature)) != 0
+        || Get16(header + 4) != FormatVersion)
+    {
+        return false;
+    }
+
+    const csmUint16 frameRate = Get16(header + 6);
+    const csmUint32 frameCount = Get32(header + 8);
+    if (frameRate == 0 || frameCount == 0)
+    {
+        return false;
+    }
+
+    _frames.Resize(frameCount, 0);
+    if (!file.read(reinterpret_cast<char*>(&_frames[0]), frameCount))
+    {
+        _frames.Clear();
+        return false;
+    }
+
+    _frameRate = frameRate;
+    return true;
+}
@@ -0,0 +1,83 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+#pragma once
+
+#include <CubismFramework.hpp>
+#include <Type/csmString.hpp>
+#include <Type/csmVector.hpp>
+
+/**
+ * @brief   事前に計算した音量の包絡線によるリップシンク
+ *
+ * 音声ファイルのRMSを一定の間隔で求めて量子化したものを、音声ファイルと同じ場所に保存しておき、
+ * 再生時は時刻に応じて値を引くだけにする。<br>
+ * ファイルの形式は、シグネチャ"LIPE"、バージョン(16bit)、1秒あたりのフレーム数(16bit)、フレーム数(32bit)、
+ * フレームごとの値(8bit)の順。値はRMSの平方根を0～255に量子化したもので、全てリトルエンディアン。
+ */
+class LAppLipSyncEnvelope
+{
+public:
+    static const Csm::csmUint16 DefaultFrameRate = 100;     ///< 1秒あたりのフレーム数の既定値
+
+    /**
+     * @brief   コンストラクタ
+     */
+    LAppLipSyncEnvelope();
+
+    /**
+     * @brief   wavファイルのRMSを計算し、包絡線のファイルに保存する。
+     *
+     * @param[in]   wavFilePath     wavファイルのパス
+     * @param[in]   frameRate       1秒あたりのフレーム数
+     * @return  保存できたか
+     */
+    static Csm::csmBool Bake(const Csm::csmString& wavFilePath, Csm::csmUint16 frameRate);
+
+    /**
+     * @brief   wavファイルに対応する包絡線のファイルのパスを取得する。
+     */
+    static Csm::csmString GetEnvelopePath(const Csm::csmString& wavFilePath);
+
+    /**
+     * @brief   wavファイルに対応する包絡線を読み込み、再生を開始する。
+     *
+     * @param[in]   wavFilePath     wavファイルのパス
+     * @return  包絡線のファイルが読み込めたか。読み込めなければ停止した状態になる
+     */
+    Csm::csmBool Start(const Csm::csmString& wavFilePath);
+
+    /**
+     * @brief   再生を停止する。
+     */
+    void Stop();
+
+    /**
+     * @brief   再生位置を進める。
+     *
+     * @param[in]   deltaTimeSeconds    デルタ時間[秒]
+     * @retval  true    更新されている
+     * @retval  false   再生していないか、末尾に達した
+     */
+    Csm::csmBool Update(Csm::csmFloat32 deltaTimeSeconds);
+
+    /**
+     * @brief   現在のRMS値を取得する。
+     */
+    Csm::csmFloat32 GetRms() const;
+
+private:
+    /**
+     * @brief   包絡線のファイルを読み込む。
+     */
+    Csm::csmBool Load(const Csm::csmString& envelopePath);
+
+    Csm::csmVector<Csm::csmUint8> _frames;  ///< 量子化したフレームごとの値
+    Csm::csmUint16 _frameRate;              ///< 1秒あたりのフレーム数
+    Csm::csmFloat32 _userTimeSeconds;       ///< 再生開始からの経過時間[秒]
+    Csm::csmFloat32 _lastRms;               ///< 現在のRMS値
+};
@@ -8,6 +8,8 @@
 #include "LAppModel.hpp"
 #include <fstream>
 #include <vector>
+#include <chrono>
+#include <cstring>
 #include <CubismModelSettingJson.hpp>
 #include <Motion/CubismMotion.hpp>
 #include <Physics/CubismPhysics.hpp>
@@ -16,9 +18,11 @@
 #include <Utils/CubismString.hpp>
 #include <Id/CubismIdManager.hpp>
 #include <Motion/CubismMotionQueueEntry.hpp>
+#include <Math/CubismMath.hpp>
 #include "LAppDefine.hpp"
 #include "LAppPal.hpp"
 #include "LAppTextureManager.hpp"
+#include "rlgl.h"
 
 using namespace Live2D::Cubism::Framework;
 using namespace Live2D::Cubism::Framework::DefaultParameterId;
@@ -42,12 +46,24 @@ namespace {
         }
         LAppPal::ReleaseBytes(buffer);
     }
+
+    const csmFloat32 MinMaskBufferSize = 64.0f;     ///< 解像度を下げたときのマスクのバッファの大きさの下限
 }
 
 LAppModel::LAppModel()
     : CubismUserModel()
     , _modelSetting(NULL)
     , _userTimeSeconds(0.0f)
+    , _audioLipSync(NULL)
+    , _modifierProfileFrames(0)
+    , _isModifierProfiling(false)
+    , _isRenderCacheEnabled(false)
+    , _isRenderCacheValid(false)
+    , _isRenderCacheHit(false)
+    , _renderCacheThreshold(0.0f)
+    , _appliedRenderScale(1.0f)
+    , _lastDrawSeconds(0.0f)
+    , _baseMaskBufferSize(0.0f, 0.0f)
 {
     if (DebugLogEnable)
     {
@@ -65,6 +81,12 @@ LAppModel::LAppModel()
 LAppModel::~LAppModel()
 {
     _renderBuffer.DestroyOffscreenFrame();
+    _renderCache.DestroyOffscreenFrame();
+
+    if (_audioLipSync != NULL)
+    {
+        CubismAudioLipSync::Delete(_audioLipSync);
+    }
 
     ReleaseMotions();
     ReleaseExpressions();
@@ -210,6 +232,11 @@ void LAppModel::SetupModel(ICubismModelSetting* setting)
         {
             _lipSyncIds.PushBack(_modelSetting->GetLipSyncParameterId(i));
         }
+
+        if (lipSyncIdCount > 0)
+        {
+            _audioLipSync = CubismAudioLipSync::Create();
+        }
     }
 
     //Layout
@@ -219,6 +246,19 @@ void LAppModel::SetupModel(ICubismModelSetting* setting)
 
     _model->SaveParameters();
 
+    _hitTester.Initialize(*_model);
+
+    // 当たり判定のIDは判定のたびに引かずに済むよう、Drawableのインデックスにしておく。
+    // 名前はハッシュコードを控え、名前で引くときに文字列を比べる回数を減らす
+    _hitAreaDrawableIndices.Clear();
+    _hitAreaNameHashes.Clear();
+    for (csmInt32 i = 0; i < _modelSetting->GetHitAreasCount(); ++i)
+    {
+        _hitAreaDrawableIndices.PushBack(_model->GetDrawableIndex(_modelSetting->GetHitAreaId(i)), false);
+        csmString name(_modelSetting->GetHitAreaName(i));
+        _hitAreaNameHashes.PushBack(name.GetHashcode(), false);
+    }
+
     for (csmInt32 i = 0; i < _modelSetting->GetMotionGroupCount(); i++)
     {
         const csmChar* group = _modelSetting->GetMotionGroupName(i);
@@ -227,6 +267,8 @@ void LAppModel::SetupModel(ICubismModelSetting* setting)
 
     _motionManager->StopAllMotions();
 
+    CompileModifierProgram();
+
     _updating = false;
     _initialized = true;
 }
@@ -324,93 +366,303 @@ void LAppModel::PreUpdate()
     const csmFloat32 deltaTimeSeconds = LAppPal::GetDeltaTime();
     _userTimeSeconds += deltaTimeSeconds;
 
-    _dragManager->Update(deltaTimeSeconds);
-    _dragX = _dragManager->GetX();
-    _dragY = _dragManager->GetY();
+    csmFloat32 registers[ModifierRegister_Count] = {};
 
     // モーションによるパラメータ更新の有無
     csmBool motionUpdated = false;
 
-    //-----------------------------------------------------------------
-    _model->LoadParameters(); // 前回セーブされた状態をロード
-    if (_motionManager->IsFinished())
+    if (!_isModifierProfiling)
     {
-        // モーションの再生がない場合、待機モーションの中からランダムで再生する
-        StartRandomMotion(MotionGroupIdle, PriorityIdle);
+        for (csmUint32 i = 0; i < _modifierProgram.GetSize(); ++i)
+        {
+            ExecuteModifierOp(_modifierProgram[i], deltaTimeSeconds, registers, motionUpdated);
+        }
+        return;
     }
-    else
+
+    for (csmUint32 i = 0; i < _modifierProgram.GetSize(); ++i)
     {
-        motionUpdated = _motionManager->UpdateMotion(_model, deltaTimeSeconds); // モーションを更新
+        const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+        ExecuteModifierOp(_modifierProgram[i], deltaTimeSeconds, registers, motionUpdated);
+
+        _modifierOpMicroseconds[i] += std::chrono::duration<csmFloat32, std::micro>(std::chrono::steady_clock::now() - begin).count();
     }
-    _model->SaveParameters(); // 状態を保存
-    //-----------------------------------------------------------------
+    ++_modifierProfileFrames;
+}
 
-    // まばたき
-    if (!motionUpdated)
+void LAppModel::CompileModifierProgram()
+{
+    _modifierProgram.Clear();
+
+    AddModifierOp(ModifierOp_UpdateDrag, ModifierCondition_Always);
+
+    // モーション(前回セーブされた状態をロードして更新し、状態を保存)
+    AddModifierOp(ModifierOp_UpdateMotion, ModifierCondition_Always);
+
+    // まばたき(メインモーションの更新がないとき)
+    if (_eyeBlink != NULL)
     {
-        if (_eyeBlink != NULL)
+        AddModifierOp(ModifierOp_UpdateEyeBlink, ModifierCondition_NoMotionUpdated);
+
+        const csmVector<CubismIdHandle>& eyeBlinkIds = _eyeBlink->GetParameterIds();
+        for (csmUint32 i = 0; i < eyeBlinkIds.GetSize(); ++i)
         {
-            // メインモーションの更新がないとき
-            _eyeBlink->UpdateParameters(_model, deltaTimeSeconds); // 目パチ
+            AddModifierOp(ModifierOp_SetWeighted, ModifierCondition_NoMotionUpdated, eyeBlinkIds[i], ModifierRegister_EyeBlink, 1.0f, 1.0f);
         }
     }
 
+    // 表情でパラメータ更新（相対変化）
     if (_expressionManager != NULL)
     {
-        _expressionManager->UpdateMotion(_model, deltaTimeSeconds); // 表情でパラメータ更新（相対変化）
+        AddModifierOp(ModifierOp_UpdateExpression, ModifierCondition_Always);
     }
 
-    //ドラッグによる変化
     //ドラッグによる顔の向きの調整
-    _model->AddParameterValue(_idParamAngleX, _dragX * 30); // -30から30の値を加える
-    _model->AddParameterValue(_idParamAngleY, _dragY * 30);
-    _model->AddParameterValue(_idParamAngleZ, _dragX * _dragY * -30);
+    AddModifierOp(ModifierOp_AddScaled, ModifierCondition_Always, _idParamAngleX, ModifierRegister_DragX, 30.0f, 1.0f); // -30から30の値を加える
+    AddModifierOp(ModifierOp_AddScaled, ModifierCondition_Always, _idParamAngleY, ModifierRegister_DragY, 30.0f, 1.0f);
+    AddModifierOp(ModifierOp_AddScaled, ModifierCondition_Always, _idParamAngleZ, ModifierRegister_DragXY, -30.0f, 1.0f);
 
     //ドラッグによる体の向きの調整
-    _model->AddParameterValue(_idParamBodyAngleX, _dragX * 10); // -10から10の値を加える
+    AddModifierOp(ModifierOp_AddScaled, ModifierCondition_Always, _idParamBodyAngleX, ModifierRegister_DragX, 10.0f, 1.0f); // -10から10の値を加える
 
     //ドラッグによる目の向きの調整
-    _model->AddParameterValue(_idParamEyeBallX, _dragX); // -1から1の値を加える
-    _model->AddParameterValue(_idParamEyeBallY, _dragY);
+    AddModifierOp(ModifierOp_AddScaled, ModifierCondition_Always, _idParamEyeBallX, ModifierRegister_DragX, 1.0f, 1.0f); // -1から1の値を加える
+    AddModifierOp(ModifierOp_AddScaled, ModifierCondition_Always, _idParamEyeBallY, ModifierRegister_DragY, 1.0f, 1.0f);
 
     // 呼吸など
     if (_breath != NULL)
     {
-        _breath->UpdateParameters(_model, deltaTimeSeconds);
+        AddModifierOp(ModifierOp_UpdateBreath, ModifierCondition_Always);
+
+        const csmVector<CubismBreath::BreathParameterData>& breathParameters = _breath->GetParameters();
+        for (csmUint32 i = 0; i < breathParameters.GetSize(); ++i)
+        {
+            AddModifierOp(ModifierOp_SineBreath, ModifierCondition_Always, breathParameters[i].ParameterId, ModifierRegister_BreathPhase, breathParameters[i].Peak, breathParameters[i].Weight);
+            _modifierProgram[_modifierProgram.GetSize() - 1].Offset = breathParameters[i].Offset;
+            _modifierProgram[_modifierProgram.GetSize() - 1].Cycle = breathParameters[i].Cycle;
+        }
     }
 
-    // 物理演算の設定
+    // 物理演算
     if (_physics != NULL)
     {
+        AddModifierOp(ModifierOp_UpdatePhysics, ModifierCondition_Always);
+    }
+
+    // リップシンク
+    AddModifierOp(ModifierOp_UpdateLipSync, ModifierCondition_LipSync);
+    for (csmUint32 i = 0; i < _lipSyncIds.GetSize(); ++i)
+    {
+        AddModifierOp(ModifierOp_AddScaled, ModifierCondition_LipSync, _lipSyncIds[i], ModifierRegister_LipSync, 1.0f, 0.8f);
+    }
+
+    // ポーズ
+    if (_pose != NULL)
+    {
+        AddModifierOp(ModifierOp_UpdatePose, ModifierCondition_Always);
+    }
+
+    _modifierOpMicroseconds.Clear();
+    _modifierOpMicroseconds.UpdateSize(_modifierProgram.GetSize(), 0.0f, false);
+    _modifierProfileFrames = 0;
+}
+
+void LAppModel::AddModifierOp(ModifierOpType type, ModifierCondition condition)
+{
+    AddModifierOp(type, condition, NULL, ModifierRegister_Count, 0.0f, 0.0f);
+}
+
+void LAppModel::AddModifierOp(ModifierOpType type, ModifierCondition condition, CubismIdHandle parameterId, ModifierRegister source, csmFloat32 scale, csmFloat32 weight)
+{
+    ModifierOp op;
+    op.Type = type;
+    op.Condition = condition;
+    op.ParameterId = parameterId;
+    op.ParameterIndex = (parameterId != NULL) ? _model->GetParameterIndex(parameterId) : -1;
+    op.Source = source;
+    op.Scale = scale;
+    op.Offset = 0.0f;
+    op.Cycle = 1.0f;
+    op.Weight = weight;
+
+    _modifierProgram.PushBack(op);
+}
+
+void LAppModel::ExecuteModifierOp(const ModifierOp& op, csmFloat32 deltaTimeSeconds, csmFloat32* registers, csmBool& motionUpdated)
+{
+    if ((op.Condition == ModifierCondition_NoMotionUpdated && motionUpdated)
+        || (op.Condition == ModifierCondition_LipSync && !_lipSync))
+    {
+        return;
+    }
+
+    csmFloat32 value;
+
+    switch (op.Type)
+    {
+    case ModifierOp_UpdateDrag:
+        _dragManager->Update(deltaTimeSeconds);
+        _dragX = _dragManager->GetX();
+        _dragY = _dragManager->GetY();
+        registers[ModifierRegister_DragX] = _dragX;
+        registers[ModifierRegister_DragY] = _dragY;
+        registers[ModifierRegister_DragXY] = _dragX * _dragY;
+        return;
+    case ModifierOp_UpdateMotion:
+        _model->LoadParameters(); // 前回セーブされた状態をロード
+        if (_motionManager->IsFinished())
+        {
+            // モーションの再生がない場合、待機モーションの中からランダムで再生する
+            StartRandomMotion(MotionGroupIdle, PriorityIdle);
+        }
+        else
+        {
+            motionUpdated = _motionManager->UpdateMotion(_model, deltaTimeSeconds); // モーションを更新
+        }
+        _model->SaveParameters(); // 状態を保存
+        return;
+    case ModifierOp_UpdateEyeBlink:
+        registers[ModifierRegister_EyeBlink] = _eyeBlink->UpdateValue(deltaTimeSeconds); // 目パチ
+        return;
+    case ModifierOp_UpdateExpression:
+        _expressionManager->UpdateMotion(_model, deltaTimeSeconds);
+        return;
+    case ModifierOp_UpdateBreath:
+        registers[ModifierRegister_BreathPhase] = _breath->UpdatePhase(deltaTimeSeconds);
+        return;
+    case ModifierOp_UpdatePhysics:
         _physics->Evaluate(_model, deltaTimeSeconds);
+        return;
+    case ModifierOp_UpdateLipSync:
+        registers[ModifierRegister_LipSync] = UpdateLipSyncValue(deltaTimeSeconds);
+        return;
+    case ModifierOp_UpdatePose:
+        _pose->UpdateParameters(_model, deltaTimeSeconds);
+        return;
+    case ModifierOp_AddScaled:
+        value = (registers[op.Source] * op.Scale) * op.Weight;
+        break;
+    case ModifierOp_SineBreath:
+        value = (op.Offset + (op.Scale * sinf(registers[op.Source] / op.Cycle))) * op.Weight;
+        break;
+    case ModifierOp_SetWeighted:
+        value = registers[op.Source];
+        break;
+    default:
+        return;
+    }
+
+    // 以降はパラメータを直接操作する命令
+    csmFloat32* parameterValues = Live2D::Cubism::Core::csmGetParameterValues(_model->GetModel());
+
+    // モデルに存在しないパラメータはCubismModelの管理領域を経由する
+    if (op.ParameterIndex >= _model->GetParameterCount())
+    {
+        if (op.Type == ModifierOp_SetWeighted)
+        {
+            _model->SetParameterValue(op.ParameterIndex, value, op.Weight);
+        }
+        else
+        {
+            _model->AddParameterValue(op.ParameterIndex, value);
+        }
+        return;
+    }
+
+#ifdef CSM_DEBUG
+    const csmFloat32 previousValue = parameterValues[op.ParameterIndex];
+#endif
+
+    csmFloat32 result = (op.Type == ModifierOp_SetWeighted) ? value : parameterValues[op.ParameterIndex] + value;
+
+    if (_model->GetParameterMaximumValue(op.ParameterIndex) < result)
+    {
+        result = _model->GetParameterMaximumValue(op.ParameterIndex);
+    }
+    if (_model->GetParameterMinimumValue(op.ParameterIndex) > result)
+    {
+        result = _model->GetParameterMinimumValue(op.ParameterIndex);
+    }
+
+    if (op.Type == ModifierOp_SetWeighted && op.Weight != 1.0f)
+    {
+        result = (parameterValues[op.ParameterIndex] * (1.0f - op.Weight)) + (result * op.Weight);
     }
 
-    // リップシンクの設定
-    if (_lipSync)
+#ifdef CSM_DEBUG
+    // 個別の関数で処理した場合と結果が一致することを確認する
+    if (op.Type == ModifierOp_SetWeighted)
     {
-        // リアルタイムでリップシンクを行う場合、システムから音量を取得して0〜1の範囲で値を入力します。
-        csmFloat32 value = 0.0f;
+        _model->SetParameterValue(op.ParameterIndex, value, op.Weight);
+    }
+    else
+    {
+        _model->AddParameterValue(op.ParameterIndex, value);
+    }
+    CSM_ASSERT(parameterValues[op.ParameterIndex] == result);
+    parameterValues[op.ParameterIndex] = previousValue;
+#endif
 
-        // 状態更新/RMS値取得
-        _wavFileHandler.Update(deltaTimeSeconds);
-        value = _wavFileHandler.GetRms();
+    parameterValues[op.ParameterIndex] = result;
+}
 
-        for (csmUint32 i = 0; i < _lipSyncIds.GetSize(); ++i)
+csmFloat32 LAppModel::UpdateLipSyncValue(csmFloat32 deltaTimeSeconds)
+{
+    // 状態更新/RMS値取得。外部から音声が与えられていれば大きい方を使う
+    _wavFileHandler.Update(deltaTimeSeconds);
+    _lipSyncEnvelope.Update(deltaTimeSeconds);
+    csmFloat32 value = (_lipSyncEnvelope.GetRms() > _wavFileHandler.GetRms()) ? _lipSyncEnvelope.GetRms() : _wavFileHandler.GetRms();
+    if (_audioLipSync != NULL)
+    {
+        const csmFloat32 audio = _audioLipSync->Update(deltaTimeSeconds);
+        if (audio > value)
         {
-            _model->AddParameterValue(_lipSyncIds[i], value, 0.8f);
+            value = audio;
         }
     }
+    return value;
+}
 
-    // ポーズの設定
-    if (_pose != NULL)
+void LAppModel::SetModifierProfiling(csmBool enabled)
+{
+    _isModifierProfiling = enabled;
+
+    for (csmUint32 i = 0; i < _modifierOpMicroseconds.GetSize(); ++i)
     {
-        _pose->UpdateParameters(_model, deltaTimeSeconds);
+        _modifierOpMicroseconds[i] = 0.0f;
+    }
+    _modifierProfileFrames = 0;
+}
+
+void LAppModel::PrintModifierProfile() const
+{
+    static const csmChar* OpNames[] =
+    {
+        "UpdateDrag", "UpdateMotion", "UpdateEyeBlink", "UpdateExpression", "UpdateBreath",
+        "UpdatePhysics", "UpdateLipSync", "UpdatePose", "AddScaled", "SetWeighted", "SineBreath"
+    };
+
+    if (_modifierProfileFrames == 0)
+    {
+        return;
+    }
+
+    for (csmUint32 i = 0; i < _modifierProgram.GetSize(); ++i)
+    {
+        const ModifierOp& op = _modifierProgram[i];
+        LAppPal::PrintLog("[APP]modifier %2u %-16s %-24s %8.2f us",
+                          i,
+                          OpNames[op.Type],
+                          (op.ParameterId != NULL) ? op.ParameterId->GetString().GetRawString() : "",
+                          _modifierOpMicroseconds[i] / _modifierProfileFrames);
     }
 }
 
 void LAppModel::Update()
 {
     _model->Update();
+    _hitTester.Update(*_model);
 }
 
 CubismMotionQueueEntryHandle LAppModel::StartMotion(const csmChar* group, csmInt32 no, csmInt32 priority, ACubismMotion::FinishedMotionCallback onFinishedMotionHandler)
@@ -471,7 +723,16 @@ CubismMotionQueueEntryHandle LAppModel::StartMotion(const csmChar* group, csmInt
     {
         csmString path = voice;
         path = _modelHomeDir + path;
-        _wavFileHandler.Start(path);
+
+        // 包絡線のファイルがあれば、wavファイルを読まずにそちらを再生する
+        if (_lipSyncEnvelope.Start(path))
+        {
+            _wavFileHandler.Stop();
+        }
+        else
+        {
+            _wavFileHandler.Start(path);
+        }
     }
 
     if (_debugMode)
@@ -503,6 +764,43 @@ void LAppModel::DoDraw()
     GetRenderer<Rendering::CubismRenderer_OpenGLES2>()->DrawModel();
 }
 
+csmBool LAppModel::DrawInstances(LAppModel* const* models, csmInt32 count, CubismMatrix44& projection)
+{
+    if (_model == NULL || count <= 0)
+    {
+        return false;
+    }
+
+    _instanceModels.Resize(0);
+    _instanceMatrices.Resize(0);
+    _instanceOpacities.Resize(0);
+
+    for (csmInt32 i = 0; i < count; ++i)
+    {
+        LAppModel* instance = models[i];
+
+        // オフスクリーンを経由して描くモデルはまとめられない
+        if (instance->_model == NULL
+            || instance->_isRenderCacheEnabled
+            || instance->_renderScaleController.IsAdaptive()
+            || instance->_renderScaleController.GetScale() < 1.0f)
+        {
+            return false;
+        }
+
+        CubismMatrix44 matrix;
+        matrix.SetMatrix(projection.GetArray());
+        matrix.MultiplyByMatrix(instance->_modelMatrix);
+
+        _instanceModels.PushBack(instance->_model, false);
+        _instanceMatrices.PushBack(matrix);
+        _instanceOpacities.PushBack(instance->GetOpacity(), false);
+    }
+
+    Rendering::CubismRenderer_OpenGLES2* renderer = GetRenderer<Rendering::CubismRenderer_OpenGLES2>();
+    return renderer->DrawInstances(_instanceModels.GetPtr(), _instanceMatrices.GetPtr(), _instanceOpacities.GetPtr(), count);
+}
+
 void LAppModel::Draw(CubismMatrix44& matrix, int w, int h)
 {
     if (_model == NULL)
@@ -512,29 +810,292 @@ void LAppModel::Draw(CubismMatrix44& matrix, int w, int h)
 
     matrix.MultiplyByMatrix(_modelMatrix);
 
-    GetRenderer<Rendering::CubismRenderer_OpenGLES2>()->SetMvpMatrix(&matrix);
-    GetRenderer<Rendering::CubismRenderer_OpenGLES2>()->SetViewport(w, h);
+    Rendering::CubismRenderer_OpenGLES2* renderer = GetRenderer<Rendering::CubismRenderer_OpenGLES2>();
+    renderer->SetMvpMatrix(&matrix);
+
+    // 解像度の倍率を決める
+    // アプリのフレーム時間は他のモデルの描画や垂直同期の待ちを含むので、前回このモデルを描くのにかかった時間を使う
+    if (_renderScaleController.IsAdaptive())
+    {
+        _renderScaleController.Update(_lastDrawSeconds);
+    }
+    const csmFloat32 renderScale = _renderScaleController.GetScale();
+    if (renderScale != _appliedRenderScale)
+    {
+        ApplyRenderScale(renderScale);
+    }
+
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    DrawScaled(matrix, w, h, renderScale);
+    _lastDrawSeconds = std::chrono::duration<csmFloat32>(std::chrono::steady_clock::now() - begin).count();
+}
+
+void LAppModel::DrawScaled(CubismMatrix44& matrix, int w, int h, csmFloat32 renderScale)
+{
+    Rendering::CubismRenderer_OpenGLES2* renderer = GetRenderer<Rendering::CubismRenderer_OpenGLES2>();
+
+    _isRenderCacheHit = false;
+    if (!_isRenderCacheEnabled && renderScale >= 1.0f)
+    {
+        renderer->SetViewport(w, h);
+        DoDraw();
+        return;
+    }
+
+    // オフスクリーンに倍率を掛けた大きさで描き、画面の大きさに拡大して貼る
+    int renderWidth = static_cast<int>(w * renderScale + 0.5f);
+    int renderHeight = static_cast<int>(h * renderScale + 0.5f);
+    if (renderWidth < 1) renderWidth = 1;
+    if (renderHeight < 1) renderHeight = 1;
+    renderer->SetViewport(renderWidth, renderHeight);
+
+    if (_isRenderCacheEnabled && IsRenderCacheUsable(matrix, renderWidth, renderHeight))
+    {
+        _isRenderCacheHit = true;
+    }
+    else
+    {
+        UpdateRenderCache(matrix, renderWidth, renderHeight);
+    }
+
+    DrawRenderCache(w, h);
+}
+
+csmBool LAppModel::IsRenderCacheUsable(CubismMatrix44& matrix, int w, int h)
+{
+    if (!_isRenderCacheValid
+        || _renderCache.GetBufferWidth() != static_cast<csmUint32>(w)
+        || _renderCache.GetBufferHeight() != static_cast<csmUint32>(h))
+    {
+        return false;
+    }
+
+    const csmFloat32* array = matrix.GetArray();
+    for (csmInt32 i = 0; i < 16; i++)
+    {
+        if (CubismMath::AbsF(array[i] - _renderCacheMatrix[i]) > _renderCacheThreshold)
+        {
+            return false;
+        }
+    }
+
+    // 見た目に関わる変化が何もなければそのまま使える
+    csmBool isChanged = false;
+    for (csmInt32 i = 0; i < _model->GetDrawableCount() && !isChanged; i++)
+    {
+        isChanged = _model->GetDrawableDynamicFlagVertexPositionsDidChange(i)
+            || _model->GetDrawableDynamicFlagOpacityDidChange(i)
+            || _model->GetDrawableDynamicFlagVisibilityDidChange(i)
+            || _model->GetDrawableDynamicFlagDrawOrderDidChange(i)
+            || _model->GetDrawableDynamicFlagRenderOrderDidChange(i)
+            || _model->GetDrawableDynamicFlagBlendColorDidChange(i);
+    }
+    if (!isChanged)
+    {
+        return true;
+    }
+
+    // 呼吸などで僅かに動き続けている場合は、キャッシュを描いたときからの変化量で判定する
+    // パラメータは範囲が-30..30の角度も0..1の開閉もあるので、変化量を範囲に対する割合にして比べる
+    for (csmInt32 i = 0; i < _model->GetParameterCount(); i++)
+    {
+        const csmFloat32 range = _model->GetParameterMaximumValue(i) - _model->GetParameterMinimumValue(i);
+        if (CubismMath::AbsF(_model->GetParameterValue(i) - _renderCacheParameters[i]) > _renderCacheThreshold * range)
+        {
+            return false;
+        }
+    }
+    for (csmInt32 i = 0; i < _model->GetPartCount(); i++)
+    {
+        if (CubismMath::AbsF(_model->GetPartOpacity(i) - _renderCachePartOpacities[i]) > _renderCacheThreshold)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void LAppModel::UpdateRenderCache(CubismMatrix44& matrix, int w, int h)
+{
+    Rendering::CubismRenderer_OpenGLES2* renderer = GetRenderer<Rendering::CubismRenderer_OpenGLES2>();
+
+    if (!_renderCache.IsValid()
+        || _renderCache.GetBufferWidth() != static_cast<csmUint32>(w)
+        || _renderCache.GetBufferHeight() != static_cast<csmUint32>(h))
+    {
+        _renderCache.CreateOffscreenFrame(w, h);
+
+        // 縮小して描いた場合は拡大して貼るので、バイリニアで補間させる
+        rlTextureParameters(_renderCache.GetColorBuffer(), RL_TEXTURE_MIN_FILTER, RL_TEXTURE_FILTER_LINEAR);
+        rlTextureParameters(_renderCache.GetColorBuffer(), RL_TEXTURE_MAG_FILTER, RL_TEXTURE_FILTER_LINEAR);
+    }
+
+    // raylibのバッチに溜まっている描画は、描画先を切り替える前に流しておく
+    rlDrawRenderBatchActive();
+
+    _renderCache.BeginDraw(0);
+    _renderCache.Clear(0.0f, 0.0f, 0.0f, 0.0f);
+    renderer->SetRenderTarget(_renderCache.GetRenderTexture());
 
     DoDraw();
+
+    renderer->SetRenderTarget(0);
+    _renderCache.EndDraw();
+
+    _isRenderCacheValid = _isRenderCacheEnabled;
+    if (!_isRenderCacheEnabled)
+    {
+        return; // 解像度を下げるためだけに使っている場合は、判定用の状態はいらない
+    }
+
+    memcpy(_renderCacheMatrix, matrix.GetArray(), sizeof(_renderCacheMatrix));
+
+    _renderCacheParameters.Resize(0);
+    for (csmInt32 i = 0; i < _model->GetParameterCount(); i++)
+    {
+        _renderCacheParameters.PushBack(_model->GetParameterValue(i), false);
+    }
+
+    _renderCachePartOpacities.Resize(0);
+    for (csmInt32 i = 0; i < _model->GetPartCount(); i++)
+    {
+        _renderCachePartOpacities.PushBack(_model->GetPartOpacity(i), false);
+    }
+}
+
+void LAppModel::DrawRenderCache(int w, int h)
+{
+    // キャッシュは乗算済みアルファで描かれている
+    // オフスクリーンのテクスチャは上下が逆なので、UVを反転して貼る
+    rlDrawRenderBatchActive();
+    rlSetBlendMode(RL_BLEND_ALPHA_PREMULTIPLY);
+    rlSetTexture(_renderCache.GetColorBuffer());
+    rlBegin(RL_QUADS);
+    rlColor4ub(255, 255, 255, 255);
+    rlTexCoord2f(0.0f, 1.0f);
+    rlVertex2f(0.0f, 0.0f);
+    rlTexCoord2f(0.0f, 0.0f);
+    rlVertex2f(0.0f, static_cast<float>(h));
+    rlTexCoord2f(1.0f, 0.0f);
+    rlVertex2f(static_cast<float>(w), static_cast<float>(h));
+    rlTexCoord2f(1.0f, 1.0f);
+    rlVertex2f(static_cast<float>(w), 0.0f);
+    rlEnd();
+    rlSetTexture(0);
+    rlDrawRenderBatchActive();
+    rlSetBlendMode(RL_BLEND_ALPHA);
 }
 
 csmBool LAppModel::HitTest(const csmChar* hitAreaName, csmFloat32 x, csmFloat32 y)
+{
+    return HitTestArea(GetHitAreaIndex(hitAreaName), x, y); // 存在しない場合はfalse
+}
+
+csmBool LAppModel::HitTestArea(csmInt32 hitAreaIndex, csmFloat32 x, csmFloat32 y)
 {
     // 透明時は当たり判定なし。
     if (_opacity < 1)
     {
         return false;
     }
-    const csmInt32 count = _modelSetting->GetHitAreasCount();
-    for (csmInt32 i = 0; i < count; i++)
+    if (hitAreaIndex < 0 || static_cast<csmUint32>(hitAreaIndex) >= _hitAreaDrawableIndices.GetSize())
+    {
+        return false;
+    }
+    return _hitTester.IsHit(*_model, _hitAreaDrawableIndices[hitAreaIndex], _modelMatrix->InvertTransformX(x), _modelMatrix->InvertTransformY(y));
+}
+
+csmInt32 LAppModel::HitTestAll(csmFloat32 x, csmFloat32 y, csmInt32* outIndices, csmInt32 capacity)
+{
+    // 透明時は当たり判定なし。
+    if (_opacity < 1)
+    {
+        return 0;
+    }
+
+    const csmFloat32 tx = _modelMatrix->InvertTransformX(x);
+    const csmFloat32 ty = _modelMatrix->InvertTransformY(y);
+
+    // 書き先が足りなくても数え続け、足りなかったことを戻り値で知らせる
+    csmInt32 count = 0;
+    for (csmUint32 i = 0; i < _hitAreaDrawableIndices.GetSize(); i++)
+    {
+        if (_hitTester.IsHit(*_model, _hitAreaDrawableIndices[i], tx, ty))
+        {
+            if (outIndices != NULL && count < capacity)
+            {
+                outIndices[count] = static_cast<csmInt32>(i);
+            }
+            count++;
+        }
+    }
+    return count;
+}
+
+csmInt32 LAppModel::GetHitAreaCount() const
+{
+    return _modelSetting->GetHitAreasCount();
+}
+
+csmInt32 LAppModel::GetHitAreaIndex(const csmChar* hitAreaName) const
+{
+    if (hitAreaName == NULL)
+    {
+        return -1;
+    }
+
+    csmString name(hitAreaName);
+    const csmInt32 hash = name.GetHashcode();
+    for (csmUint32 i = 0; i < _hitAreaNameHashes.GetSize(); i++)
+    {
+        if (_hitAreaNameHashes[i] == hash && strcmp(_modelSetting->GetHitAreaName(i), hitAreaName) == 0)
+        {
+            return static_cast<csmInt32>(i);
+        }
+    }
+    return -1;
+}
+
+const csmChar* LAppModel::GetHitAreaName(csmInt32 index) const
+{
+    if (index < 0 || index >= _modelSetting->GetHitAreasCount())
+    {
+        return NULL;
+    }
+    return _modelSetting->GetHitAreaName(index);
+}
+
+CubismAudioLipSync* LAppModel::GetAudioLipSync() const
+{
+    return _audioLipSync;
+}
+
+void LAppModel::SetHitTestAlphaThreshold(csmFloat32 threshold)
+{
+    _hitTester.SetAlphaThreshold(threshold);
+    if (threshold <= 0.0f)
+    {
+        return;
+    }
+
+    for (csmInt32 modelTextureNumber = 0; modelTextureNumber < _modelSetting->GetTextureCount(); modelTextureNumber++)
     {
-        if (strcmp(_modelSetting->GetHitAreaName(i), hitAreaName) == 0)
+        if (strcmp(_modelSetting->GetTextureFileName(modelTextureNumber), "") == 0)
+        {
+            continue;
+        }
+
+        csmString texturePath = _modelSetting->GetTextureFileName(modelTextureNumber);
+        texturePath = _modelHomeDir + texturePath;
+
+        // 読み込み済みのテクスチャが返る
+        LAppTextureManager::TextureInfo* texture = LAppTextureManager::GetInstance()->CreateTextureFromPngFile(texturePath.GetRawString());
+        if (texture == NULL || !LAppTextureManager::GetInstance()->LoadTextureAlpha(texture))
         {
-            const CubismIdHandle drawID = _modelSetting->GetHitAreaId(i);
-            return IsHit(drawID, x, y);
+            continue;
         }
+        _hitTester.SetTextureAlpha(modelTextureNumber, texture->alpha.GetPtr(), texture->width, texture->height);
     }
-    return false; // 存在しない場合はfalse
 }
 
 void LAppModel::SetExpression(const csmChar* expressionID)
@@ -579,6 +1140,9 @@ void LAppModel::SetRandomExpression()
 
 void LAppModel::ReloadRenderer()
 {
+    _isRenderCacheValid = false;
+    _appliedRenderScale = 1.0f; // 作り直したレンダラのマスクのバッファは既定の大きさに戻る
+
     DeleteRenderer();
 
     CreateRenderer();
@@ -620,6 +1184,103 @@ void LAppModel::MotionEventFired(const csmString& eventValue)
     CubismLogInfo("%s is fired on LAppModel!!", eventValue.GetRawString());
 }
 
+void LAppModel::SetPhysicsQuality(csmFloat32 quality)
+{
+    if (_physics != NULL)
+    {
+        _physics->SetQuality(quality);
+    }
+}
+
+void LAppModel::StabilizePhysics(csmFloat32 seconds)
+{
+    if (_physics != NULL)
+    {
+        _physics->Stabilize(_model, seconds);
+    }
+}
+
+csmBool LAppModel::SavePhysicsState(CubismPhysics::State& state) const
+{
+    if (_physics == NULL)
+    {
+        return false;
+    }
+
+    _physics->SaveState(state);
+    return true;
+}
+
+csmBool LAppModel::RestorePhysicsState(const CubismPhysics::State& state)
+{
+    if (_physics == NULL)
+    {
+        return false;
+    }
+
+    return _physics->RestoreState(state);
+}
+
+void LAppModel::SetRenderCacheEnabled(csmBool enabled, csmFloat32 threshold)
+{
+    _isRenderCacheEnabled = enabled;
+    _isRenderCacheValid = false;
+    _renderCacheThreshold = threshold;
+
+    if (!enabled)
+    {
+        _renderCache.DestroyOffscreenFrame();
+    }
+}
+
+csmBool LAppModel::IsRenderCacheHit() const
+{
+    return _isRenderCacheHit;
+}
+
+void LAppModel::SetRenderScale(csmFloat32 scale)
+{
+    _renderScaleController.SetScale(scale);
+}
+
+void LAppModel::SetAdaptiveRenderScale(csmFloat32 targetFrameTime, csmFloat32 minScale, csmFloat32 maxScale)
+{
+    _renderScaleController.SetTarget(targetFrameTime, minScale, maxScale);
+}
+
+const LAppRenderScaleController::Statistics& LAppModel::GetRenderScaleStatistics() const
+{
+    return _renderScaleController.GetStatistics();
+}
+
+void LAppModel::ApplyRenderScale(csmFloat32 scale)
+{
+    Rendering::CubismRenderer_OpenGLES2* renderer = GetRenderer<Rendering::CubismRenderer_OpenGLES2>();
+
+    _appliedRenderScale = scale;
+    _isRenderCacheValid = false;
+
+    // マスクを使わないモデルにはマスクのバッファがない
+    if (renderer->GetMaskBufferCount() == 0)
+    {
+        return;
+    }
+
+    if (_baseMaskBufferSize.X <= 0.0f)
+    {
+        _baseMaskBufferSize = renderer->GetClippingMaskBufferSize();
+    }
+
+    // 画面上のマスクも同じ倍率で小さくなるので、バッファも合わせて縮める
+    // 作り直しは重いので、倍率は段階的にしか変わらない
+    const csmFloat32 width = CubismMath::Max(MinMaskBufferSize, ceilf(_baseMaskBufferSize.X * scale / 16.0f) * 16.0f);
+    const csmFloat32 height = CubismMath::Max(MinMaskBufferSize, ceilf(_baseMaskBufferSize.Y * scale / 16.0f) * 16.0f);
+    if (width != renderer->GetClippingMaskBufferSize().X || height != renderer->GetClippingMaskBufferSize().Y)
+    {
+        renderer->SetClippingMaskBufferSize(width, height);
+    }
+}
+
 Csm::Rendering::CubismOffscreenFrame_OpenGLES2& LAppModel::GetRenderBuffer()
 {
     return _renderBuffer;
@@ -11,9 +11,13 @@
 #include <Model/CubismUserModel.hpp>
 #include <ICubismModelSetting.hpp>
 #include <Type/csmRectF.hpp>
+#include <Effect/CubismAudioLipSync.hpp>
 #include <Rendering/Raylib/CubismOffscreenSurface_OpenGLES2.hpp>
 
 #include "LAppWavFileHandler.hpp"
+#include "LAppLipSyncEnvelope.hpp"
+#include "LAppRenderScaleController.hpp"
+#include "LAppHitTester.hpp"
 
 /**
  * @brief ユーザーが実際に使用するモデルの実装クラス<br>
@@ -46,8 +50,30 @@ public:
      */
     void ReloadRenderer();
 
+    /**
+     * @brief   モデルのパラメータを更新する。
+     *           CompileModifierProgramで作成した命令列を実行する。
+     */
     void PreUpdate();
 
+    /**
+     * @brief   PreUpdateで実行する命令列を作成する。<br>
+     *           まばたき、呼吸、物理演算などの構成を変更した場合は再度呼び出す。
+     */
+    void CompileModifierProgram();
+
+    /**
+     * @brief   命令ごとの処理時間の計測を切り替える。
+     *
+     * @param[in]   enabled     trueで計測する
+     */
+    void SetModifierProfiling(Csm::csmBool enabled);
+
+    /**
+     * @brief   命令ごとの平均処理時間をログに出力する。
+     */
+    void PrintModifierProfile() const;
+
     /**
      * @brief   モデルの更新処理。モデルのパラメータから描画状態を決定する。
      *
@@ -61,6 +87,18 @@ public:
      */
     void Draw(Csm::CubismMatrix44& matrix, int w, int h);
 
+    /**
+     * @brief   同じモデルデータから作った複数のモデルを、このモデルのレンダラでまとめて描画する。<br>
+     *           描画命令の数はDrawableの数だけで済む。描画順・テクスチャはこのモデルのものを使う。
+     *
+     * @param[in]   models      描画するモデルの配列。Updateを済ませておくこと
+     * @param[in]   count       モデルの数
+     * @param[in]   projection  View-Projection行列
+     * @return  まとめて描画できなかった場合はfalse。マスク・描画結果のキャッシュ・解像度の倍率を使うモデルや、
+     *          構成の異なるモデルが含まれる場合が該当する。呼び出し側で1体ずつDrawすること
+     */
+    Csm::csmBool DrawInstances(LAppModel* const* models, Csm::csmInt32 count, Csm::CubismMatrix44& projection);
+
     /**
      * @brief   引数で指定したモーションの再生を開始する。
      *
@@ -103,7 +141,8 @@ public:
 
     /**
      * @brief    当たり判定テスト。<br>
-     *            指定IDの頂点リストから矩形を計算し、座標が矩形範囲内か判定する。
+     *            指定IDのDrawableの三角形のいずれかに座標が含まれるか判定する。
+     *            名前を番号に引いてからHitTestAreaで判定する。毎フレーム判定する場合はGetHitAreaIndexで引いた番号を使うこと。
      *
      * @param[in]   hitAreaName     当たり判定をテストする対象のID
      * @param[in]   x               判定を行うX座標
@@ -111,6 +150,132 @@ public:
      */
     virtual Csm::csmBool HitTest(const Csm::csmChar* hitAreaName, Csm::csmFloat32 x, Csm::csmFloat32 y);
 
+    /**
+     * @brief   番号で指定した当たり判定のDrawableの三角形のいずれかに座標が含まれるか判定する。
+     *
+     * @param[in]   hitAreaIndex    モデルセッティングの当たり判定の番号
+     * @param[in]   x               判定を行うX座標
+     * @param[in]   y               判定を行うY座標
+     * @return  含まれればtrue。番号が範囲外か、Drawableが存在しなければfalse
+     */
+    Csm::csmBool HitTestArea(Csm::csmInt32 hitAreaIndex, Csm::csmFloat32 x, Csm::csmFloat32 y);
+
+    /**
+     * @brief   当たり判定でテクスチャのアルファを見るかを設定する。<br>
+     *           有効にすると、テクスチャを読み直してアルファの写しを保持する。
+     *
+     * @param[in]   threshold   当たりにするアルファの下限(0.0～1.0)。0ならアルファを見ない
+     */
+    void SetHitTestAlphaThreshold(Csm::csmFloat32 threshold);
+
+    /**
+     * @brief   全ての当たり判定を一度に判定する。
+     *
+     * @param[in]   x           判定を行うX座標
+     * @param[in]   y           判定を行うY座標
+     * @param[out]  outIndices  座標を含む当たり判定の番号を小さい順に書く先。capacity個まで書く
+     * @param[in]   capacity    outIndicesに書ける数
+     * @return  座標を含む当たり判定の数。capacityより大きければ、書ききれなかった当たり判定がある
+     */
+    Csm::csmInt32 HitTestAll(Csm::csmFloat32 x, Csm::csmFloat32 y, Csm::csmInt32* outIndices, Csm::csmInt32 capacity);
+
+    /**
+     * @brief   当たり判定の数を取得する。
+     */
+    Csm::csmInt32 GetHitAreaCount() const;
+
+    /**
+     * @brief   当たり判定の名前から番号を取得する。
+     *
+     * @param[in]   hitAreaName     当たり判定の名前
+     * @return  モデルセッティングの当たり判定の番号。存在しなければ-1
+     */
+    Csm::csmInt32 GetHitAreaIndex(const Csm::csmChar* hitAreaName) const;
+
+    /**
+     * @brief   当たり判定の名前を取得する。
+     *
+     * @param[in]   index   当たり判定の番号
+     */
+    const Csm::csmChar* GetHitAreaName(Csm::csmInt32 index) const;
+
+    /**
+     * @brief   外部から音声を与えるリップシンクを取得する。<br>
+     *           音声スレッドからPushしてよい。wavファイルの再生と同時に使った場合は大きい方の音量で口を動かす。
+     *
+     * @return  モデルにリップシンクのパラメータがなければNULL
+     */
+    Csm::CubismAudioLipSync* GetAudioLipSync() const;
+
+    /**
+     * @brief   物理演算の品質を設定する。
+     *
+     * @param[in]   quality     品質(0.0～1.0)。1.0で通常の評価、0.0で補間のみ
+     */
+    void SetPhysicsQuality(Csm::csmFloat32 quality);
+
+    /**
+     * @brief   物理演算だけを指定時間進めて振り子を落ち着かせる。
+     *
+     * @param[in]   seconds     進める時間[秒]
+     */
+    void StabilizePhysics(Csm::csmFloat32 seconds);
+
+    /**
+     * @brief   物理演算の状態を保存する。
+     *
+     * @param[out]  state   保存先
+     * @return  物理演算がない場合はfalse
+     */
+    Csm::csmBool SavePhysicsState(Csm::CubismPhysics::State& state) const;
+
+    /**
+     * @brief   物理演算の状態を復元する。
+     *
+     * @param[in]   state   SavePhysicsStateで保存した状態
+     * @return  復元できなかった場合はfalse
+     */
+    Csm::csmBool RestorePhysicsState(const Csm::CubismPhysics::State& state);
+
+    /**
+     * @brief   描画結果のキャッシュを切り替える。<br>
+     *           有効にすると、モデルをオフスクリーンに描いておき、前回から変化がなければその画像を画面に貼るだけで済ませる。<br>
+     *           加算・乗算の合成は背景ではなく透明なキャッシュに対して行われる点に注意。
+     *
+     * @param[in]   enabled     trueで有効
+     * @param[in]   threshold   描き直さずに済ませる変化量の上限。パラメータは範囲（最大値 - 最小値）に対する割合、<br>
+     *                          パーツ不透明度はそのままの値、MVP行列はクリップ空間での各要素の差で比べる
+     */
+    void SetRenderCacheEnabled(Csm::csmBool enabled, Csm::csmFloat32 threshold);
+
+    /**
+     * @brief   直前のDrawでキャッシュを使い、モデルを描かずに済ませたかを取得する。
+     */
+    Csm::csmBool IsRenderCacheHit() const;
+
+    /**
+     * @brief   モデルを描く解像度の倍率を固定する。<br>
+     *           1.0未満ならオフスクリーンに縮小して描き、拡大して画面に貼る。マスクのバッファも倍率に合わせて縮める。
+     *
+     * @param[in]   scale   倍率(0.0～1.0)
+     */
+    void SetRenderScale(Csm::csmFloat32 scale);
+
+    /**
+     * @brief   このモデルを描く時間が目標に収まるよう、解像度の倍率を自動で調整する。<br>
+     *           時間はDrawの中でモデルを描く呼び出しにかかったCPU時間を測る。他のモデルの描画や垂直同期の待ちは含まない。
+     *
+     * @param[in]   targetFrameTime     このモデルを描くCPU時間の目標[秒]。0以下なら自動調整をやめ、現在の倍率で固定する
+     * @param[in]   minScale            倍率の最小値
+     * @param[in]   maxScale            倍率の最大値
+     */
+    void SetAdaptiveRenderScale(Csm::csmFloat32 targetFrameTime, Csm::csmFloat32 minScale, Csm::csmFloat32 maxScale);
+
+    /**
+     * @brief   解像度の倍率の調整状態と、このモデルを描いた時間を取得する。
+     */
+    const LAppRenderScaleController::Statistics& GetRenderScaleStatistics() const;
+
     /**
      * @brief   別ターゲットに描画する際に使用するバッファの取得
      */
@@ -124,6 +289,128 @@ protected:
     void DoDraw();
 
 private:
+    /**
+     * @brief   PreUpdateの命令の種類
+     */
+    enum ModifierOpType
+    {
+        ModifierOp_UpdateDrag,          ///< ドラッグの更新。ドラッグ量をレジスタに設定する
+        ModifierOp_UpdateMotion,        ///< パラメータのロード、モーションの更新、パラメータのセーブ
+        ModifierOp_UpdateEyeBlink,      ///< まばたきのエンベロープを進め、値をレジスタに設定する
+        ModifierOp_UpdateExpression,    ///< 表情の更新
+        ModifierOp_UpdateBreath,        ///< 呼吸の位相をレジスタに設定する
+        ModifierOp_UpdatePhysics,       ///< 物理演算
+        ModifierOp_UpdateLipSync,       ///< 音量をレジスタに設定する
+        ModifierOp_UpdatePose,          ///< ポーズ
+        ModifierOp_AddScaled,           ///< パラメータに「レジスタ×倍率×重み」を加える
+        ModifierOp_SetWeighted,         ///< パラメータにレジスタの値を重み付きで設定する
+        ModifierOp_SineBreath           ///< パラメータに呼吸の正弦波を加える
+    };
+
+    /**
+     * @brief   PreUpdateの命令が参照するレジスタ
+     */
+    enum ModifierRegister
+    {
+        ModifierRegister_DragX,
+        ModifierRegister_DragY,
+        ModifierRegister_DragXY,
+        ModifierRegister_EyeBlink,
+        ModifierRegister_BreathPhase,
+        ModifierRegister_LipSync,
+        ModifierRegister_Count
+    };
+
+    /**
+     * @brief   PreUpdateの命令の実行条件
+     */
+    enum ModifierCondition
+    {
+        ModifierCondition_Always,           ///< 常に実行する
+        ModifierCondition_NoMotionUpdated,  ///< モーションによるパラメータ更新がなかった場合に実行する
+        ModifierCondition_LipSync           ///< リップシンクが有効な場合に実行する
+    };
+
+    /**
+     * @brief   PreUpdateの命令。パラメータはインデックスで解決済み。
+     */
+    struct ModifierOp
+    {
+        ModifierOpType Type;                ///< 命令の種類
+        ModifierCondition Condition;        ///< 実行条件
+        Csm::CubismIdHandle ParameterId;    ///< 対象のパラメータID(ログ用)
+        Csm::csmInt32 ParameterIndex;       ///< 対象のパラメータのインデックス
+        ModifierRegister Source;            ///< 入力のレジスタ
+        Csm::csmFloat32 Scale;              ///< 入力に掛ける倍率。呼吸では振幅
+        Csm::csmFloat32 Offset;             ///< 呼吸のオフセット
+        Csm::csmFloat32 Cycle;              ///< 呼吸の周期
+        Csm::csmFloat32 Weight;             ///< 重み
+    };
+
+    /**
+     * @brief   命令を末尾に追加する。
+     */
+    void AddModifierOp(ModifierOpType type, ModifierCondition condition);
+
+    /**
+     * @brief   パラメータを操作する命令を末尾に追加する。
+     */
+    void AddModifierOp(ModifierOpType type, ModifierCondition condition, Csm::CubismIdHandle parameterId, ModifierRegister source, Csm::csmFloat32 scale, Csm::csmFloat32 weight);
+
+    /**
+     * @brief   命令を1つ実行する。
+     *
+     * @param[in]       op                  命令
+     * @param[in]       deltaTimeSeconds    デルタ時間[秒]
+     * @param[in,out]   registers           レジスタ
+     * @param[in,out]   motionUpdated       モーションによるパラメータ更新の有無
+     */
+    void ExecuteModifierOp(const ModifierOp& op, Csm::csmFloat32 deltaTimeSeconds, Csm::csmFloat32* registers, Csm::csmBool& motionUpdated);
+
+    /**
+     * @brief   リップシンクの音源を進め、口の開きに使う値を返す。
+     *
+     * @param[in]   deltaTimeSeconds    デルタ時間[秒]
+     * @return  wavファイル・包絡線・外部から与えられた音声のうち大きい値
+     */
+    Csm::csmFloat32 UpdateLipSyncValue(Csm::csmFloat32 deltaTimeSeconds);
+
+    /**
+     * @brief   キャッシュした描画結果をそのまま使えるか判定する。<br>
+     *           Drawableの変化フラグが立っていなければ使える。立っていても、キャッシュを描いたときからの<br>
+     *           パラメータの範囲に対する変化の割合と、パーツ不透明度の変化が閾値以下なら使える。
+     *
+     * @param[in]   matrix  今回のMVP行列
+     * @param[in]   w       ビューポートの幅
+     * @param[in]   h       ビューポートの高さ
+     */
+    Csm::csmBool IsRenderCacheUsable(Csm::CubismMatrix44& matrix, int w, int h);
+
+    /**
+     * @brief   モデルをキャッシュに描き、判定に使う状態を保存する。
+     */
+    void UpdateRenderCache(Csm::CubismMatrix44& matrix, int w, int h);
+
+    /**
+     * @brief   キャッシュを現在のフレームバッファに貼る。
+     */
+    void DrawRenderCache(int w, int h);
+
+    /**
+     * @brief   解像度の倍率の変更をマスクのバッファに反映する。
+     */
+    void ApplyRenderScale(Csm::csmFloat32 scale);
+
+    /**
+     * @brief   決めた解像度の倍率でモデルを描く。倍率が1.0未満か、キャッシュが有効ならオフスクリーンを経由する。
+     *
+     * @param[in]   matrix      MVP行列
+     * @param[in]   w           画面の幅
+     * @param[in]   h           画面の高さ
+     * @param[in]   renderScale 解像度の倍率
+     */
+    void DrawScaled(Csm::CubismMatrix44& matrix, int w, int h, Csm::csmFloat32 renderScale);
+
     /**
      * @brief model3.jsonからモデルを生成する。<br>
      *         model3.jsonの記述に従ってモデル生成、モーション、物理演算などのコンポーネント生成を行う。
@@ -186,8 +473,37 @@ private:
     const Csm::CubismId* _idParamEyeBallY; ///< パラメータID: ParamEyeBallXY
 
     LAppWavFileHandler _wavFileHandler; ///< wavファイルハンドラ
+    LAppLipSyncEnvelope _lipSyncEnvelope; ///< 事前に計算した音量の包絡線。あればwavファイルの代わりに使う
+    Csm::CubismAudioLipSync* _audioLipSync; ///< 外部から与えられる音声によるリップシンク
+
+    LAppHitTester _hitTester; ///< 三角形単位の当たり判定
+    Csm::csmVector<Csm::csmInt32> _hitAreaDrawableIndices; ///< 当たり判定ごとのDrawableのインデックス。存在しなければ-1
+    Csm::csmVector<Csm::csmInt32> _hitAreaNameHashes; ///< 当たり判定ごとの名前のハッシュコード
+
+    Csm::csmVector<ModifierOp> _modifierProgram; ///< PreUpdateで実行する命令列
+    Csm::csmVector<Csm::csmFloat32> _modifierOpMicroseconds; ///< 命令ごとの処理時間の積算値[マイクロ秒]
+    Csm::csmInt32 _modifierProfileFrames; ///< 処理時間を積算したフレーム数
+    Csm::csmBool _isModifierProfiling; ///< 命令ごとの処理時間を計測するか
 
     Csm::Rendering::CubismOffscreenFrame_OpenGLES2  _renderBuffer;   ///< フレームバッファ以外の描画先
+
+    Csm::Rendering::CubismOffscreenFrame_OpenGLES2  _renderCache;   ///< 描画結果のキャッシュ
+    Csm::csmBool _isRenderCacheEnabled; ///< 描画結果のキャッシュを使うか
+    Csm::csmBool _isRenderCacheValid; ///< _renderCacheに描いたモデルがそのまま使えるか
+    Csm::csmBool _isRenderCacheHit; ///< 直前のDrawでキャッシュを使ったか
+    Csm::csmFloat32 _renderCacheThreshold; ///< 描き直さずに済ませる変化量の上限。パラメータは範囲に対する割合
+    Csm::csmFloat32 _renderCacheMatrix[16]; ///< キャッシュを描いたときのMVP行列
+    Csm::csmVector<Csm::csmFloat32> _renderCacheParameters; ///< キャッシュを描いたときのパラメータの値
+    Csm::csmVector<Csm::csmFloat32> _renderCachePartOpacities; ///< キャッシュを描いたときのパーツ不透明度
+
+    LAppRenderScaleController _renderScaleController; ///< 解像度の倍率の調整
+    Csm::csmFloat32 _appliedRenderScale; ///< マスクのバッファに反映済みの倍率
+    Csm::csmFloat32 _lastDrawSeconds; ///< 前回のDrawでこのモデルを描くのにかかったCPU時間[秒]
+    Csm::CubismVector2 _baseMaskBufferSize; ///< 倍率1.0のときのマスクのバッファの大きさ
+
+    Csm::csmVector<const Csm::CubismModel*> _instanceModels; ///< DrawInstancesでレンダラに渡すモデル
+    Csm::csmVector<Csm::CubismMatrix44> _instanceMatrices; ///< DrawInstancesでレンダラに渡すMVP行列
+    Csm::csmVector<Csm::csmFloat32> _instanceOpacities; ///< DrawInstancesでレンダラに渡す不透明度
 };
 
 
@@ -77,7 +77,11 @@ void LAppPal::PrintLog(const csmChar* format, ...)
     va_list args;
     csmChar buf[256];
     va_start(args, format);
+#ifdef _WINDOWS
     vsnprintf_s(buf, sizeof(buf), format, args); // 標準出力でレンダリング
+#else
+    vsnprintf(buf, sizeof(buf), format, args);
+#endif
 #ifdef CSM_DEBUG_MEMORY_LEAKING
 // メモリリークチェック時は大量の標準出力がはしり重いのでprintfを利用する
     std::printf(buf);
@@ -0,0 +1,120 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+#include "LAppRenderScaleController.hpp"
+#include <Math/CubismMath.hpp>
+
+using namespace Csm;
+
+namespace {
+const csmFloat32 ScaleStep = 1.0f / 16.0f;      ///< 倍率の刻み。変えるたびにバッファを作り直すので細かくしない
+const csmFloat32 AverageRate = 0.1f;            ///< フレーム時間の移動平均に新しい値を混ぜる割合
+const csmInt32 AdjustInterval = 30;             ///< 倍率を変えてから次に変えるまでの最小フレーム数
+const csmFloat32 OverBudgetRatio = 1.05f;       ///< 平均が目標のこの倍を超えたら倍率を下げる
+const csmFloat32 UnderBudgetRatio = 0.8f;       ///< 平均が目標のこの倍を下回ったら倍率を上げる
+}
+
+LAppRenderScaleController::LAppRenderScaleController()
+    : _targetFrameTime(0.0f)
+    , _minScale(0.25f)
+    , _maxScale(1.0f)
+    , _framesSinceChange(0)
+{
+    _statistics.Scale = 1.0f;
+    _statistics.LastFrameTime = 0.0f;
+    _statistics.AverageFrameTime = 0.0f;
+    _statistics.Frames = 0;
+    _statistics.ScaleChanges = 0;
+}
+
+void LAppRenderScaleController::SetScale(csmFloat32 scale)
+{
+    _targetFrameTime = 0.0f;
+    _minScale = ScaleStep;
+    _maxScale = 1.0f;
+    ApplyScale(scale);
+}
+
+void LAppRenderScaleController::SetTarget(csmFloat32 targetFrameTime, csmFloat32 minScale, csmFloat32 maxScale)
+{
+    _targetFrameTime = (targetFrameTime > 0.0f) ? targetFrameTime : 0.0f;
+    _minScale = CubismMath::RangeF(minScale, ScaleStep, 1.0f);
+    _maxScale = CubismMath::RangeF(maxScale, _minScale, 1.0f);
+    _framesSinceChange = 0;
+    ApplyScale(_statistics.Scale);
+}
+
+csmFloat32 LAppRenderScaleController::Update(csmFloat32 frameTime)
+{
+    // 最初のフレームや一時停止明けの値は使わない
+    if (frameTime <= 0.0f)
+    {
+        return _statistics.Scale;
+    }
+
+    _statistics.Frames++;
+    _statistics.LastFrameTime = frameTime;
+
+    // 倍率を変えた直後は、前の倍率で測った平均を捨てて測り直す
+    if (_framesSinceChange == 0)
+    {
+        _statistics.AverageFrameTime = frameTime;
+    }
+    else
+    {
+        _statistics.AverageFrameTime += (frameTime - _statistics.AverageFrameTime) * AverageRate;
+    }
+    _framesSinceChange++;
+
+    if (_targetFrameTime <= 0.0f || _framesSinceChange < AdjustInterval)
+    {
+        return _statistics.Scale;
+    }
+
+    const csmFloat32 average = _statistics.AverageFrameTime;
+    if (average > _targetFrameTime * OverBudgetRatio)
+    {
+        // 塗りの量は倍率の2乗に比例するので、目標との比の平方根だけ倍率を下げる。少なくとも1段階は下げる
+        const csmFloat32 scale = _statistics.Scale * CubismMath::SqrtF(_targetFrameTime / average);
+        ApplyScale((scale < _statistics.Scale - ScaleStep) ? scale : _statistics.Scale - ScaleStep);
+    }
+    else if (average < _targetFrameTime * UnderBudgetRatio)
+    {
+        // 上げすぎて振動しないよう、上げるときは1段階ずつ
+        ApplyScale(_statistics.Scale + ScaleStep);
+    }
+
+    return _statistics.Scale;
+}
+
+csmFloat32 LAppRenderScaleController::GetScale() const
+{
+    return _statistics.Scale;
+}
+
+csmBool LAppRenderScaleController::IsAdaptive() const
+{
+    return _targetFrameTime > 0.0f;
+}
+
+const LAppRenderScaleController::Statistics& LAppRenderScaleController::GetStatistics() const
+{
+    return _statistics;
+}
+
+void LAppRenderScaleController::ApplyScale(csmFloat32 scale)
+{
+    csmFloat32 quantized = static_cast<csmInt32>(scale / ScaleStep + 0.5f) * ScaleStep;
+    quantized = CubismMath::RangeF(quantized, _minScale, _maxScale);
+
+    if (quantized != _statistics.Scale)
+    {
+        _statistics.Scale = quantized;
+        _statistics.ScaleChanges++;
+        _framesSinceChange = 0;
+    }
+}
@@ -0,0 +1,87 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+#pragma once
+
+#include <CubismFramework.hpp>
+
+/**
+ * @brief   モデルを描く解像度の倍率を、フレーム時間が目標に収まるように調整するクラス<br>
+ *           描画にかかる時間はおおむね塗るピクセル数（倍率の2乗）に比例するものとして倍率を決める。<br>
+ *           GLには触れないので、フレーム時間を与えれば単体で動作を確認できる。
+ */
+class LAppRenderScaleController
+{
+public:
+    /**
+     * @brief   調整の状態を保持する構造体
+     */
+    struct Statistics
+    {
+        Csm::csmFloat32 Scale;              ///< 現在の倍率
+        Csm::csmFloat32 LastFrameTime;      ///< 直前に与えられたフレーム時間[秒]
+        Csm::csmFloat32 AverageFrameTime;   ///< フレーム時間の移動平均[秒]
+        Csm::csmUint32 Frames;              ///< 与えられたフレーム時間の数
+        Csm::csmUint32 ScaleChanges;        ///< 倍率を変更した回数
+    };
+
+    /**
+     * @brief   コンストラクタ
+     */
+    LAppRenderScaleController();
+
+    /**
+     * @brief   倍率を固定する。自動調整は無効になる。
+     *
+     * @param[in]   scale   倍率。範囲外の値は最小値・最大値に収める
+     */
+    void SetScale(Csm::csmFloat32 scale);
+
+    /**
+     * @brief   自動調整の目標を設定する。
+     *
+     * @param[in]   targetFrameTime     目標のフレーム時間[秒]。0以下なら自動調整を無効にする
+     * @param[in]   minScale            倍率の最小値
+     * @param[in]   maxScale            倍率の最大値
+     */
+    void SetTarget(Csm::csmFloat32 targetFrameTime, Csm::csmFloat32 minScale, Csm::csmFloat32 maxScale);
+
+    /**
+     * @brief   1フレーム分の時間を与え、倍率を更新する。
+     *
+     * @param[in]   frameTime   フレーム時間[秒]
+     * @return  更新後の倍率
+     */
+    Csm::csmFloat32 Update(Csm::csmFloat32 frameTime);
+
+    /**
+     * @brief   現在の倍率を取得する。
+     */
+    Csm::csmFloat32 GetScale() const;
+
+    /**
+     * @brief   自動調整が有効か
+     */
+    Csm::csmBool IsAdaptive() const;
+
+    /**
+     * @brief   調整の状態を取得する。
+     */
+    const Statistics& GetStatistics() const;
+
+private:
+    /**
+     * @brief   倍率を刻みに合わせ、範囲内に収めて設定する。
+     */
+    void ApplyScale(Csm::csmFloat32 scale);
+
+    Csm::csmFloat32 _targetFrameTime;   ///< 目標のフレーム時間[秒]。0なら自動調整しない
+    Csm::csmFloat32 _minScale;          ///< 倍率の最小値
+    Csm::csmFloat32 _maxScale;          ///< 倍率の最大値
+    Csm::csmInt32 _framesSinceChange;   ///< 前回倍率を変えてからのフレーム数
+    Statistics _statistics;             ///< 調整の状態
+};
@@ -38,6 +38,9 @@ LAppTextureManager::~LAppTextureManager()
 
 LAppTextureManager::TextureInfo* LAppTextureManager::CreateTextureFromPngFile(std::string fileName)
 {
+    // テクスチャは読み込んだモデル以外からも使われる
+    Csm::CubismSharedAllocationScope sharedAllocation;
+
     //search loaded texture already.
     for (Csm::csmUint32 i = 0; i < _textures.GetSize(); i++)
     {
@@ -114,6 +117,36 @@ LAppTextureManager::TextureInfo* LAppTextureManager::CreateTextureFromPngFile(st
 
 }
 
+bool LAppTextureManager::LoadTextureAlpha(TextureInfo* texture)
+{
+    Csm::CubismSharedAllocationScope sharedAllocation;
+
+    if (texture->alpha.GetSize() > 0)
+    {
+        return true;
+    }
+
+    Csm::csmSizeInt size;
+    auto data = LAppPal::LoadFileAsBytes(texture->fileName, &size);
+    auto image = LoadImageFromMemory(".png", data, size);
+    LAppPal::ReleaseBytes(data);
+    if (image.data == NULL)
+    {
+        return false;
+    }
+
+    ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    const unsigned char* pixels = static_cast<const unsigned char*>(image.data);
+    texture->alpha.Resize(image.width * image.height);
+    for (int i = 0; i < image.width * image.height; i++)
+    {
+        texture->alpha[i] = pixels[i * 4 + 3];
+    }
+    UnloadImage(image);
+
+    return true;
+}
+
 void LAppTextureManager::ReleaseTextures()
 {
     for (Csm::csmUint32 i = 0; i < _textures.GetSize(); i++)
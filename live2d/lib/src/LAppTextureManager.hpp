@@ -28,6 +28,7 @@ public:
         int width;              ///< 横幅
         int height;             ///< 高さ
         std::string fileName;   ///< ファイル名
+        Csm::csmVector<Csm::csmUint8> alpha;  ///< 当たり判定用のアルファの写し。LoadTextureAlphaで読み込むまでは空
     };
 
     /**
@@ -78,6 +79,15 @@ public:
     */
     TextureInfo* CreateTextureFromPngFile(std::string fileName);
 
+    /**
+    * @brief アルファの写しの読み込み
+    *
+    * 当たり判定で使うため、画像を読み直してアルファだけをCPU側に保持する。読み込み済みなら何もしない
+    * @param[in] texture  読み込む画像
+    * @return 読み込めなかった場合はfalse
+    */
+    bool LoadTextureAlpha(TextureInfo* texture);
+
     /**
     * @brief 画像の解放
     *
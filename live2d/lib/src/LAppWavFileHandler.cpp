@@ -8,21 +8,247 @@
 #include "LAppWavFileHandler.hpp"
 #include <cmath>
 #include <cstdint>
-#include "LAppPal.hpp"
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LAPP_RMS_USE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define LAPP_RMS_USE_NEON
+#endif
+
+namespace {
+const Csm::csmUint16 WaveFormatPcm = 1;             ///< リニアPCM
+const Csm::csmUint16 WaveFormatIeeeFloat = 3;       ///< 浮動小数点のPCM
+const Csm::csmUint16 WaveFormatExtensible = 0xFFFE; ///< 拡張形式。実際の形式はSubFormatの先頭2バイト
+const double Int16Scale = 1.0 / 32768.0;            ///< 16bitのサンプルを-1～1に変換する係数
+
+/**
+ * @brief   ファイルを読み取り専用でメモリにマップする
+ *
+ * @param[in]   path        ファイルのパス
+ * @param[out]  outSize     ファイルサイズ
+ * @param[out]  outHandle   UnmapFileに渡すハンドル
+ * @return  マップした先頭。失敗した場合はNULL
+ */
+Csm::csmByte* MapFile(const Csm::csmChar* path, Csm::csmSizeInt* outSize, void** outHandle)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return NULL;
+    }
+
+    LARGE_INTEGER size;
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+    {
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    }
+    // マッピングがファイルを参照し続けるので、ファイルのハンドルはすぐに閉じてよい
+    CloseHandle(file);
+    if (mapping == NULL)
+    {
+        return NULL;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == NULL)
+    {
+        CloseHandle(mapping);
+        return NULL;
+    }
+
+    *outSize = static_cast<Csm::csmSizeInt>(size.QuadPart);
+    *outHandle = mapping;
+    return static_cast<Csm::csmByte*>(view);
+#else
+    const int file = open(path, O_RDONLY);
+    if (file < 0)
+    {
+        return NULL;
+    }
+
+    struct stat statBuf;
+    void* view = MAP_FAILED;
+    if (fstat(file, &statBuf) == 0 && statBuf.st_size > 0)
+    {
+        view = mmap(NULL, statBuf.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    }
+    close(file);
+    if (view == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    *outSize = static_cast<Csm::csmSizeInt>(statBuf.st_size);
+    *outHandle = NULL;
+    return static_cast<Csm::csmByte*>(view);
+#endif
+}
+
+/**
+ * @brief   MapFileでマップしたファイルを解放する
+ */
+void UnmapFile(Csm::csmByte* data, Csm::csmSizeInt size, void* handle)
+{
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(static_cast<HANDLE>(handle));
+#else
+    (void)handle; // POSIXではマップした範囲だけで解放できる
+    munmap(data, size);
+#endif
+}
+
+// スカラー実装。SIMD実装の端数処理に使う
+double SumSquaresFloatScalar(const Csm::csmByte* samples, Csm::csmUint32 count)
+{
+    double sum = 0.0;
+    for (Csm::csmUint32 i = 0; i < count; ++i)
+    {
+        // マップしたファイル上の値は4バイト境界に揃っているとは限らない
+        Csm::csmFloat32 sample;
+        memcpy(&sample, samples + i * sizeof(Csm::csmFloat32), sizeof(sample));
+        sum += sample * sample;
+    }
+    return sum;
+}
+
+double SumSquaresInt16Scalar(const Csm::csmByte* samples, Csm::csmUint32 count)
+{
+    double sum = 0.0;
+    for (Csm::csmUint32 i = 0; i < count; ++i)
+    {
+        const Csm::csmInt16 sample = static_cast<Csm::csmInt16>(samples[i * 2] | (samples[i * 2 + 1] << 8));
+        sum += static_cast<double>(sample) * sample;
+    }
+    return sum * Int16Scale * Int16Scale;
+}
+
+#if defined(LAPP_RMS_USE_SSE2)
+double ReduceSum(__m128 sum)
+{
+    Csm::csmFloat32 lanes[4];
+    _mm_storeu_ps(lanes, sum);
+    return static_cast<double>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+}
+
+// 処理したサンプル数を返す。残りはスカラー実装で処理する
+Csm::csmUint32 SumSquaresFloatSimd(const Csm::csmByte* samples, Csm::csmUint32 count, double& sum)
+{
+    __m128 sum0 = _mm_setzero_ps(), sum1 = sum0;
+
+    // 1回のループで8サンプルを処理する
+    Csm::csmUint32 i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128 v0 = _mm_loadu_ps(reinterpret_cast<const float*>(samples + i * 4));
+        const __m128 v1 = _mm_loadu_ps(reinterpret_cast<const float*>(samples + i * 4 + 16));
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(v0, v0));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(v1, v1));
+    }
+
+    sum += ReduceSum(_mm_add_ps(sum0, sum1));
+    return i;
+}
+
+Csm::csmUint32 SumSquaresInt16Simd(const Csm::csmByte* samples, Csm::csmUint32 count, double& sum)
+{
+    __m128 sum0 = _mm_setzero_ps(), sum1 = sum0;
+
+    // 1回のループで8サンプルを処理する。符号拡張して浮動小数点に変換してから2乗する
+    Csm::csmUint32 i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i * 2));
+        const __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+        const __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(lo, lo));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(hi, hi));
+    }
+
+    sum += ReduceSum(_mm_add_ps(sum0, sum1)) * Int16Scale * Int16Scale;
+    return i;
+}
+#elif defined(LAPP_RMS_USE_NEON)
+Csm::csmUint32 SumSquaresFloatSimd(const Csm::csmByte* samples, Csm::csmUint32 count, double& sum)
+{
+    float32x4_t sum0 = vdupq_n_f32(0.0f), sum1 = sum0;
+
+    Csm::csmUint32 i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const float32x4_t v0 = vreinterpretq_f32_u8(vld1q_u8(samples + i * 4));
+        const float32x4_t v1 = vreinterpretq_f32_u8(vld1q_u8(samples + i * 4 + 16));
+        sum0 = vmlaq_f32(sum0, v0, v0);
+        sum1 = vmlaq_f32(sum1, v1, v1);
+    }
+
+    Csm::csmFloat32 lanes[4];
+    vst1q_f32(lanes, vaddq_f32(sum0, sum1));
+    sum += static_cast<double>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+    return i;
+}
+
+Csm::csmUint32 SumSquaresInt16Simd(const Csm::csmByte* samples, Csm::csmUint32 count, double& sum)
+{
+    float32x4_t sum0 = vdupq_n_f32(0.0f), sum1 = sum0;
+
+    Csm::csmUint32 i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const int16x8_t v = vreinterpretq_s16_u8(vld1q_u8(samples + i * 2));
+        const float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+        const float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+        sum0 = vmlaq_f32(sum0, lo, lo);
+        sum1 = vmlaq_f32(sum1, hi, hi);
+    }
+
+    Csm::csmFloat32 lanes[4];
+    vst1q_f32(lanes, vaddq_f32(sum0, sum1));
+    sum += (static_cast<double>(lanes[0]) + lanes[1] + lanes[2] + lanes[3]) * Int16Scale * Int16Scale;
+    return i;
+}
+#else
+Csm::csmUint32 SumSquaresFloatSimd(const Csm::csmByte*, Csm::csmUint32, double&)
+{
+    return 0;
+}
+
+Csm::csmUint32 SumSquaresInt16Simd(const Csm::csmByte*, Csm::csmUint32, double&)
+{
+    return 0;
+}
+#endif
+}
 
 LAppWavFileHandler::LAppWavFileHandler()
-    : _pcmData(NULL)
-    , _userTimeSeconds(0.0f)
-    , _lastRms(0.0f)
+    : _mappingHandle(NULL)
     , _sampleOffset(0)
+    , _lastRms(0.0f)
+    , _userTimeSeconds(0.0f)
 {
 }
 
 LAppWavFileHandler::~LAppWavFileHandler()
 {
-    if (_pcmData != NULL)
+    if (_byteReader._fileByte != NULL)
     {
-        ReleasePcmData();
+        ReleaseFile();
     }
 }
 
@@ -32,7 +258,7 @@ Csm::csmBool LAppWavFileHandler::Update(Csm::csmFloat32 deltaTimeSeconds)
     Csm::csmFloat32 rms;
 
     // データロード前/ファイル末尾に達した場合は更新しない
-    if ((_pcmData == NULL)
+    if ((_byteReader._fileByte == NULL)
         || (_sampleOffset >= _wavFileInfo._samplesPerChannel))
     {
         _lastRms = 0.0f;
@@ -47,17 +273,17 @@ Csm::csmBool LAppWavFileHandler::Update(Csm::csmFloat32 deltaTimeSeconds)
         goalOffset = _wavFileInfo._samplesPerChannel;
     }
 
-    // RMS計測
-    rms = 0.0f;
-    for (Csm::csmUint32 channelCount = 0; channelCount < _wavFileInfo._numberOfChannels; channelCount++)
+    // RMS計測。チャンネルは交互に並んでいるので、全チャンネルをまとめて処理する
+    if (goalOffset > _sampleOffset)
     {
-        for (Csm::csmUint32 sampleCount = _sampleOffset; sampleCount < goalOffset; sampleCount++)
-        {
-            Csm::csmFloat32 pcm = _pcmData[channelCount][sampleCount];
-            rms += pcm * pcm;
-        }
+        const Csm::csmUint32 sampleCount = (goalOffset - _sampleOffset) * _wavFileInfo._numberOfChannels;
+        const double sum = SumSquares(_sampleOffset * _wavFileInfo._numberOfChannels, sampleCount);
+        rms = static_cast<Csm::csmFloat32>(sqrt(sum / sampleCount));
+    }
+    else
+    {
+        rms = _lastRms;
     }
-    rms = sqrt(rms / (_wavFileInfo._numberOfChannels * (goalOffset - _sampleOffset)));
 
     _lastRms = rms;
     _sampleOffset = goalOffset;
@@ -80,6 +306,15 @@ void LAppWavFileHandler::Start(const Csm::csmString& filePath)
     _lastRms = 0.0f;
 }
 
+void LAppWavFileHandler::Stop()
+{
+    if (_byteReader._fileByte != NULL)
+    {
+        ReleaseFile();
+    }
+    _lastRms = 0.0f;
+}
+
 Csm::csmFloat32 LAppWavFileHandler::GetRms() const
 {
     return _lastRms;
@@ -90,18 +325,22 @@ Csm::csmBool LAppWavFileHandler::LoadWavFile(const Csm::csmString& filePath)
     Csm::csmBool ret;
 
     // 既にwavファイルロード済みならば領域開放
-    if (_pcmData != NULL)
+    if (_byteReader._fileByte != NULL)
     {
-        ReleasePcmData();
+        ReleaseFile();
     }
 
-    // ファイルロード
-    _byteReader._fileByte = LAppPal::LoadFileAsBytes(filePath.GetRawString(), &(_byteReader._fileSize));
+    // ファイルをマップする。波形は再生中に必要な区間だけ読む
+    _byteReader._fileByte = MapFile(filePath.GetRawString(), &(_byteReader._fileSize), &_mappingHandle);
     _byteReader._readOffset = 0;
 
     // ファイルロードに失敗しているか、先頭のシグネチャ"RIFF"を入れるサイズもない場合は失敗
     if ((_byteReader._fileByte == NULL) || (_byteReader._fileSize < 4))
     {
+        if (_byteReader._fileByte != NULL)
+        {
+            ReleaseFile();
+        }
         return false;
     }
 
@@ -131,12 +370,9 @@ Csm::csmBool LAppWavFileHandler::LoadWavFile(const Csm::csmString& filePath)
         }
         // fmtチャンクサイズ
         const Csm::csmUint32 fmtChunkSize = _byteReader.Get32LittleEndian();
-        // フォーマットIDは1（リニアPCM）以外受け付けない
-        if (_byteReader.Get16LittleEndian() != 1)
-        {
-            ret = false;
-            break;
-        }
+        const Csm::csmUint32 fmtChunkOffset = _byteReader._readOffset;
+        // フォーマットID。拡張形式の場合は後でSubFormatから取り直す
+        Csm::csmUint16 formatTag = _byteReader.Get16LittleEndian();
         // チャンネル数
         _wavFileInfo._numberOfChannels = _byteReader.Get16LittleEndian();
         // サンプリングレート
@@ -147,51 +383,55 @@ Csm::csmBool LAppWavFileHandler::LoadWavFile(const Csm::csmString& filePath)
         _byteReader.Get16LittleEndian();
         // 量子化ビット数
         _wavFileInfo._bitsPerSample = _byteReader.Get16LittleEndian();
-        // fmtチャンクの拡張部分の読み飛ばし
-        if (fmtChunkSize > 16)
+        // 拡張形式のSubFormatはfmtチャンクの先頭から24バイト目
+        if (formatTag == WaveFormatExtensible && fmtChunkSize >= 26)
+        {
+            _byteReader._readOffset = fmtChunkOffset + 24;
+            formatTag = _byteReader.Get16LittleEndian();
+        }
+        // リニアPCMと、32bitの浮動小数点のPCM以外は受け付けない
+        _wavFileInfo._isFloat = (formatTag == WaveFormatIeeeFloat);
+        if (!((formatTag == WaveFormatPcm && _wavFileInfo._bitsPerSample % 8 == 0 && _wavFileInfo._bitsPerSample <= 32)
+              || (_wavFileInfo._isFloat && _wavFileInfo._bitsPerSample == 32))
+            || _wavFileInfo._numberOfChannels == 0)
         {
-            _byteReader._readOffset += (fmtChunkSize - 16);
+            ret = false;
+            break;
         }
+        // fmtチャンクの拡張部分の読み飛ばし
+        _byteReader._readOffset = fmtChunkOffset + fmtChunkSize;
         // "data"チャンクが出現するまで読み飛ばし
-        while (!(_byteReader.GetCheckSignature("data"))
-            && (_byteReader._readOffset < _byteReader._fileSize))
+        while ((_byteReader._readOffset + 8 <= _byteReader._fileSize)
+            && !(_byteReader.GetCheckSignature("data")))
         {
             _byteReader._readOffset += _byteReader.Get32LittleEndian();
         }
         // ファイル内に"data"チャンクが出現しなかった
-        if (_byteReader._readOffset >= _byteReader._fileSize)
+        if (_byteReader._readOffset + 4 > _byteReader._fileSize)
         {
             ret = false;
             break;
         }
-        // サンプル数
-        {
-            const Csm::csmUint32 dataChunkSize = _byteReader.Get32LittleEndian();
-            _wavFileInfo._samplesPerChannel = (dataChunkSize * 8) / (_wavFileInfo._bitsPerSample * _wavFileInfo._numberOfChannels);
-        }
-        // 領域確保
-        _pcmData = static_cast<Csm::csmFloat32**>(CSM_MALLOC(sizeof(Csm::csmFloat32*) * _wavFileInfo._numberOfChannels));
-        for (Csm::csmUint32 channelCount = 0; channelCount < _wavFileInfo._numberOfChannels; channelCount++)
-        {
-            _pcmData[channelCount] = static_cast<Csm::csmFloat32*>(CSM_MALLOC(sizeof(Csm::csmFloat32) * _wavFileInfo._samplesPerChannel));
-        }
-        // 波形データ取得
-        for (Csm::csmUint32 sampleCount = 0; sampleCount < _wavFileInfo._samplesPerChannel; sampleCount++)
+        // サンプル数。途中で切れたファイルは、ファイル内にある分だけを使う
         {
-            for (Csm::csmUint32 channelCount = 0; channelCount < _wavFileInfo._numberOfChannels; channelCount++)
+            Csm::csmUint32 dataChunkSize = _byteReader.Get32LittleEndian();
+            _wavFileInfo._dataOffset = _byteReader._readOffset;
+            if (dataChunkSize > _byteReader._fileSize - _wavFileInfo._dataOffset)
             {
-                _pcmData[channelCount][sampleCount] = GetPcmSample();
+                dataChunkSize = _byteReader._fileSize - _wavFileInfo._dataOffset;
             }
+            _wavFileInfo._samplesPerChannel = (dataChunkSize * 8) / (_wavFileInfo._bitsPerSample * _wavFileInfo._numberOfChannels);
         }
 
         ret = true;
 
     }  while (false);
 
-    // ファイル開放
-    LAppPal::ReleaseBytes(_byteReader._fileByte);
-    _byteReader._fileByte = NULL;
-    _byteReader._fileSize = 0;
+    // 読み込めなかった場合はファイルを開放
+    if (!ret)
+    {
+        ReleaseFile();
+    }
 
     return ret;
 }
@@ -213,6 +453,9 @@ Csm::csmFloat32 LAppWavFileHandler::GetPcmSample()
     case 24:
         pcm32 = _byteReader.Get24LittleEndian() << 8;
         break;
+    case 32:
+        pcm32 = static_cast<Csm::csmInt32>(_byteReader.Get32LittleEndian());
+        break;
     default:
         // 対応していないビット幅
         pcm32 = 0;
@@ -222,12 +465,45 @@ Csm::csmFloat32 LAppWavFileHandler::GetPcmSample()
     return static_cast<Csm::csmFloat32>(pcm32) / INT32_MAX;
 }
 
-void LAppWavFileHandler::ReleasePcmData()
+double LAppWavFileHandler::SumSquares(Csm::csmUint32 firstSample, Csm::csmUint32 sampleCount)
 {
-    for (Csm::csmUint32 channelCount = 0; channelCount < _wavFileInfo._numberOfChannels; channelCount++)
+    const Csm::csmUint32 bytesPerSample = _wavFileInfo._bitsPerSample / 8;
+    const Csm::csmByte* samples = _byteReader._fileByte + _wavFileInfo._dataOffset + firstSample * bytesPerSample;
+    double sum = 0.0;
+
+    // 16bit整数と浮動小数点はファイル上の値をそのまま計算する
+    if (_wavFileInfo._isFloat)
+    {
+        const Csm::csmUint32 done = SumSquaresFloatSimd(samples, sampleCount, sum);
+        return sum + SumSquaresFloatScalar(samples + done * 4, sampleCount - done);
+    }
+    if (_wavFileInfo._bitsPerSample == 16)
+    {
+        const Csm::csmUint32 done = SumSquaresInt16Simd(samples, sampleCount, sum);
+        return sum + SumSquaresInt16Scalar(samples + done * 2, sampleCount - done);
+    }
+
+    // それ以外のビット幅は、一時領域に収まる分ずつ浮動小数点に変換してから計算する
+    _byteReader._readOffset = _wavFileInfo._dataOffset + firstSample * bytesPerSample;
+    for (Csm::csmUint32 first = 0; first < sampleCount; first += PcmWindowSize)
     {
-        CSM_FREE(_pcmData[channelCount]);
+        const Csm::csmUint32 count = (sampleCount - first < PcmWindowSize) ? sampleCount - first : PcmWindowSize;
+        for (Csm::csmUint32 i = 0; i < count; ++i)
+        {
+            _pcmWindow[i] = GetPcmSample();
+        }
+
+        const Csm::csmByte* window = reinterpret_cast<const Csm::csmByte*>(_pcmWindow);
+        const Csm::csmUint32 done = SumSquaresFloatSimd(window, count, sum);
+        sum += SumSquaresFloatScalar(window + done * 4, count - done);
     }
-    CSM_FREE(_pcmData);
-    _pcmData = NULL;
+    return sum;
+}
+
+void LAppWavFileHandler::ReleaseFile()
+{
+    UnmapFile(_byteReader._fileByte, _byteReader._fileSize, _mappingHandle);
+    _byteReader._fileByte = NULL;
+    _byteReader._fileSize = 0;
+    _mappingHandle = NULL;
 }
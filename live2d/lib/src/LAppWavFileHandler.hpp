@@ -12,7 +12,10 @@
 
  /**
   * @brief wavファイルハンドラ
-  * @attention 16bit wav ファイル読み込みのみ実装済み
+  *
+  * ファイルをメモリにマップし、フレームごとに経過した区間のサンプルだけを読んでRMSを求める。
+  * 波形全体を展開しないので、使うメモリはファイルの長さによらない。
+  * @attention 8/16/24/32bit整数と32bit浮動小数点のリニアPCMに対応
   */
 class LAppWavFileHandler
 {
@@ -43,6 +46,11 @@ public:
      */
     void Start(const Csm::csmString& filePath);
 
+    /**
+     * @brief 再生を停止し、wavファイルを解放する
+     */
+    void Stop();
+
     /**
      * @brief 現在のRMS値取得
      *
@@ -61,9 +69,9 @@ private:
     Csm::csmBool LoadWavFile(const Csm::csmString& filePath);
 
     /**
-     * @brief PCMデータの解放
+     * @brief マップしたファイルの解放
      */
-    void ReleasePcmData();
+    void ReleaseFile();
 
     /**
      * @brief -1～1の範囲の1サンプル取得
@@ -71,6 +79,15 @@ private:
      */
     Csm::csmFloat32 GetPcmSample();
 
+    /**
+     * @brief 指定した範囲のサンプルの2乗和を求める
+     *
+     * @param[in]   firstSample     先頭のサンプル（全チャンネルを並べた位置）
+     * @param[in]   sampleCount     サンプル数（全チャンネル分）
+     * @return  2乗和。サンプルは-1～1に正規化したもの
+     */
+    double SumSquares(Csm::csmUint32 firstSample, Csm::csmUint32 sampleCount);
+
     /**
      * @brief 読み込んだwavfileの情報
      */
@@ -80,7 +97,8 @@ private:
          * @brief コンストラクタ
          */
         WavFileInfo() : _fileName(""), _numberOfChannels(0),
-            _bitsPerSample(0), _samplingRate(0), _samplesPerChannel(0)
+            _bitsPerSample(0), _samplingRate(0), _samplesPerChannel(0),
+            _isFloat(false), _dataOffset(0)
         { }
 
         Csm::csmString _fileName; ///< ファイル名
@@ -88,6 +106,8 @@ private:
         Csm::csmUint32 _bitsPerSample; ///< サンプルあたりビット数
         Csm::csmUint32 _samplingRate; ///< サンプリングレート
         Csm::csmUint32 _samplesPerChannel; ///< 1チャンネルあたり総サンプル数
+        Csm::csmBool _isFloat; ///< 浮動小数点のPCMか
+        Csm::csmUint32 _dataOffset; ///< ファイル内の波形データの先頭
     } _wavFileInfo;
 
     /**
@@ -175,7 +195,10 @@ private:
         Csm::csmUint32 _readOffset; ///< ファイル参照位置
     } _byteReader;
 
-    Csm::csmFloat32** _pcmData; ///< -1から1の範囲で表現された音声データ配列
+    static const Csm::csmUint32 PcmWindowSize = 1024; ///< 一度に変換するサンプル数
+
+    void* _mappingHandle; ///< ファイルのマッピングのハンドル
+    Csm::csmFloat32 _pcmWindow[PcmWindowSize]; ///< -1から1の範囲に変換したサンプルの一時領域
     Csm::csmUint32 _sampleOffset; ///< サンプル参照位置
     Csm::csmFloat32 _lastRms; ///< 最後に計測したRMS値
     Csm::csmFloat32 _userTimeSeconds; ///< デルタ時間の積算値[秒]
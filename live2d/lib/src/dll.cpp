@@ -2,6 +2,7 @@
 #include "LAppAllocator.hpp"
 #include "LAppDefine.hpp"
 #include "LAppModel.hpp"
+#include "LAppCoverage.hpp"
 #include "LAppPal.hpp"
 #include "raylib.h"
 #include "rlgl.h"
@@ -10,18 +11,58 @@
 #include <Math/CubismViewMatrix.hpp>
 #include <Id/CubismId.hpp>
 #include <Id/CubismIdManager.hpp>
+#include <Physics/CubismPhysics.hpp>
+#include <Rendering/Raylib/CubismRenderer_OpenGLES2.hpp>
 #include <CubismFramework.hpp>
 
 using namespace Csm;
 using namespace LAppDefine;
 
+namespace {
+	LAppCoverage* s_coverage = NULL;
+	int s_coverageDownsample = 1;
+	bool s_coverageUseGpu = true;
+
+	// only needed when the coverage can not be read back from the GPU
+	void RasterizeCoverage(LAppModel* model, Csm::CubismMatrix44& mvp) {
+		if (s_coverage != NULL && !s_coverage->IsGpuReadback()) {
+			s_coverage->RasterizeUpperBound(*model->GetModel(), mvp, model->GetOpacity());
+		}
+	}
+
+	LAppAllocator* s_allocator = NULL;
+	bool s_useModelArenas = false;
+
+	// Live2DManagedData followed by what only the dll needs to release the model
+	struct ManagedModel {
+		Live2DManagedData data;
+		LAppAllocator::Arena* arena;
+	};
+
+	ManagedModel* LoadManagedModel(const char* dir, const char* filename) {
+		auto model = new LAppModel();
+		auto arena = s_useModelArenas ? s_allocator->CreateArena() : NULL;
+		{
+			LAppAllocator::ArenaScope scope(*s_allocator, arena);
+			model->LoadAssets(dir, filename);
+		}
+
+		auto m = static_cast<ManagedModel*>(CSM_MALLOC(sizeof(ManagedModel)));
+		m->data.model = model;
+		m->data.x = m->data.y = 0;
+		m->data.scaleX = m->data.scaleY = 1;
+		m->arena = arena;
+		return m;
+	}
+}
+
 void l2dInit() {
-	auto cubismAllocator = new LAppAllocator();
+	s_allocator = new LAppAllocator();
 	auto cubismOption = new CubismFramework::Option();
 
 	cubismOption->LogFunction = LAppPal::PrintMessage;
 	cubismOption->LoggingLevel = LAppDefine::CubismLoggingLevel;
-	Csm::CubismFramework::StartUp(cubismAllocator, cubismOption);
+	Csm::CubismFramework::StartUp(s_allocator, cubismOption);
 
 	//ʼcubism
 	CubismFramework::Initialize();
@@ -31,12 +72,7 @@ void l2dInit() {
 }
 
 Live2DManagedData* l2dLoadModel1(const char* dir, const char* filename) {
-	auto model = new LAppModel();
-	model->LoadAssets(dir, filename);
-	Live2DManagedData* m = static_cast<Live2DManagedData*>(CSM_MALLOC(sizeof(Live2DManagedData)));
-	m->model = model;
-	m->x = m->y = 0;
-	m->scaleX = m->scaleY = 1;
+	Live2DManagedData* m = &LoadManagedModel(dir, filename)->data;
 	l2dUpdateModelMatrix(m);
 	return m;
 }
@@ -81,20 +117,45 @@ void l2dUpdateModelMatrix(Live2DManagedData* data) {
 }
 
 Live2DManagedData* l2dLoadModel(const char* dir, const char* filename) {
-	auto model = new LAppModel();
-	model->LoadAssets(dir, filename);
-	Live2DManagedData* m = static_cast<Live2DManagedData*>(CSM_MALLOC(sizeof(Live2DManagedData)));
-	m->model = model;
-	m->x = m->y = 0;
-	m->scaleX = m->scaleY = 1;
-	model->GetModelMatrix()->LoadIdentity();
+	Live2DManagedData* m = &LoadManagedModel(dir, filename)->data;
+	static_cast<LAppModel*>(m->model)->GetModelMatrix()->LoadIdentity();
 	l2dUpdateModelMatrix(m);
 	return m;
 }
 
+void l2dReleaseModel(Live2DManagedData* data) {
+	auto m = reinterpret_cast<ManagedModel*>(data);
+
+	// small blocks freed while the model lived were reused inside its arena, the chunks are now freed at once
+	delete static_cast<LAppModel*>(m->data.model);
+	s_allocator->ReleaseArena(m->arena);
+	CSM_FREE(m);
+}
+
+void l2dSetModelArenas(int enabled) {
+	s_useModelArenas = enabled != 0;
+}
+
+void l2dGetAllocatorStatistics(AllocatorStatistics* statistics) {
+	auto stats = s_allocator->GetStatistics();
+	statistics->poolReservedBytes = stats.PoolReservedBytes;
+	statistics->poolUsedBytes = stats.PoolUsedBytes;
+	statistics->largeUsedBytes = stats.LargeUsedBytes;
+	statistics->arenaReservedBytes = stats.ArenaReservedBytes;
+	statistics->arenaCount = stats.ArenaCount;
+}
+
 void l2dUpdate(void) {
 	rlDrawRenderBatchActive();
 	LAppPal::UpdateTime();
+	CubismPhysics::BeginFrame();
+
+	if (s_coverage != NULL) {
+		if (s_coverage->GetScreenWidth() != GetScreenWidth() || s_coverage->GetScreenHeight() != GetScreenHeight()) {
+			s_coverage->Initialize(GetScreenWidth(), GetScreenHeight(), s_coverageDownsample, s_coverageUseGpu);
+		}
+		s_coverage->BeginFrame();
+	}
 }
 
 void l2dUpdateModel1(Live2DManagedData* data) {
@@ -106,6 +167,7 @@ void l2dUpdateModel1(Live2DManagedData* data) {
 	projection.LoadIdentity();
 	model->Update();
 	model->Draw(projection, width, height);
+	RasterizeCoverage(model, projection);
 }
 
 void l2dPreUpdateModel(Live2DManagedData* data) {
@@ -120,12 +182,72 @@ void l2dUpdateModel(Live2DManagedData* data) {
 	projection.LoadIdentity();
 	model->Update();
 	model->Draw(projection, GetScreenWidth(), GetScreenHeight());
+	RasterizeCoverage(model, projection);
+}
+
+void l2dUpdateModelInstances(Live2DManagedData** models, int count) {
+	const int BatchSize = 64;
+	LAppModel* batch[BatchSize];
+
+	for (int first = 0; first < count; first += BatchSize) {
+		int n = (count - first < BatchSize) ? count - first : BatchSize;
+		for (int i = 0; i < n; i++) {
+			batch[i] = static_cast<LAppModel*>(models[first + i]->model);
+			batch[i]->Update();
+		}
+
+		Csm::CubismMatrix44 projection;
+		projection.LoadIdentity();
+		if (batch[0]->DrawInstances(batch, n, projection)) {
+			for (int i = 0; i < n; i++) {
+				Csm::CubismMatrix44 mvp;
+				mvp.LoadIdentity();
+				mvp.MultiplyByMatrix(batch[i]->GetModelMatrix());
+				RasterizeCoverage(batch[i], mvp);
+			}
+			continue;
+		}
+
+		// masks, render cache or render scale in use: draw one by one
+		for (int i = 0; i < n; i++) {
+			Csm::CubismMatrix44 modelProjection;
+			modelProjection.LoadIdentity();
+			batch[i]->Draw(modelProjection, GetScreenWidth(), GetScreenHeight());
+			RasterizeCoverage(batch[i], modelProjection);
+		}
+	}
 }
 
 int l2dHitTest(Live2DManagedData* data, const char *name, float x, float y) {
 	return static_cast<LAppModel*>(data->model)->HitTest(name, (x / GetScreenWidth()) * 2 - 1, 1 - (y / GetScreenHeight()) * 2);
 }
 
+int l2dHitTestArea(Live2DManagedData* data, int index, float x, float y) {
+	return static_cast<LAppModel*>(data->model)->HitTestArea(index, (x / GetScreenWidth()) * 2 - 1, 1 - (y / GetScreenHeight()) * 2);
+}
+
+int l2dHitTestAll(Live2DManagedData* data, float x, float y, int* outIndices, int capacity) {
+	auto model = static_cast<LAppModel*>(data->model);
+	return model->HitTestAll((x / GetScreenWidth()) * 2 - 1, 1 - (y / GetScreenHeight()) * 2, outIndices, capacity);
+}
+
+int l2dGetHitAreaCount(Live2DManagedData* data) {
+	return static_cast<LAppModel*>(data->model)->GetHitAreaCount();
+}
+
+int l2dGetHitAreaIndex(Live2DManagedData* data, const char* name) {
+	return static_cast<LAppModel*>(data->model)->GetHitAreaIndex(name);
+}
+
+const char* l2dGetHitAreaName(Live2DManagedData* data, int index) {
+	return static_cast<LAppModel*>(data->model)->GetHitAreaName(index);
+}
+
+void l2dSetHitTestAlphaThreshold(Live2DManagedData* data, float threshold) {
+	auto model = static_cast<LAppModel*>(data->model);
+	model->SetHitTestAlphaThreshold(threshold);
+}
+
 void l2dSetExpression(Live2DManagedData* data, const char* expid) {
 	auto model = static_cast<LAppModel*>(data->model);
 	model->SetExpression(expid);
@@ -154,3 +276,178 @@ void l2dSetParameter(Live2DManagedData* data, const void*id, SetParameterType ty
 		break;
 	}
 }
+
+int l2dPushAudio(Live2DManagedData* data, const float* samples, int count, int rate) {
+	auto lipSync = static_cast<LAppModel*>(data->model)->GetAudioLipSync();
+	if (lipSync == NULL) {
+		return -1;
+	}
+	if (count <= 0 || rate <= 0) {
+		return 0;
+	}
+	return static_cast<int>(lipSync->Push(samples, count, rate));
+}
+
+void l2dSetAudioEnvelope(Live2DManagedData* data, float window, float attack, float release) {
+	auto lipSync = static_cast<LAppModel*>(data->model)->GetAudioLipSync();
+	if (lipSync != NULL) {
+		lipSync->SetEnvelope(window, attack, release);
+	}
+}
+
+void l2dGetAudioStatistics(Live2DManagedData* data, AudioLipSyncStatistics* statistics) {
+	auto lipSync = static_cast<LAppModel*>(data->model)->GetAudioLipSync();
+	if (lipSync == NULL) {
+		*statistics = AudioLipSyncStatistics();
+		return;
+	}
+	auto stats = lipSync->GetStatistics();
+	statistics->pushedSamples = stats.PushedSamples;
+	statistics->droppedSamples = stats.DroppedSamples;
+	statistics->skippedSamples = stats.SkippedSamples;
+	statistics->underruns = stats.Underruns;
+}
+
+int l2dBakeLipSyncEnvelope(const char* wavPath, int frameRate) {
+	if (frameRate <= 0 || frameRate > 0xFFFF) {
+		frameRate = LAppLipSyncEnvelope::DefaultFrameRate;
+	}
+	return LAppLipSyncEnvelope::Bake(wavPath, static_cast<Csm::csmUint16>(frameRate)) ? 1 : 0;
+}
+
+void l2dSetPhysicsQuality(Live2DManagedData* data, float quality) {
+	auto model = static_cast<LAppModel*>(data->model);
+	model->SetPhysicsQuality(quality);
+}
+
+void l2dSetPhysicsFrameBudget(float microseconds) {
+	CubismPhysics::SetFrameBudget(microseconds);
+}
+
+void l2dStabilizePhysics(Live2DManagedData* data, float seconds) {
+	auto model = static_cast<LAppModel*>(data->model);
+	model->StabilizePhysics(seconds);
+}
+
+void* l2dSavePhysicsState(Live2DManagedData* data) {
+	auto model = static_cast<LAppModel*>(data->model);
+	auto state = CSM_NEW CubismPhysics::State();
+	if (!model->SavePhysicsState(*state)) {
+		CSM_DELETE(state);
+		return NULL;
+	}
+	return state;
+}
+
+int l2dRestorePhysicsState(Live2DManagedData* data, const void* state) {
+	if (state == NULL) {
+		return 0;
+	}
+	auto model = static_cast<LAppModel*>(data->model);
+	return model->RestorePhysicsState(*static_cast<const CubismPhysics::State*>(state));
+}
+
+void l2dReleasePhysicsState(void* state) {
+	CSM_DELETE(static_cast<CubismPhysics::State*>(state));
+}
+
+void l2dSetModifierProfiling(Live2DManagedData* data, int enabled) {
+	auto model = static_cast<LAppModel*>(data->model);
+	model->SetModifierProfiling(enabled != 0);
+}
+
+void l2dPrintModifierProfile(Live2DManagedData* data) {
+	auto model = static_cast<LAppModel*>(data->model);
+	model->PrintModifierProfile();
+}
+
+void l2dSetRenderCache(Live2DManagedData* data, int enabled, float threshold) {
+	auto model = static_cast<LAppModel*>(data->model);
+	model->SetRenderCacheEnabled(enabled != 0, threshold);
+}
+
+void l2dSetRenderScale(Live2DManagedData* data, float scale) {
+	auto model = static_cast<LAppModel*>(data->model);
+	model->SetRenderScale(scale);
+}
+
+void l2dSetAdaptiveRenderScale(Live2DManagedData* data, float targetMilliseconds, float minScale, float maxScale) {
+	auto model = static_cast<LAppModel*>(data->model);
+	model->SetAdaptiveRenderScale(targetMilliseconds / 1000.0f, minScale, maxScale);
+}
+
+void l2dGetRenderScaleStatistics(Live2DManagedData* data, RenderScaleStatistics* statistics) {
+	auto model = static_cast<LAppModel*>(data->model);
+	auto& stats = model->GetRenderScaleStatistics();
+	statistics->scale = stats.Scale;
+	statistics->lastFrameTime = stats.LastFrameTime * 1000.0f;
+	statistics->averageFrameTime = stats.AverageFrameTime * 1000.0f;
+	statistics->frames = stats.Frames;
+	statistics->scaleChanges = stats.ScaleChanges;
+}
+
+void l2dSetShaderCacheDirectory(const char* dir) {
+	Csm::Rendering::CubismRenderer_OpenGLES2::SetShaderCacheDirectory(dir);
+}
+
+void l2dGetShaderStatistics(ShaderStatistics* statistics) {
+	auto& stats = Csm::Rendering::CubismRenderer_OpenGLES2::GetShaderStatistics();
+	statistics->compiledPrograms = stats.CompiledPrograms;
+	statistics->cachedPrograms = stats.CachedPrograms;
+	statistics->rejectedBinaries = stats.RejectedBinaries;
+	statistics->compileTime = stats.CompileMilliseconds;
+	statistics->cacheLoadTime = stats.CacheLoadMilliseconds;
+}
+
+void l2dSetCoverage(int enabled, int downsample, int useGpu) {
+	delete s_coverage;
+	s_coverage = NULL;
+	if (!enabled) {
+		return;
+	}
+
+	s_coverageDownsample = downsample;
+	s_coverageUseGpu = useGpu != 0;
+	s_coverage = new LAppCoverage();
+	s_coverage->Initialize(GetScreenWidth(), GetScreenHeight(), s_coverageDownsample, s_coverageUseGpu);
+	s_coverage->BeginFrame();
+}
+
+void l2dCaptureCoverage(void) {
+	if (s_coverage != NULL) {
+		s_coverage->EndFrame(0);
+	}
+}
+
+int l2dQueryCoverage(float x, float y) {
+	return (s_coverage != NULL) ? s_coverage->Query(x, y) : 0;
+}
+
+const unsigned char* l2dGetCoverageMask(int* width, int* height) {
+	if (s_coverage == NULL || !s_coverage->IsValid()) {
+		*width = *height = 0;
+		return NULL;
+	}
+	*width = s_coverage->GetWidth();
+	*height = s_coverage->GetHeight();
+	return s_coverage->GetMask();
+}
+
+void l2dSetDrawableCulling(Live2DManagedData* data, int enabled, float minOpacity, float minPixelArea) {
+	auto renderer = static_cast<LAppModel*>(data->model)->GetRenderer<Csm::Rendering::CubismRenderer_OpenGLES2>();
+	if (renderer != NULL) {
+		renderer->SetDrawableCulling(enabled != 0, minOpacity, minPixelArea);
+	}
+}
+
+void l2dGetCullingStatistics(Live2DManagedData* data, CullingStatistics* statistics) {
+	auto renderer = static_cast<LAppModel*>(data->model)->GetRenderer<Csm::Rendering::CubismRenderer_OpenGLES2>();
+	if (renderer == NULL) {
+		*statistics = CullingStatistics();
+		return;
+	}
+	auto& stats = renderer->GetFrameStatistics();
+	statistics->culledByOpacity = stats.CulledByOpacity;
+	statistics->culledByViewport = stats.CulledByViewport;
+	statistics->culledBySize = stats.CulledBySize;
+}
@@ -4,6 +4,31 @@ extern "C" {
 		void* model;
 	} Live2DManagedData;
 
+	typedef struct RenderScaleStatistics_t {
+		float scale;
+		float lastFrameTime, averageFrameTime; // milliseconds
+		unsigned int frames, scaleChanges;
+	} RenderScaleStatistics;
+
+	typedef struct ShaderStatistics_t {
+		unsigned int compiledPrograms, cachedPrograms, rejectedBinaries;
+		float compileTime, cacheLoadTime; // milliseconds
+	} ShaderStatistics;
+
+	typedef struct CullingStatistics_t {
+		unsigned int culledByOpacity, culledByViewport, culledBySize;
+	} CullingStatistics;
+
+	typedef struct AudioLipSyncStatistics_t {
+		unsigned long long pushedSamples, droppedSamples, skippedSamples;
+		unsigned int underruns;
+	} AudioLipSyncStatistics;
+
+	typedef struct AllocatorStatistics_t {
+		unsigned long long poolReservedBytes, poolUsedBytes, largeUsedBytes, arenaReservedBytes;
+		unsigned int arenaCount;
+	} AllocatorStatistics;
+
 	typedef enum SetParameterType_t {
 		SetParameterType_Set,
 		SetParameterType_Add,
@@ -20,6 +45,18 @@ extern "C" {
 	/// <returns>ģݵָ</returns>
 	__declspec(dllexport) Live2DManagedData* l2dLoadModel(const char* dir, const char* file);
 
+	/// <summary>
+	/// Destroy a model returned by l2dLoadModel, its arena is freed at once when it was loaded with arenas enabled
+	/// </summary>
+	__declspec(dllexport) void l2dReleaseModel(Live2DManagedData* model);
+
+	/// <summary>
+	/// Load subsequent models into their own arena so that releasing them does not fragment the shared heap
+	/// </summary>
+	__declspec(dllexport) void l2dSetModelArenas(int enabled);
+
+	__declspec(dllexport) void l2dGetAllocatorStatistics(AllocatorStatistics* statistics);
+
 	__declspec(dllexport) void l2dUpdateModelMatrix(Live2DManagedData* model);
 
 	__declspec(dllexport) void l2dUpdate();
@@ -28,8 +65,45 @@ extern "C" {
 
 	__declspec(dllexport) void l2dUpdateModel(Live2DManagedData* model);
 
+	/// <summary>
+	/// Update and draw copies of the same model, with one instanced draw call per drawable when possible
+	/// </summary>
+	/// <param name="models">models loaded from the same .model3.json, textures and draw order are taken from the first one</param>
+	/// <param name="count">number of models</param>
+	__declspec(dllexport) void l2dUpdateModelInstances(Live2DManagedData** models, int count);
+
 	__declspec(dllexport) int l2dHitTest(Live2DManagedData* data, const char* name, float x, float y);
 
+	/// <summary>
+	/// Same as l2dHitTest for the hit area index returned by l2dGetHitAreaIndex, avoids the name lookup
+	/// </summary>
+	__declspec(dllexport) int l2dHitTestArea(Live2DManagedData* data, int index, float x, float y);
+
+	/// <summary>
+	/// Test every hit area of the model at once, there is no limit on the number of hit areas
+	/// </summary>
+	/// <param name="outIndices">receives the indices of the hit areas containing the point in ascending order, at most capacity of them</param>
+	/// <param name="capacity">number of ints outIndices can hold, l2dGetHitAreaCount is always enough</param>
+	/// <returns>number of hit areas containing the point, when larger than capacity the indices after the first capacity ones were not written</returns>
+	__declspec(dllexport) int l2dHitTestAll(Live2DManagedData* data, float x, float y, int* outIndices, int capacity);
+
+	__declspec(dllexport) int l2dGetHitAreaCount(Live2DManagedData* data);
+
+	/// <summary>
+	/// Index of the hit area with the given name, -1 if there is none
+	/// </summary>
+	__declspec(dllexport) int l2dGetHitAreaIndex(Live2DManagedData* data, const char* name);
+
+	/// <summary>
+	/// Name of the hit area for an index written by l2dHitTestAll, NULL if out of range
+	/// </summary>
+	__declspec(dllexport) const char* l2dGetHitAreaName(Live2DManagedData* data, int index);
+
+	/// <summary>
+	/// Only count hits where the texture alpha is at least threshold, 0 = test triangles only
+	/// </summary>
+	__declspec(dllexport) void l2dSetHitTestAlphaThreshold(Live2DManagedData* data, float threshold);
+
 	__declspec(dllexport) void l2dSetExpression(Live2DManagedData* data, const char* expid);
 
 	__declspec(dllexport) void l2dSetMotion(Live2DManagedData* data, const char* group, int no, int priority);
@@ -37,4 +111,136 @@ extern "C" {
 	__declspec(dllexport) const void* l2dGetParameterId(const char* name);
 	
 	__declspec(dllexport) void l2dSetParameter(Live2DManagedData* data, const void* id, SetParameterType type, float value, float weight);
+
+	/// <summary>
+	/// Feed mono audio to lip sync without blocking, may be called from one audio thread per model
+	/// </summary>
+	/// <param name="samples">samples in -1..1</param>
+	/// <param name="rate">sample rate in Hz</param>
+	/// <returns>number of samples queued, the rest is dropped when the buffer is full. -1 if the model has no lip sync parameters</returns>
+	__declspec(dllexport) int l2dPushAudio(Live2DManagedData* data, const float* samples, int count, int rate);
+
+	/// <summary>
+	/// RMS window and attack/release time constants of pushed audio, in seconds
+	/// </summary>
+	__declspec(dllexport) void l2dSetAudioEnvelope(Live2DManagedData* data, float window, float attack, float release);
+
+	/// <summary>
+	/// Counters of the audio pushed with l2dPushAudio since the model was loaded, all zero if the model has no lip sync parameters.
+	/// pushedSamples: samples passed to l2dPushAudio, including dropped ones.
+	/// droppedSamples: samples discarded by l2dPushAudio because the ring buffer was full.
+	/// skippedSamples: queued samples discarded on update because more than 100 ms was waiting, so the mouth does not lag.
+	/// underruns: updates where fewer samples had arrived than the elapsed time needs, the last level is held for 100 ms and then released to silence
+	/// </summary>
+	__declspec(dllexport) void l2dGetAudioStatistics(Live2DManagedData* data, AudioLipSyncStatistics* statistics);
+
+	/// <summary>
+	/// Precompute the lip sync envelope of a voice file and save it beside the file as wavPath + ".lip",
+	/// motions then play the envelope instead of decoding the wav
+	/// </summary>
+	/// <param name="frameRate">envelope frames per second, 0 = 100</param>
+	/// <returns>1 if the envelope was written</returns>
+	__declspec(dllexport) int l2dBakeLipSyncEnvelope(const char* wavPath, int frameRate);
+
+	/// <summary>
+	/// Physics quality of the model, 1 = full rate, 0 = interpolation only
+	/// </summary>
+	__declspec(dllexport) void l2dSetPhysicsQuality(Live2DManagedData* data, float quality);
+
+	/// <summary>
+	/// Physics time budget shared by all models per frame, 0 = unlimited
+	/// </summary>
+	__declspec(dllexport) void l2dSetPhysicsFrameBudget(float microseconds);
+
+	/// <summary>
+	/// Advance only the physics of the model so that it starts settled
+	/// </summary>
+	__declspec(dllexport) void l2dStabilizePhysics(Live2DManagedData* data, float seconds);
+
+	/// <summary>
+	/// Snapshot of the physics state, released by l2dReleasePhysicsState. NULL if the model has no physics
+	/// </summary>
+	__declspec(dllexport) void* l2dSavePhysicsState(Live2DManagedData* data);
+
+	/// <summary>
+	/// Restore a snapshot taken by l2dSavePhysicsState, the snapshot stays valid and can be restored again
+	/// </summary>
+	/// <returns>1 if restored, 0 if the model has no physics, the snapshot is NULL or it was taken from a different physics rig</returns>
+	__declspec(dllexport) int l2dRestorePhysicsState(Live2DManagedData* data, const void* state);
+
+	/// <summary>
+	/// Free a snapshot returned by l2dSavePhysicsState, NULL is ignored
+	/// </summary>
+	__declspec(dllexport) void l2dReleasePhysicsState(void* state);
+
+	__declspec(dllexport) void l2dSetModifierProfiling(Live2DManagedData* data, int enabled);
+
+	/// <summary>
+	/// Log the average time of each parameter update op since profiling was enabled
+	/// </summary>
+	__declspec(dllexport) void l2dPrintModifierProfile(Live2DManagedData* data);
+
+	/// <summary>
+	/// Draw the model through an offscreen cache that is only redrawn when the model changed by more than threshold.
+	/// Parameter changes are measured as a fraction of each parameter's range; part opacities and the matrix as they are
+	/// </summary>
+	__declspec(dllexport) void l2dSetRenderCache(Live2DManagedData* data, int enabled, float threshold);
+
+	/// <summary>
+	/// Render the model at a fixed fraction of the window resolution and upscale it, 1 = full resolution
+	/// </summary>
+	__declspec(dllexport) void l2dSetRenderScale(Live2DManagedData* data, float scale);
+
+	/// <summary>
+	/// Adjust the render scale automatically to keep the CPU time spent drawing this model under target, 0 = stop adjusting
+	/// </summary>
+	__declspec(dllexport) void l2dSetAdaptiveRenderScale(Live2DManagedData* data, float targetMilliseconds, float minScale, float maxScale);
+
+	__declspec(dllexport) void l2dGetRenderScaleStatistics(Live2DManagedData* data, RenderScaleStatistics* statistics);
+
+	/// <summary>
+	/// Cache linked shader programs in an existing directory so later runs skip compilation, call before loading models
+	/// </summary>
+	/// <param name="dir">directory path without trailing separator, NULL or empty = no cache</param>
+	__declspec(dllexport) void l2dSetShaderCacheDirectory(const char* dir);
+
+	/// <summary>
+	/// Number of shader programs compiled or loaded from the cache so far and the time spent on each
+	/// </summary>
+	__declspec(dllexport) void l2dGetShaderStatistics(ShaderStatistics* statistics);
+
+	/// <summary>
+	/// Keep a downsampled mask of the window alpha for click-through, read back from the GPU without stalling.
+	/// The mask lags one frame behind. Without pixel buffer support (or useGpu = 0) the triangles of the drawn models are
+	/// rasterized on the CPU instead, ignoring clipping masks and transparent texels, so the mask is a coarse upper bound
+	/// </summary>
+	/// <param name="downsample">one mask pixel covers downsample x downsample window pixels</param>
+	__declspec(dllexport) void l2dSetCoverage(int enabled, int downsample, int useGpu);
+
+	/// <summary>
+	/// Update the coverage mask, call after all models are drawn and before the frame is presented
+	/// </summary>
+	__declspec(dllexport) void l2dCaptureCoverage(void);
+
+	/// <summary>
+	/// Alpha (0-255) of the coverage mask at window pixel (x, y), 0 if coverage is disabled.
+	/// When rasterized on the CPU this is at least the real alpha, never less
+	/// </summary>
+	__declspec(dllexport) int l2dQueryCoverage(float x, float y);
+
+	/// <summary>
+	/// Raw coverage mask, one byte per pixel, top row first. NULL if coverage is disabled
+	/// </summary>
+	__declspec(dllexport) const unsigned char* l2dGetCoverageMask(int* width, int* height);
+
+	/// <summary>
+	/// Skip drawables that cannot be seen: nearly transparent, outside the viewport or smaller than minPixelArea on screen.
+	/// Disabled by default, masks are still drawn from culled drawables
+	/// </summary>
+	__declspec(dllexport) void l2dSetDrawableCulling(Live2DManagedData* data, int enabled, float minOpacity, float minPixelArea);
+
+	/// <summary>
+	/// Number of drawables skipped by each culling test in the last draw of the model
+	/// </summary>
+	__declspec(dllexport) void l2dGetCullingStatistics(Live2DManagedData* data, CullingStatistics* statistics);
 }
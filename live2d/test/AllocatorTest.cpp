@@ -0,0 +1,171 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+/**
+ * LAppAllocatorのプールとモデルごとのアリーナを検証する。
+ * 読み込み中に解放された一時的な領域がアリーナに残らないこと、
+ * モデルの読み込みと解放を繰り返しても確保している領域が増え続けないことを確かめる。
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <Rendering/CubismRenderer.hpp>
+#include "LAppAllocator.hpp"
+#include "LAppModel.hpp"
+#include "MockCubismCore.hpp"
+#include "TestSupport.hpp"
+
+using namespace Live2D::Cubism::Framework;
+
+namespace {
+    const int ModelVariantCount = 4;
+    const int LoadCycleCount = 40;
+
+    LAppAllocator s_allocator;
+
+    /**
+     * @brief   Drawableの数とサブリグの数が異なるモデルを書く
+     */
+    std::string WriteVariant(int variant)
+    {
+        MockCubismCore::ModelBuilder builder;
+        builder.AddParameter("ParamAngleX", -30.0f, 30.0f, 0.0f);
+        builder.AddParameter("ParamAngleY", -30.0f, 30.0f, 0.0f);
+        for (int i = 0; i < 8 * (variant + 1); i++)
+        {
+            char id[32];
+            snprintf(id, sizeof(id), "ParamHair%d", i);
+            builder.AddParameter(id, -30.0f, 30.0f, 0.0f);
+            builder.AddGrid("Hair", 0, -0.9f + (i % 8) * 0.22f, -0.9f + (i / 8) * 0.2f, 0.2f, 0.2f, 4, 4);
+        }
+
+        TestSupport::ModelFiles files;
+        files.PhysicsJson = TestSupport::CreatePhysicsJson(8 * (variant + 1), 30.0f);
+        files.IdleMotionJsons.push_back(
+            "{\"Version\":3,\"Meta\":{\"Duration\":2,\"Fps\":30,\"Loop\":true,\"AreBeziersRestricted\":true,\"CurveCount\":1,"
+            "\"TotalSegmentCount\":2,\"TotalPointCount\":3,\"UserDataCount\":0,\"TotalUserDataSize\":0},"
+            "\"Curves\":[{\"Target\":\"Parameter\",\"Id\":\"ParamAngleY\",\"Segments\":[0,0,0,1,20,0,2,0]}]}");
+
+        char name[32];
+        snprintf(name, sizeof(name), "AllocatorTest%d", variant);
+        return TestSupport::WriteModel(name, builder, files);
+    }
+
+    void TestArenaReusesTemporaries()
+    {
+        LAppAllocator::Arena* arena = s_allocator.CreateArena();
+        std::vector<void*> kept;
+        csmSizeType chunkBytes = 0;
+        {
+            LAppAllocator::ArenaScope scope(s_allocator, arena);
+            kept.push_back(CSM_MALLOC(32));
+            chunkBytes = s_allocator.GetStatistics().ArenaReservedBytes;
+            CSM_TEST_ASSERT(chunkBytes > 0);
+
+            for (int i = 0; i < 20000; i++)
+            {
+                // csmVectorの伸長と同じく、新しい領域を確保してから古い領域を解放する
+                void* temporary = CSM_MALLOC(64);
+                for (csmSizeType size = 128; size <= 512; size *= 2)
+                {
+                    void* grown = CSM_MALLOC(size);
+                    CSM_FREE(temporary);
+                    temporary = grown;
+                }
+                CSM_FREE(temporary);
+
+                if (i % 16 == 15)
+                {
+                    kept.push_back(CSM_MALLOC(32));
+                }
+            }
+
+            // 大きな一時的な領域はヒープから確保し、解放したら残らない
+            const csmSizeType largeUsedBytes = s_allocator.GetStatistics().LargeUsedBytes;
+            void* buffer = CSM_MALLOC(1024 * 1024);
+            CSM_TEST_ASSERT_EQUAL(largeUsedBytes + 1024 * 1024, s_allocator.GetStatistics().LargeUsedBytes);
+            CSM_FREE(buffer);
+            CSM_TEST_ASSERT_EQUAL(largeUsedBytes, s_allocator.GetStatistics().LargeUsedBytes);
+        }
+
+        // 解放された一時的な領域は使い回されるので、残した分だけなら最初のチャンクに収まる
+        CSM_TEST_ASSERT_EQUAL(chunkBytes, s_allocator.GetStatistics().ArenaReservedBytes);
+
+        for (size_t i = 0; i < kept.size(); i++)
+        {
+            CSM_FREE(kept[i]);
+        }
+        s_allocator.ReleaseArena(arena);
+        CSM_TEST_ASSERT_EQUAL(0, s_allocator.GetStatistics().ArenaReservedBytes);
+        CSM_TEST_ASSERT_EQUAL(0, s_allocator.GetStatistics().ArenaCount);
+    }
+
+    void TestLoadCyclesStayBounded()
+    {
+        std::string fileNames[ModelVariantCount];
+        for (int i = 0; i < ModelVariantCount; i++)
+        {
+            fileNames[i] = WriteVariant(i);
+        }
+
+        csmSizeType arenaReservedBytes[ModelVariantCount] = {};
+        csmSizeType poolReservedBytes = 0;
+        const csmSizeType largeUsedBytes = s_allocator.GetStatistics().LargeUsedBytes;
+
+        for (int cycle = 0; cycle < LoadCycleCount; cycle++)
+        {
+            const int variant = (cycle * 3) % ModelVariantCount;
+
+            // dllのLoadManagedModelと同じく、読み込みの間だけアリーナを設定する
+            LAppAllocator::Arena* arena = s_allocator.CreateArena();
+            LAppModel* model = new LAppModel();
+            {
+                LAppAllocator::ArenaScope scope(s_allocator, arena);
+                model->LoadAssets(TestSupport::GetTemporaryDirectory().c_str(), fileNames[variant].c_str());
+            }
+
+            // 同じモデルなら何度読み込んでもアリーナの大きさは変わらない
+            const csmSizeType reservedBytes = s_allocator.GetStatistics().ArenaReservedBytes;
+            if (cycle < ModelVariantCount)
+            {
+                arenaReservedBytes[variant] = reservedBytes;
+            }
+            CSM_TEST_ASSERT_EQUAL(arenaReservedBytes[variant], reservedBytes);
+
+            delete model;
+            s_allocator.ReleaseArena(arena);
+
+            // 解放すればアリーナもヒープから確保した領域も残らない
+            const LAppAllocator::Statistics released = s_allocator.GetStatistics();
+            CSM_TEST_ASSERT_EQUAL(0, released.ArenaCount);
+            CSM_TEST_ASSERT_EQUAL(0, released.ArenaReservedBytes);
+            CSM_TEST_ASSERT_EQUAL(largeUsedBytes, released.LargeUsedBytes);
+
+            // 共有プールはすべてのモデルを一巡した後は増えない
+            if (cycle == ModelVariantCount - 1)
+            {
+                poolReservedBytes = released.PoolReservedBytes;
+            }
+            else if (cycle >= ModelVariantCount)
+            {
+                CSM_TEST_ASSERT_EQUAL(poolReservedBytes, released.PoolReservedBytes);
+            }
+        }
+    }
+}
+
+int main()
+{
+    TestSupport::FrameworkScope framework(&s_allocator);
+
+    TestArenaReusesTemporaries();
+    TestLoadCyclesStayBounded();
+
+    Rendering::CubismRenderer::StaticRelease();
+    return TestSupport::Finish("AllocatorTest");
+}
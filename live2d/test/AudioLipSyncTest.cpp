@@ -0,0 +1,165 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+/**
+ * CubismAudioLipSyncに合成したPCMを与え、リングバッファの折り返しと溢れ、
+ * サンプルが途切れた時の保持、遅延が100msを超えた時の読み飛ばし、アタック・リリースの平滑化を検証する。
+ * 値と統計は実装の式から手で求めた値と比べる。
+ * サンプリングレートは1000Hz、RMSの区間は10サンプル(0.0095秒を切り捨てて1を足した数)とする。
+ */
+
+#include <cmath>
+#include <vector>
+#include <Effect/CubismAudioLipSync.hpp>
+#include "TestSupport.hpp"
+
+using namespace Live2D::Cubism::Framework;
+
+namespace {
+    const csmUint32 SampleRate = 1000;
+    const csmFloat32 WindowSeconds = 0.0095f;
+
+    void PushConstant(CubismAudioLipSync* lipSync, csmFloat32 value, csmUint32 count, csmUint32 expectedWritten)
+    {
+        const std::vector<csmFloat32> samples(count, value);
+        CSM_TEST_ASSERT_EQUAL(expectedWritten, lipSync->Push(&samples[0], count, SampleRate));
+    }
+
+    void TestRingBuffer()
+    {
+        // 100サンプルを指定すると128サンプルに切り上げる。平滑化しないので値は区間のRMSになる
+        CubismAudioLipSync* lipSync = CubismAudioLipSync::Create(100);
+        lipSync->SetEnvelope(WindowSeconds, 0.0f, 0.0f);
+
+        // 届く前と経過時間が0の更新は何もしない
+        CSM_TEST_ASSERT_EQUAL(0.0f, lipSync->Update(0.05f));
+        PushConstant(lipSync, 0.5f, 100, 100);
+        CSM_TEST_ASSERT_EQUAL(0.0f, lipSync->Update(0.0f));
+
+        CSM_TEST_ASSERT_NEAR(0.5f, lipSync->Update(0.05f), 1e-6);
+
+        // 書き込み位置100から160まで書き、128で先頭へ折り返す。折り返しの前後で値を変える
+        std::vector<csmFloat32> samples(60);
+        for (size_t i = 0; i < samples.size(); i++)
+        {
+            samples[i] = (i < 28) ? -0.25f : 0.75f;
+        }
+        CSM_TEST_ASSERT_EQUAL(60, lipSync->Push(&samples[0], 60, SampleRate));
+
+        // 110サンプルが溜まっているので、100サンプルを残して10サンプル読み飛ばす
+        CSM_TEST_ASSERT_NEAR(0.25f, lipSync->Update(0.05f), 1e-6);
+        // 折り返した先の0.75を読む
+        CSM_TEST_ASSERT_NEAR(0.75f, lipSync->Update(0.05f), 1e-6);
+
+        // 空いている128サンプルだけ書き、残りは捨てる
+        PushConstant(lipSync, 0.1f, 200, 128);
+
+        const CubismAudioLipSync::Statistics statistics = lipSync->GetStatistics();
+        CSM_TEST_ASSERT_EQUAL(360, statistics.PushedSamples);
+        CSM_TEST_ASSERT_EQUAL(72, statistics.DroppedSamples);
+        CSM_TEST_ASSERT_EQUAL(10, statistics.SkippedSamples);
+        CSM_TEST_ASSERT_EQUAL(0, statistics.Underruns);
+
+        CubismAudioLipSync::Delete(lipSync);
+    }
+
+    void TestUnderrunHold()
+    {
+        CubismAudioLipSync* lipSync = CubismAudioLipSync::Create();
+        lipSync->SetEnvelope(WindowSeconds, 0.0f, 0.0f);
+
+        PushConstant(lipSync, 0.5f, 50, 50);
+        CSM_TEST_ASSERT_NEAR(0.5f, lipSync->Update(0.05f), 1e-6);
+
+        // 途切れてから0.1秒までは直前の音量を保つ
+        CSM_TEST_ASSERT_NEAR(0.5f, lipSync->Update(0.05f), 1e-6);
+        CSM_TEST_ASSERT_NEAR(0.5f, lipSync->Update(0.04f), 1e-6);
+        CSM_TEST_ASSERT_EQUAL(2, lipSync->GetStatistics().Underruns);
+
+        // 0.1秒を過ぎたら無音とみなす
+        CSM_TEST_ASSERT_EQUAL(0.0f, lipSync->Update(0.02f));
+        CSM_TEST_ASSERT_EQUAL(3, lipSync->GetStatistics().Underruns);
+
+        // 足りない分だけ届いた場合も数えるが、届いた分で値を求める
+        PushConstant(lipSync, 0.3f, 20, 20);
+        CSM_TEST_ASSERT_NEAR(0.3f, lipSync->Update(0.05f), 1e-6);
+        CSM_TEST_ASSERT_EQUAL(4, lipSync->GetStatistics().Underruns);
+
+        // 届いた後は保持の時間を数え直す
+        CSM_TEST_ASSERT_NEAR(0.3f, lipSync->Update(0.09f), 1e-6);
+        CSM_TEST_ASSERT_EQUAL(5, lipSync->GetStatistics().Underruns);
+
+        CubismAudioLipSync::Delete(lipSync);
+    }
+
+    void TestLatencySkip()
+    {
+        CubismAudioLipSync* lipSync = CubismAudioLipSync::Create();
+        lipSync->SetEnvelope(WindowSeconds, 0.0f, 0.0f);
+
+        // 300ms分が溜まると、古い200ms分を読み飛ばして最新の100ms分から読む
+        PushConstant(lipSync, 1.0f, 200, 200);
+        PushConstant(lipSync, 0.2f, 100, 100);
+        CSM_TEST_ASSERT_NEAR(0.2f, lipSync->Update(0.01f), 1e-6);
+        CSM_TEST_ASSERT_EQUAL(200, lipSync->GetStatistics().SkippedSamples);
+
+        // 100ms以内なら読み飛ばさない
+        PushConstant(lipSync, 0.4f, 10, 10);
+        CSM_TEST_ASSERT_NEAR(0.2f, lipSync->Update(0.01f), 1e-6);
+        CSM_TEST_ASSERT_EQUAL(200, lipSync->GetStatistics().SkippedSamples);
+        CSM_TEST_ASSERT_EQUAL(0, lipSync->GetStatistics().DroppedSamples);
+        CSM_TEST_ASSERT_EQUAL(310, lipSync->GetStatistics().PushedSamples);
+
+        CubismAudioLipSync::Delete(lipSync);
+    }
+
+    void TestAttackRelease()
+    {
+        const csmFloat32 attackSeconds = 0.02f;
+        const csmFloat32 releaseSeconds = 0.12f;
+        const csmFloat32 frameSeconds = 0.01f;
+
+        CubismAudioLipSync* lipSync = CubismAudioLipSync::Create();
+        lipSync->SetEnvelope(WindowSeconds, attackSeconds, releaseSeconds);
+
+        // 音が続く間はアタックの時定数で0.5に近づく
+        double expected = 0.0;
+        for (int frame = 0; frame < 10; frame++)
+        {
+            PushConstant(lipSync, 0.5f, 10, 10);
+            expected += (0.5 - expected) * (1.0 - exp(-frameSeconds / attackSeconds));
+            CSM_TEST_ASSERT_NEAR(expected, lipSync->Update(frameSeconds), 1e-5);
+        }
+        CSM_TEST_ASSERT(lipSync->GetValue() > 0.49f);
+
+        // 無音になるとリリースの時定数でゆっくり下がる
+        const double peak = expected;
+        for (int frame = 0; frame < 10; frame++)
+        {
+            PushConstant(lipSync, 0.0f, 10, 10);
+            expected *= exp(-frameSeconds / releaseSeconds);
+            CSM_TEST_ASSERT_NEAR(expected, lipSync->Update(frameSeconds), 1e-5);
+        }
+        CSM_TEST_ASSERT(lipSync->GetValue() > 0.4 * peak);
+        CSM_TEST_ASSERT(lipSync->GetValue() < 0.5 * peak);
+
+        CSM_TEST_ASSERT_EQUAL(0, lipSync->GetStatistics().Underruns);
+        CubismAudioLipSync::Delete(lipSync);
+    }
+}
+
+int main()
+{
+    TestSupport::FrameworkScope framework;
+
+    TestRingBuffer();
+    TestUnderrunHold();
+    TestLatencySkip();
+    TestAttackRelease();
+
+    return TestSupport::Finish("AudioLipSyncTest");
+}
@@ -0,0 +1,225 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+/**
+ * CubismMath::CalculateBoundsのSIMD実装を、1頂点ずつ比べるスカラーの参照実装と比較する。
+ * SIMDで処理しきれない端数の頂点数と、NaNを含む配列も確かめる。
+ * 最後に両者の処理時間を計測して表示する（時間は環境に依存するので検証はしない）。
+ */
+
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+#include <Math/CubismMath.hpp>
+#include "TestSupport.hpp"
+
+using namespace Live2D::Cubism::Framework;
+
+namespace {
+    const int MaximumTailLength = 17;
+    const int RandomArrayCount = 500;
+    const int BenchmarkVertexCount = 4096;
+    const int BenchmarkIterations = 2000;
+
+    struct Bounds
+    {
+        float MinX;
+        float MinY;
+        float MaxX;
+        float MaxY;
+        bool IsValid;
+    };
+
+    /**
+     * @brief   参照実装。NaNとの比較は常にfalseになるので、NaNの座標は無視される
+     */
+    Bounds CalculateReference(const float* vertices, int vertexCount)
+    {
+        Bounds bounds = { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX, false };
+        for (int i = 0; i < vertexCount; i++)
+        {
+            const float x = vertices[i * 2];
+            const float y = vertices[i * 2 + 1];
+            if (x < bounds.MinX) bounds.MinX = x;
+            if (x > bounds.MaxX) bounds.MaxX = x;
+            if (y < bounds.MinY) bounds.MinY = y;
+            if (y > bounds.MaxY) bounds.MaxY = y;
+        }
+        bounds.IsValid = bounds.MinX != FLT_MAX;
+        return bounds;
+    }
+
+    Bounds Calculate(const float* vertices, int vertexCount)
+    {
+        Bounds bounds;
+        bounds.IsValid = CubismMath::CalculateBounds(vertices, vertexCount, bounds.MinX, bounds.MinY, bounds.MaxX, bounds.MaxY);
+        return bounds;
+    }
+
+    bool IsSameBounds(const Bounds& expected, const Bounds& actual)
+    {
+        return expected.IsValid == actual.IsValid
+               && expected.MinX == actual.MinX && expected.MinY == actual.MinY
+               && expected.MaxX == actual.MaxX && expected.MaxY == actual.MaxY;
+    }
+
+    float RandomCoordinate()
+    {
+        return (static_cast<float>(rand()) / RAND_MAX) * 200.0f - 100.0f;
+    }
+
+    /**
+     * @brief   先頭を1要素ずらした位置からも計算し、アラインメントに依存しないことを確かめる
+     */
+    int CountMismatches(std::vector<float>& storage, int vertexCount)
+    {
+        int mismatches = 0;
+        for (int shift = 0; shift < 2; shift++)
+        {
+            const float* vertices = &storage[shift];
+            if (!IsSameBounds(CalculateReference(vertices, vertexCount), Calculate(vertices, vertexCount)))
+            {
+                mismatches++;
+            }
+        }
+        return mismatches;
+    }
+
+    void TestEveryTailLength()
+    {
+        // SIMDの1回の処理単位より長い配列の後ろに、0～MaximumTailLength個の端数を付ける
+        int mismatches = 0;
+        for (int base = 0; base <= 64; base += 32)
+        {
+            for (int tail = 0; tail <= MaximumTailLength; tail++)
+            {
+                const int vertexCount = base + tail;
+                std::vector<float> storage(vertexCount * 2 + 2);
+                for (size_t i = 0; i < storage.size(); i++)
+                {
+                    storage[i] = RandomCoordinate();
+                }
+
+                // 最小と最大が端数の頂点にしか無い場合
+                if (tail > 0)
+                {
+                    storage[(vertexCount - 1) * 2] = -1000.0f;
+                    storage[(vertexCount - 1) * 2 + 1] = 1000.0f;
+                    storage[vertexCount * 2] = -1000.0f;
+                    storage[vertexCount * 2 + 1] = 1000.0f;
+                }
+                mismatches += CountMismatches(storage, vertexCount);
+            }
+        }
+        CSM_TEST_ASSERT_EQUAL(0, mismatches);
+
+        // 頂点が無ければfalseを返す
+        float unused[2] = { 0.0f, 0.0f };
+        CSM_TEST_ASSERT(!Calculate(unused, 0).IsValid);
+        CSM_TEST_ASSERT(!Calculate(NULL, 4).IsValid);
+    }
+
+    void TestRandomArrays()
+    {
+        int mismatches = 0;
+        for (int array = 0; array < RandomArrayCount; array++)
+        {
+            const int vertexCount = rand() % 300;
+            std::vector<float> storage(vertexCount * 2 + 2);
+            for (size_t i = 0; i < storage.size(); i++)
+            {
+                storage[i] = RandomCoordinate();
+            }
+
+            // 正負のゼロと極端な値も混ぜる
+            if (vertexCount > 0)
+            {
+                storage[rand() % (vertexCount * 2)] = -0.0f;
+                storage[rand() % (vertexCount * 2)] = FLT_MAX;
+                storage[rand() % (vertexCount * 2)] = -FLT_MAX;
+            }
+            mismatches += CountMismatches(storage, vertexCount);
+        }
+        CSM_TEST_ASSERT_EQUAL(0, mismatches);
+    }
+
+    void TestNanArrays()
+    {
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        int mismatches = 0;
+
+        for (int vertexCount = 0; vertexCount <= 40; vertexCount++)
+        {
+            // すべてNaNなら有効な頂点は無い
+            std::vector<float> storage(vertexCount * 2 + 2, nan);
+            mismatches += CountMismatches(storage, vertexCount);
+            if (vertexCount > 0 && Calculate(&storage[0], vertexCount).IsValid)
+            {
+                mismatches++;
+            }
+
+            // 一部がNaNなら、残りの座標だけで囲む。NaNは先頭・SIMDの範囲・端数のどこにも置く
+            for (size_t i = 0; i < storage.size(); i++)
+            {
+                storage[i] = (rand() % 3 == 0) ? nan : RandomCoordinate();
+            }
+            storage[0] = nan;
+            mismatches += CountMismatches(storage, vertexCount);
+        }
+        CSM_TEST_ASSERT_EQUAL(0, mismatches);
+    }
+
+    void RunBenchmark()
+    {
+        std::vector<float> vertices(BenchmarkVertexCount * 2);
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            vertices[i] = RandomCoordinate();
+        }
+
+        // 最適化で計算が消えないように結果を足し込む
+        volatile float sink = 0.0f;
+
+        const std::chrono::steady_clock::time_point referenceStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < BenchmarkIterations; i++)
+        {
+            vertices[0] = static_cast<float>(i);
+            sink = sink + CalculateReference(&vertices[0], BenchmarkVertexCount).MaxX;
+        }
+        const std::chrono::steady_clock::time_point simdStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < BenchmarkIterations; i++)
+        {
+            vertices[0] = static_cast<float>(i);
+            sink = sink + Calculate(&vertices[0], BenchmarkVertexCount).MaxX;
+        }
+        const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+        const double vertexCount = static_cast<double>(BenchmarkVertexCount) * BenchmarkIterations;
+        const double referenceNanoseconds = std::chrono::duration<double, std::nano>(simdStart - referenceStart).count();
+        const double simdNanoseconds = std::chrono::duration<double, std::nano>(end - simdStart).count();
+        printf("CalculateBounds: scalar %.3f ns/vertex, CubismMath %.3f ns/vertex (%.2fx)\n",
+               referenceNanoseconds / vertexCount, simdNanoseconds / vertexCount,
+               (simdNanoseconds > 0.0) ? referenceNanoseconds / simdNanoseconds : 0.0);
+    }
+}
+
+int main()
+{
+    TestSupport::FrameworkScope framework;
+
+    srand(36);
+    TestEveryTailLength();
+    TestRandomArrays();
+    TestNanArrays();
+    RunBenchmark();
+
+    return TestSupport::Finish("CalculateBoundsTest");
+}
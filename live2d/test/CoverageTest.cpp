@@ -0,0 +1,163 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+/**
+ * LAppCoverageがCPUで塗るマスクが、既知のメッシュの画面上の範囲と不透明度に一致することを検証する。
+ * 以前はLAppCoverageがテストのライブラリに含まれず、CPUで塗る経路を確かめていなかった。
+ * 今はRasterizeUpperBound・EndFrame・Queryを合成モデルで確かめる。
+ */
+
+#include <vector>
+#include <Math/CubismMatrix44.hpp>
+#include <Model/CubismMoc.hpp>
+#include <Model/CubismModel.hpp>
+#include "LAppCoverage.hpp"
+#include "MockCubismCore.hpp"
+#include "TestSupport.hpp"
+
+using namespace Live2D::Cubism::Framework;
+
+namespace {
+    const int ScreenSize = 64;
+    const int Downsample = 2;
+    const int MaskSize = ScreenSize / Downsample;
+
+    /**
+     * @brief   合成モデルから作ったCubismModel
+     */
+    class MockModel
+    {
+    public:
+        explicit MockModel(const MockCubismCore::ModelBuilder& builder)
+        {
+            const std::vector<unsigned char> mocBytes = builder.BuildMoc();
+            _moc = CubismMoc::Create(&mocBytes[0], static_cast<csmSizeInt>(mocBytes.size()));
+            _model = _moc->CreateModel();
+            _model->Update();
+        }
+
+        ~MockModel()
+        {
+            _moc->DeleteModel(_model);
+            CubismMoc::Delete(_moc);
+        }
+
+        CubismModel* Get() { return _model; }
+
+    private:
+        CubismMoc* _moc;
+        CubismModel* _model;
+    };
+
+    int CountCovered(const LAppCoverage& coverage)
+    {
+        int count = 0;
+        for (int i = 0; i < coverage.GetWidth() * coverage.GetHeight(); i++)
+        {
+            count += (coverage.GetMask()[i] != 0) ? 1 : 0;
+        }
+        return count;
+    }
+
+    void TestRasterizesKnownMesh()
+    {
+        // 右上の矩形は不透明、左下の矩形は不透明度0.4で、中央で重なる。左上の矩形は表示しない
+        MockCubismCore::ModelBuilder builder;
+        const int visible = builder.AddParameter("ParamVisible", 0.0f, 1.0f, 0.0f);
+        builder.AddGrid("Opaque", 0, -0.25f, -0.25f, 0.75f, 0.75f, 3, 3);
+        const int translucent = builder.AddQuad("Translucent", 0, -0.5f, -0.5f, 0.5f, 0.5f);
+        builder.GetDrawable(translucent).Opacity = 0.4f;
+        const int hidden = builder.AddQuad("Hidden", 0, -1.0f, 0.5f, 0.5f, 0.5f);
+        builder.GetDrawable(hidden).VisibilityParameter = visible;
+        MockModel model(builder);
+
+        LAppCoverage coverage;
+        coverage.Initialize(ScreenSize, ScreenSize, Downsample, true);
+        CSM_TEST_ASSERT(coverage.IsValid());
+        CSM_TEST_ASSERT(!coverage.IsGpuReadback());
+        CSM_TEST_ASSERT_EQUAL(MaskSize, coverage.GetWidth());
+        CSM_TEST_ASSERT_EQUAL(MaskSize, coverage.GetHeight());
+
+        // モデル座標がそのままクリップ座標になる
+        CubismMatrix44 mvp;
+        coverage.BeginFrame();
+        coverage.RasterizeUpperBound(*model.Get(), mvp, 1.0f);
+
+        // EndFrameまでは前のマスクのまま
+        CSM_TEST_ASSERT_EQUAL(0, coverage.Query(40.0f, 24.0f));
+        coverage.EndFrame(0);
+
+        // 不透明な矩形はマスクの12～23列、8～19行。半透明な矩形は8～15列、16～23行。重なりは大きい方を残す
+        const int translucentValue = static_cast<int>(0.4f * 255.0f + 0.5f);
+        for (int row = 0; row < MaskSize; row++)
+        {
+            for (int column = 0; column < MaskSize; column++)
+            {
+                const bool inOpaque = column >= 12 && column < 24 && row >= 8 && row < 20;
+                const bool inTranslucent = column >= 8 && column < 16 && row >= 16 && row < 24;
+                const int expected = inOpaque ? 255 : (inTranslucent ? translucentValue : 0);
+                CSM_TEST_ASSERT_EQUAL(expected, coverage.GetMask()[row * MaskSize + column]);
+            }
+        }
+        CSM_TEST_ASSERT_EQUAL(12 * 12 + 8 * 8 - 4 * 4, CountCovered(coverage));
+
+        // Queryは画面のピクセルを縮小率で割ったマスクの値を返す
+        CSM_TEST_ASSERT_EQUAL(255, coverage.Query(24.0f, 16.0f));
+        CSM_TEST_ASSERT_EQUAL(255, coverage.Query(47.9f, 39.9f));
+        CSM_TEST_ASSERT_EQUAL(0, coverage.Query(48.0f, 16.0f));
+        CSM_TEST_ASSERT_EQUAL(translucentValue, coverage.Query(17.0f, 46.0f));
+        CSM_TEST_ASSERT_EQUAL(0, coverage.Query(-1.0f, 16.0f));
+        CSM_TEST_ASSERT_EQUAL(0, coverage.Query(24.0f, ScreenSize + 1.0f));
+
+        // モデルの不透明度を掛ける。次のフレームは塗り直す
+        coverage.BeginFrame();
+        coverage.RasterizeUpperBound(*model.Get(), mvp, 0.5f);
+        coverage.EndFrame(0);
+        CSM_TEST_ASSERT_EQUAL(128, coverage.Query(24.0f, 16.0f));
+        CSM_TEST_ASSERT_EQUAL(static_cast<int>(0.4f * 0.5f * 255.0f + 0.5f), coverage.Query(17.0f, 46.0f));
+
+        // 何も描かないフレームは空になる
+        coverage.BeginFrame();
+        coverage.EndFrame(0);
+        CSM_TEST_ASSERT_EQUAL(0, CountCovered(coverage));
+
+        coverage.Release();
+        CSM_TEST_ASSERT(!coverage.IsValid());
+        CSM_TEST_ASSERT(coverage.GetMask() == NULL);
+        CSM_TEST_ASSERT_EQUAL(0, coverage.Query(24.0f, 16.0f));
+    }
+
+    void TestIgnoresClippingMasks()
+    {
+        // 小さいマスクで切り抜かれる矩形も、三角形全体を塗る。実際の不透明度の上界になる
+        MockCubismCore::ModelBuilder builder;
+        const int mask = builder.AddQuad("Mask", 0, -0.125f, -0.125f, 0.25f, 0.25f);
+        const int clipped = builder.AddQuad("Clipped", 0, -0.5f, -0.5f, 1.0f, 1.0f);
+        builder.GetDrawable(clipped).Masks.push_back(mask);
+        MockModel model(builder);
+
+        LAppCoverage coverage;
+        coverage.Initialize(ScreenSize, ScreenSize, Downsample, false);
+        CubismMatrix44 mvp;
+        coverage.BeginFrame();
+        coverage.RasterizeUpperBound(*model.Get(), mvp, 1.0f);
+        coverage.EndFrame(0);
+
+        CSM_TEST_ASSERT_EQUAL(16 * 16, CountCovered(coverage));
+        CSM_TEST_ASSERT_EQUAL(255, coverage.Query(18.0f, 18.0f));
+    }
+}
+
+int main()
+{
+    TestSupport::FrameworkScope framework;
+
+    TestRasterizesKnownMesh();
+    TestIgnoresClippingMasks();
+
+    return TestSupport::Finish("CoverageTest");
+}
@@ -0,0 +1,283 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+/**
+ * LAppHitTesterのグリッドを使った判定が三角形の内外と一致し、
+ * テクスチャのアルファが下限に満たない位置を当たりにしないことを検証する。
+ * 以前はLAppModel::HitTestが名前を文字列で順に比べていた。今は番号に引いた当たり判定をLAppHitTesterで判定する。
+ * 以前はLAppModel::HitTestAllが64ビットのマスクを返し、65番目以降の当たり判定を落としていた。
+ * 今は呼び出し側の配列に番号を書き、書ききれなかった分も数える。
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <Model/CubismMoc.hpp>
+#include <Model/CubismModel.hpp>
+#include "LAppHitTester.hpp"
+#include "LAppModel.hpp"
+#include "MockCubismCore.hpp"
+#include "TestSupport.hpp"
+
+using namespace Live2D::Cubism::Framework;
+
+namespace {
+    /**
+     * @brief   合成モデルから作ったCubismModel
+     */
+    class MockModel
+    {
+    public:
+        explicit MockModel(const MockCubismCore::ModelBuilder& builder)
+        {
+            const std::vector<unsigned char> mocBytes = builder.BuildMoc();
+            _moc = CubismMoc::Create(&mocBytes[0], static_cast<csmSizeInt>(mocBytes.size()));
+            _model = _moc->CreateModel();
+            _model->Update();
+        }
+
+        ~MockModel()
+        {
+            _moc->DeleteModel(_model);
+            CubismMoc::Delete(_moc);
+        }
+
+        CubismModel* Get() { return _model; }
+
+    private:
+        CubismMoc* _moc;
+        CubismModel* _model;
+    };
+
+    /**
+     * @brief   中心と4つの頂点を結ぶ、|x| + |y| <= 0.5のひし形のDrawable
+     */
+    MockCubismCore::DrawableDescription CreateDiamond()
+    {
+        const float positions[] = { 0.0f, 0.5f, 0.5f, 0.0f, 0.0f, -0.5f, -0.5f, 0.0f, 0.0f, 0.0f };
+        const unsigned short indices[] = { 4, 0, 1, 4, 1, 2, 4, 2, 3, 4, 3, 0 };
+
+        MockCubismCore::DrawableDescription drawable;
+        drawable.Id = "Diamond";
+        for (size_t i = 0; i < sizeof(positions) / sizeof(positions[0]); i++)
+        {
+            drawable.Positions.push_back(positions[i]);
+            drawable.Uvs.push_back(positions[i] + 0.5f);
+        }
+        drawable.Indices.assign(indices, indices + sizeof(indices) / sizeof(indices[0]));
+        return drawable;
+    }
+
+    void TestGridMatchesTriangles()
+    {
+        MockCubismCore::ModelBuilder builder;
+        const int move = builder.AddParameter("ParamMove", 0.0f, 1.0f, 0.0f);
+        const int diamond = builder.AddDrawable(CreateDiamond());
+        builder.GetDrawable(diamond).MoveParameter = move;
+        builder.GetDrawable(diamond).MoveX = 1.0f;
+        builder.AddGrid("Grid", 0, -0.8f, -0.6f, 1.6f, 1.2f, 12, 16);
+
+        MockModel model(builder);
+        LAppHitTester hitTester;
+        hitTester.Initialize(*model.Get());
+
+        // 格子点の内外が解析的な内外と一致する。辺の上の点は避ける
+        int hits = 0;
+        for (int row = 0; row < 40; row++)
+        {
+            for (int column = 0; column < 40; column++)
+            {
+                const float x = -1.0f + (column + 0.5f) / 20.0f;
+                const float y = -1.0f + (row + 0.5f) / 20.0f;
+                const bool inDiamond = fabsf(x) + fabsf(y) <= 0.5f;
+                const bool inGrid = x >= -0.8f && x <= 0.8f && y >= -0.6f && y <= 0.6f;
+                CSM_TEST_ASSERT_EQUAL(inDiamond, hitTester.IsHit(*model.Get(), 0, x, y));
+                CSM_TEST_ASSERT_EQUAL(inGrid, hitTester.IsHit(*model.Get(), 1, x, y));
+                hits += inDiamond ? 1 : 0;
+            }
+        }
+        CSM_TEST_ASSERT(hits > 0);
+
+        // 外接矩形の内側でも三角形の外なら外れ。辺の上は当たり
+        CSM_TEST_ASSERT(!hitTester.IsHit(*model.Get(), 0, 0.4f, 0.4f));
+        CSM_TEST_ASSERT(hitTester.IsHit(*model.Get(), 0, 0.25f, 0.25f));
+        CSM_TEST_ASSERT(hitTester.IsHit(*model.Get(), 1, 0.8f, 0.6f));
+
+        // 範囲外のDrawableは外れ
+        CSM_TEST_ASSERT(!hitTester.IsHit(*model.Get(), -1, 0.0f, 0.0f));
+        CSM_TEST_ASSERT(!hitTester.IsHit(*model.Get(), 2, 0.0f, 0.0f));
+
+        // 頂点が動いたらグリッドを作り直す
+        model.Get()->SetParameterValue(move, 1.0f);
+        model.Get()->Update();
+        hitTester.Update(*model.Get());
+        CSM_TEST_ASSERT(!hitTester.IsHit(*model.Get(), 0, 0.0f, 0.0f));
+        CSM_TEST_ASSERT(hitTester.IsHit(*model.Get(), 0, 1.0f, 0.0f));
+        CSM_TEST_ASSERT(hitTester.IsHit(*model.Get(), 0, 1.2f, 0.2f));
+        CSM_TEST_ASSERT(!hitTester.IsHit(*model.Get(), 0, 1.4f, 0.2f));
+    }
+
+    void TestAlphaThreshold()
+    {
+        MockCubismCore::ModelBuilder builder;
+        builder.AddQuad("Quad", 0, -0.5f, -0.5f, 1.0f, 1.0f);
+        MockModel model(builder);
+
+        LAppHitTester hitTester;
+        hitTester.Initialize(*model.Get());
+
+        // 4×2のテクスチャ。左の列から透明・半透明・不透明・不透明で、上下の行は同じ
+        const csmUint8 alpha[] = { 0, 100, 255, 255, 0, 100, 255, 255 };
+        hitTester.SetTextureAlpha(0, alpha, 4, 2);
+
+        const float transparentX = -0.375f;
+        const float translucentX = -0.125f;
+        const float opaqueX = 0.25f;
+
+        // 下限が0ならアルファを見ない
+        CSM_TEST_ASSERT(hitTester.IsHit(*model.Get(), 0, transparentX, 0.0f));
+
+        hitTester.SetAlphaThreshold(0.3f);
+        CSM_TEST_ASSERT(!hitTester.IsHit(*model.Get(), 0, transparentX, 0.0f));
+        CSM_TEST_ASSERT(hitTester.IsHit(*model.Get(), 0, translucentX, 0.25f));
+        CSM_TEST_ASSERT(hitTester.IsHit(*model.Get(), 0, opaqueX, -0.25f));
+
+        hitTester.SetAlphaThreshold(0.5f);
+        CSM_TEST_ASSERT(!hitTester.IsHit(*model.Get(), 0, transparentX, 0.0f));
+        CSM_TEST_ASSERT(!hitTester.IsHit(*model.Get(), 0, translucentX, 0.25f));
+        CSM_TEST_ASSERT(hitTester.IsHit(*model.Get(), 0, opaqueX, -0.25f));
+
+        // 三角形の外はアルファによらず外れ
+        CSM_TEST_ASSERT(!hitTester.IsHit(*model.Get(), 0, 0.75f, 0.0f));
+
+        // 写しを外すとアルファを見ない
+        hitTester.SetTextureAlpha(0, NULL, 0, 0);
+        CSM_TEST_ASSERT(hitTester.IsHit(*model.Get(), 0, transparentX, 0.0f));
+    }
+
+    /**
+     * @brief   当たり判定を外から見られるLAppModel
+     */
+    class HitTestModel : public LAppModel
+    {
+    public:
+        void SetOpacity(csmFloat32 opacity) { _opacity = opacity; }
+    };
+
+    void TestModelHitAreas()
+    {
+        MockCubismCore::ModelBuilder builder;
+        builder.AddQuad("Head", 0, -0.5f, 0.0f, 1.0f, 0.5f);
+        builder.AddQuad("Body", 0, -0.5f, -0.5f, 1.0f, 0.5f);
+
+        TestSupport::ModelFiles files;
+        files.HitAreaIds.push_back("Body");
+        files.HitAreaIds.push_back("Head");
+        files.HitAreaIds.push_back("Missing");
+        const std::string fileName = TestSupport::WriteModel("HitTestTest", builder, files);
+
+        HitTestModel* model = new HitTestModel();
+        model->LoadAssets(TestSupport::GetTemporaryDirectory().c_str(), fileName.c_str());
+        model->GetModel()->Update(); // 頂点はモデルを更新して初めて計算される
+
+        CSM_TEST_ASSERT_EQUAL(3, model->GetHitAreaCount());
+        CSM_TEST_ASSERT_EQUAL(0, model->GetHitAreaIndex("Body"));
+        CSM_TEST_ASSERT_EQUAL(1, model->GetHitAreaIndex("Head"));
+        CSM_TEST_ASSERT_EQUAL(2, model->GetHitAreaIndex("Missing"));
+        CSM_TEST_ASSERT_EQUAL(-1, model->GetHitAreaIndex("Hand"));
+        CSM_TEST_ASSERT_EQUAL(-1, model->GetHitAreaIndex(NULL));
+
+        // モデル行列は単位行列なので、モデル座標がそのまま画面の座標になる
+        CSM_TEST_ASSERT(model->HitTest("Head", 0.0f, 0.25f));
+        CSM_TEST_ASSERT(!model->HitTest("Head", 0.0f, -0.25f));
+        CSM_TEST_ASSERT(model->HitTest("Body", 0.0f, -0.25f));
+        CSM_TEST_ASSERT(!model->HitTest("Missing", 0.0f, 0.25f));
+        CSM_TEST_ASSERT(!model->HitTest("Hand", 0.0f, 0.25f));
+
+        CSM_TEST_ASSERT(model->HitTestArea(1, 0.0f, 0.25f));
+        CSM_TEST_ASSERT(!model->HitTestArea(0, 0.0f, 0.25f));
+        CSM_TEST_ASSERT(!model->HitTestArea(-1, 0.0f, 0.25f));
+        CSM_TEST_ASSERT(!model->HitTestArea(3, 0.0f, 0.25f));
+
+        // 透明時は当たらない
+        model->SetOpacity(0.5f);
+        CSM_TEST_ASSERT(!model->HitTest("Head", 0.0f, 0.25f));
+        CSM_TEST_ASSERT(!model->HitTestArea(1, 0.0f, 0.25f));
+
+        delete model;
+    }
+
+    void TestHitTestAllOverlapping()
+    {
+        // 65個以上の当たり判定が重なる。3つに1つは原点から外す
+        const int AreaCount = 70;
+        MockCubismCore::ModelBuilder builder;
+        TestSupport::ModelFiles files;
+        std::vector<int> expected;
+        for (int i = 0; i < AreaCount; i++)
+        {
+            char id[32];
+            snprintf(id, sizeof(id), "Area%02d", i);
+            const bool containsOrigin = (i % 3) != 2;
+            builder.AddQuad(id, 0, containsOrigin ? -0.3f + 0.004f * i : 0.5f, -0.25f, 0.5f, 0.5f);
+            files.HitAreaIds.push_back(id);
+            if (containsOrigin)
+            {
+                expected.push_back(i);
+            }
+        }
+        const std::string fileName = TestSupport::WriteModel("HitTestAllTest", builder, files);
+
+        HitTestModel* model = new HitTestModel();
+        model->LoadAssets(TestSupport::GetTemporaryDirectory().c_str(), fileName.c_str());
+        model->GetModel()->Update();
+
+        // 全部書ける場合は番号を小さい順に書く
+        std::vector<csmInt32> indices(AreaCount, -1);
+        CSM_TEST_ASSERT_EQUAL(expected.size(), model->HitTestAll(0.0f, 0.0f, &indices[0], AreaCount));
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            CSM_TEST_ASSERT_EQUAL(expected[i], indices[i]);
+        }
+        CSM_TEST_ASSERT_EQUAL(-1, indices[expected.size()]);
+        CSM_TEST_ASSERT(expected.back() >= 64);
+
+        // 書き先が足りなければ書ける分だけ書き、全体の数を返す
+        std::vector<csmInt32> few(5, -1);
+        CSM_TEST_ASSERT_EQUAL(expected.size(), model->HitTestAll(0.0f, 0.0f, &few[0], 4));
+        for (int i = 0; i < 4; i++)
+        {
+            CSM_TEST_ASSERT_EQUAL(expected[i], few[i]);
+        }
+        CSM_TEST_ASSERT_EQUAL(-1, few[4]);
+        CSM_TEST_ASSERT_EQUAL(expected.size(), model->HitTestAll(0.0f, 0.0f, NULL, 0));
+
+        // 原点から外した当たり判定だけが含む座標
+        CSM_TEST_ASSERT_EQUAL(AreaCount - static_cast<int>(expected.size()), model->HitTestAll(0.9f, 0.0f, &indices[0], AreaCount));
+        CSM_TEST_ASSERT_EQUAL(2, indices[0]);
+        CSM_TEST_ASSERT_EQUAL(0, model->HitTestAll(0.0f, 0.4f, &indices[0], AreaCount));
+
+        // 透明時は当たらない
+        model->SetOpacity(0.5f);
+        CSM_TEST_ASSERT_EQUAL(0, model->HitTestAll(0.0f, 0.0f, &indices[0], AreaCount));
+
+        delete model;
+    }
+}
+
+int main()
+{
+    TestSupport::FrameworkScope framework;
+
+    TestGridMatchesTriangles();
+    TestAlphaThreshold();
+    TestModelHitAreas();
+    TestHitTestAllOverlapping();
+
+    return TestSupport::Finish("HitTestTest");
+}
@@ -0,0 +1,142 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+/**
+ * 事前に計算した包絡線のRMSが、再生時にwavファイルから求めるRMSと一致することを検証する。
+ * 音声は300Hzの正弦波の振幅を1.5Hzで揺らし、途中に無音の区間を挟んだものを生成する。
+ * 300Hzは100fpsと60fpsのどちらの区間にも整数周期が収まるので、区間の位相によるRMSの揺れは入らない。
+ *
+ * 誤差の上限:
+ * - 量子化: 値はRMSの平方根を1/255刻みで丸めるので、RMSがrのときの誤差は最大でsqrt(r)/255（r <= 0.6で0.0031）
+ * - 補間: 包絡線は100fpsの区間の平均を線形補間し、再生時は60fpsの区間の平均を求める。
+ *   RMSの揺れの振幅は約0.25なので、区間の長さの違いと線形補間による差はどちらも0.0003程度
+ * 以上から、最大誤差の上限を0.005、平均絶対誤差の上限を0.002とする。
+ * 無音の始まりと終わりをまたぐ区間は、包絡線と再生時とで音を含む割合が違うので最大誤差からは除く。
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "LAppLipSyncEnvelope.hpp"
+#include "LAppWavFileHandler.hpp"
+#include "TestSupport.hpp"
+
+using namespace Live2D::Cubism::Framework;
+
+namespace {
+    const int SampleRate = 48000;
+    const float DurationSeconds = 3.0f;
+    const float SilenceBegin = 1.2f;
+    const float SilenceEnd = 1.5f;
+    const float PlaybackFrameSeconds = 1.0f / 60.0f;
+    const float MeanErrorBound = 0.002f;
+    const float MaximumErrorBound = 0.005f;
+
+    void Put16(std::vector<unsigned char>& data, unsigned int value)
+    {
+        data.push_back(static_cast<unsigned char>(value));
+        data.push_back(static_cast<unsigned char>(value >> 8));
+    }
+
+    void Put32(std::vector<unsigned char>& data, unsigned int value)
+    {
+        Put16(data, value & 0xFFFF);
+        Put16(data, value >> 16);
+    }
+
+    void PutTag(std::vector<unsigned char>& data, const char* tag)
+    {
+        data.insert(data.end(), tag, tag + 4);
+    }
+
+    /**
+     * @brief   振幅を揺らした300Hzの正弦波を、16bitモノラルのwavファイルとして書く
+     */
+    std::string WriteTestWav()
+    {
+        const int sampleCount = static_cast<int>(SampleRate * DurationSeconds);
+        std::vector<unsigned char> data;
+        PutTag(data, "RIFF");
+        Put32(data, 36 + sampleCount * 2);
+        PutTag(data, "WAVE");
+        PutTag(data, "fmt ");
+        Put32(data, 16);
+        Put16(data, 1);
+        Put16(data, 1);
+        Put32(data, SampleRate);
+        Put32(data, SampleRate * 2);
+        Put16(data, 2);
+        Put16(data, 16);
+        PutTag(data, "data");
+        Put32(data, sampleCount * 2);
+
+        for (int i = 0; i < sampleCount; i++)
+        {
+            const float time = static_cast<float>(i) / SampleRate;
+            const float amplitude = (time >= SilenceBegin && time < SilenceEnd) ? 0.0f : 0.45f + 0.35f * sinf(2.0f * 3.14159265f * 1.5f * time);
+            const float sample = amplitude * sinf(2.0f * 3.14159265f * 300.0f * time);
+            Put16(data, static_cast<unsigned int>(static_cast<int>(sample * 32767.0f)) & 0xFFFF);
+        }
+
+        return TestSupport::WriteFile("LipSyncEnvelopeTest.wav", &data[0], data.size());
+    }
+
+    void TestEnvelopeMatchesRuntimeRms()
+    {
+        const csmString wavPath(WriteTestWav().c_str());
+        CSM_TEST_ASSERT(LAppLipSyncEnvelope::Bake(wavPath, LAppLipSyncEnvelope::DefaultFrameRate));
+
+        LAppWavFileHandler wavFileHandler;
+        LAppLipSyncEnvelope envelope;
+        wavFileHandler.Start(wavPath);
+        CSM_TEST_ASSERT(envelope.Start(wavPath));
+
+        int frames = 0;
+        float totalError = 0.0f;
+        float maximumError = 0.0f;
+        float maximumRms = 0.0f;
+        float time = 0.0f;
+        while (wavFileHandler.Update(PlaybackFrameSeconds))
+        {
+            CSM_TEST_ASSERT(envelope.Update(PlaybackFrameSeconds));
+            time += PlaybackFrameSeconds;
+
+            const float error = fabsf(envelope.GetRms() - wavFileHandler.GetRms());
+            frames++;
+            totalError += error;
+            maximumRms = fmaxf(maximumRms, wavFileHandler.GetRms());
+
+            // 無音の始まりと終わりをまたぐ区間は除く
+            const float margin = 2.0f * PlaybackFrameSeconds;
+            if (fabsf(time - SilenceBegin) > margin && fabsf(time - SilenceEnd) > margin)
+            {
+                maximumError = fmaxf(maximumError, error);
+            }
+        }
+        const float meanError = totalError / frames;
+        printf("LipSyncEnvelopeTest: mean error %.5f, maximum error %.5f\n", meanError, maximumError);
+
+        CSM_TEST_ASSERT(frames >= static_cast<int>(DurationSeconds / PlaybackFrameSeconds));
+        CSM_TEST_ASSERT(maximumRms > 0.5f);
+        CSM_TEST_ASSERT(meanError < MeanErrorBound);
+        CSM_TEST_ASSERT(maximumError < MaximumErrorBound);
+
+        // 末尾に達したら包絡線も止まる
+        CSM_TEST_ASSERT(!envelope.Update(PlaybackFrameSeconds));
+        CSM_TEST_ASSERT_EQUAL(0.0f, envelope.GetRms());
+    }
+}
+
+int main()
+{
+    TestSupport::FrameworkScope framework;
+
+    TestEnvelopeMatchesRuntimeRms();
+
+    return TestSupport::Finish("LipSyncEnvelopeTest");
+}
@@ -0,0 +1,217 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+/**
+ * マスク用のレンダーテクスチャへのマスクの配置を、記録用のrlglで検証する。
+ * 以前はマスクの数だけで決まる均等な格子に並べていた。
+ * 今は画面上の大きさに合わせた矩形を各チャンネルへ棚詰めし、入りきらなければ全体を縮小して詰め直す。
+ */
+
+#include <cmath>
+#include <vector>
+#include "MockCubismCore.hpp"
+#include "RenderedModel.hpp"
+#include "TestSupport.hpp"
+
+using namespace Live2D::Cubism::Framework;
+using namespace Live2D::Cubism::Framework::Rendering;
+using TestSupport::RenderedModel;
+
+namespace {
+    const int MaskBufferSize = 256;
+    const int ChannelCount = 4;
+    const float PixelsPerUnit = RenderedModel::ViewportSize * 0.5f;
+
+    /**
+     * @brief   マスクを使うDrawableのレンダーテクスチャ上の配置
+     */
+    struct MaskLayout
+    {
+        csmInt32 BufferIndex;
+        csmInt32 ChannelNo;
+        csmRectF Bounds;
+    };
+
+    /**
+     * @brief   大きさの異なるDrawableに、それぞれ別のマスクを付けたモデル
+     *
+     * @return  マスクを使うDrawableのインデックス
+     */
+    std::vector<int> AddMaskedQuads(MockCubismCore::ModelBuilder& builder, const std::vector<float>& sizes)
+    {
+        std::vector<int> clipped;
+        for (size_t i = 0; i < sizes.size(); i++)
+        {
+            const int mask = builder.AddQuad("Mask", 0, -0.9f, -0.9f, 0.05f, 0.05f);
+            const int drawable = builder.AddQuad("Clipped", 0, -0.9f, -0.9f, sizes[i], sizes[i]);
+            builder.GetDrawable(drawable).Masks.push_back(mask);
+            clipped.push_back(drawable);
+        }
+        return clipped;
+    }
+
+    /**
+     * @brief   画面上の大きさからマスク領域の一辺を求める。マージンと16ピクセル単位の切り上げを含む
+     */
+    int GetSlotPixels(float size, float scale)
+    {
+        return static_cast<int>(ceilf(size * 1.1f * PixelsPerUnit * scale / 16.0f)) * 16;
+    }
+
+    std::vector<MaskLayout> GetLayouts(RenderedModel& rendered, const std::vector<int>& clipped)
+    {
+        std::vector<MaskLayout> layouts;
+        for (size_t i = 0; i < clipped.size(); i++)
+        {
+            MaskLayout layout;
+            CSM_TEST_ASSERT(rendered.GetRenderer()->GetMaskLayout(clipped[i], layout.BufferIndex, layout.ChannelNo, layout.Bounds));
+            layouts.push_back(layout);
+        }
+        return layouts;
+    }
+
+    /**
+     * @brief   すべての矩形がキャンバスに収まり、同じチャンネルの矩形同士が重ならないことを確かめる
+     */
+    void AssertNoOverlap(const std::vector<MaskLayout>& layouts, int bufferCount)
+    {
+        for (size_t i = 0; i < layouts.size(); i++)
+        {
+            const MaskLayout& a = layouts[i];
+            CSM_TEST_ASSERT(a.BufferIndex >= 0 && a.BufferIndex < bufferCount);
+            CSM_TEST_ASSERT(a.ChannelNo >= 0 && a.ChannelNo < ChannelCount);
+            CSM_TEST_ASSERT(a.Bounds.X >= 0.0f && a.Bounds.GetRight() <= 1.0f);
+            CSM_TEST_ASSERT(a.Bounds.Y >= 0.0f && a.Bounds.GetBottom() <= 1.0f);
+
+            for (size_t j = i + 1; j < layouts.size(); j++)
+            {
+                const MaskLayout& b = layouts[j];
+                if (a.BufferIndex != b.BufferIndex || a.ChannelNo != b.ChannelNo)
+                {
+                    continue;
+                }
+                const bool isSeparated = a.Bounds.GetRight() <= b.Bounds.X || b.Bounds.GetRight() <= a.Bounds.X
+                    || a.Bounds.GetBottom() <= b.Bounds.Y || b.Bounds.GetBottom() <= a.Bounds.Y;
+                CSM_TEST_ASSERT(isSeparated);
+            }
+        }
+    }
+
+    /**
+     * @brief   マスクの生成で塗ったピクセル数。使ったレンダーテクスチャのクリアと、各マスク領域の合計
+     */
+    double GetExpectedPixelFill(const std::vector<MaskLayout>& layouts, int bufferCount)
+    {
+        const double bufferPixels = static_cast<double>(MaskBufferSize) * MaskBufferSize;
+        double fill = bufferPixels * bufferCount;
+        for (size_t i = 0; i < layouts.size(); i++)
+        {
+            fill += bufferPixels * layouts[i].Bounds.Width * layouts[i].Bounds.Height;
+        }
+        return fill;
+    }
+
+    void TestPacksDifferentSizes()
+    {
+        std::vector<float> sizes;
+        sizes.push_back(0.1f);
+        sizes.push_back(0.5f);
+        sizes.push_back(0.2f);
+        sizes.push_back(0.4f);
+        sizes.push_back(0.3f);
+        sizes.push_back(0.15f);
+
+        MockCubismCore::ModelBuilder builder;
+        const std::vector<int> clipped = AddMaskedQuads(builder, sizes);
+        RenderedModel rendered(builder);
+        const CubismRlglRecorder::Statistics& first = rendered.DrawFrame();
+        CSM_TEST_ASSERT_EQUAL(0, first.InvalidCalls);
+
+        // 1チャンネルに収まるので縮小せず、画面上と同じ解像度で配置する
+        const std::vector<MaskLayout> layouts = GetLayouts(rendered, clipped);
+        for (size_t i = 0; i < layouts.size(); i++)
+        {
+            const int expected = GetSlotPixels(sizes[i], 1.0f);
+            CSM_TEST_ASSERT_EQUAL(expected, static_cast<int>(layouts[i].Bounds.Width * MaskBufferSize + 0.5f));
+            CSM_TEST_ASSERT_EQUAL(expected, static_cast<int>(layouts[i].Bounds.Height * MaskBufferSize + 0.5f));
+        }
+        AssertNoOverlap(layouts, 1);
+
+        // 棚詰めは背の高い順なので、最も大きいマスクが1枚目のRチャンネルの左上に来る
+        CSM_TEST_ASSERT_EQUAL(0, layouts[1].BufferIndex);
+        CSM_TEST_ASSERT_EQUAL(0, layouts[1].ChannelNo);
+        CSM_TEST_ASSERT_NEAR(0.0f, layouts[1].Bounds.X, 1e-6);
+        CSM_TEST_ASSERT_NEAR(0.0f, layouts[1].Bounds.Y, 1e-6);
+
+        const CubismRenderer_OpenGLES2::FrameStatistics& frame = rendered.GetRenderer()->GetFrameStatistics();
+        CSM_TEST_ASSERT_EQUAL(static_cast<csmUint32>(sizes.size()), frame.MaskRedraws);
+        CSM_TEST_ASSERT_NEAR(GetExpectedPixelFill(layouts, 1), frame.MaskPixelFill, sizes.size());
+    }
+
+    void TestShrinksUntilMasksFit()
+    {
+        // 1つ240ピクセルの領域が12個あり、4チャンネルには1つずつしか入らない。
+        // 0.8倍ずつ3回縮めると128ピクセルになり、1チャンネルに4つずつ入る
+        const int MaskCount = 12;
+        const float size = 0.8f;
+        std::vector<float> sizes(MaskCount, size);
+        CSM_TEST_ASSERT_EQUAL(240, GetSlotPixels(size, 1.0f));
+        CSM_TEST_ASSERT_EQUAL(160, GetSlotPixels(size, 0.8f * 0.8f));
+
+        MockCubismCore::ModelBuilder builder;
+        const std::vector<int> clipped = AddMaskedQuads(builder, sizes);
+        RenderedModel rendered(builder);
+        const CubismRlglRecorder::Statistics& first = rendered.DrawFrame();
+        CSM_TEST_ASSERT_EQUAL(0, first.InvalidCalls);
+
+        const std::vector<MaskLayout> layouts = GetLayouts(rendered, clipped);
+        const int expected = GetSlotPixels(size, 0.8f * 0.8f * 0.8f);
+        CSM_TEST_ASSERT_EQUAL(128, expected);
+        for (size_t i = 0; i < layouts.size(); i++)
+        {
+            CSM_TEST_ASSERT_EQUAL(expected, static_cast<int>(layouts[i].Bounds.Width * MaskBufferSize + 0.5f));
+        }
+        AssertNoOverlap(layouts, 1);
+
+        // 3チャンネルを埋め、4つ目のチャンネルは使わない
+        int usedChannels = 0;
+        for (size_t i = 0; i < layouts.size(); i++)
+        {
+            if (layouts[i].ChannelNo + 1 > usedChannels)
+            {
+                usedChannels = layouts[i].ChannelNo + 1;
+            }
+        }
+        CSM_TEST_ASSERT_EQUAL(3, usedChannels);
+
+        const CubismRenderer_OpenGLES2::FrameStatistics& frame = rendered.GetRenderer()->GetFrameStatistics();
+        CSM_TEST_ASSERT_NEAR(GetExpectedPixelFill(layouts, 1), frame.MaskPixelFill, MaskCount);
+
+        // レンダーテクスチャを3枚にすれば12チャンネルになり、縮小せずに収まる
+        rendered.GetRenderer()->SetMaskBufferCount(3);
+        rendered.GetModel()->Update();
+        rendered.DrawFrame();
+        const std::vector<MaskLayout> tripled = GetLayouts(rendered, clipped);
+        for (size_t i = 0; i < tripled.size(); i++)
+        {
+            CSM_TEST_ASSERT_EQUAL(GetSlotPixels(size, 1.0f), static_cast<int>(tripled[i].Bounds.Width * MaskBufferSize + 0.5f));
+        }
+        AssertNoOverlap(tripled, 3);
+        CSM_TEST_ASSERT_NEAR(GetExpectedPixelFill(tripled, 3), frame.MaskPixelFill, MaskCount);
+    }
+}
+
+int main()
+{
+    TestSupport::FrameworkScope framework;
+
+    TestPacksDifferentSizes();
+    TestShrinksUntilMasksFit();
+
+    CubismRenderer::StaticRelease();
+    return TestSupport::Finish("MaskPackingTest");
+}
@@ -0,0 +1,669 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+#include "MockCubismCore.hpp"
+#include <algorithm>
+#include <cstring>
+#include "Live2DCubismCore.hpp"
+
+using namespace Live2D::Cubism::Core;
+
+namespace MockCubismCore {
+
+/**
+ * @brief   登録したモデルの、Coreの関数が返す形に並べ直した定数部分
+ */
+struct MocData
+{
+    csmVector2 CanvasSize;
+    csmVector2 CanvasOrigin;
+    float PixelsPerUnit;
+
+    std::vector<std::string> ParameterIdStrings;
+    std::vector<const char*> ParameterIds;
+    std::vector<csmParameterType> ParameterTypes;
+    std::vector<float> ParameterMinimums;
+    std::vector<float> ParameterMaximums;
+    std::vector<float> ParameterDefaults;
+
+    std::vector<std::string> PartIdStrings;
+    std::vector<const char*> PartIds;
+    std::vector<int> PartParents;
+
+    std::vector<DrawableDescription> Drawables;
+    std::vector<const char*> DrawableIds;
+    std::vector<csmFlags> ConstantFlags;
+    std::vector<int> TextureIndices;
+    std::vector<int> DrawOrders;
+    std::vector<int> MaskCounts;
+    std::vector<const int*> Masks;
+    std::vector<int> VertexCounts;
+    std::vector<std::vector<csmVector2> > UvStorage;
+    std::vector<const csmVector2*> Uvs;
+    std::vector<int> IndexCounts;
+    std::vector<const unsigned short*> Indices;
+    std::vector<int> ParentParts;
+    int VertexTotal;
+
+    explicit MocData(const ModelBuilder& builder)
+        : PixelsPerUnit(builder._pixelsPerUnit)
+        , VertexTotal(0)
+    {
+        CanvasSize.X = builder._canvasWidth;
+        CanvasSize.Y = builder._canvasHeight;
+        CanvasOrigin.X = builder._canvasWidth * 0.5f;
+        CanvasOrigin.Y = builder._canvasHeight * 0.5f;
+
+        for (size_t i = 0; i < builder._parameters.size(); i++)
+        {
+            ParameterIdStrings.push_back(builder._parameters[i].Id);
+            ParameterTypes.push_back(csmParameterType_Normal);
+            ParameterMinimums.push_back(builder._parameters[i].Minimum);
+            ParameterMaximums.push_back(builder._parameters[i].Maximum);
+            ParameterDefaults.push_back(builder._parameters[i].Default);
+        }
+        for (size_t i = 0; i < ParameterIdStrings.size(); i++)
+        {
+            ParameterIds.push_back(ParameterIdStrings[i].c_str());
+        }
+
+        for (size_t i = 0; i < builder._parts.size(); i++)
+        {
+            PartIdStrings.push_back(builder._parts[i].Id);
+            PartParents.push_back(builder._parts[i].Parent);
+        }
+        for (size_t i = 0; i < PartIdStrings.size(); i++)
+        {
+            PartIds.push_back(PartIdStrings[i].c_str());
+        }
+
+        Drawables = builder._drawables;
+        UvStorage.resize(Drawables.size());
+        for (size_t i = 0; i < Drawables.size(); i++)
+        {
+            const DrawableDescription& drawable = Drawables[i];
+            const int vertexCount = static_cast<int>(drawable.Positions.size() / 2);
+            for (int j = 0; j < vertexCount; j++)
+            {
+                csmVector2 uv;
+                uv.X = drawable.Uvs[j * 2];
+                uv.Y = drawable.Uvs[j * 2 + 1];
+                UvStorage[i].push_back(uv);
+            }
+
+            DrawableIds.push_back(drawable.Id.c_str());
+            ConstantFlags.push_back(drawable.ConstantFlags);
+            TextureIndices.push_back(drawable.TextureIndex);
+            DrawOrders.push_back(drawable.DrawOrder);
+            MaskCounts.push_back(static_cast<int>(drawable.Masks.size()));
+            Masks.push_back(drawable.Masks.empty() ? NULL : &drawable.Masks[0]);
+            VertexCounts.push_back(vertexCount);
+            Uvs.push_back(UvStorage[i].empty() ? NULL : &UvStorage[i][0]);
+            IndexCounts.push_back(static_cast<int>(drawable.Indices.size()));
+            Indices.push_back(drawable.Indices.empty() ? NULL : &drawable.Indices[0]);
+            ParentParts.push_back(drawable.ParentPart);
+            VertexTotal += vertexCount;
+        }
+    }
+};
+
+namespace {
+    const char MocMagic[4] = { 'M', 'O', 'C', 'K' };
+    unsigned int s_updateCount = 0;
+
+    std::vector<MocData*>& GetRegistry()
+    {
+        static std::vector<MocData*> registry;
+        return registry;
+    }
+
+    size_t Align(size_t value)
+    {
+        return (value + 15) & ~static_cast<size_t>(15);
+    }
+}
+
+DrawableDescription::DrawableDescription()
+    : TextureIndex(0)
+    , ConstantFlags(0)
+    , DrawOrder(500)
+    , Opacity(1.0f)
+    , ParentPart(-1)
+    , MoveParameter(-1)
+    , MoveX(0.0f)
+    , MoveY(0.0f)
+    , OpacityParameter(-1)
+    , VisibilityParameter(-1)
+{
+}
+
+ModelBuilder::ModelBuilder(float canvasWidth, float canvasHeight, float pixelsPerUnit)
+    : _canvasWidth(canvasWidth)
+    , _canvasHeight(canvasHeight)
+    , _pixelsPerUnit(pixelsPerUnit)
+{
+}
+
+int ModelBuilder::AddParameter(const char* id, float minimum, float maximum, float defaultValue)
+{
+    Parameter parameter;
+    parameter.Id = id;
+    parameter.Minimum = minimum;
+    parameter.Maximum = maximum;
+    parameter.Default = defaultValue;
+    _parameters.push_back(parameter);
+    return static_cast<int>(_parameters.size() - 1);
+}
+
+int ModelBuilder::AddPart(const char* id, int parent)
+{
+    Part part;
+    part.Id = id;
+    part.Parent = parent;
+    _parts.push_back(part);
+    return static_cast<int>(_parts.size() - 1);
+}
+
+int ModelBuilder::AddDrawable(const DrawableDescription& drawable)
+{
+    _drawables.push_back(drawable);
+    return static_cast<int>(_drawables.size() - 1);
+}
+
+int ModelBuilder::AddQuad(const char* id, int textureIndex, float x, float y, float width, float height)
+{
+    return AddGrid(id, textureIndex, x, y, width, height, 1, 1);
+}
+
+int ModelBuilder::AddGrid(const char* id, int textureIndex, float x, float y, float width, float height, int rows, int columns)
+{
+    DrawableDescription drawable;
+    drawable.Id = id;
+    drawable.TextureIndex = textureIndex;
+    drawable.DrawOrder = static_cast<int>(_drawables.size());
+
+    for (int row = 0; row <= rows; row++)
+    {
+        for (int column = 0; column <= columns; column++)
+        {
+            const float u = static_cast<float>(column) / columns;
+            const float v = static_cast<float>(row) / rows;
+            drawable.Positions.push_back(x + width * u);
+            drawable.Positions.push_back(y + height * v);
+            drawable.Uvs.push_back(u);
+            drawable.Uvs.push_back(v);
+        }
+    }
+
+    for (int row = 0; row < rows; row++)
+    {
+        for (int column = 0; column < columns; column++)
+        {
+            const unsigned short topLeft = static_cast<unsigned short>(row * (columns + 1) + column);
+            const unsigned short bottomLeft = static_cast<unsigned short>(topLeft + columns + 1);
+            drawable.Indices.push_back(topLeft);
+            drawable.Indices.push_back(bottomLeft);
+            drawable.Indices.push_back(static_cast<unsigned short>(topLeft + 1));
+            drawable.Indices.push_back(static_cast<unsigned short>(topLeft + 1));
+            drawable.Indices.push_back(bottomLeft);
+            drawable.Indices.push_back(static_cast<unsigned short>(bottomLeft + 1));
+        }
+    }
+
+    return AddDrawable(drawable);
+}
+
+DrawableDescription& ModelBuilder::GetDrawable(int index)
+{
+    return _drawables[index];
+}
+
+std::vector<unsigned char> ModelBuilder::BuildMoc() const
+{
+    std::vector<MocData*>& registry = GetRegistry();
+    registry.push_back(new MocData(*this));
+
+    const unsigned int id = static_cast<unsigned int>(registry.size() - 1);
+    std::vector<unsigned char> bytes(csmAlignofMoc, 0);
+    memcpy(&bytes[0], MocMagic, sizeof(MocMagic));
+    memcpy(&bytes[sizeof(MocMagic)], &id, sizeof(id));
+    return bytes;
+}
+
+unsigned int GetUpdateCount()
+{
+    return s_updateCount;
+}
+
+}
+
+//------------ Core ------------
+namespace Live2D { namespace Cubism { namespace Core {
+
+struct csmMoc
+{
+    char Magic[4];
+    unsigned int Id;
+};
+
+/**
+ * @brief   モデルのバッファの先頭に置く。続く領域に値が変わる配列を並べる
+ */
+struct csmModel
+{
+    const MockCubismCore::MocData* Moc;
+    float* ParameterValues;
+    float* PartOpacities;
+    csmFlags* DynamicFlags;
+    float* Opacities;
+    int* RenderOrders;
+    csmVector2* Positions;
+    const csmVector2** PositionPointers;
+    csmVector4* MultiplyColors;
+    csmVector4* ScreenColors;
+    float* EffectivePartOpacities;
+    int* SortedDrawables;
+    bool IsUpdated;
+};
+
+namespace {
+    /**
+     * @brief   モデルのバッファの配置を計算する。modelがNULLでなければポインタも設定する
+     *
+     * @return  必要なバイト数
+     */
+    unsigned int LayoutModel(const MockCubismCore::MocData& moc, csmModel* model)
+    {
+        char* base = reinterpret_cast<char*>(model);
+        size_t offset = MockCubismCore::Align(sizeof(csmModel));
+        const size_t parameterCount = moc.ParameterIds.size();
+        const size_t partCount = moc.PartIds.size();
+        const size_t drawableCount = moc.Drawables.size();
+
+#define MOCK_TAKE(member, type, count) \
+        if (model != NULL) { model->member = reinterpret_cast<type*>(base + offset); } \
+        offset = MockCubismCore::Align(offset + sizeof(type) * (count));
+
+        MOCK_TAKE(ParameterValues, float, parameterCount)
+        MOCK_TAKE(PartOpacities, float, partCount)
+        MOCK_TAKE(EffectivePartOpacities, float, partCount)
+        MOCK_TAKE(DynamicFlags, csmFlags, drawableCount)
+        MOCK_TAKE(Opacities, float, drawableCount)
+        MOCK_TAKE(RenderOrders, int, drawableCount)
+        MOCK_TAKE(SortedDrawables, int, drawableCount)
+        MOCK_TAKE(Positions, csmVector2, moc.VertexTotal)
+        MOCK_TAKE(PositionPointers, const csmVector2*, drawableCount)
+        MOCK_TAKE(MultiplyColors, csmVector4, drawableCount)
+        MOCK_TAKE(ScreenColors, csmVector4, drawableCount)
+#undef MOCK_TAKE
+
+        return static_cast<unsigned int>(offset);
+    }
+
+    float GetPartOpacity(csmModel* model, int part)
+    {
+        if (part < 0)
+        {
+            return 1.0f;
+        }
+        return model->EffectivePartOpacities[part];
+    }
+
+    float Clamp01(float value)
+    {
+        return (value < 0.0f) ? 0.0f : ((value > 1.0f) ? 1.0f : value);
+    }
+
+    struct DrawOrderLess
+    {
+        const MockCubismCore::MocData* Moc;
+
+        bool operator()(int left, int right) const
+        {
+            return Moc->DrawOrders[left] < Moc->DrawOrders[right];
+        }
+    };
+}
+
+csmVersion csmGetVersion()
+{
+    return 0x05000000;
+}
+
+csmMocVersion csmGetLatestMocVersion()
+{
+    return csmMocVersion_42;
+}
+
+csmMocVersion csmGetMocVersion(const void* address, const unsigned int size)
+{
+    if (size < sizeof(csmMoc) || memcmp(address, MockCubismCore::MocMagic, sizeof(MockCubismCore::MocMagic)) != 0)
+    {
+        return csmMocVersion_Unknown;
+    }
+    return csmMocVersion_40;
+}
+
+csmLogFunction csmGetLogFunction()
+{
+    return NULL;
+}
+
+void csmSetLogFunction(csmLogFunction handler)
+{
+}
+
+csmMoc* csmReviveMocInPlace(void* address, const unsigned int size)
+{
+    if (csmGetMocVersion(address, size) == csmMocVersion_Unknown)
+    {
+        return NULL;
+    }
+
+    csmMoc* moc = static_cast<csmMoc*>(address);
+    if (moc->Id >= MockCubismCore::GetRegistry().size())
+    {
+        return NULL;
+    }
+    return moc;
+}
+
+unsigned int csmGetSizeofModel(const csmMoc* moc)
+{
+    return LayoutModel(*MockCubismCore::GetRegistry()[moc->Id], NULL);
+}
+
+csmModel* csmInitializeModelInPlace(const csmMoc* moc, void* address, const unsigned int size)
+{
+    const MockCubismCore::MocData& data = *MockCubismCore::GetRegistry()[moc->Id];
+    if (size < LayoutModel(data, NULL))
+    {
+        return NULL;
+    }
+
+    csmModel* model = static_cast<csmModel*>(address);
+    memset(model, 0, size);
+    model->Moc = &data;
+    LayoutModel(data, model);
+
+    for (size_t i = 0; i < data.ParameterIds.size(); i++)
+    {
+        model->ParameterValues[i] = data.ParameterDefaults[i];
+    }
+    for (size_t i = 0; i < data.PartIds.size(); i++)
+    {
+        model->PartOpacities[i] = 1.0f;
+    }
+
+    int vertexOffset = 0;
+    for (size_t i = 0; i < data.Drawables.size(); i++)
+    {
+        model->PositionPointers[i] = model->Positions + vertexOffset;
+        vertexOffset += data.VertexCounts[i];
+
+        csmVector4 white = { 1.0f, 1.0f, 1.0f, 1.0f };
+        csmVector4 black = { 0.0f, 0.0f, 0.0f, 1.0f };
+        model->MultiplyColors[i] = white;
+        model->ScreenColors[i] = black;
+        model->RenderOrders[i] = -1;
+    }
+
+    return model;
+}
+
+void csmUpdateModel(csmModel* model)
+{
+    const MockCubismCore::MocData& data = *model->Moc;
+    MockCubismCore::s_updateCount++;
+
+    // 親は子より前に追加されている前提で、親から順に不透明度を掛ける
+    for (size_t i = 0; i < data.PartIds.size(); i++)
+    {
+        model->EffectivePartOpacities[i] = model->PartOpacities[i] * GetPartOpacity(model, data.PartParents[i]);
+    }
+
+    for (size_t i = 0; i < data.Drawables.size(); i++)
+    {
+        const MockCubismCore::DrawableDescription& drawable = data.Drawables[i];
+        csmFlags flags = model->DynamicFlags[i];
+        const bool wasVisible = (flags & csmIsVisible) != 0;
+
+        bool isVisible = true;
+        if (drawable.VisibilityParameter >= 0)
+        {
+            isVisible = model->ParameterValues[drawable.VisibilityParameter] >= 0.5f;
+        }
+
+        float opacity = drawable.Opacity * GetPartOpacity(model, drawable.ParentPart);
+        if (drawable.OpacityParameter >= 0)
+        {
+            opacity *= Clamp01(model->ParameterValues[drawable.OpacityParameter]);
+        }
+
+        float moveX = 0.0f;
+        float moveY = 0.0f;
+        if (drawable.MoveParameter >= 0)
+        {
+            moveX = model->ParameterValues[drawable.MoveParameter] * drawable.MoveX;
+            moveY = model->ParameterValues[drawable.MoveParameter] * drawable.MoveY;
+        }
+
+        bool positionsChanged = !model->IsUpdated;
+        csmVector2* positions = const_cast<csmVector2*>(model->PositionPointers[i]);
+        for (int j = 0; j < data.VertexCounts[i]; j++)
+        {
+            const float x = drawable.Positions[j * 2] + moveX;
+            const float y = drawable.Positions[j * 2 + 1] + moveY;
+            positionsChanged = positionsChanged || positions[j].X != x || positions[j].Y != y;
+            positions[j].X = x;
+            positions[j].Y = y;
+        }
+
+        if (!model->IsUpdated)
+        {
+            flags |= csmVisibilityDidChange | csmOpacityDidChange | csmDrawOrderDidChange | csmRenderOrderDidChange | csmBlendColorDidChange;
+        }
+        if (isVisible != wasVisible)
+        {
+            flags |= csmVisibilityDidChange;
+        }
+        if (opacity != model->Opacities[i])
+        {
+            flags |= csmOpacityDidChange;
+        }
+        if (positionsChanged)
+        {
+            flags |= csmVertexPositionsDidChange;
+        }
+        flags = isVisible ? (flags | csmIsVisible) : (flags & ~csmIsVisible);
+
+        model->Opacities[i] = opacity;
+        model->DynamicFlags[i] = flags;
+    }
+
+    const int drawableCount = static_cast<int>(data.Drawables.size());
+    for (int i = 0; i < drawableCount; i++)
+    {
+        model->SortedDrawables[i] = i;
+    }
+    DrawOrderLess less = { &data };
+    std::stable_sort(model->SortedDrawables, model->SortedDrawables + drawableCount, less);
+    for (int order = 0; order < drawableCount; order++)
+    {
+        const int drawable = model->SortedDrawables[order];
+        if (model->RenderOrders[drawable] != order)
+        {
+            model->RenderOrders[drawable] = order;
+            model->DynamicFlags[drawable] |= csmRenderOrderDidChange;
+        }
+    }
+
+    model->IsUpdated = true;
+}
+
+void csmReadCanvasInfo(const csmModel* model, csmVector2* outSizeInPixels, csmVector2* outOriginInPixels, float* outPixelsPerUnit)
+{
+    *outSizeInPixels = model->Moc->CanvasSize;
+    *outOriginInPixels = model->Moc->CanvasOrigin;
+    *outPixelsPerUnit = model->Moc->PixelsPerUnit;
+}
+
+int csmGetParameterCount(const csmModel* model)
+{
+    return static_cast<int>(model->Moc->ParameterIds.size());
+}
+
+const char** csmGetParameterIds(const csmModel* model)
+{
+    return const_cast<const char**>(model->Moc->ParameterIds.empty() ? NULL : &model->Moc->ParameterIds[0]);
+}
+
+const csmParameterType* csmGetParameterTypes(const csmModel* model)
+{
+    return model->Moc->ParameterTypes.empty() ? NULL : &model->Moc->ParameterTypes[0];
+}
+
+const float* csmGetParameterMinimumValues(const csmModel* model)
+{
+    return model->Moc->ParameterMinimums.empty() ? NULL : &model->Moc->ParameterMinimums[0];
+}
+
+const float* csmGetParameterMaximumValues(const csmModel* model)
+{
+    return model->Moc->ParameterMaximums.empty() ? NULL : &model->Moc->ParameterMaximums[0];
+}
+
+const float* csmGetParameterDefaultValues(const csmModel* model)
+{
+    return model->Moc->ParameterDefaults.empty() ? NULL : &model->Moc->ParameterDefaults[0];
+}
+
+float* csmGetParameterValues(csmModel* model)
+{
+    return model->ParameterValues;
+}
+
+int csmGetPartCount(const csmModel* model)
+{
+    return static_cast<int>(model->Moc->PartIds.size());
+}
+
+const char** csmGetPartIds(const csmModel* model)
+{
+    return const_cast<const char**>(model->Moc->PartIds.empty() ? NULL : &model->Moc->PartIds[0]);
+}
+
+float* csmGetPartOpacities(csmModel* model)
+{
+    return model->PartOpacities;
+}
+
+const int* csmGetPartParentPartIndices(const csmModel* model)
+{
+    return model->Moc->PartParents.empty() ? NULL : &model->Moc->PartParents[0];
+}
+
+int csmGetDrawableCount(const csmModel* model)
+{
+    return static_cast<int>(model->Moc->Drawables.size());
+}
+
+const char** csmGetDrawableIds(const csmModel* model)
+{
+    return const_cast<const char**>(model->Moc->DrawableIds.empty() ? NULL : &model->Moc->DrawableIds[0]);
+}
+
+const csmFlags* csmGetDrawableConstantFlags(const csmModel* model)
+{
+    return model->Moc->ConstantFlags.empty() ? NULL : &model->Moc->ConstantFlags[0];
+}
+
+const csmFlags* csmGetDrawableDynamicFlags(const csmModel* model)
+{
+    return model->DynamicFlags;
+}
+
+const int* csmGetDrawableTextureIndices(const csmModel* model)
+{
+    return model->Moc->TextureIndices.empty() ? NULL : &model->Moc->TextureIndices[0];
+}
+
+const int* csmGetDrawableDrawOrders(const csmModel* model)
+{
+    return model->Moc->DrawOrders.empty() ? NULL : &model->Moc->DrawOrders[0];
+}
+
+const int* csmGetDrawableRenderOrders(const csmModel* model)
+{
+    return model->RenderOrders;
+}
+
+const float* csmGetDrawableOpacities(const csmModel* model)
+{
+    return model->Opacities;
+}
+
+const int* csmGetDrawableMaskCounts(const csmModel* model)
+{
+    return model->Moc->MaskCounts.empty() ? NULL : &model->Moc->MaskCounts[0];
+}
+
+const int** csmGetDrawableMasks(const csmModel* model)
+{
+    return const_cast<const int**>(model->Moc->Masks.empty() ? NULL : &model->Moc->Masks[0]);
+}
+
+const int* csmGetDrawableVertexCounts(const csmModel* model)
+{
+    return model->Moc->VertexCounts.empty() ? NULL : &model->Moc->VertexCounts[0];
+}
+
+const csmVector2** csmGetDrawableVertexPositions(const csmModel* model)
+{
+    return model->PositionPointers;
+}
+
+const csmVector2** csmGetDrawableVertexUvs(const csmModel* model)
+{
+    return const_cast<const csmVector2**>(model->Moc->Uvs.empty() ? NULL : &model->Moc->Uvs[0]);
+}
+
+const int* csmGetDrawableIndexCounts(const csmModel* model)
+{
+    return model->Moc->IndexCounts.empty() ? NULL : &model->Moc->IndexCounts[0];
+}
+
+const unsigned short** csmGetDrawableIndices(const csmModel* model)
+{
+    return const_cast<const unsigned short**>(model->Moc->Indices.empty() ? NULL : &model->Moc->Indices[0]);
+}
+
+const csmVector4* csmGetDrawableMultiplyColors(const csmModel* model)
+{
+    return model->MultiplyColors;
+}
+
+const csmVector4* csmGetDrawableScreenColors(const csmModel* model)
+{
+    return model->ScreenColors;
+}
+
+const int* csmGetDrawableParentPartIndices(const csmModel* model)
+{
+    return model->Moc->ParentParts.empty() ? NULL : &model->Moc->ParentParts[0];
+}
+
+void csmResetDrawableDynamicFlags(csmModel* model)
+{
+    for (size_t i = 0; i < model->Moc->Drawables.size(); i++)
+    {
+        model->DynamicFlags[i] &= csmIsVisible;
+    }
+}
+
+}}}
+//------------ Core ------------
@@ -0,0 +1,107 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief   テスト用のCubism Core<br>
+ *           .moc3の代わりにModelBuilderで組み立てた合成モデルを評価する。
+ *           パラメータは頂点の平行移動・不透明度・表示状態に対応付けられ、
+ *           csmUpdateModelが頂点・不透明度・描画順と変化のフラグを計算する。
+ */
+namespace MockCubismCore {
+
+/**
+ * @brief   合成モデルのDrawable
+ */
+struct DrawableDescription
+{
+    std::string Id;
+    int TextureIndex;
+    unsigned char ConstantFlags;            ///< csmBlendAdditive・csmIsDoubleSided等
+    int DrawOrder;
+    float Opacity;
+    int ParentPart;                         ///< -1なら親パーツ無し
+    std::vector<float> Positions;           ///< x, yの組
+    std::vector<float> Uvs;                 ///< u, vの組
+    std::vector<unsigned short> Indices;
+    std::vector<int> Masks;                 ///< マスクになるDrawableの番号
+
+    int MoveParameter;                      ///< 頂点を動かすパラメータ。-1なら動かない
+    float MoveX;                            ///< パラメータの値1あたりの移動量
+    float MoveY;
+    int OpacityParameter;                   ///< 不透明度に掛けるパラメータ（0..1に丸める）。-1なら掛けない
+    int VisibilityParameter;                ///< 0.5以上で表示するパラメータ。-1なら常に表示
+
+    DrawableDescription();
+};
+
+/**
+ * @brief   合成モデルを組み立て、Coreに渡す.moc3の代わりのバイト列を作る
+ */
+class ModelBuilder
+{
+public:
+    ModelBuilder(float canvasWidth = 1024.0f, float canvasHeight = 1024.0f, float pixelsPerUnit = 512.0f);
+
+    int AddParameter(const char* id, float minimum, float maximum, float defaultValue);
+
+    int AddPart(const char* id, int parent = -1);
+
+    int AddDrawable(const DrawableDescription& drawable);
+
+    /**
+     * @brief   モデル座標の矩形を2つの三角形で張ったDrawableを追加する。描画順は追加した順
+     */
+    int AddQuad(const char* id, int textureIndex, float x, float y, float width, float height);
+
+    /**
+     * @brief   rows×columnsの格子に分けた矩形のDrawableを追加する。頂点数を増やしたい場合に使う
+     */
+    int AddGrid(const char* id, int textureIndex, float x, float y, float width, float height, int rows, int columns);
+
+    DrawableDescription& GetDrawable(int index);
+
+    /**
+     * @brief   組み立てたモデルを登録し、CubismMoc::Createに渡すバイト列を返す
+     */
+    std::vector<unsigned char> BuildMoc() const;
+
+private:
+    struct Parameter
+    {
+        std::string Id;
+        float Minimum;
+        float Maximum;
+        float Default;
+    };
+
+    struct Part
+    {
+        std::string Id;
+        int Parent;
+    };
+
+    friend struct MocData;
+
+    float _canvasWidth;
+    float _canvasHeight;
+    float _pixelsPerUnit;
+    std::vector<Parameter> _parameters;
+    std::vector<Part> _parts;
+    std::vector<DrawableDescription> _drawables;
+};
+
+/**
+ * @brief   csmUpdateModelが呼ばれた回数を取得する
+ */
+unsigned int GetUpdateCount();
+
+}
@@ -0,0 +1,71 @@
+/**
+ * Mock of the Live2D Cubism Core API for tests.
+ *
+ * Declares the subset of Live2DCubismCore.h that the framework uses, with the
+ * same names, types and values as the Core distributed with the Cubism SDK.
+ * The implementation in MockCubismCore.cpp evaluates synthetic models built
+ * with MockCubismCore::ModelBuilder instead of real .moc3 files.
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+typedef struct csmMoc csmMoc;
+typedef struct csmModel csmModel;
+typedef unsigned int csmVersion;
+typedef unsigned int csmMocVersion;
+enum { csmMocVersion_Unknown = 0, csmMocVersion_30 = 1, csmMocVersion_33 = 2, csmMocVersion_40 = 3, csmMocVersion_42 = 4 };
+typedef int csmParameterType;
+enum { csmParameterType_Normal = 0, csmParameterType_BlendShape = 1 };
+enum { csmAlignofMoc = 64, csmAlignofModel = 16 };
+enum { csmBlendAdditive = 1 << 0, csmBlendMultiplicative = 1 << 1, csmIsDoubleSided = 1 << 2, csmIsInvertedMask = 1 << 3 };
+enum { csmIsVisible = 1 << 0, csmVisibilityDidChange = 1 << 1, csmOpacityDidChange = 1 << 2, csmDrawOrderDidChange = 1 << 3, csmRenderOrderDidChange = 1 << 4, csmVertexPositionsDidChange = 1 << 5, csmBlendColorDidChange = 1 << 6 };
+typedef unsigned char csmFlags;
+typedef struct { float X; float Y; } csmVector2;
+typedef struct { float X; float Y; float Z; float W; } csmVector4;
+typedef void (*csmLogFunction)(const char* message);
+csmVersion csmGetVersion();
+csmMocVersion csmGetLatestMocVersion();
+csmMocVersion csmGetMocVersion(const void* address, const unsigned int size);
+csmLogFunction csmGetLogFunction();
+void csmSetLogFunction(csmLogFunction handler);
+csmMoc* csmReviveMocInPlace(void* address, const unsigned int size);
+unsigned int csmGetSizeofModel(const csmMoc* moc);
+csmModel* csmInitializeModelInPlace(const csmMoc* moc, void* address, const unsigned int size);
+void csmUpdateModel(csmModel* model);
+void csmReadCanvasInfo(const csmModel* model, csmVector2* outSizeInPixels, csmVector2* outOriginInPixels, float* outPixelsPerUnit);
+int csmGetParameterCount(const csmModel* model);
+const char** csmGetParameterIds(const csmModel* model);
+const csmParameterType* csmGetParameterTypes(const csmModel* model);
+const float* csmGetParameterMinimumValues(const csmModel* model);
+const float* csmGetParameterMaximumValues(const csmModel* model);
+const float* csmGetParameterDefaultValues(const csmModel* model);
+float* csmGetParameterValues(csmModel* model);
+int csmGetPartCount(const csmModel* model);
+const char** csmGetPartIds(const csmModel* model);
+float* csmGetPartOpacities(csmModel* model);
+const int* csmGetPartParentPartIndices(const csmModel* model);
+int csmGetDrawableCount(const csmModel* model);
+const char** csmGetDrawableIds(const csmModel* model);
+const csmFlags* csmGetDrawableConstantFlags(const csmModel* model);
+const csmFlags* csmGetDrawableDynamicFlags(const csmModel* model);
+const int* csmGetDrawableTextureIndices(const csmModel* model);
+const int* csmGetDrawableDrawOrders(const csmModel* model);
+const int* csmGetDrawableRenderOrders(const csmModel* model);
+const float* csmGetDrawableOpacities(const csmModel* model);
+const int* csmGetDrawableMaskCounts(const csmModel* model);
+const int** csmGetDrawableMasks(const csmModel* model);
+const int* csmGetDrawableVertexCounts(const csmModel* model);
+const csmVector2** csmGetDrawableVertexPositions(const csmModel* model);
+const csmVector2** csmGetDrawableVertexUvs(const csmModel* model);
+const int* csmGetDrawableIndexCounts(const csmModel* model);
+const unsigned short** csmGetDrawableIndices(const csmModel* model);
+const csmVector4* csmGetDrawableMultiplyColors(const csmModel* model);
+const csmVector4* csmGetDrawableScreenColors(const csmModel* model);
+const int* csmGetDrawableParentPartIndices(const csmModel* model);
+void csmResetDrawableDynamicFlags(csmModel* model);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,205 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+/**
+ * LAppModel::PreUpdateの命令列が、各コンポーネントを順に更新する従来の処理と
+ * 同じパラメータを作ることを検証する。
+ * 従来の処理の結果は、命令列を導入する前のPreUpdateで同じ入力を与えて記録した値と比べる。
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <Effect/CubismBreath.hpp>
+#include <Id/CubismIdManager.hpp>
+#include <Model/CubismModel.hpp>
+#include "LAppModel.hpp"
+#include "LAppPal.hpp"
+#include "MockCubismCore.hpp"
+#include "TestSupport.hpp"
+#include "raylib.h"
+
+using namespace Live2D::Cubism::Framework;
+
+namespace {
+    const int FrameCount = 900;
+    const int ParameterCount = 11;
+
+    /**
+     * @brief   記録したフレームのパラメータ
+     */
+    struct RecordedFrame
+    {
+        int Frame;
+        float Values[ParameterCount];
+    };
+
+    /**
+     * @brief   命令列を導入する前のPreUpdateで記録した値。まばたきが動いたフレームを含む
+     */
+    const RecordedFrame RecordedFrames[] =
+    {
+        { 10, { 10.5862122f, 24.0543289f, -6.98215914f, 2.99848366f, 0.299848378f, 0.776187778f, 0.963102639f, 1.0f, 0.293304145f, 0.35462153f, -0.247861847f } },
+        { 45, { 29.5545158f, 18.7952309f, -4.96379232f, 8.11486816f, 0.81148684f, 0.203896999f, 0.39144063f, 1.0f, 0.37611565f, 0.499953121f, 0.028384719f } },
+        { 90, { -21.8999596f, -3.49526978f, -27.595768f, -9.79186153f, -0.979186177f, -0.9394117f, 0.405364335f, 1.0f, 0.377213091f, 0.282683522f, -0.115300931f } },
+        { 150, { 30.0f, -1.33656406f, 3.16986203f, 9.1177845f, 0.91177845f, -0.115885682f, 0.791885614f, 1.0f, 0.431085914f, 0.00454768538f, 0.0438855402f } },
+        { 240, { -22.300808f, 28.8577995f, 7.38588333f, -5.76529598f, -0.576529622f, 0.427031159f, 0.229750395f, 1.0f, 0.436971515f, 0.499878585f, -0.217975795f } },
+        { 363, { -23.0186081f, 2.67073917f, 4.75070858f, -6.67547226f, -0.667547226f, 0.23722209f, 0.774816632f, 0.774816632f, 0.43812713f, 0.0885949284f, -0.203762889f } },
+        { 450, { -6.92256641f, 30.0f, 2.90114284f, -4.39376879f, -0.439376891f, 0.220095232f, 0.373411775f, 1.0f, 0.314280033f, 0.463016391f, -0.119224392f } },
+        { 547, { 28.7894859f, -14.1937599f, 8.03479576f, 8.13869667f, 0.813869655f, -0.329077899f, 0.527259409f, 0.527259409f, 0.35434112f, 0.0310757607f, 0.0592197068f } },
+        { 731, { -30.0f, -27.8385887f, -21.7771511f, -9.20491028f, -0.92049098f, -0.788606405f, 0.336521387f, 0.336521387f, 0.203180894f, 0.00249391794f, 0.0454259478f } },
+        { 899, { 30.0f, -30.0f, 20.9875717f, 7.77640867f, 0.777640879f, -0.899625719f, 0.886517346f, 1.0f, 0.429548115f, 0.0598877519f, -0.172941446f } }
+    };
+
+    /**
+     * @brief   呼吸とまばたきを設定できるLAppModel
+     */
+    class ConfiguredModel : public LAppModel
+    {
+    public:
+        void Setup()
+        {
+            csmVector<CubismBreath::BreathParameterData> parameters;
+            parameters.PushBack(CubismBreath::BreathParameterData(CubismFramework::GetIdManager()->GetId("ParamAngleX"), 0.0f, 15.0f, 6.5345f, 0.5f));
+            parameters.PushBack(CubismBreath::BreathParameterData(CubismFramework::GetIdManager()->GetId("ParamBreath"), 0.5f, 0.5f, 3.2345f, 0.5f));
+            _breath->SetParameters(parameters);
+
+            // 間隔が0.5秒なら次のまばたきまでの時間は乱数によらず0になり、記録した値が環境に依存しない
+            _eyeBlink->SetBlinkingInterval(0.5f);
+            CompileModifierProgram();
+        }
+    };
+
+    std::string WriteTestModel()
+    {
+        MockCubismCore::ModelBuilder builder;
+        builder.AddParameter("ParamAngleX", -30.0f, 30.0f, 0.0f);
+        builder.AddParameter("ParamAngleY", -30.0f, 30.0f, 0.0f);
+        builder.AddParameter("ParamAngleZ", -30.0f, 30.0f, 0.0f);
+        builder.AddParameter("ParamBodyAngleX", -10.0f, 10.0f, 0.0f);
+        builder.AddParameter("ParamEyeBallX", -1.0f, 1.0f, 0.0f);
+        builder.AddParameter("ParamEyeBallY", -1.0f, 1.0f, 0.0f);
+        builder.AddParameter("ParamEyeLOpen", 0.0f, 1.0f, 1.0f);
+        builder.AddParameter("ParamEyeROpen", 0.0f, 1.0f, 1.0f);
+        builder.AddParameter("ParamMouthOpenY", 0.0f, 1.0f, 0.0f);
+        builder.AddParameter("ParamBreath", 0.0f, 1.0f, 0.0f);
+        builder.AddParameter("ParamHair0", -30.0f, 30.0f, 0.0f);
+        builder.AddQuad("Body", 0, -0.5f, -0.5f, 1.0f, 1.0f);
+
+        TestSupport::ModelFiles files;
+        files.PhysicsJson = TestSupport::CreatePhysicsJson(1, 30.0f);
+        files.EyeBlinkIds.push_back("ParamEyeLOpen");
+        files.EyeBlinkIds.push_back("ParamEyeROpen");
+        files.LipSyncIds.push_back("ParamMouthOpenY");
+
+        // 待機モーションは頭と片目を動かす。モーションが目を動かすフレームではまばたきしない
+        files.IdleMotionJsons.push_back(
+            "{\"Version\":3,\"Meta\":{\"Duration\":3,\"Fps\":30,\"Loop\":false,\"AreBeziersRestricted\":true,\"CurveCount\":2,"
+            "\"TotalSegmentCount\":4,\"TotalPointCount\":6,\"UserDataCount\":0,\"TotalUserDataSize\":0},"
+            "\"Curves\":[{\"Target\":\"Parameter\",\"Id\":\"ParamAngleY\",\"Segments\":[0,0,0,1.5,25,0,3,-10]},"
+            "{\"Target\":\"Parameter\",\"Id\":\"ParamEyeLOpen\",\"Segments\":[0,1,0,1,0.2,0,3,1]}]}");
+
+        return TestSupport::WriteModel("ModifierProgramTest", builder, files);
+    }
+
+    /**
+     * @brief   記録した時と同じ入力でモデルを動かし、フレームごとのパラメータを返す
+     */
+    std::vector<std::vector<float> > Run(const std::string& fileName)
+    {
+        srand(30);
+        SetHeadlessTime(0.0);
+        LAppPal::UpdateTime();
+
+        ConfiguredModel* model = new ConfiguredModel();
+        model->LoadAssets(TestSupport::GetTemporaryDirectory().c_str(), fileName.c_str());
+        model->Setup();
+
+        std::vector<std::vector<float> > frames;
+        std::vector<float> samples(800);
+        double time = 0.0;
+        for (int frame = 0; frame < FrameCount; frame++)
+        {
+            // 描画間隔を揺らす
+            time += (1.0 / 60.0) * (1.0 + 0.5 * sin(frame * 0.37));
+            SetHeadlessTime(time);
+            LAppPal::UpdateTime();
+
+            model->SetDragging(sinf(frame * 0.05f), cosf(frame * 0.031f));
+
+            for (size_t i = 0; i < samples.size(); i++)
+            {
+                samples[i] = 0.8f * sinf(frame * 0.1f) * sinf(static_cast<float>(i) * 0.3f);
+            }
+            model->GetAudioLipSync()->Push(&samples[0], static_cast<csmUint32>(samples.size()), 48000);
+
+            model->PreUpdate();
+
+            CubismModel* cubismModel = model->GetModel();
+            std::vector<float> values(cubismModel->GetParameterCount());
+            for (csmInt32 i = 0; i < cubismModel->GetParameterCount(); i++)
+            {
+                values[i] = cubismModel->GetParameterValue(i);
+            }
+            frames.push_back(values);
+
+            model->Update();
+        }
+
+        delete model;
+        return frames;
+    }
+
+    void TestProgramMatchesRecordedStages()
+    {
+        const std::string fileName = WriteTestModel();
+        const std::vector<std::vector<float> > program = Run(fileName);
+
+        CSM_TEST_ASSERT_EQUAL(FrameCount, program.size());
+        CSM_TEST_ASSERT_EQUAL(ParameterCount, program[0].size());
+
+        // 同じ計算を同じ順で行うので、記録した桁まで一致する
+        for (size_t i = 0; i < sizeof(RecordedFrames) / sizeof(RecordedFrames[0]); i++)
+        {
+            const RecordedFrame& recorded = RecordedFrames[i];
+            for (int parameter = 0; parameter < ParameterCount; parameter++)
+            {
+                CSM_TEST_ASSERT_NEAR(recorded.Values[parameter], program[recorded.Frame][parameter], 1e-5);
+            }
+        }
+
+        // 各段がパラメータを動かしていること
+        float maximumBreath = 0.0f;
+        float minimumEye = 1.0f;
+        float minimumBlink = 1.0f;
+        float maximumMouth = 0.0f;
+        float maximumHair = 0.0f;
+        for (size_t frame = 0; frame < program.size(); frame++)
+        {
+            minimumEye = fminf(minimumEye, program[frame][6]);
+            minimumBlink = fminf(minimumBlink, program[frame][7]);
+            maximumMouth = fmaxf(maximumMouth, program[frame][8]);
+            maximumBreath = fmaxf(maximumBreath, program[frame][9]);
+            maximumHair = fmaxf(maximumHair, fabsf(program[frame][10]));
+        }
+        CSM_TEST_ASSERT(minimumEye < 0.5f);
+        CSM_TEST_ASSERT(minimumBlink < 0.5f);
+        CSM_TEST_ASSERT(maximumMouth > 0.0f);
+        CSM_TEST_ASSERT(maximumBreath > 0.25f);
+        CSM_TEST_ASSERT(maximumHair > 0.0f);
+    }
+}
+
+int main()
+{
+    TestSupport::FrameworkScope framework;
+
+    TestProgramMatchesRecordedStages();
+
+    return TestSupport::Finish("ModifierProgramTest");
+}
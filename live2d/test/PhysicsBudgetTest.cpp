@@ -0,0 +1,167 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+/**
+ * 物理演算のフレーム予算を複数のモデルで分け合う動作を検証する。
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <Model/CubismMoc.hpp>
+#include <Model/CubismModel.hpp>
+#include <Physics/CubismPhysics.hpp>
+#include "MockCubismCore.hpp"
+#include "TestSupport.hpp"
+
+using namespace Live2D::Cubism::Framework;
+
+namespace {
+    const int SettingCount = 64;
+    const float Fps = 60.0f;
+    const float FrameSeconds = 1.0f / 60.0f;
+
+    /**
+     * @brief   SettingCount個のサブリグを持つ物理演算とモデル
+     */
+    class PhysicsModel
+    {
+    public:
+        PhysicsModel()
+        {
+            MockCubismCore::ModelBuilder builder;
+            builder.AddParameter("ParamAngleX", -30.0f, 30.0f, 0.0f);
+            for (int i = 0; i < SettingCount; i++)
+            {
+                char id[32];
+                snprintf(id, sizeof(id), "ParamHair%d", i);
+                builder.AddParameter(id, -30.0f, 30.0f, 0.0f);
+            }
+            builder.AddQuad("Body", 0, -0.5f, -0.5f, 1.0f, 1.0f);
+
+            const std::vector<unsigned char> mocBytes = builder.BuildMoc();
+            _moc = CubismMoc::Create(&mocBytes[0], static_cast<csmSizeInt>(mocBytes.size()));
+            _model = _moc->CreateModel();
+
+            const std::string json = TestSupport::CreatePhysicsJson(SettingCount, Fps);
+            _physics = CubismPhysics::Create(reinterpret_cast<const csmByte*>(json.data()), static_cast<csmSizeInt>(json.size()));
+        }
+
+        ~PhysicsModel()
+        {
+            CubismPhysics::Delete(_physics);
+            _moc->DeleteModel(_model);
+            CubismMoc::Delete(_moc);
+        }
+
+        /**
+         * @brief   入力を揺らして1フレーム評価する
+         */
+        void Evaluate(int frame)
+        {
+            _model->SetParameterValue(0, 30.0f * sinf(frame * 0.2f));
+            _physics->Evaluate(_model, FrameSeconds);
+        }
+
+        /**
+         * @brief   最初の出力パラメータの値
+         */
+        float GetOutput() const
+        {
+            return _model->GetParameterValue(1);
+        }
+
+        float GetRemainTime() const
+        {
+            CubismPhysics::State state;
+            _physics->SaveState(state);
+            return state.CurrentRemainTime;
+        }
+
+        CubismPhysics* GetPhysics() { return _physics; }
+
+    private:
+        CubismMoc* _moc;
+        CubismModel* _model;
+        CubismPhysics* _physics;
+    };
+
+    void TestBudgetIsShared()
+    {
+        PhysicsModel first;
+        PhysicsModel second;
+        PhysicsModel third;
+        third.GetPhysics()->SetQuality(0.5f);
+
+        // 十分な予算で1サブステップの平均処理時間を落ち着かせる。初回の計測は遅く出ることがある
+        CubismPhysics::SetFrameBudget(1000000.0f);
+        for (int frame = 0; frame < 120; frame++)
+        {
+            CubismPhysics::BeginFrame();
+            first.Evaluate(0);
+            second.Evaluate(0);
+            third.Evaluate(0);
+        }
+
+        // どのモデルの1サブステップにも足りない予算でも、後に評価するモデルが止まったままにならない
+        CubismPhysics::SetFrameBudget(1.0f);
+
+        float maximumOutput[3] = { 0.0f, 0.0f, 0.0f };
+        bool isCarried = false;
+        for (int frame = 1; frame < 600; frame++)
+        {
+            CubismPhysics::BeginFrame();
+            first.Evaluate(frame);
+            second.Evaluate(frame);
+            third.Evaluate(frame);
+
+            maximumOutput[0] = fmaxf(maximumOutput[0], fabsf(first.GetOutput()));
+            maximumOutput[1] = fmaxf(maximumOutput[1], fabsf(second.GetOutput()));
+            maximumOutput[2] = fmaxf(maximumOutput[2], fabsf(third.GetOutput()));
+
+            // 進められなかった時間は持ち越すが、4サブステップ分より溜めない
+            const float remainTime = second.GetRemainTime();
+            isCarried = isCarried || remainTime >= 1.0f / Fps;
+            CSM_TEST_ASSERT(remainTime <= 4.0f / Fps + 1e-5f);
+        }
+
+        CSM_TEST_ASSERT(maximumOutput[0] > 0.0f);
+        CSM_TEST_ASSERT(maximumOutput[1] > 0.0f);
+        CSM_TEST_ASSERT(maximumOutput[2] > 0.0f);
+        CSM_TEST_ASSERT(isCarried);
+
+        CubismPhysics::SetFrameBudget(0.0f);
+    }
+
+    void TestUnlimitedBudgetIsNotTimed()
+    {
+        PhysicsModel model;
+        CubismPhysics::SetFrameBudget(0.0f);
+
+        for (int frame = 0; frame < 10; frame++)
+        {
+            CubismPhysics::BeginFrame();
+            model.Evaluate(frame);
+
+            // 予算が無ければサブステップを計測しない
+            CSM_TEST_ASSERT_EQUAL(0.0f, CubismPhysics::GetFrameElapsedMicroseconds());
+            CSM_TEST_ASSERT(model.GetRemainTime() < 1.0f / Fps);
+        }
+        CSM_TEST_ASSERT(model.GetOutput() != 0.0f);
+    }
+}
+
+int main()
+{
+    TestSupport::FrameworkScope framework;
+
+    TestBudgetIsShared();
+    TestUnlimitedBudgetIsNotTimed();
+
+    return TestSupport::Finish("PhysicsBudgetTest");
+}
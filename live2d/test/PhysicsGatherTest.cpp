@@ -0,0 +1,483 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+/**
+ * 物理演算が参照するパラメータだけをキャッシュへ集める経路と、
+ * すべてのパラメータをコピーする従来の経路が同じ結果になることを検証する。
+ * 従来の経路はこのテストの中で振り子を計算し直すReferencePhysicsで再現する。
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <Id/CubismIdManager.hpp>
+#include <Math/CubismMath.hpp>
+#include <Model/CubismMoc.hpp>
+#include <Model/CubismModel.hpp>
+#include <Physics/CubismPhysics.hpp>
+#include "MockCubismCore.hpp"
+#include "TestSupport.hpp"
+
+using namespace Live2D::Cubism::Framework;
+
+namespace {
+    const int UnrelatedParameterCount = 40;
+    const int FrameCount = 600;
+    const float Fps = 60.0f;
+    const float NormalizationMaximum = 10.0f;
+
+    /**
+     * @brief   入力の種類。出力はすべて角度
+     */
+    enum InputType
+    {
+        InputType_X,
+        InputType_Angle,
+    };
+
+    struct InputDescription
+    {
+        const char* Id;
+        float Weight;
+        InputType Type;
+        bool Reflect;
+    };
+
+    struct OutputDescription
+    {
+        const char* Id;
+        int VertexIndex;
+        float Scale;
+        bool Reflect;
+    };
+
+    struct VertexDescription
+    {
+        float Y;
+        float Mobility;
+        float Delay;
+        float Acceleration;
+        float Radius;
+    };
+
+    struct SettingDescription
+    {
+        std::vector<InputDescription> Inputs;
+        std::vector<OutputDescription> Outputs;
+        std::vector<VertexDescription> Vertices;
+    };
+
+    /**
+     * @brief   2つのサブリグを持つ物理演算。2つ目は1つ目の出力を入力にする
+     */
+    std::vector<SettingDescription> CreateSettings()
+    {
+        std::vector<SettingDescription> settings(2);
+
+        const InputDescription inputs0[] = { { "ParamAngleX", 60.0f, InputType_X, false }, { "ParamAngleZ", 40.0f, InputType_Angle, false } };
+        const OutputDescription outputs0[] = { { "ParamHairFront", 1, 1.5f, false }, { "ParamHairSide", 2, 1.0f, true } };
+        const VertexDescription vertices0[] = { { 0.0f, 1.0f, 1.0f, 1.0f, 0.0f }, { 3.0f, 0.95f, 0.9f, 1.5f, 3.0f }, { 6.0f, 0.9f, 0.8f, 1.2f, 3.0f } };
+        settings[0].Inputs.assign(inputs0, inputs0 + 2);
+        settings[0].Outputs.assign(outputs0, outputs0 + 2);
+        settings[0].Vertices.assign(vertices0, vertices0 + 3);
+
+        const InputDescription inputs1[] = { { "ParamHairFront", 100.0f, InputType_X, false } };
+        const OutputDescription outputs1[] = { { "ParamHairBack", 1, 2.0f, false } };
+        const VertexDescription vertices1[] = { { 0.0f, 1.0f, 1.0f, 1.0f, 0.0f }, { 4.0f, 0.9f, 0.7f, 2.0f, 4.0f } };
+        settings[1].Inputs.assign(inputs1, inputs1 + 1);
+        settings[1].Outputs.assign(outputs1, outputs1 + 1);
+        settings[1].Vertices.assign(vertices1, vertices1 + 2);
+
+        return settings;
+    }
+
+    /**
+     * @brief   settingsからphysics3.jsonを作る
+     */
+    std::string CreatePhysicsJson(const std::vector<SettingDescription>& settings)
+    {
+        char buffer[512];
+        size_t inputCount = 0;
+        size_t outputCount = 0;
+        size_t vertexCount = 0;
+        for (size_t i = 0; i < settings.size(); i++)
+        {
+            inputCount += settings[i].Inputs.size();
+            outputCount += settings[i].Outputs.size();
+            vertexCount += settings[i].Vertices.size();
+        }
+
+        snprintf(buffer, sizeof(buffer),
+                 "{\"Version\":3,\"Meta\":{\"PhysicsSettingCount\":%d,\"TotalInputCount\":%d,\"TotalOutputCount\":%d,\"VertexCount\":%d,"
+                 "\"EffectiveForces\":{\"Gravity\":{\"X\":0,\"Y\":-1},\"Wind\":{\"X\":0,\"Y\":0}},\"Fps\":%g},\"PhysicsSettings\":[",
+                 static_cast<int>(settings.size()), static_cast<int>(inputCount), static_cast<int>(outputCount), static_cast<int>(vertexCount), Fps);
+        std::string json = buffer;
+
+        for (size_t i = 0; i < settings.size(); i++)
+        {
+            snprintf(buffer, sizeof(buffer), "%s{\"Id\":\"PhysicsSetting%d\",\"Input\":[", (i == 0) ? "" : ",", static_cast<int>(i));
+            json += buffer;
+            for (size_t j = 0; j < settings[i].Inputs.size(); j++)
+            {
+                const InputDescription& input = settings[i].Inputs[j];
+                snprintf(buffer, sizeof(buffer), "%s{\"Source\":{\"Target\":\"Parameter\",\"Id\":\"%s\"},\"Weight\":%g,\"Type\":\"%s\",\"Reflect\":%s}",
+                         (j == 0) ? "" : ",", input.Id, input.Weight, (input.Type == InputType_X) ? "X" : "Angle", input.Reflect ? "true" : "false");
+                json += buffer;
+            }
+            json += "],\"Output\":[";
+            for (size_t j = 0; j < settings[i].Outputs.size(); j++)
+            {
+                const OutputDescription& output = settings[i].Outputs[j];
+                snprintf(buffer, sizeof(buffer),
+                         "%s{\"Destination\":{\"Target\":\"Parameter\",\"Id\":\"%s\"},\"VertexIndex\":%d,\"Scale\":%g,\"Weight\":100,\"Type\":\"Angle\",\"Reflect\":%s}",
+                         (j == 0) ? "" : ",", output.Id, output.VertexIndex, output.Scale, output.Reflect ? "true" : "false");
+                json += buffer;
+            }
+            json += "],\"Vertices\":[";
+            for (size_t j = 0; j < settings[i].Vertices.size(); j++)
+            {
+                const VertexDescription& vertex = settings[i].Vertices[j];
+                snprintf(buffer, sizeof(buffer), "%s{\"Position\":{\"X\":0,\"Y\":%g},\"Mobility\":%g,\"Delay\":%g,\"Acceleration\":%g,\"Radius\":%g}",
+                         (j == 0) ? "" : ",", vertex.Y, vertex.Mobility, vertex.Delay, vertex.Acceleration, vertex.Radius);
+                json += buffer;
+            }
+            snprintf(buffer, sizeof(buffer),
+                     "],\"Normalization\":{\"Position\":{\"Minimum\":%g,\"Default\":0,\"Maximum\":%g},\"Angle\":{\"Minimum\":%g,\"Default\":0,\"Maximum\":%g}}}",
+                     -NormalizationMaximum, NormalizationMaximum, -NormalizationMaximum, NormalizationMaximum);
+            json += buffer;
+        }
+        json += "]}";
+        return json;
+    }
+
+    /**
+     * @brief   CubismPhysicsの正規化と同じ計算。既定値は範囲の中央、正規化の既定値は0
+     */
+    float NormalizeParameterValue(float value, float minimum, float maximum, bool isInverted)
+    {
+        value = CubismMath::RangeF(value, minimum, maximum);
+        const float middle = minimum + (maximum - minimum) / 2.0f;
+        const float offset = value - middle;
+
+        float result = 0.0f;
+        if (offset > 0.0f)
+        {
+            result = offset * (NormalizationMaximum / (maximum - middle));
+        }
+        else if (offset < 0.0f)
+        {
+            result = offset * (-NormalizationMaximum / (minimum - middle));
+        }
+        return isInverted ? result : -result;
+    }
+
+    /**
+     * @brief   サブステップごとにすべてのパラメータをキャッシュへコピーする、従来の物理演算
+     */
+    class ReferencePhysics
+    {
+    public:
+        explicit ReferencePhysics(const std::vector<SettingDescription>& settings)
+            : _settings(settings)
+            , _remainTime(0.0f)
+        {
+            for (size_t i = 0; i < _settings.size(); i++)
+            {
+                std::vector<CubismPhysicsParticle> strand(_settings[i].Vertices.size());
+                for (size_t j = 0; j < strand.size(); j++)
+                {
+                    const VertexDescription& vertex = _settings[i].Vertices[j];
+                    strand[j].Mobility = vertex.Mobility;
+                    strand[j].Delay = vertex.Delay;
+                    strand[j].Acceleration = vertex.Acceleration;
+                    strand[j].Radius = vertex.Radius;
+                    strand[j].InitialPosition = (j == 0) ? CubismVector2(0.0f, 0.0f) : strand[j - 1].InitialPosition + CubismVector2(0.0f, vertex.Radius);
+                    strand[j].Position = (j == 0) ? CubismVector2(0.0f, vertex.Y) : strand[j].InitialPosition;
+                    strand[j].LastPosition = strand[j].InitialPosition;
+                    strand[j].LastGravity = CubismVector2(0.0f, 1.0f);
+                    strand[j].Velocity = CubismVector2(0.0f, 0.0f);
+                    strand[j].Force = CubismVector2(0.0f, 0.0f);
+                }
+                _strands.push_back(strand);
+                _currentOutputs.push_back(std::vector<float>(_settings[i].Outputs.size(), 0.0f));
+            }
+            _previousOutputs = _currentOutputs;
+        }
+
+        void Evaluate(CubismModel* model, float deltaTime)
+        {
+            const float physicsDeltaTime = 1.0f / Fps;
+            _remainTime += deltaTime;
+
+            while (_remainTime >= physicsDeltaTime)
+            {
+                _previousOutputs = _currentOutputs;
+
+                // すべてのパラメータをコピーする
+                _cache.resize(model->GetParameterCount());
+                for (csmInt32 i = 0; i < model->GetParameterCount(); i++)
+                {
+                    _cache[i] = model->GetParameterValue(i);
+                }
+
+                for (size_t i = 0; i < _settings.size(); i++)
+                {
+                    UpdateSetting(model, i, physicsDeltaTime);
+                }
+                _remainTime -= physicsDeltaTime;
+            }
+
+            const float weight = CubismMath::Min(_remainTime / physicsDeltaTime, 1.0f);
+            for (size_t i = 0; i < _settings.size(); i++)
+            {
+                for (size_t j = 0; j < _settings[i].Outputs.size(); j++)
+                {
+                    const csmInt32 index = GetParameterIndex(model, _settings[i].Outputs[j].Id);
+                    const float value = _previousOutputs[i][j] * (1 - weight) + _currentOutputs[i][j] * weight;
+                    model->SetParameterValue(index, ScaleOutput(model, index, value, _settings[i].Outputs[j].Scale));
+                }
+            }
+        }
+
+        const std::vector<CubismPhysicsParticle>& GetStrand(size_t setting) const { return _strands[setting]; }
+
+    private:
+        static csmInt32 GetParameterIndex(CubismModel* model, const char* id)
+        {
+            return model->GetParameterIndex(CubismFramework::GetIdManager()->GetId(id));
+        }
+
+        static float ScaleOutput(CubismModel* model, csmInt32 index, float value, float scale)
+        {
+            return CubismMath::RangeF(value * scale, model->GetParameterMinimumValue(index), model->GetParameterMaximumValue(index));
+        }
+
+        void UpdateSetting(CubismModel* model, size_t settingIndex, float deltaTime)
+        {
+            const SettingDescription& setting = _settings[settingIndex];
+            std::vector<CubismPhysicsParticle>& strand = _strands[settingIndex];
+
+            CubismVector2 totalTranslation(0.0f, 0.0f);
+            float totalAngle = 0.0f;
+            for (size_t i = 0; i < setting.Inputs.size(); i++)
+            {
+                const csmInt32 index = GetParameterIndex(model, setting.Inputs[i].Id);
+                const float normalized = NormalizeParameterValue(_cache[index], model->GetParameterMinimumValue(index),
+                                                                 model->GetParameterMaximumValue(index), setting.Inputs[i].Reflect)
+                                         * (setting.Inputs[i].Weight / 100.0f);
+                if (setting.Inputs[i].Type == InputType_X)
+                {
+                    totalTranslation.X += normalized;
+                }
+                else
+                {
+                    totalAngle += normalized;
+                }
+            }
+
+            // CubismPhysicsと同じく、回転したXでYを求める
+            const float radAngle = CubismMath::DegreesToRadian(-totalAngle);
+            totalTranslation.X = totalTranslation.X * CubismMath::CosF(radAngle) - totalTranslation.Y * CubismMath::SinF(radAngle);
+            totalTranslation.Y = totalTranslation.X * CubismMath::SinF(radAngle) + totalTranslation.Y * CubismMath::CosF(radAngle);
+
+            UpdateStrand(strand, totalTranslation, totalAngle, 0.001f * NormalizationMaximum, deltaTime);
+
+            for (size_t i = 0; i < setting.Outputs.size(); i++)
+            {
+                const int vertex = setting.Outputs[i].VertexIndex;
+                const CubismVector2 translation = strand[vertex].Position - strand[vertex - 1].Position;
+                const CubismVector2 parentGravity = (vertex >= 2) ? strand[vertex - 1].Position - strand[vertex - 2].Position : CubismVector2(0.0f, -1.0f) * -1.0f;
+                float value = CubismMath::DirectionToRadian(parentGravity, translation);
+                if (setting.Outputs[i].Reflect)
+                {
+                    value *= -1.0f;
+                }
+                _currentOutputs[settingIndex][i] = value;
+
+                const csmInt32 index = GetParameterIndex(model, setting.Outputs[i].Id);
+                _cache[index] = ScaleOutput(model, index, value, setting.Outputs[i].Scale);
+            }
+        }
+
+        static void UpdateStrand(std::vector<CubismPhysicsParticle>& strand, CubismVector2 totalTranslation, float totalAngle,
+                                 float threshold, float deltaTime)
+        {
+            const float airResistance = 5.0f;
+
+            strand[0].Position = totalTranslation;
+            CubismVector2 gravity = CubismMath::RadianToDirection(CubismMath::DegreesToRadian(totalAngle));
+            gravity.Normalize();
+
+            for (size_t i = 1; i < strand.size(); i++)
+            {
+                strand[i].Force = gravity * strand[i].Acceleration;
+                strand[i].LastPosition = strand[i].Position;
+                const float delay = strand[i].Delay * deltaTime * 30.0f;
+
+                CubismVector2 direction = strand[i].Position - strand[i - 1].Position;
+                const float radian = CubismMath::DirectionToRadian(strand[i].LastGravity, gravity) / airResistance;
+                direction.X = (CubismMath::CosF(radian) * direction.X) - (direction.Y * CubismMath::SinF(radian));
+                direction.Y = (CubismMath::SinF(radian) * direction.X) + (direction.Y * CubismMath::CosF(radian));
+                strand[i].Position = strand[i - 1].Position + direction;
+
+                const CubismVector2 velocity(strand[i].Velocity.X * delay, strand[i].Velocity.Y * delay);
+                const CubismVector2 force = strand[i].Force * delay * delay;
+                strand[i].Position = strand[i].Position + velocity + force;
+
+                CubismVector2 newDirection = strand[i].Position - strand[i - 1].Position;
+                newDirection.Normalize();
+                strand[i].Position = strand[i - 1].Position + (newDirection * strand[i].Radius);
+
+                if (CubismMath::AbsF(strand[i].Position.X) < threshold)
+                {
+                    strand[i].Position.X = 0.0f;
+                }
+
+                if (delay != 0.0f)
+                {
+                    strand[i].Velocity = strand[i].Position - strand[i].LastPosition;
+                    strand[i].Velocity /= delay;
+                    strand[i].Velocity *= strand[i].Mobility;
+                }
+
+                strand[i].Force = CubismVector2(0.0f, 0.0f);
+                strand[i].LastGravity = gravity;
+            }
+        }
+
+        std::vector<SettingDescription> _settings;
+        std::vector<std::vector<CubismPhysicsParticle> > _strands;
+        std::vector<std::vector<float> > _currentOutputs;
+        std::vector<std::vector<float> > _previousOutputs;
+        std::vector<float> _cache;
+        float _remainTime;
+    };
+
+    /**
+     * @brief   物理演算と関係の無いパラメータを多く含むモデル
+     */
+    class PhysicsModel
+    {
+    public:
+        PhysicsModel()
+        {
+            MockCubismCore::ModelBuilder builder;
+            for (int i = 0; i < UnrelatedParameterCount; i++)
+            {
+                char id[32];
+                snprintf(id, sizeof(id), "ParamUnrelated%d", i);
+                builder.AddParameter(id, -1.0f, 1.0f, 0.0f);
+
+                // 物理演算のパラメータを関係の無いパラメータの間に置く
+                if (i == 5)
+                {
+                    builder.AddParameter("ParamAngleX", -30.0f, 30.0f, 0.0f);
+                    builder.AddParameter("ParamHairBack", -1.0f, 1.0f, 0.0f);
+                }
+                else if (i == 20)
+                {
+                    builder.AddParameter("ParamHairFront", -1.0f, 1.0f, 0.0f);
+                    builder.AddParameter("ParamAngleZ", -30.0f, 30.0f, 0.0f);
+                }
+                else if (i == 33)
+                {
+                    builder.AddParameter("ParamHairSide", -1.0f, 1.0f, 0.0f);
+                }
+            }
+            builder.AddQuad("Body", 0, -0.5f, -0.5f, 1.0f, 1.0f);
+
+            const std::vector<unsigned char> mocBytes = builder.BuildMoc();
+            _moc = CubismMoc::Create(&mocBytes[0], static_cast<csmSizeInt>(mocBytes.size()));
+            _model = _moc->CreateModel();
+        }
+
+        ~PhysicsModel()
+        {
+            _moc->DeleteModel(_model);
+            CubismMoc::Delete(_moc);
+        }
+
+        CubismModel* GetModel() { return _model; }
+
+    private:
+        CubismMoc* _moc;
+        CubismModel* _model;
+    };
+
+    void TestGatherMatchesFullCopy()
+    {
+        const std::vector<SettingDescription> settings = CreateSettings();
+        const std::string json = CreatePhysicsJson(settings);
+        CubismPhysics* physics = CubismPhysics::Create(reinterpret_cast<const csmByte*>(json.data()), static_cast<csmSizeInt>(json.size()));
+        ReferencePhysics reference(settings);
+
+        PhysicsModel gather;
+        PhysicsModel fullCopy;
+        CubismModel* gatherModel = gather.GetModel();
+        CubismModel* fullCopyModel = fullCopy.GetModel();
+        const csmInt32 parameterCount = gatherModel->GetParameterCount();
+
+        srand(27);
+        csmInt32 mismatchedFrames = 0;
+        for (int frame = 0; frame < FrameCount; frame++)
+        {
+            // 入力と関係の無いパラメータを同じ値で動かし、描画間隔も揺らす
+            for (csmInt32 i = 0; i < parameterCount; i++)
+            {
+                const csmFloat32 value = (static_cast<csmFloat32>(rand()) / RAND_MAX) * 2.0f - 1.0f;
+                gatherModel->SetParameterValue(i, value * 30.0f);
+                fullCopyModel->SetParameterValue(i, value * 30.0f);
+            }
+            const csmFloat32 deltaTime = (1.0f / 60.0f) * (0.5f + static_cast<csmFloat32>(rand()) / RAND_MAX);
+
+            physics->Evaluate(gatherModel, deltaTime);
+            reference.Evaluate(fullCopyModel, deltaTime);
+
+            // 同じ計算を同じ順で行うので、ビット単位で一致する
+            bool isMatched = true;
+            for (csmInt32 i = 0; i < parameterCount; i++)
+            {
+                isMatched = isMatched && gatherModel->GetParameterValue(i) == fullCopyModel->GetParameterValue(i);
+            }
+
+            CubismPhysics::State state;
+            physics->SaveState(state);
+            csmUint32 particle = 0;
+            for (size_t i = 0; i < settings.size(); i++)
+            {
+                const std::vector<CubismPhysicsParticle>& strand = reference.GetStrand(i);
+                for (size_t j = 0; j < strand.size() && particle < state.Particles.GetSize(); j++, particle++)
+                {
+                    isMatched = isMatched
+                                && state.Particles[particle].Position.X == strand[j].Position.X
+                                && state.Particles[particle].Position.Y == strand[j].Position.Y;
+                }
+            }
+            CSM_TEST_ASSERT_EQUAL(state.Particles.GetSize(), particle);
+
+            if (!isMatched)
+            {
+                mismatchedFrames++;
+            }
+        }
+
+        CSM_TEST_ASSERT_EQUAL(0, mismatchedFrames);
+
+        CubismPhysics::Delete(physics);
+    }
+}
+
+int main()
+{
+    TestSupport::FrameworkScope framework;
+
+    TestGatherMatchesFullCopy();
+
+    return TestSupport::Finish("PhysicsGatherTest");
+}
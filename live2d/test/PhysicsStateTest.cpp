@@ -0,0 +1,274 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+/**
+ * 物理演算の状態の保存・復元と、振り子の安定化を検証する。
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <Model/CubismMoc.hpp>
+#include <Model/CubismModel.hpp>
+#include <Physics/CubismPhysics.hpp>
+#include "MockCubismCore.hpp"
+#include "TestSupport.hpp"
+
+using namespace Live2D::Cubism::Framework;
+
+namespace {
+    const int SettingCount = 4;
+    const float FrameSeconds = 1.0f / 60.0f;
+
+    /**
+     * @brief   settingCount個のサブリグを持つ物理演算とモデル
+     */
+    class PhysicsModel
+    {
+    public:
+        explicit PhysicsModel(int settingCount)
+        {
+            MockCubismCore::ModelBuilder builder;
+            builder.AddParameter("ParamAngleX", -30.0f, 30.0f, 0.0f);
+            for (int i = 0; i < SettingCount; i++)
+            {
+                char id[32];
+                snprintf(id, sizeof(id), "ParamHair%d", i);
+                builder.AddParameter(id, -30.0f, 30.0f, 0.0f);
+            }
+            builder.AddQuad("Body", 0, -0.5f, -0.5f, 1.0f, 1.0f);
+
+            const std::vector<unsigned char> mocBytes = builder.BuildMoc();
+            _moc = CubismMoc::Create(&mocBytes[0], static_cast<csmSizeInt>(mocBytes.size()));
+            _model = _moc->CreateModel();
+
+            const std::string json = TestSupport::CreatePhysicsJson(settingCount, 60.0f);
+            _physics = CubismPhysics::Create(reinterpret_cast<const csmByte*>(json.data()), static_cast<csmSizeInt>(json.size()));
+        }
+
+        ~PhysicsModel()
+        {
+            CubismPhysics::Delete(_physics);
+            _moc->DeleteModel(_model);
+            CubismMoc::Delete(_moc);
+        }
+
+        /**
+         * @brief   入力を値inputにして1フレーム評価する
+         */
+        void Evaluate(float input)
+        {
+            _model->SetParameterValue(0, input);
+            _physics->Evaluate(_model, FrameSeconds);
+        }
+
+        /**
+         * @brief   すべての出力パラメータの値
+         */
+        std::vector<float> GetOutputs() const
+        {
+            std::vector<float> outputs;
+            for (int i = 0; i < SettingCount; i++)
+            {
+                outputs.push_back(_model->GetParameterValue(1 + i));
+            }
+            return outputs;
+        }
+
+        CubismModel* GetModel() { return _model; }
+
+        CubismPhysics* GetPhysics() { return _physics; }
+
+    private:
+        CubismMoc* _moc;
+        CubismModel* _model;
+        CubismPhysics* _physics;
+    };
+
+    float GetSwingInput(int frame)
+    {
+        return 30.0f * sinf(frame * 0.2f);
+    }
+
+    bool IsSameState(const CubismPhysics::State& expected, const CubismPhysics::State& actual)
+    {
+        if (expected.Particles.GetSize() != actual.Particles.GetSize()
+            || expected.CurrentRigOutputs.GetSize() != actual.CurrentRigOutputs.GetSize()
+            || expected.CurrentRemainTime != actual.CurrentRemainTime)
+        {
+            return false;
+        }
+        for (csmUint32 i = 0; i < expected.CurrentRigOutputs.GetSize(); i++)
+        {
+            const csmVector<csmFloat32>& expectedOutput = expected.CurrentRigOutputs[i].output;
+            const csmVector<csmFloat32>& actualOutput = actual.CurrentRigOutputs[i].output;
+            if (expectedOutput.GetSize() != actualOutput.GetSize())
+            {
+                return false;
+            }
+            for (csmUint32 j = 0; j < expectedOutput.GetSize(); j++)
+            {
+                if (expectedOutput[j] != actualOutput[j])
+                {
+                    return false;
+                }
+            }
+        }
+        for (csmUint32 i = 0; i < expected.Particles.GetSize(); i++)
+        {
+            if (expected.Particles[i].Position.X != actual.Particles[i].Position.X
+                || expected.Particles[i].Position.Y != actual.Particles[i].Position.Y
+                || expected.Particles[i].Velocity.X != actual.Particles[i].Velocity.X
+                || expected.Particles[i].Velocity.Y != actual.Particles[i].Velocity.Y)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void TestRestoreReplaysFrames()
+    {
+        PhysicsModel model(SettingCount);
+        for (int frame = 0; frame < 30; frame++)
+        {
+            model.Evaluate(GetSwingInput(frame));
+        }
+
+        CubismPhysics::State state;
+        model.GetPhysics()->SaveState(state);
+
+        std::vector<std::vector<float> > expected;
+        for (int frame = 30; frame < 90; frame++)
+        {
+            model.Evaluate(GetSwingInput(frame));
+            expected.push_back(model.GetOutputs());
+        }
+
+        // 復元すれば同じ入力で同じ出力を繰り返す。状態は何度でも復元できる
+        for (int repeat = 0; repeat < 2; repeat++)
+        {
+            CSM_TEST_ASSERT(model.GetPhysics()->RestoreState(state));
+            csmInt32 mismatchedFrames = 0;
+            for (int frame = 30; frame < 90; frame++)
+            {
+                model.Evaluate(GetSwingInput(frame));
+                if (model.GetOutputs() != expected[frame - 30])
+                {
+                    mismatchedFrames++;
+                }
+            }
+            CSM_TEST_ASSERT_EQUAL(0, mismatchedFrames);
+        }
+    }
+
+    void TestRestoreRejectsOtherRigs()
+    {
+        PhysicsModel model(SettingCount);
+        PhysicsModel other(SettingCount - 1);
+        for (int frame = 0; frame < 30; frame++)
+        {
+            model.Evaluate(GetSwingInput(frame));
+            other.Evaluate(GetSwingInput(frame));
+        }
+
+        CubismPhysics::State before;
+        model.GetPhysics()->SaveState(before);
+
+        // サブリグの数が違う
+        CubismPhysics::State otherState;
+        other.GetPhysics()->SaveState(otherState);
+        CSM_TEST_ASSERT(!model.GetPhysics()->RestoreState(otherState));
+
+        // 物理点の数が違う
+        CubismPhysics::State particles = before;
+        particles.Particles.Resize(particles.Particles.GetSize() - 1);
+        CSM_TEST_ASSERT(!model.GetPhysics()->RestoreState(particles));
+
+        // サブリグの数は同じだが、サブリグの出力の数が違う
+        CubismPhysics::State currentOutputs = before;
+        currentOutputs.CurrentRigOutputs[SettingCount - 1].output.Clear();
+        CSM_TEST_ASSERT(!model.GetPhysics()->RestoreState(currentOutputs));
+
+        CubismPhysics::State previousOutputs = before;
+        previousOutputs.PreviousRigOutputs[0].output.PushBack(0.0f);
+        CSM_TEST_ASSERT(!model.GetPhysics()->RestoreState(previousOutputs));
+
+        // 拒否した状態は何も変えない
+        CubismPhysics::State after;
+        model.GetPhysics()->SaveState(after);
+        CSM_TEST_ASSERT(IsSameState(before, after));
+    }
+
+    /**
+     * @brief   入力を傾けたまま評価した時の、出力の最初の値からの最大の変化
+     */
+    float GetMaximumSwing(PhysicsModel& model)
+    {
+        model.Evaluate(30.0f);
+        const std::vector<float> first = model.GetOutputs();
+
+        float maximumSwing = 0.0f;
+        for (int frame = 1; frame < 120; frame++)
+        {
+            model.Evaluate(30.0f);
+            const std::vector<float> outputs = model.GetOutputs();
+            for (size_t i = 0; i < outputs.size(); i++)
+            {
+                maximumSwing = fmaxf(maximumSwing, fabsf(outputs[i] - first[i]));
+            }
+        }
+        return maximumSwing;
+    }
+
+    void TestStabilizeSettles()
+    {
+        PhysicsModel settled(SettingCount);
+        PhysicsModel unsettled(SettingCount);
+        for (int frame = 0; frame < 30; frame++)
+        {
+            settled.Evaluate(GetSwingInput(frame));
+            unsettled.Evaluate(GetSwingInput(frame));
+        }
+
+        // 揺れている途中の状態を保存し、別の時点から復元してから安定化する
+        CubismPhysics::State state;
+        settled.GetPhysics()->SaveState(state);
+        for (int frame = 30; frame < 45; frame++)
+        {
+            settled.Evaluate(GetSwingInput(frame));
+        }
+        CSM_TEST_ASSERT(settled.GetPhysics()->RestoreState(state));
+
+        settled.GetModel()->SetParameterValue(0, 30.0f);
+        settled.GetPhysics()->Stabilize(settled.GetModel(), 10.0f);
+
+        // 安定化した振り子はほとんど揺れず、していない振り子は大きく揺れる
+        const float settledSwing = GetMaximumSwing(settled);
+        const float unsettledSwing = GetMaximumSwing(unsettled);
+        CSM_TEST_ASSERT(settledSwing < 0.01f);
+        CSM_TEST_ASSERT(unsettledSwing > 1.0f);
+
+        // 安定化しても保存した時点の状態には戻せる
+        CSM_TEST_ASSERT(settled.GetPhysics()->RestoreState(state));
+        CubismPhysics::State restored;
+        settled.GetPhysics()->SaveState(restored);
+        CSM_TEST_ASSERT(IsSameState(state, restored));
+    }
+}
+
+int main()
+{
+    TestSupport::FrameworkScope framework;
+
+    TestRestoreReplaysFrames();
+    TestRestoreRejectsOtherRigs();
+    TestStabilizeSettles();
+
+    return TestSupport::Finish("PhysicsStateTest");
+}
@@ -0,0 +1,308 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+/**
+ * 詰めた配列でフェードするCubismPoseと、パーツごとにCubismModelを経由する従来のフェードが
+ * 同じパーツの不透明度になることを検証する。従来のフェードはこのテストの中のReferencePoseで再現する。
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <Effect/CubismPose.hpp>
+#include <Id/CubismIdManager.hpp>
+#include <Model/CubismMoc.hpp>
+#include <Model/CubismModel.hpp>
+#include "MockCubismCore.hpp"
+#include "TestSupport.hpp"
+
+using namespace Live2D::Cubism::Framework;
+
+namespace {
+    const int FrameCount = 180;
+    const float FadeInSeconds = 0.5f;
+
+    /**
+     * @brief   腕の2枚のグループと手の3枚のグループ。PartMissingはモデルに無い
+     */
+    const char* PoseJson =
+        "{\"Type\":\"Live2D Pose\",\"FadeInTime\":0.5,\"Groups\":["
+        "[{\"Id\":\"PartArmA\",\"Link\":[\"PartSleeveA\"]},{\"Id\":\"PartArmB\",\"Link\":[\"PartSleeveB\",\"PartMissingLink\"]}],"
+        "[{\"Id\":\"PartHandA\",\"Link\":[]},{\"Id\":\"PartHandB\"},{\"Id\":\"PartMissing\"}]"
+        "]}";
+
+    const char* PartIds[] = { "PartArmA", "PartArmB", "PartSleeveA", "PartSleeveB", "PartHandA", "PartHandB" };
+    const int PartCount = sizeof(PartIds) / sizeof(PartIds[0]);
+
+    CubismIdHandle GetId(const char* id)
+    {
+        return CubismFramework::GetIdManager()->GetId(id);
+    }
+
+    /**
+     * @brief   パーツを1つずつCubismModelで読み書きする、従来のポーズ
+     */
+    class ReferencePose
+    {
+    public:
+        struct Part
+        {
+            const char* Id;
+            std::vector<const char*> Links;
+        };
+
+        ReferencePose()
+            : _lastModel(NULL)
+        {
+            std::vector<Part> arms(2);
+            arms[0].Id = "PartArmA";
+            arms[0].Links.push_back("PartSleeveA");
+            arms[1].Id = "PartArmB";
+            arms[1].Links.push_back("PartSleeveB");
+            arms[1].Links.push_back("PartMissingLink");
+            _groups.push_back(arms);
+
+            std::vector<Part> hands(3);
+            hands[0].Id = "PartHandA";
+            hands[1].Id = "PartHandB";
+            hands[2].Id = "PartMissing";
+            _groups.push_back(hands);
+        }
+
+        void UpdateParameters(CubismModel* model, float deltaTimeSeconds)
+        {
+            if (model != _lastModel)
+            {
+                Reset(model);
+            }
+            _lastModel = model;
+
+            for (size_t i = 0; i < _groups.size(); i++)
+            {
+                DoFade(model, deltaTimeSeconds, _groups[i]);
+            }
+
+            for (size_t i = 0; i < _groups.size(); i++)
+            {
+                for (size_t j = 0; j < _groups[i].size(); j++)
+                {
+                    const float opacity = model->GetPartOpacity(GetId(_groups[i][j].Id));
+                    for (size_t k = 0; k < _groups[i][j].Links.size(); k++)
+                    {
+                        model->SetPartOpacity(model->GetPartIndex(GetId(_groups[i][j].Links[k])), opacity);
+                    }
+                }
+            }
+        }
+
+    private:
+        void Reset(CubismModel* model)
+        {
+            for (size_t i = 0; i < _groups.size(); i++)
+            {
+                for (size_t j = 0; j < _groups[i].size(); j++)
+                {
+                    const CubismIdHandle id = GetId(_groups[i][j].Id);
+                    model->SetPartOpacity(id, (j == 0) ? 1.0f : 0.0f);
+                    model->SetParameterValue(id, (j == 0) ? 1.0f : 0.0f);
+
+                    for (size_t k = 0; k < _groups[i][j].Links.size(); k++)
+                    {
+                        model->SetParameterValue(GetId(_groups[i][j].Links[k]), 1.0f);
+                    }
+                }
+            }
+        }
+
+        void DoFade(CubismModel* model, float deltaTimeSeconds, const std::vector<Part>& group)
+        {
+            const float Phi = 0.5f;
+            const float BackOpacityThreshold = 0.15f;
+
+            int visiblePart = -1;
+            float newOpacity = 1.0f;
+            for (size_t i = 0; i < group.size(); i++)
+            {
+                if (model->GetParameterValue(GetId(group[i].Id)) > 0.001f)
+                {
+                    if (visiblePart >= 0)
+                    {
+                        break;
+                    }
+                    visiblePart = static_cast<int>(i);
+                    newOpacity = model->GetPartOpacity(GetId(group[i].Id)) + deltaTimeSeconds / FadeInSeconds;
+                    if (newOpacity > 1.0f)
+                    {
+                        newOpacity = 1.0f;
+                    }
+                }
+            }
+
+            if (visiblePart < 0)
+            {
+                visiblePart = 0;
+                newOpacity = 1.0f;
+            }
+
+            for (size_t i = 0; i < group.size(); i++)
+            {
+                const CubismIdHandle id = GetId(group[i].Id);
+                if (static_cast<int>(i) == visiblePart)
+                {
+                    model->SetPartOpacity(id, newOpacity);
+                    continue;
+                }
+
+                float a1 = (newOpacity < Phi) ? newOpacity * (Phi - 1) / Phi + 1.0f : (1 - newOpacity) * Phi / (1.0f - Phi);
+                if ((1.0f - a1) * (1.0f - newOpacity) > BackOpacityThreshold)
+                {
+                    a1 = 1.0f - BackOpacityThreshold / (1.0f - newOpacity);
+                }
+
+                const float opacity = model->GetPartOpacity(id);
+                model->SetPartOpacity(id, (opacity > a1) ? a1 : opacity);
+            }
+        }
+
+        std::vector<std::vector<Part> > _groups;
+        CubismModel* _lastModel;
+    };
+
+    /**
+     * @brief   ポーズのパーツと、同じIDの表示切り替えパラメータを持つモデル
+     */
+    class PoseModel
+    {
+    public:
+        PoseModel()
+        {
+            MockCubismCore::ModelBuilder builder;
+            builder.AddParameter("ParamAngleX", -30.0f, 30.0f, 0.0f);
+            for (int i = 0; i < PartCount; i++)
+            {
+                builder.AddParameter(PartIds[i], 0.0f, 1.0f, 0.0f);
+                builder.AddPart(PartIds[i]);
+            }
+            builder.AddQuad("Body", 0, -0.5f, -0.5f, 1.0f, 1.0f);
+
+            const std::vector<unsigned char> mocBytes = builder.BuildMoc();
+            _moc = CubismMoc::Create(&mocBytes[0], static_cast<csmSizeInt>(mocBytes.size()));
+            _model = _moc->CreateModel();
+        }
+
+        ~PoseModel()
+        {
+            _moc->DeleteModel(_model);
+            CubismMoc::Delete(_moc);
+        }
+
+        CubismModel* GetModel() { return _model; }
+
+        /**
+         * @brief   グループの中でidだけを表示する
+         */
+        void Show(const char* id, const char* const* group, int groupCount)
+        {
+            for (int i = 0; i < groupCount; i++)
+            {
+                _model->SetParameterValue(GetId(group[i]), (strcmp(group[i], id) == 0) ? 1.0f : 0.0f);
+            }
+        }
+
+    private:
+        CubismMoc* _moc;
+        CubismModel* _model;
+    };
+
+    void TestPackedFadeMatchesPerPartFade()
+    {
+        CubismPose* pose = CubismPose::Create(reinterpret_cast<const csmByte*>(PoseJson), static_cast<csmSizeInt>(strlen(PoseJson)));
+        ReferencePose reference;
+        PoseModel packed;
+        PoseModel perPart;
+
+        const char* arms[] = { "PartArmA", "PartArmB" };
+        const char* hands[] = { "PartHandA", "PartHandB", "PartMissing" };
+
+        srand(29);
+        csmInt32 mismatchedFrames = 0;
+        bool isFading = false;
+        for (int frame = 0; frame < FrameCount; frame++)
+        {
+            // 表示するパーツを途中で切り替え、フェードの途中でも切り替える
+            PoseModel* models[2] = { &packed, &perPart };
+            for (int i = 0; i < 2; i++)
+            {
+                if (frame == 20)
+                {
+                    models[i]->Show("PartArmB", arms, 2);
+                }
+                else if (frame == 30)
+                {
+                    models[i]->Show("PartHandB", hands, 3);
+                }
+                else if (frame == 40)
+                {
+                    models[i]->Show("PartArmA", arms, 2);
+                }
+                else if (frame == 90)
+                {
+                    models[i]->Show("PartMissing", hands, 3);
+                }
+                else if (frame == 140)
+                {
+                    // 2枚とも表示すると先の1枚が表示パーツになる
+                    models[i]->Show("PartHandA", hands, 3);
+                    models[i]->GetModel()->SetParameterValue(GetId("PartHandB"), 1.0f);
+                }
+            }
+            const float deltaTime = (1.0f / 60.0f) * (0.5f + static_cast<float>(rand()) / RAND_MAX);
+
+            pose->UpdateParameters(packed.GetModel(), deltaTime);
+            reference.UpdateParameters(perPart.GetModel(), deltaTime);
+
+            bool isMatched = true;
+            for (int i = 0; i < PartCount; i++)
+            {
+                const float opacity = packed.GetModel()->GetPartOpacity(GetId(PartIds[i]));
+                isMatched = isMatched && opacity == perPart.GetModel()->GetPartOpacity(GetId(PartIds[i]));
+                isFading = isFading || (opacity > 0.0f && opacity < 1.0f);
+            }
+            isMatched = isMatched
+                        && packed.GetModel()->GetPartOpacity(GetId("PartMissing")) == perPart.GetModel()->GetPartOpacity(GetId("PartMissing"))
+                        && packed.GetModel()->GetPartOpacity(GetId("PartMissingLink")) == perPart.GetModel()->GetPartOpacity(GetId("PartMissingLink"));
+
+            if (!isMatched)
+            {
+                mismatchedFrames++;
+            }
+        }
+
+        CSM_TEST_ASSERT_EQUAL(0, mismatchedFrames);
+        CSM_TEST_ASSERT(isFading);
+
+        // 連動するパーツは連動元と同じ不透明度になり、切り替えた後は腕Aだけが見える
+        CubismModel* model = packed.GetModel();
+        CSM_TEST_ASSERT_EQUAL(1.0f, model->GetPartOpacity(GetId("PartArmA")));
+        CSM_TEST_ASSERT_EQUAL(0.0f, model->GetPartOpacity(GetId("PartArmB")));
+        CSM_TEST_ASSERT_EQUAL(model->GetPartOpacity(GetId("PartArmA")), model->GetPartOpacity(GetId("PartSleeveA")));
+        CSM_TEST_ASSERT_EQUAL(model->GetPartOpacity(GetId("PartArmB")), model->GetPartOpacity(GetId("PartSleeveB")));
+        CSM_TEST_ASSERT_EQUAL(model->GetPartOpacity(GetId("PartArmB")), model->GetPartOpacity(GetId("PartMissingLink")));
+
+        CubismPose::Delete(pose);
+    }
+}
+
+int main()
+{
+    TestSupport::FrameworkScope framework;
+
+    TestPackedFadeMatchesPerPartFade();
+
+    return TestSupport::Finish("PoseFadeTest");
+}
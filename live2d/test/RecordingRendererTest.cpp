@@ -0,0 +1,213 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+/**
+ * OpenGLES2のレンダラを記録用のrlglの上で動かし、実際に発行されたGLの呼び出しを検証する。
+ * モデルはMockCubismCoreで組み立てた合成モデルを使う。
+ */
+
+#include <limits>
+#include <Math/CubismMatrix44.hpp>
+#include "MockCubismCore.hpp"
+#include "RenderedModel.hpp"
+#include "TestSupport.hpp"
+
+using namespace Live2D::Cubism::Framework;
+using namespace Live2D::Cubism::Framework::Rendering;
+using TestSupport::RenderedModel;
+
+namespace {
+    /**
+     * @brief   同じステートで並んだ6枚、別のテクスチャの1枚、加算の1枚を描くモデル
+     */
+    MockCubismCore::ModelBuilder CreateBatchModel()
+    {
+        MockCubismCore::ModelBuilder builder;
+        builder.AddParameter("ParamMove", -1.0f, 1.0f, 0.0f);
+        for (int i = 0; i < 6; i++)
+        {
+            builder.AddQuad("Same", 0, -0.9f + i * 0.25f, -0.5f, 0.2f, 0.2f);
+        }
+        builder.AddQuad("OtherTexture", 1, -0.5f, 0.2f, 0.2f, 0.2f);
+        const int additive = builder.AddQuad("Additive", 0, 0.2f, 0.2f, 0.2f, 0.2f);
+        builder.GetDrawable(additive).ConstantFlags = Live2D::Cubism::Core::csmBlendAdditive;
+        return builder;
+    }
+
+    void TestBatchesReachRlgl()
+    {
+        RenderedModel rendered(CreateBatchModel());
+
+        const CubismRlglRecorder::Statistics& statistics = rendered.DrawFrame();
+        const CubismRenderer_OpenGLES2::FrameStatistics& frame = rendered.GetRenderer()->GetFrameStatistics();
+
+        // 6枚は1回にまとめられ、テクスチャと合成モードが違う2枚はそれぞれ1回
+        CSM_TEST_ASSERT_EQUAL(3, statistics.DrawCalls);
+        CSM_TEST_ASSERT_EQUAL(frame.DrawCalls, statistics.DrawCalls);
+        CSM_TEST_ASSERT_EQUAL(6, frame.BatchedDrawables);
+        CSM_TEST_ASSERT_EQUAL(8 * 6, statistics.DrawnIndices);
+        CSM_TEST_ASSERT_EQUAL(0, statistics.InvalidCalls);
+    }
+
+    void TestCullingReachesRlgl()
+    {
+        MockCubismCore::ModelBuilder builder;
+        builder.AddQuad("Visible", 0, -0.5f, -0.5f, 0.5f, 0.5f);
+        builder.AddQuad("OffScreen", 1, 3.0f, 3.0f, 0.5f, 0.5f);
+        const int transparent = builder.AddQuad("Transparent", 0, 0.1f, 0.1f, 0.5f, 0.5f);
+        builder.GetDrawable(transparent).Opacity = 0.0f;
+        RenderedModel rendered(builder);
+
+        // 既定ではカリングしないので3枚とも描く
+        CSM_TEST_ASSERT_EQUAL(3, rendered.DrawFrame().DrawCalls);
+        CSM_TEST_ASSERT_EQUAL(0, rendered.GetRenderer()->GetFrameStatistics().CulledByViewport);
+        CSM_TEST_ASSERT_EQUAL(0, rendered.GetRenderer()->GetFrameStatistics().CulledByOpacity);
+
+        rendered.GetRenderer()->SetDrawableCulling(true, 0.001f, 0.0f);
+        const CubismRlglRecorder::Statistics& statistics = rendered.DrawFrame();
+        const CubismRenderer_OpenGLES2::FrameStatistics& frame = rendered.GetRenderer()->GetFrameStatistics();
+        CSM_TEST_ASSERT_EQUAL(1, statistics.DrawCalls);
+        CSM_TEST_ASSERT_EQUAL(6, statistics.DrawnIndices);
+        CSM_TEST_ASSERT_EQUAL(1, frame.CulledByViewport);
+        CSM_TEST_ASSERT_EQUAL(1, frame.CulledByOpacity);
+        CSM_TEST_ASSERT_EQUAL(0, statistics.InvalidCalls);
+
+        // 切れば再び3枚とも描く
+        rendered.GetRenderer()->SetDrawableCulling(false, 0.0f, 0.0f);
+        CSM_TEST_ASSERT_EQUAL(3, rendered.DrawFrame().DrawCalls);
+    }
+
+    void TestCullingKeepsDrawablesWithoutBounds()
+    {
+        MockCubismCore::ModelBuilder builder;
+        builder.AddParameter("ParamMove", -1.0f, 1.0f, 1.0f);
+        const int broken = builder.AddQuad("Broken", 0, -0.5f, 3.0f, 0.5f, 0.5f);
+        builder.GetDrawable(broken).MoveParameter = 0;
+        builder.GetDrawable(broken).MoveX = std::numeric_limits<float>::quiet_NaN();
+        RenderedModel rendered(builder);
+
+        // X座標がNaNで外接矩形を求められないDrawableは、Y座標が画面外でもカリングせずに描く
+        rendered.GetRenderer()->SetDrawableCulling(true, 0.001f, 1.0f);
+        const CubismRlglRecorder::Statistics& statistics = rendered.DrawFrame();
+        const CubismRenderer_OpenGLES2::FrameStatistics& frame = rendered.GetRenderer()->GetFrameStatistics();
+        CSM_TEST_ASSERT_EQUAL(1, statistics.DrawCalls);
+        CSM_TEST_ASSERT_EQUAL(0, frame.CulledByViewport);
+        CSM_TEST_ASSERT_EQUAL(0, frame.CulledBySize);
+    }
+
+    void TestMasksReachRlgl()
+    {
+        MockCubismCore::ModelBuilder builder;
+        builder.AddParameter("ParamMove", -1.0f, 1.0f, 0.0f);
+        const int mask = builder.AddQuad("Mask", 0, -0.5f, -0.5f, 0.5f, 0.5f);
+        const int clipped = builder.AddQuad("Clipped", 0, -0.4f, -0.4f, 0.5f, 0.5f);
+        builder.GetDrawable(clipped).Masks.push_back(mask);
+        builder.GetDrawable(mask).MoveParameter = 0;
+        builder.GetDrawable(mask).MoveX = 0.1f;
+        RenderedModel rendered(builder);
+
+        // 最初のフレームはマスクを描いてから、元のフレームバッファに戻す
+        const CubismRlglRecorder::Statistics& first = rendered.DrawFrame();
+        CSM_TEST_ASSERT_EQUAL(1, first.Clears);
+        CSM_TEST_ASSERT_EQUAL(2, first.FramebufferBinds);
+        CSM_TEST_ASSERT_EQUAL(3, first.DrawCalls);
+        CSM_TEST_ASSERT_EQUAL(0, first.InvalidCalls);
+
+        // 何も変わらなければマスクは描き直さない
+        rendered.GetModel()->Update();
+        const CubismRlglRecorder::Statistics& unchanged = rendered.DrawFrame();
+        CSM_TEST_ASSERT_EQUAL(0, unchanged.Clears);
+        CSM_TEST_ASSERT_EQUAL(2, unchanged.DrawCalls);
+
+        // マスクのDrawableが動けば描き直す
+        rendered.GetModel()->SetParameterValue(0, 1.0f);
+        rendered.GetModel()->Update();
+        const CubismRlglRecorder::Statistics& moved = rendered.DrawFrame();
+        CSM_TEST_ASSERT_EQUAL(1, moved.Clears);
+        CSM_TEST_ASSERT_EQUAL(3, moved.DrawCalls);
+    }
+
+    void TestInstancesReachRlgl()
+    {
+        const MockCubismCore::ModelBuilder builder = CreateBatchModel();
+        RenderedModel first(builder);
+        RenderedModel second(builder);
+        RenderedModel third(builder);
+
+        const CubismModel* models[3] = { first.GetModel(), second.GetModel(), third.GetModel() };
+        CubismMatrix44 mvps[3];
+        const csmFloat32 opacities[3] = { 1.0f, 0.5f, 0.25f };
+
+        CubismRlglRecorder::InvalidateState();
+        CubismRlglRecorder::ResetStatistics();
+        CSM_TEST_ASSERT(first.GetRenderer()->DrawInstances(models, mvps, opacities, 3));
+
+        const CubismRlglRecorder::Statistics& statistics = CubismRlglRecorder::GetStatistics();
+        CSM_TEST_ASSERT(statistics.InstancedDrawCalls > 0);
+        CSM_TEST_ASSERT_EQUAL(statistics.InstancedDrawCalls, statistics.DrawCalls);
+        CSM_TEST_ASSERT_EQUAL(3 * statistics.InstancedDrawCalls, statistics.DrawnInstances);
+        CSM_TEST_ASSERT_EQUAL(0, statistics.InvalidCalls);
+    }
+
+    void TestCommandStream()
+    {
+        RenderedModel rendered(CreateBatchModel());
+        rendered.DrawFrame();
+
+        CubismRlglRecorder::SetCommandRecording(true);
+        rendered.DrawFrame();
+
+        // 統計と記録した呼び出しは一致する
+        const csmVector<CubismRlglCommand>& commands = CubismRlglRecorder::GetCommands();
+        csmUint32 drawCalls = 0;
+        csmUint32 drawnIndices = 0;
+        for (csmUint32 i = 0; i < commands.GetSize(); i++)
+        {
+            if (commands[i].Type == CubismRlglCommandType_Draw)
+            {
+                drawCalls++;
+                drawnIndices += commands[i].Count;
+            }
+        }
+        CSM_TEST_ASSERT_EQUAL(CubismRlglRecorder::GetStatistics().DrawCalls, drawCalls);
+        CSM_TEST_ASSERT_EQUAL(CubismRlglRecorder::GetStatistics().DrawnIndices, drawnIndices);
+        CubismRlglRecorder::SetCommandRecording(false);
+    }
+
+    void TestReleaseUnloadsGlObjects()
+    {
+        CubismRenderer::StaticRelease();
+        const csmUint32 liveObjects = CubismRlglRecorder::GetLiveObjectCount();
+        CSM_TEST_ASSERT_EQUAL(0, liveObjects);
+        {
+            RenderedModel rendered(CreateBatchModel());
+            rendered.DrawFrame();
+            CSM_TEST_ASSERT(CubismRlglRecorder::GetLiveObjectCount() > liveObjects);
+        }
+        CubismRenderer::StaticRelease();
+        CSM_TEST_ASSERT_EQUAL(liveObjects, CubismRlglRecorder::GetLiveObjectCount());
+
+        // 解放した時に種類を取り違えたIDは無い
+        CSM_TEST_ASSERT_EQUAL(0, CubismRlglRecorder::GetStatistics().InvalidCalls);
+    }
+}
+
+int main()
+{
+    TestSupport::FrameworkScope framework;
+
+    TestBatchesReachRlgl();
+    TestCullingReachesRlgl();
+    TestCullingKeepsDrawablesWithoutBounds();
+    TestMasksReachRlgl();
+    TestInstancesReachRlgl();
+    TestCommandStream();
+    TestReleaseUnloadsGlObjects();
+
+    CubismRenderer::StaticRelease();
+    return TestSupport::Finish("RecordingRendererTest");
+}
@@ -0,0 +1,96 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+/**
+ * LAppModelの描画結果のキャッシュが、パラメータの変化を範囲に対する割合で判定することを検証する。
+ * 範囲が-30..30の角度と0..1の開閉を同じ閾値で比べても、見た目の変化に見合った判定になる。
+ */
+
+#include <string>
+#include <Math/CubismMatrix44.hpp>
+#include <Model/CubismModel.hpp>
+#include "LAppModel.hpp"
+#include "MockCubismCore.hpp"
+#include "TestSupport.hpp"
+
+using namespace Live2D::Cubism::Framework;
+
+namespace {
+    const int ViewportSize = 256;
+    const float Threshold = 0.01f;
+
+    std::string WriteTestModel()
+    {
+        MockCubismCore::ModelBuilder builder;
+        const int angle = builder.AddParameter("ParamAngleX", -30.0f, 30.0f, 0.0f);
+        const int open = builder.AddParameter("ParamEyeLOpen", 0.0f, 1.0f, 1.0f);
+        builder.AddPart("PartBody");
+        const int head = builder.AddQuad("Head", 0, -0.5f, 0.0f, 0.4f, 0.4f);
+        const int eye = builder.AddQuad("Eye", 0, 0.1f, 0.0f, 0.2f, 0.1f);
+        builder.GetDrawable(head).MoveParameter = angle;
+        builder.GetDrawable(head).MoveX = 0.01f;
+        builder.GetDrawable(eye).MoveParameter = open;
+        builder.GetDrawable(eye).MoveY = 0.1f;
+
+        return TestSupport::WriteModel("RenderCacheTest", builder, TestSupport::ModelFiles());
+    }
+
+    /**
+     * @brief   パラメータを設定してモデルを更新し、1フレーム描く
+     *
+     * @return  キャッシュをそのまま使ったか
+     */
+    bool DrawFrame(LAppModel* model, float angle, float open, float partOpacity)
+    {
+        CubismModel* cubismModel = model->GetModel();
+        cubismModel->SetParameterValue(0, angle);
+        cubismModel->SetParameterValue(1, open);
+        cubismModel->SetPartOpacity(0, partOpacity);
+        cubismModel->Update();
+
+        CubismMatrix44 projection;
+        model->Draw(projection, ViewportSize, ViewportSize);
+        return model->IsRenderCacheHit();
+    }
+
+    void TestParameterChangeIsRelativeToRange()
+    {
+        const std::string fileName = WriteTestModel();
+        LAppModel* model = new LAppModel();
+        model->LoadAssets(TestSupport::GetTemporaryDirectory().c_str(), fileName.c_str());
+        model->SetRenderCacheEnabled(true, Threshold);
+
+        // 初回はキャッシュを描く
+        CSM_TEST_ASSERT(!DrawFrame(model, 0.0f, 1.0f, 1.0f));
+
+        // 角度の0.3は範囲60の0.5%なので描き直さない。絶対値で比べると閾値を超えていた
+        CSM_TEST_ASSERT(DrawFrame(model, 0.3f, 1.0f, 1.0f));
+
+        // 開閉の0.05は範囲1の5%なので描き直す
+        CSM_TEST_ASSERT(!DrawFrame(model, 0.3f, 0.95f, 1.0f));
+
+        // 描き直したときの値からの変化で判定する
+        CSM_TEST_ASSERT(DrawFrame(model, 0.6f, 0.95f, 1.0f));
+        CSM_TEST_ASSERT(!DrawFrame(model, 3.0f, 0.95f, 1.0f));
+
+        // パーツ不透明度は0..1なので、そのままの変化量で比べる
+        CSM_TEST_ASSERT(DrawFrame(model, 3.3f, 0.95f, 0.995f));
+        CSM_TEST_ASSERT(!DrawFrame(model, 3.0f, 0.95f, 0.9f));
+
+        delete model;
+    }
+}
+
+int main()
+{
+    TestSupport::FrameworkScope framework;
+
+    TestParameterChangeIsRelativeToRange();
+
+    Rendering::CubismRenderer::StaticRelease();
+    return TestSupport::Finish("RenderCacheTest");
+}
@@ -0,0 +1,84 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+/**
+ * LAppModelの解像度の自動調整が、アプリのフレーム時間ではなくモデル自身の描画時間で倍率を決めることを検証する。
+ */
+
+#include <string>
+#include <Math/CubismMatrix44.hpp>
+#include "LAppModel.hpp"
+#include "LAppPal.hpp"
+#include "MockCubismCore.hpp"
+#include "TestSupport.hpp"
+#include "raylib.h"
+
+using namespace Live2D::Cubism::Framework;
+
+namespace {
+    const int ViewportSize = 256;
+    const int FrameCount = 100;
+    const double FrameSeconds = 0.1;
+
+    std::string WriteTestModel()
+    {
+        MockCubismCore::ModelBuilder builder;
+        builder.AddQuad("Body", 0, -0.5f, -0.5f, 1.0f, 1.0f);
+        return TestSupport::WriteModel("RenderScaleTest", builder, TestSupport::ModelFiles());
+    }
+
+    void TestScaleFollowsDrawTime()
+    {
+        const std::string fileName = WriteTestModel();
+        LAppModel* fast = new LAppModel();
+        LAppModel* slow = new LAppModel();
+        fast->LoadAssets(TestSupport::GetTemporaryDirectory().c_str(), fileName.c_str());
+        slow->LoadAssets(TestSupport::GetTemporaryDirectory().c_str(), fileName.c_str());
+
+        // 1枚の矩形は目標の5msより十分速く描ける。もう一方は、どんな描画でも超える目標にする
+        fast->SetAdaptiveRenderScale(0.005f, 0.25f, 1.0f);
+        slow->SetAdaptiveRenderScale(1e-9f, 0.25f, 1.0f);
+
+        // アプリのフレーム時間はどちらの目標も大きく超える
+        double time = 0.0;
+        for (int frame = 0; frame < FrameCount; frame++)
+        {
+            time += FrameSeconds;
+            SetHeadlessTime(time);
+            LAppPal::UpdateTime();
+
+            CubismMatrix44 fastProjection;
+            CubismMatrix44 slowProjection;
+            fast->Draw(fastProjection, ViewportSize, ViewportSize);
+            slow->Draw(slowProjection, ViewportSize, ViewportSize);
+        }
+
+        const LAppRenderScaleController::Statistics& fastStatistics = fast->GetRenderScaleStatistics();
+        CSM_TEST_ASSERT_EQUAL(1.0f, fastStatistics.Scale);
+        CSM_TEST_ASSERT_EQUAL(0, fastStatistics.ScaleChanges);
+        CSM_TEST_ASSERT(fastStatistics.LastFrameTime > 0.0f);
+        CSM_TEST_ASSERT(fastStatistics.LastFrameTime < static_cast<float>(FrameSeconds));
+
+        // 最初のDrawはまだ描画時間が無いので数えない
+        const LAppRenderScaleController::Statistics& slowStatistics = slow->GetRenderScaleStatistics();
+        CSM_TEST_ASSERT_EQUAL(0.25f, slowStatistics.Scale);
+        CSM_TEST_ASSERT_EQUAL(FrameCount - 1, slowStatistics.Frames);
+
+        delete fast;
+        delete slow;
+    }
+}
+
+int main()
+{
+    TestSupport::FrameworkScope framework;
+
+    TestScaleFollowsDrawTime();
+
+    Rendering::CubismRenderer::StaticRelease();
+    return TestSupport::Finish("RenderScaleTest");
+}
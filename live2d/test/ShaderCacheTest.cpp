@@ -0,0 +1,154 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+/**
+ * シェーダプログラムのバイナリのキャッシュを、記録用のrlglのプログラムバイナリで検証する。
+ * 以前は起動のたびにすべてのプログラムをコンパイルしていた。
+ * 今は初回にバイナリを保存し、次回からは読み込む。壊れたファイルやドライバが受け付けないバイナリはコンパイルし直す。
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <unistd.h>
+#include "MockCubismCore.hpp"
+#include "RenderedModel.hpp"
+#include "TestSupport.hpp"
+
+using namespace Live2D::Cubism::Framework;
+using namespace Live2D::Cubism::Framework::Rendering;
+using TestSupport::RenderedModel;
+
+namespace {
+    /**
+     * @brief   キャッシュのディレクトリにあるファイルのパスを返す
+     */
+    std::vector<std::string> ListCacheFiles(const std::string& directory)
+    {
+        std::vector<std::string> files;
+        DIR* dir = opendir(directory.c_str());
+        CSM_TEST_ASSERT(dir != NULL);
+        if (dir == NULL)
+        {
+            return files;
+        }
+
+        for (dirent* entry = readdir(dir); entry != NULL; entry = readdir(dir))
+        {
+            const std::string name = entry->d_name;
+            if (name != "." && name != "..")
+            {
+                files.push_back(directory + "/" + name);
+            }
+        }
+        closedir(dir);
+        return files;
+    }
+
+    /**
+     * @brief   起動から終了までを1回行い、シェーダプログラムの読み込みの統計を返す
+     */
+    CubismShader_OpenGLES2::ProgramStatistics Launch(const std::string& cacheDirectory)
+    {
+        CubismRenderer_OpenGLES2::SetShaderCacheDirectory(cacheDirectory.c_str());
+
+        CubismShader_OpenGLES2::ProgramStatistics statistics;
+        {
+            MockCubismCore::ModelBuilder builder;
+            const int mask = builder.AddQuad("Mask", 0, -0.5f, -0.5f, 0.5f, 0.5f);
+            const int clipped = builder.AddQuad("Clipped", 0, -0.4f, -0.4f, 0.5f, 0.5f);
+            builder.GetDrawable(clipped).Masks.push_back(mask);
+            builder.AddQuad("Body", 0, -0.2f, -0.2f, 0.5f, 0.5f);
+
+            RenderedModel rendered(builder);
+            const CubismRlglRecorder::Statistics& frame = rendered.DrawFrame();
+            CSM_TEST_ASSERT_EQUAL(0, frame.InvalidCalls);
+            statistics = CubismRenderer_OpenGLES2::GetShaderStatistics();
+        }
+
+        // シェーダのインスタンスを破棄し、次の起動ではプログラムを作り直させる
+        CubismRenderer::StaticRelease();
+        return statistics;
+    }
+
+    void TestCacheHitsAndFallbacks()
+    {
+        char directory[1024];
+        snprintf(directory, sizeof(directory), "%sShaderCacheTestXXXXXX", TestSupport::GetTemporaryDirectory().c_str());
+        CSM_TEST_ASSERT(mkdtemp(directory) != NULL);
+        const std::string cacheDirectory = directory;
+
+        CubismRenderer_OpenGLES2::SetGLProcAddressLoader(CubismRlglRecorder::GetGLProcAddress);
+
+        // 初回はすべてコンパイルし、1プログラムにつき1つのファイルを保存する
+        const CubismShader_OpenGLES2::ProgramStatistics cold = Launch(cacheDirectory);
+        const csmUint32 programCount = cold.CompiledPrograms;
+        CSM_TEST_ASSERT(programCount >= 2);
+        CSM_TEST_ASSERT_EQUAL(0, cold.CachedPrograms);
+        CSM_TEST_ASSERT_EQUAL(0, cold.RejectedBinaries);
+        std::vector<std::string> files = ListCacheFiles(cacheDirectory);
+        CSM_TEST_ASSERT_EQUAL(programCount, files.size());
+
+        // 次回はすべてキャッシュから読む
+        const CubismShader_OpenGLES2::ProgramStatistics warm = Launch(cacheDirectory);
+        CSM_TEST_ASSERT_EQUAL(0, warm.CompiledPrograms);
+        CSM_TEST_ASSERT_EQUAL(programCount, warm.CachedPrograms);
+        CSM_TEST_ASSERT_EQUAL(0, warm.RejectedBinaries);
+
+        // 識別子が壊れたファイルと途中で切れたファイルは読まずにコンパイルし、保存し直す
+        for (size_t i = 0; i < files.size(); i++)
+        {
+            if (i == 0)
+            {
+                CSM_TEST_ASSERT_EQUAL(0, truncate(files[i].c_str(), 6));
+                continue;
+            }
+            FILE* file = fopen(files[i].c_str(), "r+b");
+            CSM_TEST_ASSERT(file != NULL);
+            const unsigned char zero[4] = { 0, 0, 0, 0 };
+            fwrite(zero, 1, sizeof(zero), file);
+            fclose(file);
+        }
+        const CubismShader_OpenGLES2::ProgramStatistics corrupted = Launch(cacheDirectory);
+        CSM_TEST_ASSERT_EQUAL(programCount, corrupted.CompiledPrograms);
+        CSM_TEST_ASSERT_EQUAL(0, corrupted.CachedPrograms);
+        CSM_TEST_ASSERT_EQUAL(0, corrupted.RejectedBinaries);
+        CSM_TEST_ASSERT_EQUAL(programCount, Launch(cacheDirectory).CachedPrograms);
+
+        // ドライバが以前のバイナリを受け付けなくなれば、リンクの失敗を確かめてコンパイルし直す
+        CubismRlglRecorder::SetProgramBinaryFormat(0x5244);
+        const CubismShader_OpenGLES2::ProgramStatistics rejected = Launch(cacheDirectory);
+        CSM_TEST_ASSERT_EQUAL(programCount, rejected.RejectedBinaries);
+        CSM_TEST_ASSERT_EQUAL(programCount, rejected.CompiledPrograms);
+        CSM_TEST_ASSERT_EQUAL(0, rejected.CachedPrograms);
+        CSM_TEST_ASSERT_EQUAL(programCount, Launch(cacheDirectory).CachedPrograms);
+
+        // ローダが無ければ関数を取得できないので、キャッシュを使わずにコンパイルする
+        CubismRenderer_OpenGLES2::SetGLProcAddressLoader(NULL);
+        const CubismShader_OpenGLES2::ProgramStatistics unsupported = Launch(cacheDirectory);
+        CSM_TEST_ASSERT_EQUAL(programCount, unsupported.CompiledPrograms);
+        CSM_TEST_ASSERT_EQUAL(0, unsupported.CachedPrograms);
+
+        files = ListCacheFiles(cacheDirectory);
+        for (size_t i = 0; i < files.size(); i++)
+        {
+            remove(files[i].c_str());
+        }
+        rmdir(cacheDirectory.c_str());
+    }
+}
+
+int main()
+{
+    TestSupport::FrameworkScope framework;
+
+    TestCacheHitsAndFallbacks();
+
+    return TestSupport::Finish("ShaderCacheTest");
+}
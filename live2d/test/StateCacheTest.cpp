@@ -0,0 +1,125 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+/**
+ * レンダラのステートキャッシュを、記録用のrlglで再生した描画の流れで検証する。
+ * キャッシュが無ければ、Drawableごとにプログラム・テクスチャ・合成モード・ユニフォームを設定し直していた。
+ * 今は直前と同じ値の設定を省くので、GLへ届くステート変更に冗長なものは無い。
+ */
+
+#include "MockCubismCore.hpp"
+#include "RenderedModel.hpp"
+#include "TestSupport.hpp"
+
+using namespace Live2D::Cubism::Framework;
+using namespace Live2D::Cubism::Framework::Rendering;
+using TestSupport::RenderedModel;
+
+namespace {
+    const int DrawableCount = 12;
+
+    /**
+     * @brief   テクスチャと合成モードが入れ替わり、まとめて描けないDrawableが並ぶモデル
+     */
+    MockCubismCore::ModelBuilder CreateStateModel()
+    {
+        MockCubismCore::ModelBuilder builder;
+        for (int i = 0; i < DrawableCount; i++)
+        {
+            const int drawable = builder.AddQuad("Quad", i % 2, -0.9f + i * 0.15f, -0.2f, 0.1f, 0.1f);
+            if (i % 3 == 2)
+            {
+                builder.GetDrawable(drawable).ConstantFlags = Live2D::Cubism::Core::csmBlendAdditive;
+            }
+        }
+        return builder;
+    }
+
+    /**
+     * @brief   記録した呼び出しを再生して、ステートを設定した呼び出しを数える
+     */
+    void CountStateCommands(csmUint32& stateChanges, csmUint32& redundantStateChanges)
+    {
+        stateChanges = 0;
+        redundantStateChanges = 0;
+        const csmVector<CubismRlglCommand>& commands = CubismRlglRecorder::GetCommands();
+        for (csmUint32 i = 0; i < commands.GetSize(); i++)
+        {
+            switch (commands[i].Type)
+            {
+            case CubismRlglCommandType_UseProgram:
+            case CubismRlglCommandType_BindVertexArray:
+            case CubismRlglCommandType_SetVertexAttribute:
+            case CubismRlglCommandType_BindElementBuffer:
+            case CubismRlglCommandType_BindTexture:
+            case CubismRlglCommandType_SetBlend:
+            case CubismRlglCommandType_SetCulling:
+            case CubismRlglCommandType_SetUniform:
+                if (commands[i].IsRedundant)
+                {
+                    redundantStateChanges++;
+                }
+                else
+                {
+                    stateChanges++;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    void TestNoRedundantStateReachesRlgl()
+    {
+        RenderedModel rendered(CreateStateModel());
+        rendered.DrawFrame();
+
+        // 2フレーム目以降を比べる。初回はシェーダーとバッファの作成を含む
+        CubismRlglRecorder::SetCommandRecording(true);
+        csmUint32 firstStateChanges = 0;
+        for (int frame = 0; frame < 3; frame++)
+        {
+            const CubismRlglRecorder::Statistics& statistics = rendered.DrawFrame();
+            const CubismRenderer_OpenGLES2::FrameStatistics& renderer = rendered.GetRenderer()->GetFrameStatistics();
+            csmUint32 stateChanges = 0;
+            csmUint32 redundantStateChanges = 0;
+            CountStateCommands(stateChanges, redundantStateChanges);
+
+            // 1枚ずつ描くので、Drawableごとに何かしらのステートが変わる
+            CSM_TEST_ASSERT_EQUAL(DrawableCount, statistics.DrawCalls);
+            CSM_TEST_ASSERT(stateChanges >= static_cast<csmUint32>(DrawableCount));
+
+            // GLへ届いた呼び出しに冗長なものは無く、レンダラが数えた変更と一致する
+            CSM_TEST_ASSERT_EQUAL(0, redundantStateChanges);
+            CSM_TEST_ASSERT_EQUAL(0, statistics.RedundantStateChanges);
+            CSM_TEST_ASSERT_EQUAL(stateChanges, statistics.StateChanges);
+            CSM_TEST_ASSERT_EQUAL(renderer.StateChanges, statistics.StateChanges);
+
+            // キャッシュが無ければ送っていた呼び出しは、送った呼び出し以上にある
+            CSM_TEST_ASSERT(renderer.RedundantStateChanges >= renderer.StateChanges);
+
+            // フレームを先頭から描き直しても同じ流れになる
+            if (frame == 0)
+            {
+                firstStateChanges = stateChanges;
+            }
+            CSM_TEST_ASSERT_EQUAL(firstStateChanges, stateChanges);
+        }
+        CubismRlglRecorder::SetCommandRecording(false);
+    }
+}
+
+int main()
+{
+    TestSupport::FrameworkScope framework;
+
+    TestNoRedundantStateReachesRlgl();
+
+    CubismRenderer::StaticRelease();
+    return TestSupport::Finish("StateCacheTest");
+}
@@ -0,0 +1,109 @@
+/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+#include "raylib.h"
+#include <cstdlib>
+#include <cstring>
+#include "rlgl.h"
+
+namespace {
+    const int ImageSize = 4;        ///< 読み込んだ画像の幅と高さ。中身は見ないので小さくてよい
+
+    double s_time = 0.0;
+    int s_screenWidth = 800;
+    int s_screenHeight = 600;
+}
+
+void SetHeadlessTime(double seconds)
+{
+    s_time = seconds;
+}
+
+void SetHeadlessScreenSize(int width, int height)
+{
+    s_screenWidth = width;
+    s_screenHeight = height;
+}
+
+extern "C" {
+
+double GetTime(void)
+{
+    return s_time;
+}
+
+int GetScreenWidth(void)
+{
+    return s_screenWidth;
+}
+
+int GetScreenHeight(void)
+{
+    return s_screenHeight;
+}
+
+Image LoadImageFromMemory(const char* fileType, const unsigned char* fileData, int dataSize)
+{
+    Image image;
+    memset(&image, 0, sizeof(image));
+    if (fileData == NULL || dataSize <= 0)
+    {
+        return image;
+    }
+
+    image.width = ImageSize;
+    image.height = ImageSize;
+    image.mipmaps = 1;
+    image.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    image.data = malloc(ImageSize * ImageSize * 4);
+    memset(image.data, 0xFF, ImageSize * ImageSize * 4);
+    return image;
+}
+
+void UnloadImage(Image image)
+{
+    free(image.data);
+}
+
+void ImageFormat(Image* image, int newFormat)
+{
+}
+
+Texture2D LoadTexture(const char* fileName)
+{
+    Texture2D texture;
+    memset(&texture, 0, sizeof(texture));
+    return texture;
+}
+
+Texture2D LoadTextureFromImage(Image image)
+{
+    Texture2D texture;
+    memset(&texture, 0, sizeof(texture));
+    if (image.data == NULL)
+    {
+        return texture;
+    }
+
+    texture.id = rlLoadTexture(image.data, image.width, image.height, image.format, image.mipmaps);
+    texture.width = image.width;
+    texture.height = image.height;
+    texture.mipmaps = image.mipmaps;
+    texture.format = image.format;
+    return texture;
+}
+
+void UnloadTexture(Texture2D texture)
+{
+    rlUnloadTexture(texture.id);
+}
+
+void GenTextureMipmaps(Texture2D* texture)
+{
+}
+
+}
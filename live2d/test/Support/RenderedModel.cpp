@@ -0,0 +1,58 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+#include "RenderedModel.hpp"
+#include <vector>
+#include "rlgl.h"
+
+using namespace Live2D::Cubism::Framework;
+using namespace Live2D::Cubism::Framework::Rendering;
+
+namespace TestSupport {
+
+RenderedModel::RenderedModel(const MockCubismCore::ModelBuilder& builder)
+{
+    const std::vector<unsigned char> mocBytes = builder.BuildMoc();
+    _moc = CubismMoc::Create(&mocBytes[0], static_cast<csmSizeInt>(mocBytes.size()));
+    _model = _moc->CreateModel();
+    _model->Update();
+
+    _renderer = static_cast<CubismRenderer_OpenGLES2*>(CubismRenderer::Create());
+    _renderer->Initialize(_model);
+    _renderer->SetViewport(ViewportSize, ViewportSize);
+
+    const unsigned char pixel[4] = { 255, 255, 255, 255 };
+    for (csmInt32 i = 0; i < TextureCount; i++)
+    {
+        _textures[i] = rlLoadTexture(pixel, 1, 1, RL_PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, 1);
+        _renderer->BindTexture(i, _textures[i]);
+    }
+
+    _mvp.LoadIdentity();
+    _renderer->SetMvpMatrix(&_mvp);
+}
+
+RenderedModel::~RenderedModel()
+{
+    CubismRenderer::Delete(_renderer);
+    for (csmInt32 i = 0; i < TextureCount; i++)
+    {
+        rlUnloadTexture(_textures[i]);
+    }
+    _moc->DeleteModel(_model);
+    CubismMoc::Delete(_moc);
+}
+
+const CubismRlglRecorder::Statistics& RenderedModel::DrawFrame()
+{
+    CubismRlglRecorder::InvalidateState();
+    CubismRlglRecorder::ResetStatistics();
+    _renderer->DrawModel();
+    return CubismRlglRecorder::GetStatistics();
+}
+
+}
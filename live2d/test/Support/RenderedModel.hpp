@@ -0,0 +1,51 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+#pragma once
+
+#include <Math/CubismMatrix44.hpp>
+#include <Model/CubismMoc.hpp>
+#include <Model/CubismModel.hpp>
+#include <Rendering/Raylib/CubismRenderer_OpenGLES2.hpp>
+#include <Rendering/Recording/CubismRlglRecorder.hpp>
+#include "MockCubismCore.hpp"
+
+namespace TestSupport {
+
+/**
+ * @brief   合成モデルと、それを記録用のrlglの上で描くレンダラ
+ */
+class RenderedModel
+{
+public:
+    static const int ViewportSize = 512;
+    static const int TextureCount = 2;
+
+    explicit RenderedModel(const MockCubismCore::ModelBuilder& builder);
+
+    ~RenderedModel();
+
+    /**
+     * @brief   記録をリセットして1フレーム描く。前のフレームとの間に他の描画があったものとする
+     *
+     * @return  このフレームで記録した呼び出しの量
+     */
+    const Live2D::Cubism::Framework::Rendering::CubismRlglRecorder::Statistics& DrawFrame();
+
+    Live2D::Cubism::Framework::CubismModel* GetModel() { return _model; }
+
+    Live2D::Cubism::Framework::Rendering::CubismRenderer_OpenGLES2* GetRenderer() { return _renderer; }
+
+private:
+    Live2D::Cubism::Framework::CubismMoc* _moc;
+    Live2D::Cubism::Framework::CubismModel* _model;
+    Live2D::Cubism::Framework::Rendering::CubismRenderer_OpenGLES2* _renderer;
+    unsigned int _textures[TextureCount];
+    Live2D::Cubism::Framework::CubismMatrix44 _mvp;
+};
+
+}
@@ -0,0 +1,232 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+#include "TestSupport.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+
+using namespace Live2D::Cubism::Framework;
+
+namespace TestSupport {
+
+namespace {
+    int s_failures = 0;
+
+    /**
+     * @brief   mallocで確保するアロケータ
+     */
+    class MallocAllocator : public ICubismAllocator
+    {
+    public:
+        void* Allocate(const csmSizeType size)
+        {
+            return malloc(size);
+        }
+
+        void Deallocate(void* memory)
+        {
+            free(memory);
+        }
+
+        void* AllocateAligned(const csmSizeType size, const csmUint32 alignment)
+        {
+            // 先頭の手前に確保したアドレスを置く
+            char* allocated = static_cast<char*>(malloc(size + alignment + sizeof(void*)));
+            if (allocated == NULL)
+            {
+                return NULL;
+            }
+            const uintptr_t start = reinterpret_cast<uintptr_t>(allocated + sizeof(void*));
+            char* aligned = reinterpret_cast<char*>((start + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+            reinterpret_cast<void**>(aligned)[-1] = allocated;
+            return aligned;
+        }
+
+        void DeallocateAligned(void* alignedMemory)
+        {
+            if (alignedMemory != NULL)
+            {
+                free(reinterpret_cast<void**>(alignedMemory)[-1]);
+            }
+        }
+    };
+
+    MallocAllocator s_mallocAllocator;
+
+    void PrintLog(const csmChar* message)
+    {
+        fprintf(stderr, "%s", message);
+    }
+}
+
+void Fail(const char* file, int line, const char* condition)
+{
+    fprintf(stderr, "%s:%d: FAILED: %s\n", file, line, condition);
+    s_failures++;
+}
+
+void FailEqual(const char* file, int line, const char* expectedText, const char* actualText, double expected, double actual)
+{
+    fprintf(stderr, "%s:%d: FAILED: %s == %s (expected %.9g, actual %.9g)\n", file, line, expectedText, actualText, expected, actual);
+    s_failures++;
+}
+
+int Finish(const char* testName)
+{
+    if (s_failures > 0)
+    {
+        fprintf(stderr, "%s: %d failure(s)\n", testName, s_failures);
+        return 1;
+    }
+
+    printf("%s: passed\n", testName);
+    return 0;
+}
+
+FrameworkScope::FrameworkScope(ICubismAllocator* allocator)
+{
+    static CubismFramework::Option option;
+    option.LogFunction = PrintLog;
+    option.LoggingLevel = CubismFramework::Option::LogLevel_Warning;
+    CubismFramework::StartUp((allocator != NULL) ? allocator : &s_mallocAllocator, &option);
+    CubismFramework::Initialize();
+}
+
+FrameworkScope::~FrameworkScope()
+{
+    CubismFramework::Dispose();
+    CubismFramework::CleanUp();
+}
+
+std::string GetTemporaryDirectory()
+{
+    const char* directory = getenv("TMPDIR");
+    std::string path = (directory != NULL && directory[0] != '\0') ? directory : "/tmp";
+    if (path[path.size() - 1] != '/')
+    {
+        path += '/';
+    }
+    return path;
+}
+
+std::string WriteFile(const std::string& name, const void* data, size_t size)
+{
+    const std::string path = GetTemporaryDirectory() + name;
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == NULL)
+    {
+        Fail(__FILE__, __LINE__, path.c_str());
+        return path;
+    }
+    fwrite(data, 1, size, file);
+    fclose(file);
+    return path;
+}
+
+std::string WriteTextFile(const std::string& name, const std::string& text)
+{
+    return WriteFile(name, text.data(), text.size());
+}
+
+std::string CreatePhysicsJson(int settingCount, float fps)
+{
+    char buffer[1024];
+    std::string json;
+
+    snprintf(buffer, sizeof(buffer),
+             "{\"Version\":3,\"Meta\":{\"PhysicsSettingCount\":%d,\"TotalInputCount\":%d,\"TotalOutputCount\":%d,"
+             "\"VertexCount\":%d,\"EffectiveForces\":{\"Gravity\":{\"X\":0,\"Y\":-1},\"Wind\":{\"X\":0,\"Y\":0}}",
+             settingCount, settingCount, settingCount, settingCount * 2);
+    json += buffer;
+    if (fps > 0.0f)
+    {
+        snprintf(buffer, sizeof(buffer), ",\"Fps\":%g", fps);
+        json += buffer;
+    }
+    json += "},\"PhysicsSettings\":[";
+
+    for (int i = 0; i < settingCount; i++)
+    {
+        snprintf(buffer, sizeof(buffer),
+                 "%s{\"Id\":\"PhysicsSetting%d\","
+                 "\"Input\":[{\"Source\":{\"Target\":\"Parameter\",\"Id\":\"ParamAngleX\"},\"Weight\":100,\"Type\":\"X\",\"Reflect\":false}],"
+                 "\"Output\":[{\"Destination\":{\"Target\":\"Parameter\",\"Id\":\"ParamHair%d\"},\"VertexIndex\":1,\"Scale\":%g,"
+                 "\"Weight\":100,\"Type\":\"Angle\",\"Reflect\":false}],"
+                 "\"Vertices\":[{\"Position\":{\"X\":0,\"Y\":0},\"Mobility\":1,\"Delay\":1,\"Acceleration\":1,\"Radius\":0},"
+                 "{\"Position\":{\"X\":0,\"Y\":3},\"Mobility\":0.95,\"Delay\":0.9,\"Acceleration\":1.5,\"Radius\":3}],"
+                 "\"Normalization\":{\"Position\":{\"Minimum\":-10,\"Default\":0,\"Maximum\":10},"
+                 "\"Angle\":{\"Minimum\":-10,\"Default\":0,\"Maximum\":10}}}",
+                 (i == 0) ? "" : ",", i, i, 1.0f + 0.1f * i);
+        json += buffer;
+    }
+    json += "]}";
+    return json;
+}
+
+namespace {
+    std::string JoinQuoted(const std::vector<std::string>& values)
+    {
+        std::string joined;
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            joined += (i == 0) ? "\"" : ",\"";
+            joined += values[i] + "\"";
+        }
+        return joined;
+    }
+}
+
+std::string WriteModel(const std::string& name, const MockCubismCore::ModelBuilder& builder, const ModelFiles& files)
+{
+    const std::vector<unsigned char> moc = builder.BuildMoc();
+    WriteFile(name + ".moc3", &moc[0], moc.size());
+
+    // 画像はHeadlessRaylibが内容を読まずに作るので、中身は何でもよい
+    std::vector<std::string> textures;
+    for (int i = 0; i < files.TextureCount; i++)
+    {
+        char textureName[64];
+        snprintf(textureName, sizeof(textureName), "%s.texture_%02d.png", name.c_str(), i);
+        WriteTextFile(textureName, "png");
+        textures.push_back(textureName);
+    }
+
+    std::string json = "{\"Version\":3,\"FileReferences\":{\"Moc\":\"" + name + ".moc3\",\"Textures\":[" + JoinQuoted(textures) + "]";
+    if (!files.PhysicsJson.empty())
+    {
+        WriteTextFile(name + ".physics3.json", files.PhysicsJson);
+        json += ",\"Physics\":\"" + name + ".physics3.json\"";
+    }
+    if (!files.IdleMotionJsons.empty())
+    {
+        json += ",\"Motions\":{\"Idle\":[";
+        for (size_t i = 0; i < files.IdleMotionJsons.size(); i++)
+        {
+            char motionName[64];
+            snprintf(motionName, sizeof(motionName), "%s.idle_%02d.motion3.json", name.c_str(), static_cast<int>(i));
+            WriteTextFile(motionName, files.IdleMotionJsons[i]);
+            json += (i == 0) ? "{\"File\":\"" : ",{\"File\":\"";
+            json += std::string(motionName) + "\"}";
+        }
+        json += "]}";
+    }
+    json += "},\"Groups\":[{\"Target\":\"Parameter\",\"Name\":\"EyeBlink\",\"Ids\":[" + JoinQuoted(files.EyeBlinkIds) + "]},"
+            "{\"Target\":\"Parameter\",\"Name\":\"LipSync\",\"Ids\":[" + JoinQuoted(files.LipSyncIds) + "]}]";
+    json += ",\"HitAreas\":[";
+    for (size_t i = 0; i < files.HitAreaIds.size(); i++)
+    {
+        json += (i == 0) ? "{\"Id\":\"" : ",{\"Id\":\"";
+        json += files.HitAreaIds[i] + "\",\"Name\":\"" + files.HitAreaIds[i] + "\"}";
+    }
+    json += "]}";
+
+    WriteTextFile(name + ".model3.json", json);
+    return name + ".model3.json";
+}
+
+}
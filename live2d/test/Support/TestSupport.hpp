@@ -0,0 +1,125 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <CubismFramework.hpp>
+#include <ICubismAllocator.hpp>
+#include "MockCubismCore.hpp"
+
+/**
+ * @brief   条件が偽なら失敗を記録する。テストは続ける
+ */
+#define CSM_TEST_ASSERT(condition) \
+    do { if (!(condition)) { TestSupport::Fail(__FILE__, __LINE__, #condition); } } while (0)
+
+/**
+ * @brief   2つの値が等しくなければ失敗を記録する
+ */
+#define CSM_TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        const double csmTestExpected = static_cast<double>(expected); \
+        const double csmTestActual = static_cast<double>(actual); \
+        if (csmTestExpected != csmTestActual) { TestSupport::FailEqual(__FILE__, __LINE__, #expected, #actual, csmTestExpected, csmTestActual); } \
+    } while (0)
+
+/**
+ * @brief   2つの値の差がtoleranceより大きければ失敗を記録する
+ */
+#define CSM_TEST_ASSERT_NEAR(expected, actual, tolerance) \
+    do { \
+        const double csmTestExpected = static_cast<double>(expected); \
+        const double csmTestActual = static_cast<double>(actual); \
+        if (!(csmTestActual >= csmTestExpected - (tolerance) && csmTestActual <= csmTestExpected + (tolerance))) { \
+            TestSupport::FailEqual(__FILE__, __LINE__, #expected, #actual, csmTestExpected, csmTestActual); \
+        } \
+    } while (0)
+
+namespace TestSupport {
+
+void Fail(const char* file, int line, const char* condition);
+
+void FailEqual(const char* file, int line, const char* expectedText, const char* actualText, double expected, double actual);
+
+/**
+ * @brief   テストの結果を表示し、mainの戻り値を返す
+ *
+ * @return  失敗が無ければ0
+ */
+int Finish(const char* testName);
+
+/**
+ * @brief   生存期間の間だけCubismFrameworkを起動しておく
+ */
+class FrameworkScope
+{
+public:
+    /**
+     * @param[in]   allocator   ->  フレームワークに渡すアロケータ。NULLならmallocを使う
+     */
+    explicit FrameworkScope(Live2D::Cubism::Framework::ICubismAllocator* allocator = NULL);
+
+    ~FrameworkScope();
+};
+
+/**
+ * @brief   テスト用の一時ディレクトリにファイルを書く
+ *
+ * @return  書いたファイルのパス
+ */
+std::string WriteFile(const std::string& name, const void* data, size_t size);
+
+/**
+ * @brief   テスト用の一時ディレクトリにテキストを書く
+ *
+ * @return  書いたファイルのパス
+ */
+std::string WriteTextFile(const std::string& name, const std::string& text);
+
+/**
+ * @brief   テスト用の一時ディレクトリ。末尾に区切り文字が付く
+ */
+std::string GetTemporaryDirectory();
+
+/**
+ * @brief   physics3.jsonを作る。<br>
+ *           サブリグiはParamAngleXのX成分を入力とし、2つの物理点の角度をParamHair<i>に出力する。
+ *
+ * @param[in]   settingCount    ->  サブリグの数
+ * @param[in]   fps             ->  振り子のFPS。0なら書かない
+ */
+std::string CreatePhysicsJson(int settingCount, float fps);
+
+/**
+ * @brief   WriteModelで書くモデルの構成
+ */
+struct ModelFiles
+{
+    std::string PhysicsJson;                    ///< 空でなければphysics3.jsonとして書く
+    std::vector<std::string> IdleMotionJsons;   ///< Idleグループのmotion3.json
+    std::vector<std::string> EyeBlinkIds;       ///< EyeBlinkグループのパラメータ
+    std::vector<std::string> LipSyncIds;        ///< LipSyncグループのパラメータ
+    std::vector<std::string> HitAreaIds;        ///< 当たり判定にするDrawable。名前はIDと同じ
+    int TextureCount;                           ///< テクスチャの数
+
+    ModelFiles() : TextureCount(1) { }
+};
+
+/**
+ * @brief   LAppModel::LoadAssetsで読み込めるモデル一式をテスト用の一時ディレクトリに書く
+ *
+ * @param[in]   name        ->  ファイル名の先頭に付ける名前
+ * @param[in]   builder     ->  .moc3の代わりに登録するモデル
+ * @param[in]   files       ->  モデルの構成
+ *
+ * @return  model3.jsonのファイル名。ディレクトリはGetTemporaryDirectory
+ */
+std::string WriteModel(const std::string& name, const MockCubismCore::ModelBuilder& builder, const ModelFiles& files);
+
+}
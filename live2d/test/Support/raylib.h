@@ -0,0 +1,59 @@
+/**
+ * Headless subset of raylib.h for tests.
+ *
+ * Declares only the raylib core functions the sample library uses, with the
+ * same signatures as raylib. HeadlessRaylib.cpp implements them without a
+ * window: images decode to a small white RGBA picture, textures are created
+ * through the recording rlgl, and GetTime returns a clock the test controls.
+ */
+
+#pragma once
+
+#define PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 7
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Image {
+    void* data;
+    int width;
+    int height;
+    int mipmaps;
+    int format;
+} Image;
+
+typedef struct Texture2D {
+    unsigned int id;
+    int width;
+    int height;
+    int mipmaps;
+    int format;
+} Texture2D;
+
+double GetTime(void);
+int GetScreenWidth(void);
+int GetScreenHeight(void);
+
+Image LoadImageFromMemory(const char* fileType, const unsigned char* fileData, int dataSize);
+void UnloadImage(Image image);
+void ImageFormat(Image* image, int newFormat);
+
+Texture2D LoadTexture(const char* fileName);
+Texture2D LoadTextureFromImage(Image image);
+void UnloadTexture(Texture2D texture);
+void GenTextureMipmaps(Texture2D* texture);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @brief   GetTimeが返す時刻[秒]を設定する
+ */
+void SetHeadlessTime(double seconds);
+
+/**
+ * @brief   GetScreenWidthとGetScreenHeightが返す大きさを設定する
+ */
+void SetHeadlessScreenSize(int width, int height);
@@ -0,0 +1,187 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+/**
+ * 全モデルの頂点を1つのストリーミングバッファへ書き込む動作を、記録用のrlglで検証する。
+ * 以前はモデルごとの頂点バッファへ、変化したDrawableごとにrlUpdateVertexBufferを呼んでいた。
+ * 今は各モデルが一度だけ領域を追記し、以降は変化したDrawableの範囲をその領域へ上書きする。
+ * 隣り合う範囲は1回の転送にまとまり、領域を追記し直すのはバッファが作り直されたときだけになる。
+ */
+
+#include <cmath>
+#include "MockCubismCore.hpp"
+#include "RenderedModel.hpp"
+#include "TestSupport.hpp"
+
+using namespace Live2D::Cubism::Framework;
+using namespace Live2D::Cubism::Framework::Rendering;
+using TestSupport::RenderedModel;
+
+namespace {
+    const int MovingModelCount = 3;
+    const int DrawableCount = 8;
+    const int MovingDrawableCount = 4;
+    const int GridVertexBytes = 16 * 16 * 2 * sizeof(float);
+    const int FrameCount = 120;
+
+    /**
+     * @brief   1モデルあたり16KBの頂点を持ち、前半のDrawableがパラメータで動くモデル
+     */
+    MockCubismCore::ModelBuilder CreateStreamModel()
+    {
+        MockCubismCore::ModelBuilder builder;
+        builder.AddParameter("ParamMove", -1.0f, 1.0f, 0.0f);
+        for (int i = 0; i < DrawableCount; i++)
+        {
+            const int drawable = builder.AddGrid("Grid", 0, -0.9f + i * 0.22f, -0.2f, 0.2f, 0.2f, 15, 15);
+            if (i < MovingDrawableCount)
+            {
+                builder.GetDrawable(drawable).MoveParameter = 0;
+                builder.GetDrawable(drawable).MoveY = 0.1f;
+            }
+        }
+        return builder;
+    }
+
+    /**
+     * @brief   記録した呼び出しのうち、最後に頂点を転送したバッファを返す
+     */
+    csmUint32 GetLastVertexTarget()
+    {
+        const csmVector<CubismRlglCommand>& commands = CubismRlglRecorder::GetCommands();
+        csmUint32 target = 0;
+        for (csmUint32 i = 0; i < commands.GetSize(); i++)
+        {
+            if (commands[i].Type == CubismRlglCommandType_UploadVertices)
+            {
+                target = commands[i].Target;
+            }
+        }
+        return target;
+    }
+
+    void TestDirtyRangesOverwriteInPlace()
+    {
+        const MockCubismCore::ModelBuilder builder = CreateStreamModel();
+        RenderedModel first(builder);
+        RenderedModel second(builder);
+        RenderedModel third(builder);
+        RenderedModel idle(builder);
+        RenderedModel* moving[MovingModelCount] = { &first, &second, &third };
+
+        CubismRlglRecorder::SetCommandRecording(true);
+
+        csmUint32 streamBuffer = 0;
+        csmInt32 regionOffsets[MovingModelCount] = { 0 };
+        csmUint32 mismatchedFrames = 0;
+        for (int frame = 0; frame < FrameCount; frame++)
+        {
+            for (int i = 0; i < MovingModelCount; i++)
+            {
+                moving[i]->GetModel()->SetParameterValue(0, sinf(frame * 0.3f + i));
+                moving[i]->GetModel()->Update();
+            }
+            idle.GetModel()->Update();
+
+            CubismRlglRecorder::InvalidateState();
+            CubismRlglRecorder::ResetStatistics();
+            for (int i = 0; i < MovingModelCount; i++)
+            {
+                moving[i]->GetRenderer()->DrawModel();
+            }
+            idle.GetRenderer()->DrawModel();
+
+            if (frame == 0)
+            {
+                // 初回はモデルごとのUVとインデックスのバッファ、共有のストリーミングバッファを作る
+                streamBuffer = GetLastVertexTarget();
+                continue;
+            }
+
+            // 動いた4つのDrawableは頂点バッファ上で隣り合うので、モデルごとに1回の転送にまとまる。
+            // 止まっているモデルは何も転送せず、バッファも作り直さない
+            const CubismRlglRecorder::Statistics& statistics = CubismRlglRecorder::GetStatistics();
+            if (statistics.UploadCalls != MovingModelCount
+                || statistics.UploadedVertexBytes != MovingModelCount * MovingDrawableCount * GridVertexBytes
+                || statistics.BufferAllocations != 0
+                || idle.GetRenderer()->GetFrameStatistics().UploadCalls != 0)
+            {
+                mismatchedFrames++;
+            }
+
+            // 毎フレーム、各モデルの同じ領域へ上書きする
+            const csmVector<CubismRlglCommand>& commands = CubismRlglRecorder::GetCommands();
+            int model = 0;
+            for (csmUint32 i = 0; i < commands.GetSize(); i++)
+            {
+                if (commands[i].Type != CubismRlglCommandType_UploadVertices)
+                {
+                    continue;
+                }
+                CSM_TEST_ASSERT_EQUAL(streamBuffer, commands[i].Target);
+                CSM_TEST_ASSERT(model < MovingModelCount);
+                if (frame == 1)
+                {
+                    regionOffsets[model] = commands[i].Offset;
+                }
+                CSM_TEST_ASSERT_EQUAL(regionOffsets[model], commands[i].Offset);
+                model++;
+            }
+        }
+
+        CSM_TEST_ASSERT_EQUAL(0, mismatchedFrames);
+        CSM_TEST_ASSERT(regionOffsets[0] != regionOffsets[1]);
+        CSM_TEST_ASSERT(regionOffsets[1] != regionOffsets[2]);
+
+        // 他のモデルが追記を続けてバッファが作り直されるまで、新しいモデルを描く
+        int appendedModels = 0;
+        csmUint32 rebuiltBuffer = streamBuffer;
+        while (rebuiltBuffer == streamBuffer && appendedModels < 256)
+        {
+            RenderedModel other(builder);
+            other.DrawFrame();
+            rebuiltBuffer = GetLastVertexTarget();
+            appendedModels++;
+        }
+        CSM_TEST_ASSERT(rebuiltBuffer != streamBuffer);
+
+        // 前回の領域が無効になったので、止まっているモデルも含めて全体を1回ずつ追記し直す
+        for (int i = 0; i < MovingModelCount; i++)
+        {
+            moving[i]->GetModel()->SetParameterValue(0, 0.5f);
+            moving[i]->GetModel()->Update();
+        }
+        idle.GetModel()->Update();
+
+        CubismRlglRecorder::InvalidateState();
+        CubismRlglRecorder::ResetStatistics();
+        for (int i = 0; i < MovingModelCount; i++)
+        {
+            moving[i]->GetRenderer()->DrawModel();
+        }
+        idle.GetRenderer()->DrawModel();
+
+        const CubismRlglRecorder::Statistics& rebuilt = CubismRlglRecorder::GetStatistics();
+        CSM_TEST_ASSERT_EQUAL(MovingModelCount + 1, rebuilt.UploadCalls);
+        CSM_TEST_ASSERT_EQUAL((MovingModelCount + 1) * DrawableCount * GridVertexBytes, rebuilt.UploadedVertexBytes);
+        CSM_TEST_ASSERT_EQUAL(rebuiltBuffer, GetLastVertexTarget());
+
+        CubismRlglRecorder::SetCommandRecording(false);
+
+        CSM_TEST_ASSERT_EQUAL(0, CubismRlglRecorder::GetStatistics().InvalidCalls);
+    }
+}
+
+int main()
+{
+    TestSupport::FrameworkScope framework;
+
+    TestDirtyRangesOverwriteInPlace();
+
+    CubismRenderer::StaticRelease();
+    return TestSupport::Finish("VertexStreamTest");
+}
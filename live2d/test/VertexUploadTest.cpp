@@ -0,0 +1,114 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+/**
+ * モデルのGPUバッファへの転送量を検証する。
+ * 以前はフレームごとに全Drawableの頂点・UV・インデックスを転送していた。
+ * 今は初回にすべてを転送し、以降は頂点が変化したDrawableの範囲だけを転送する。
+ */
+
+#include "MockCubismCore.hpp"
+#include "RenderedModel.hpp"
+#include "TestSupport.hpp"
+
+using namespace Live2D::Cubism::Framework;
+using namespace Live2D::Cubism::Framework::Rendering;
+using TestSupport::RenderedModel;
+
+namespace {
+    const int QuadCount = 4;
+    const int VertexBytes = QuadCount * 4 * 2 * sizeof(float);
+    const int UvBytes = QuadCount * 4 * 2 * sizeof(float);
+    const int IndexBytes = QuadCount * 6 * sizeof(unsigned short);
+    const int QuadVertexBytes = 4 * 2 * sizeof(float);
+
+    void TestUploadsOnlyWhenChanged()
+    {
+        MockCubismCore::ModelBuilder builder;
+        builder.AddParameter("ParamMove", -1.0f, 1.0f, 0.0f);
+        builder.AddParameter("ParamMoveOthers", -1.0f, 1.0f, 0.0f);
+        for (int i = 0; i < QuadCount; i++)
+        {
+            builder.AddQuad("Quad", 0, -0.8f + i * 0.4f, -0.2f, 0.3f, 0.3f);
+        }
+        builder.GetDrawable(2).MoveParameter = 0;
+        builder.GetDrawable(2).MoveY = 0.2f;
+        for (int i = 0; i < QuadCount; i++)
+        {
+            if (i != 2)
+            {
+                builder.GetDrawable(i).MoveParameter = 1;
+                builder.GetDrawable(i).MoveX = 0.1f;
+            }
+        }
+        RenderedModel rendered(builder);
+        const CubismRenderer_OpenGLES2::FrameStatistics& frame = rendered.GetRenderer()->GetFrameStatistics();
+
+        // 初回はすべて転送する。4枚は1つのバッチになるので、連結したインデックスを転送する
+        const CubismRlglRecorder::Statistics& first = rendered.DrawFrame();
+        CSM_TEST_ASSERT_EQUAL(VertexBytes, frame.UploadedVertexBytes);
+        CSM_TEST_ASSERT_EQUAL(UvBytes, frame.UploadedUvBytes);
+        CSM_TEST_ASSERT_EQUAL(2 * IndexBytes, frame.UploadedIndexBytes);
+        CSM_TEST_ASSERT_EQUAL(frame.UploadedVertexBytes + frame.UploadedUvBytes, first.UploadedVertexBytes);
+        CSM_TEST_ASSERT_EQUAL(frame.UploadedIndexBytes, first.UploadedIndexBytes);
+        CSM_TEST_ASSERT_EQUAL(0, first.InvalidCalls);
+
+        // 何も変わらなければ何も転送しない
+        rendered.GetModel()->Update();
+        const CubismRlglRecorder::Statistics& unchanged = rendered.DrawFrame();
+        CSM_TEST_ASSERT_EQUAL(0, frame.UploadCalls);
+        CSM_TEST_ASSERT_EQUAL(0, unchanged.UploadCalls);
+        CSM_TEST_ASSERT_EQUAL(0, unchanged.UploadedVertexBytes + unchanged.UploadedIndexBytes);
+        CSM_TEST_ASSERT_EQUAL(1, unchanged.DrawCalls);
+
+        // 1枚が動けばその1枚の頂点だけを、ストリームバッファ上の前回の領域へ上書きする
+        rendered.GetModel()->SetParameterValue(0, 1.0f);
+        rendered.GetModel()->Update();
+        const CubismRlglRecorder::Statistics& moved = rendered.DrawFrame();
+        CSM_TEST_ASSERT_EQUAL(1, frame.UploadCalls);
+        CSM_TEST_ASSERT_EQUAL(QuadVertexBytes, frame.UploadedVertexBytes);
+        CSM_TEST_ASSERT_EQUAL(0, frame.UploadedUvBytes);
+        CSM_TEST_ASSERT_EQUAL(0, frame.UploadedIndexBytes);
+        CSM_TEST_ASSERT_EQUAL(1, moved.UploadCalls);
+        CSM_TEST_ASSERT_EQUAL(QuadVertexBytes, moved.UploadedVertexBytes);
+        CSM_TEST_ASSERT_EQUAL(0, moved.UploadedIndexBytes);
+        CSM_TEST_ASSERT_EQUAL(0, moved.BufferAllocations);
+        CSM_TEST_ASSERT_EQUAL(0, moved.InvalidCalls);
+
+        // 隣り合う0枚目と1枚目は1回にまとめ、離れた3枚目は別に転送する
+        rendered.GetModel()->SetParameterValue(1, 1.0f);
+        rendered.GetModel()->Update();
+        const CubismRlglRecorder::Statistics& others = rendered.DrawFrame();
+        CSM_TEST_ASSERT_EQUAL(2, frame.UploadCalls);
+        CSM_TEST_ASSERT_EQUAL(3 * QuadVertexBytes, frame.UploadedVertexBytes);
+        CSM_TEST_ASSERT_EQUAL(2, others.UploadCalls);
+        CSM_TEST_ASSERT_EQUAL(3 * QuadVertexBytes, others.UploadedVertexBytes);
+
+        // すべてが動けば1回で全体を上書きする
+        rendered.GetModel()->SetParameterValue(0, -1.0f);
+        rendered.GetModel()->SetParameterValue(1, -1.0f);
+        rendered.GetModel()->Update();
+        const CubismRlglRecorder::Statistics& all = rendered.DrawFrame();
+        CSM_TEST_ASSERT_EQUAL(1, all.UploadCalls);
+        CSM_TEST_ASSERT_EQUAL(VertexBytes, all.UploadedVertexBytes);
+        CSM_TEST_ASSERT_EQUAL(0, all.InvalidCalls);
+
+        // 止まれば再び転送しない
+        rendered.GetModel()->Update();
+        CSM_TEST_ASSERT_EQUAL(0, rendered.DrawFrame().UploadCalls);
+    }
+}
+
+int main()
+{
+    TestSupport::FrameworkScope framework;
+
+    TestUploadsOnlyWhenChanged();
+
+    CubismRenderer::StaticRelease();
+    return TestSupport::Finish("VertexUploadTest");
+}
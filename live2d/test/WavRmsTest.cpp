@@ -0,0 +1,190 @@
+﻿/**
+ * Copyright(c) Live2D Inc. All rights reserved.
+ *
+ * Use of this source code is governed by the Live2D Open Software license
+ * that can be found at https://www.live2d.com/eula/live2d-open-software-license-agreement_en.html.
+ */
+
+/**
+ * LAppWavFileHandlerがマップしたファイルからSIMDで求めるRMSが、
+ * サンプルを1つずつ正規化して求めるスカラーの値と一致することを検証する。
+ * 8bit・16bit・24bit整数と32bit浮動小数点のステレオのwavファイルを生成し、
+ * SIMDの端数が出る長さの区間と、一時領域に収まらない長さの区間を読む。
+ * SIMDは単精度で足し合わせるので、相対誤差の上限を1e-4とする。
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "LAppWavFileHandler.hpp"
+#include "TestSupport.hpp"
+
+using namespace Live2D::Cubism::Framework;
+
+namespace {
+    const int SampleRate = 8000;
+    const int ChannelCount = 2;
+    const int FrameCount = 8001;
+    const double RelativeErrorBound = 1e-4;
+
+    void Put16(std::vector<unsigned char>& data, unsigned int value)
+    {
+        data.push_back(static_cast<unsigned char>(value));
+        data.push_back(static_cast<unsigned char>(value >> 8));
+    }
+
+    void Put32(std::vector<unsigned char>& data, unsigned int value)
+    {
+        Put16(data, value & 0xFFFF);
+        Put16(data, value >> 16);
+    }
+
+    void PutTag(std::vector<unsigned char>& data, const char* tag)
+    {
+        data.insert(data.end(), tag, tag + 4);
+    }
+
+    /**
+     * @brief   -1～1の試験信号。区間ごとに振幅を変えた正弦波に雑音を足し、所々で最小値と最大値に振り切る
+     */
+    std::vector<double> CreateSignal()
+    {
+        std::vector<double> signal;
+        unsigned int random = 12345;
+        for (int i = 0; i < FrameCount * ChannelCount; i++)
+        {
+            random = random * 1103515245u + 12345u;
+            const double noise = static_cast<double>((random >> 16) & 0x7FFF) / 32768.0 - 0.5;
+            const double amplitude = 0.2 + 0.6 * ((i / 1500) % 3) / 2.0;
+            double value = amplitude * sin(i * 0.013 * (1 + i % ChannelCount)) + 0.15 * noise;
+            if (i % 997 == 0)
+            {
+                value = (i % 2 == 0) ? -1.0 : 1.0;
+            }
+            signal.push_back(value < -1.0 ? -1.0 : (value > 1.0 ? 1.0 : value));
+        }
+        return signal;
+    }
+
+    /**
+     * @brief   信号を指定のビット幅で書き、LAppWavFileHandlerと同じ方法で正規化した値を返す
+     *
+     * @param[in]   bits        量子化ビット数
+     * @param[in]   isFloat     浮動小数点で書くか
+     * @param[out]  normalized  ファイルに書いた値を-1～1に正規化したもの
+     */
+    std::string WriteWav(int bits, bool isFloat, const std::vector<double>& signal, std::vector<double>& normalized)
+    {
+        const int bytesPerSample = bits / 8;
+        const unsigned int dataSize = static_cast<unsigned int>(signal.size() * bytesPerSample);
+        std::vector<unsigned char> data;
+        PutTag(data, "RIFF");
+        Put32(data, 36 + dataSize);
+        PutTag(data, "WAVE");
+        PutTag(data, "fmt ");
+        Put32(data, 16);
+        Put16(data, isFloat ? 3 : 1);
+        Put16(data, ChannelCount);
+        Put32(data, SampleRate);
+        Put32(data, SampleRate * ChannelCount * bytesPerSample);
+        Put16(data, ChannelCount * bytesPerSample);
+        Put16(data, bits);
+        PutTag(data, "data");
+        Put32(data, dataSize);
+
+        normalized.clear();
+        for (size_t i = 0; i < signal.size(); i++)
+        {
+            if (isFloat)
+            {
+                const float value = static_cast<float>(signal[i]);
+                unsigned int word;
+                memcpy(&word, &value, sizeof(word));
+                Put32(data, word);
+                normalized.push_back(value);
+                continue;
+            }
+
+            // 整数は最小値から最大値までに丸める。8bitは符号なしで書く
+            const double maximum = ldexp(1.0, bits - 1);
+            double scaled = floor(signal[i] * maximum + 0.5);
+            if (scaled > maximum - 1.0) scaled = maximum - 1.0;
+            const int value = static_cast<int>(scaled);
+            const unsigned int word = (bits == 8) ? static_cast<unsigned int>(value + 128) : static_cast<unsigned int>(value);
+            for (int k = 0; k < bytesPerSample; k++)
+            {
+                data.push_back(static_cast<unsigned char>(word >> (8 * k)));
+            }
+            normalized.push_back((bits == 16) ? value / 32768.0 : ldexp(static_cast<double>(value), 32 - bits) / 2147483647.0);
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "WavRmsTest_%d%s.wav", bits, isFloat ? "f" : "");
+        return TestSupport::WriteFile(name, &data[0], data.size());
+    }
+
+    /**
+     * @brief   経過時間を与えて最後まで再生し、更新ごとのRMSをスカラーの値と比べる
+     */
+    void TestFormat(int bits, bool isFloat)
+    {
+        std::vector<double> normalized;
+        const std::string path = WriteWav(bits, isFloat, CreateSignal(), normalized);
+
+        LAppWavFileHandler handler;
+        handler.Start(path.c_str());
+
+        // 1/60秒は端数のある区間、0.3秒は一時領域より長い区間になる
+        const float deltas[] = { 1.0f / 60.0f, 0.3f, 1.0f / 60.0f, 0.0f, 0.11f };
+        float userTimeSeconds = 0.0f;
+        unsigned int sampleOffset = 0;
+        double expectedRms = 0.0;
+        int updates = 0;
+        while (sampleOffset < static_cast<unsigned int>(FrameCount))
+        {
+            const float delta = deltas[updates % (sizeof(deltas) / sizeof(deltas[0]))];
+            CSM_TEST_ASSERT(handler.Update(delta));
+
+            // 再生位置はLAppWavFileHandlerと同じく単精度で積算した時間から求める
+            userTimeSeconds += delta;
+            unsigned int goalOffset = static_cast<unsigned int>(userTimeSeconds * SampleRate);
+            if (goalOffset > static_cast<unsigned int>(FrameCount))
+            {
+                goalOffset = FrameCount;
+            }
+            if (goalOffset > sampleOffset)
+            {
+                double sum = 0.0;
+                for (unsigned int i = sampleOffset * ChannelCount; i < goalOffset * ChannelCount; i++)
+                {
+                    sum += normalized[i] * normalized[i];
+                }
+                expectedRms = sqrt(sum / ((goalOffset - sampleOffset) * ChannelCount));
+            }
+            sampleOffset = goalOffset;
+
+            CSM_TEST_ASSERT_NEAR(expectedRms, handler.GetRms(), expectedRms * RelativeErrorBound);
+            updates++;
+        }
+        CSM_TEST_ASSERT(updates > 10);
+
+        // 末尾に達した後は更新しない
+        CSM_TEST_ASSERT(!handler.Update(1.0f / 60.0f));
+        CSM_TEST_ASSERT_EQUAL(0.0f, handler.GetRms());
+        handler.Stop();
+    }
+}
+
+int main()
+{
+    TestSupport::FrameworkScope framework;
+
+    TestFormat(8, false);
+    TestFormat(16, false);
+    TestFormat(24, false);
+    TestFormat(32, true);
+
+    return TestSupport::Finish("WavRmsTest");
+}